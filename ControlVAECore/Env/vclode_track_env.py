@@ -36,23 +36,20 @@ import pickle
 import numpy as np
 import torch
 from ..Utils.motion_dataset import MotionDataSet
-from scipy.spatial.transform import Rotation
 try:
     from VclSimuBackend import SetInitSeed
 except:
     from ModifyODE import SetInitSeed
-from ..Utils.motion_utils import character_state, state2ob, state_to_BodyInfoState
+from ..Utils.motion_utils import character_state_ob
 from ..Utils.index_counter import index_counter
 
 
 import VclSimuBackend
 try:
-    from VclSimuBackend.Common.MathHelper import MathHelper
     from VclSimuBackend.ODESim.Saver import CharacterToBVH
     from VclSimuBackend.ODESim.Loader.JsonSceneLoader import JsonSceneLoader
     from VclSimuBackend.ODESim.PDControler import DampedPDControler
 except ImportError:
-    MathHelper = VclSimuBackend.Common.MathHelper
     CharacterToBVH = VclSimuBackend.ODESim.CharacterTOBVH
     JsonSceneLoader = VclSimuBackend.ODESim.JsonSceneLoader
     DampedPDControler = VclSimuBackend.ODESim.PDController.DampedPDControler
@@ -208,10 +205,8 @@ class VCLODETrackEnv():
     
     @staticmethod
     def load_character_state(character, state):
-        character.load(state_to_BodyInfoState(state))
-        aabb = character.get_aabb() # prevent under the floor....
-        if aabb[2]<0:
-            character.move_character_by_delta(np.array([0,-aabb[2]+1e-8,0]))
+        # prevent under the floor....
+        character.load_state13(state, ground_clearance = 1e-8)
     
     def step_counter(self, random = False):
         self.counter += 1
@@ -230,8 +225,7 @@ class VCLODETrackEnv():
              self.step_counter(random=True)
         if set_state:
             self.load_character_state(self.sim_character, self.motion_data.state[self.counter])        
-        self.state = character_state(self.sim_character)
-        self.observation = state2ob(torch.from_numpy(self.state)).numpy()
+        self.state, self.observation = character_state_ob(self.sim_character)
         
         info = self.get_info()
         
@@ -254,11 +248,11 @@ class VCLODETrackEnv():
     
     def step_core(self, action, using_yield = False, **kargs):
         
-        action = Rotation.from_rotvec(action.reshape(-1,3)).as_quat()
-        action = MathHelper.flip_quat_by_w(action)
+        # rotvec to quaternion (flipped by w) in C++, once for all substeps
+        self.stable_pd.set_target_rotvec(action)
 
         for i in range(self.substep):
-            self.stable_pd.add_torques_by_quat(action)
+            self.stable_pd.add_torques_by_target()
             if 'force' in kargs:
                 self.add_force(kargs['force'])
             self.scene.damped_simulate(1)
@@ -266,8 +260,7 @@ class VCLODETrackEnv():
             if using_yield:
                 yield self.sim_character.save()
         
-        self.state = character_state(self.sim_character, self.state if self.recompute_velocity else None, self.dt)
-        self.observation = state2ob(torch.from_numpy(self.state)).numpy()
+        self.state, self.observation = character_state_ob(self.sim_character, self.state if self.recompute_velocity else None, self.dt)
         reward = 0 
         done = self.cal_done(self.state, self.observation)
         info = self.get_info()
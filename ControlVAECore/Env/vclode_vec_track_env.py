@@ -0,0 +1,139 @@
+'''
+*************************************************************************
+
+BSD 3-Clause License
+
+Copyright (c) 2023,  Visual Computing and Learning Lab, Peking University
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*************************************************************************
+'''
+import numpy as np
+from typing import List, Optional
+import VclSimuBackend
+from .vclode_track_env import VCLODETrackEnv
+from ..Utils.index_counter import index_counter
+
+
+class VCLODEVecTrackEnv(VCLODETrackEnv):
+    """N copies of the tracking environment stepped together by the C++ VecTrackEnv.
+    The copies are native clones (World.clone) of the world and space of the scene loaded
+    from env_scene_fname; the motion dataset and the balance of initial frames are shared. step takes actions in shape (N, num_joint * 3)
+    and returns states, observations, targets and done flags batched over the N copies,
+    so the policy can be evaluated once for all of them.
+    Collision uses the contact callback of World.damped_step_fast_collision.
+    """
+    def __init__(self, num_envs: int = 8, num_threads: int = 0, **kargs) -> None:
+        self.num_envs = num_envs
+        self.num_threads = num_threads
+        super(VCLODEVecTrackEnv, self).__init__(**kargs)
+
+    def object_reset(self, **kargs):
+        super(VCLODEVecTrackEnv, self).object_reset(**kargs)
+        world = self.scene.world
+        world.use_max_force_contact = int(self.scene.contact_type == VclSimuBackend.ODESim.ODEScene.ContactType.MAX_FORCE_ODE_LCP)
+        world.max_contact_num = self.scene._contact_count
+        world.self_collision = self.scene.self_collision
+
+        joint_info = self.sim_character.joint_info
+        body_id, joint_id = self.sim_character.body_info.body_c_id, joint_info.joint_c_id
+        # (world, space, body id, joint id) of every copy, cloned after the contact parameters are set
+        self.copies = [(world, self.scene.space, body_id, joint_id)]
+        for _ in range(1, self.num_envs):
+            self.copies.append(world.clone(self.scene.space, body_id, joint_id))
+
+        self.vec_env = VclSimuBackend.VecTrackEnv(self.substep, self.dt, self.head_idx,
+            self.min_length, self.max_length, self.err_threshod, self.err_length,
+            self.recompute_velocity, self.num_threads)
+        for copy_world, copy_space, copy_body_id, copy_joint_id in self.copies:
+            self.vec_env.add_world(copy_world, copy_space, copy_joint_id, copy_body_id,
+                                   joint_info.kps, joint_info.torque_limit)
+
+        self.counter = np.zeros(self.num_envs, dtype=np.int64)
+        nb = self.vec_env.num_bodies
+        self.state = np.zeros((self.num_envs, nb, 13), dtype=np.float32)
+        self.observation = np.zeros((self.num_envs, 16 * nb + 3), dtype=np.float32)
+
+    @property
+    def step_cnt(self) -> np.ndarray:
+        return self.vec_env.step_cnt
+
+    def get_info(self):
+        return {
+            'frame_num': self.counter.copy()
+        }
+
+    def get_target(self):
+        return self.motion_data.observation[self.counter]
+
+    def step_counter_at(self, i: int, random = False):
+        self.counter[i] += 1
+        if self.motion_data.done[self.counter[i]] or random:
+            self.counter[i] = index_counter.random_select(self.init_index, p = self.p_init)
+
+    def reset(self, indices: Optional[List[int]] = None, frame = -1, set_state = True):
+        """reset the environments in indices, all of them if None.
+        see VCLODETrackEnv.reset for frame and set_state.
+        """
+        if indices is None:
+            indices = range(self.num_envs)
+        info_frame = self.counter.copy()
+        for i in indices:
+            self.counter[i] = frame
+            if frame == -1:
+                self.step_counter_at(i, random = True)
+            state = self.motion_data.state[self.counter[i]] if set_state else self.state[i]
+            self.state[i], self.observation[i] = self.vec_env.reset(i, state, 1e-8)
+            info_frame[i] = self.counter[i]
+            self.step_counter_at(i, random = False)
+
+        return {
+            'state': self.state.copy(),
+            'observation': self.observation.copy(),
+            'target': self.get_target()
+        }, {'frame_num': info_frame}
+
+    def after_step(self, **kargs):
+        step_cnt = self.vec_env.step_cnt - 1  # the step count before this step, as VCLODETrackEnv
+        for i in range(self.num_envs):
+            self.step_counter_at(i, random = (step_cnt[i] % self.random_count) == 0 and step_cnt[i] != 0)
+        self.target = self.get_target()
+
+    def step(self, action, **kargs):
+        action = np.asarray(action, dtype=np.float64).reshape(self.num_envs, -1, 3)
+        target_height = self.motion_data.state[self.counter, self.head_idx, 1]
+        self.state, self.observation, done = self.vec_env.step(action, target_height)
+        info = self.get_info()
+        self.after_step()
+
+        observation = {
+            'state': self.state,
+            'target': self.target,
+            'observation': self.observation
+        }
+        reward = np.zeros(self.num_envs)
+        return observation, reward, done, info
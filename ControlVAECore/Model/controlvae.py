@@ -41,6 +41,7 @@ import torch.distributions as D
 from ControlVAECore.Model.trajectory_collection import TrajectorCollector
 from ControlVAECore.Model.world_model import SimpleWorldModel
 from ControlVAECore.Utils.mpi_utils import gather_dict_ndarray
+from ControlVAECore.Utils.shm_transport import TrajectoryTransport, ParameterTransport
 from ControlVAECore.Utils.replay_buffer import ReplayBuffer
 from tensorboardX import SummaryWriter
 from modules import *
@@ -48,6 +49,7 @@ from ..Utils.motion_utils import *
 from ..Utils import pytorch_utils as ptu
 import time
 import sys
+import os
 from ControlVAECore.Utils.radam import RAdam
 from mpi4py import MPI
 mpi_comm = MPI.COMM_WORLD
@@ -115,6 +117,12 @@ class ControlVAE(nn.Module):
         self.env = env    
         self.replay_buffer = ReplayBuffer(self.replay_buffer_keys, kargs['replay_buffer_size']) if mpi_rank ==0 else None
         self.kargs = kargs
+        
+        # samples and parameters go through shared memory instead of MPI messages, only for a single machine
+        self.use_shm_transport = kargs.get('use_shm_transport', False) and mpi_world_size > 1
+        self.action_size = action_size
+        self.trajectory_transport = None
+        self.parameter_transport = None
     #--------------------------------for MPI sync------------------------------------#
     def parameters_for_sample(self):
         '''
@@ -128,6 +136,75 @@ class ControlVAE(nn.Module):
         self.encoder.load_state_dict(dict['encoder'])
         self.agent.load_state_dict(dict['agent'])
     
+    def init_shm_transport(self):
+        '''
+        root process creates the shared memory, others attach to it after a barrier
+        '''
+        name = mpi_comm.bcast(f'controlvae_{os.getpid()}' if mpi_rank == 0 else None, root = 0)
+        layout = {
+            'state': (self.env.motion_data.state.shape[1:], np.float32),
+            'action': ((self.action_size,), np.float32),
+            'target': (self.env.motion_data.observation.shape[1:], np.float32),
+            'done': ((), np.int32),
+            'rwd': ((), np.float64),
+            'frame_num': ((), np.int64)
+        }
+        # every sampler may be one trajectory over its share of collect_size
+        capacity = 2 * self.collect_size + (mpi_world_size - 1) * self.env.max_length
+        param_size = ParameterTransport.nbytes(self.parameters_for_sample())
+        if mpi_rank == 0:
+            self.trajectory_transport = TrajectoryTransport(name + '_traj', layout, capacity, create = True)
+            self.parameter_transport = ParameterTransport(name + '_param', param_size, create = True)
+        mpi_comm.barrier()
+        if mpi_rank > 0:
+            self.trajectory_transport = TrajectoryTransport(name + '_traj', layout)
+            self.parameter_transport = ParameterTransport(name + '_param')
+    
+    def shm_sync(self, path):
+        '''
+        same as the gather and broadcast in mpi_sync, through shared memory
+        '''
+        if self.trajectory_transport is None:
+            self.init_shm_transport()
+        error = None
+        if mpi_rank > 0:
+            try:
+                self.trajectory_transport.append(path)
+            except Exception as e: # e.g. the ring is full
+                error = e
+        self.shm_check_error(error) # all trajectories are committed
+        
+        info = None
+        if mpi_rank == 0:
+            try:
+                res, num = self.trajectory_transport.read()
+                self.replay_buffer.add_trajectory(res)
+                info = {
+                    'rwd_mean': np.mean(res['rwd']),
+                    'rwd_std': np.std(res['rwd']),
+                    'episode_length': num/(res['done']!=0).sum()
+                }
+                self.trajectory_transport.release(num)
+                self.parameter_transport.write(self.parameters_for_sample())
+            except Exception as e:
+                error = e
+        self.shm_check_error(error) # parameters are written
+        
+        if mpi_rank > 0:
+            self.parameter_transport.read(self.parameters_for_sample())
+        return info
+    
+    @staticmethod
+    def shm_check_error(error):
+        '''
+        barrier of shm_sync that also shares whether a rank failed, so every rank raises
+        together instead of the others waiting forever in the barrier
+        '''
+        if mpi_comm.allreduce(int(error is not None), op = MPI.MAX):
+            if error is not None:
+                raise error
+            raise RuntimeError('shm_sync failed on another rank')
+    
     #-----------------------------for replay buffer-----------------------------------#
     @property
     def world_model_data_name(self):
@@ -191,6 +268,9 @@ class ControlVAE(nn.Module):
         self.env.val = tmp / mpi_world_size
         self.env.update_p()
         
+        if self.use_shm_transport:
+            return self.shm_sync(path)
+        
         res = gather_dict_ndarray(path)
         if mpi_rank == 0:
             paramter = self.parameters_for_sample()
@@ -302,6 +382,7 @@ class ControlVAE(nn.Module):
         arg_parser.add_argument("--save_period", type = int, default = 100, help = "save checkpoints for every * iterations")
         arg_parser.add_argument("--evaluate_period", type = int, default = 100, help = "save checkpoints for every * iterations")
         arg_parser.add_argument("--replay_buffer_size", type = int, default = 50000, help = "buffer size of replay buffer")
+        arg_parser.add_argument("--use_shm_transport", default = False, help = "send samples and parameters through shared memory, all processes on one machine", action = 'store_true')
 
         return arg_parser
     
@@ -33,6 +33,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *************************************************************************
 '''
 import sys
+import time
 import numpy as np
 import os
 from typing import Any, Optional, Tuple
@@ -40,6 +41,7 @@ from scipy.spatial.transform import Rotation
 import torch
 from torch import nn
 from torch.autograd import Variable, Function
+from torch.autograd.function import once_differentiable
 
 
 fdir = os.path.dirname(__file__)
@@ -91,6 +93,172 @@ class CatWithMask(Function):
         # for x1, the grad is 1. for x2, the grad is 1. for idx1, the grad is None
 
 
+# The batch quaternion kernels of VclSimuBackend (QuaternionWithGrad.cpp, with hand written backward).
+# quat_multiply, quat_apply, quat_to_matrix, quat_to_vec6d, quat_to_rotvec and quat_from_rotvec run them
+# as autograd functions on the tensor storage (by data_ptr, no numpy) for cpu tensors. float64 contiguous
+# tensors are used in place, float32 ones are cast to float64 and back. Other devices and dtypes use the torch ops.
+# The backwards build no graph, so double backward (create_graph=True) raises an error instead of returning
+# wrong second derivatives; call set_quat_kernel_enabled(False) for it.
+# By default the kernels only take float64 batches of at least _QUAT_KERNEL_MIN_ROWS rotations: float32 pays
+# two casts, and small batches are dominated by the call overhead. Run bench_quat_kernel() on the training box
+# and widen them with set_quat_kernel_enabled where the kernels win.
+_quat_kernel_available: bool = hasattr(VclSimuBackend, "quat_multiply_forward_ptr")
+_quat_kernel_enabled: bool = _quat_kernel_available
+_QUAT_KERNEL_DTYPES: Tuple[torch.dtype, ...] = (torch.float64,)
+_QUAT_KERNEL_MIN_ROWS: int = 4096  # a world model batch of 512 x 20 bodies is above, a single character below
+_quat_kernel_dtypes: Tuple[torch.dtype, ...] = _QUAT_KERNEL_DTYPES
+_quat_kernel_min_rows: int = _QUAT_KERNEL_MIN_ROWS
+
+
+def set_quat_kernel_enabled(enabled: bool, dtypes: Optional[Tuple[torch.dtype, ...]] = None,
+                            min_rows: Optional[int] = None) -> None:
+    """
+    use or not the C++ quaternion kernels, e.g. to compare with the torch ops.
+    dtypes (float32 and / or float64) and min_rows (rotations in the batch) select the
+    batches run by the kernels, None keeps the current value.
+    """
+    global _quat_kernel_enabled, _quat_kernel_dtypes, _quat_kernel_min_rows
+    _quat_kernel_enabled = enabled and _quat_kernel_available
+    if dtypes is not None:
+        _quat_kernel_dtypes = tuple(dtypes)
+    if min_rows is not None:
+        _quat_kernel_min_rows = min_rows
+
+
+def _use_quat_kernel(*args: torch.Tensor) -> bool:
+    if not _quat_kernel_enabled:
+        return False
+    dtype = args[0].dtype
+    if dtype not in _quat_kernel_dtypes or args[0].numel() < _quat_kernel_min_rows * args[0].shape[-1]:
+        return False
+    for x in args:
+        if x.device.type != "cpu" or x.dtype != dtype:
+            return False
+    return True
+
+
+def _kernel_input(x: torch.Tensor) -> torch.Tensor:
+    """
+    contiguous float64 tensor, the input itself if it is one already
+    """
+    return x.detach().to(torch.float64).contiguous()
+
+
+class _QuatMultiplyKernel(Function):
+    @staticmethod
+    def forward(ctx: Any, *args: Any) -> torch.Tensor:
+        p, q = args
+        p64, q64 = _kernel_input(p), _kernel_input(q)
+        res = torch.empty_like(p64)
+        VclSimuBackend.quat_multiply_forward_ptr(p64.data_ptr(), q64.data_ptr(), res.data_ptr(), p64.shape[0])
+        ctx.save_for_backward(p64, q64)
+        ctx.dtype = p.dtype
+        return res.to(p.dtype)
+
+    @staticmethod
+    @once_differentiable
+    def backward(ctx: Any, *grad_outputs: Any) -> Tuple[torch.Tensor, torch.Tensor]:
+        p64, q64 = ctx.saved_tensors
+        grad = _kernel_input(grad_outputs[0])
+        grad_p, grad_q = torch.empty_like(p64), torch.empty_like(q64)
+        VclSimuBackend.quat_multiply_backward_ptr(
+            p64.data_ptr(), q64.data_ptr(), grad.data_ptr(), grad_p.data_ptr(), grad_q.data_ptr(), p64.shape[0])
+        return grad_p.to(ctx.dtype), grad_q.to(ctx.dtype)
+
+
+class _QuatApplyKernel(Function):
+    @staticmethod
+    def forward(ctx: Any, *args: Any) -> torch.Tensor:
+        q, v = args
+        q64, v64 = _kernel_input(q), _kernel_input(v)
+        res = torch.empty_like(v64)
+        VclSimuBackend.quat_apply_forward_ptr(q64.data_ptr(), v64.data_ptr(), res.data_ptr(), q64.shape[0])
+        ctx.save_for_backward(q64, v64)
+        ctx.dtype = q.dtype
+        return res.to(q.dtype)
+
+    @staticmethod
+    @once_differentiable
+    def backward(ctx: Any, *grad_outputs: Any) -> Tuple[torch.Tensor, torch.Tensor]:
+        q64, v64 = ctx.saved_tensors
+        grad = _kernel_input(grad_outputs[0])
+        grad_q, grad_v = torch.empty_like(q64), torch.empty_like(v64)
+        VclSimuBackend.quat_apply_backward_ptr(
+            q64.data_ptr(), v64.data_ptr(), grad.data_ptr(), grad_q.data_ptr(), grad_v.data_ptr(), q64.shape[0])
+        return grad_q.to(ctx.dtype), grad_v.to(ctx.dtype)
+
+
+class _QuatToMatrixKernel(Function):
+    """
+    (n, 4) quaternion to (n, 9) rotation matrix, or to (n, 6) vec6d (first 2 columns) with vec6d = True
+    """
+    @staticmethod
+    def forward(ctx: Any, *args: Any) -> torch.Tensor:
+        q, vec6d = args
+        q64 = _kernel_input(q)
+        res = torch.empty((q64.shape[0], 6 if vec6d else 9), dtype=torch.float64)
+        forward_ptr = VclSimuBackend.quat_to_vec6d_ptr if vec6d else VclSimuBackend.quat_to_matrix_ptr
+        forward_ptr(q64.data_ptr(), res.data_ptr(), q64.shape[0])
+        ctx.save_for_backward(q64)
+        ctx.dtype, ctx.vec6d = q.dtype, vec6d
+        return res.to(q.dtype)
+
+    @staticmethod
+    @once_differentiable
+    def backward(ctx: Any, *grad_outputs: Any) -> Tuple[torch.Tensor, None]:
+        q64, = ctx.saved_tensors
+        grad = _kernel_input(grad_outputs[0])
+        grad_q = torch.empty_like(q64)
+        backward_ptr = VclSimuBackend.quat_to_vec6d_backward_ptr if ctx.vec6d else VclSimuBackend.quat_to_matrix_backward_ptr
+        backward_ptr(q64.data_ptr(), grad.data_ptr(), grad_q.data_ptr(), q64.shape[0])
+        return grad_q.to(ctx.dtype), None
+
+
+class _QuatToRotvecKernel(Function):
+    @staticmethod
+    def forward(ctx: Any, *args: Any) -> torch.Tensor:
+        q, = args
+        q64 = _kernel_input(q)
+        angle = torch.empty(q64.shape[0], dtype=torch.float64)
+        res = torch.empty((q64.shape[0], 3), dtype=torch.float64)
+        VclSimuBackend.quat_to_rotvec_ptr(q64.data_ptr(), angle.data_ptr(), res.data_ptr(), q64.shape[0])
+        ctx.save_for_backward(q64, angle)
+        ctx.dtype = q.dtype
+        return res.to(q.dtype)
+
+    @staticmethod
+    @once_differentiable
+    def backward(ctx: Any, *grad_outputs: Any) -> torch.Tensor:
+        q64, angle = ctx.saved_tensors
+        grad = _kernel_input(grad_outputs[0])
+        grad_q = torch.empty_like(q64)
+        VclSimuBackend.quat_to_rotvec_backward_ptr(
+            q64.data_ptr(), angle.data_ptr(), grad.data_ptr(), grad_q.data_ptr(), q64.shape[0])
+        return grad_q.to(ctx.dtype)
+
+
+class _QuatFromRotvecKernel(Function):
+    @staticmethod
+    def forward(ctx: Any, *args: Any) -> torch.Tensor:
+        rotvec, = args
+        rotvec64 = _kernel_input(rotvec)
+        res = torch.empty((rotvec64.shape[0], 4), dtype=torch.float64)
+        VclSimuBackend.quat_from_rotvec_ptr(rotvec64.data_ptr(), res.data_ptr(), rotvec64.shape[0])
+        ctx.save_for_backward(rotvec64)
+        ctx.dtype = rotvec.dtype
+        return res.to(rotvec.dtype)
+
+    @staticmethod
+    @once_differentiable
+    def backward(ctx: Any, *grad_outputs: Any) -> torch.Tensor:
+        rotvec64, = ctx.saved_tensors
+        grad = _kernel_input(grad_outputs[0])
+        grad_rotvec = torch.empty_like(rotvec64)
+        VclSimuBackend.quat_from_rotvec_backward_ptr(
+            rotvec64.data_ptr(), grad.data_ptr(), grad_rotvec.data_ptr(), rotvec64.shape[0])
+        return grad_rotvec.to(ctx.dtype)
+
+
 def quat_conj(q: torch.Tensor) -> torch.Tensor:
     assert q.shape[-1] == 4
     ret: torch.Tensor = torch.cat([-1 * q[..., :3], q[..., 3:4]], dim=-1)
@@ -103,6 +271,8 @@ def quat_multiply(p: torch.Tensor, q: torch.Tensor) -> torch.Tensor:
     """
     assert len(p.shape) == 2 and p.shape[-1] == 4
     assert len(q.shape) == 2 and q.shape[-1] == 4
+    if p.shape == q.shape and _use_quat_kernel(p, q):
+        return _QuatMultiplyKernel.apply(p, q)
 
     w: torch.Tensor = p[:, 3:4] * q[:, 3:4] - torch.sum(p[:, :3] * q[:, :3], dim=1, keepdim=True)
     xyz: torch.Tensor = (
@@ -194,6 +364,8 @@ def quat_apply(q: torch.Tensor, vec3: torch.Tensor) -> torch.Tensor:
     assert q.shape[-1] == 4 and vec3.shape[-1] == 3
     if vec3.shape == (3,):
         vec3 = vec3[None, :]
+    if q.ndim == 2 and vec3.shape == (q.shape[0], 3) and _use_quat_kernel(q, vec3):
+        return _QuatApplyKernel.apply(q, vec3)
     
     t = 2 * torch.cross(q[:, :3], vec3, dim=1)
     xyz: torch.Tensor = vec3 + q[:, 3, None] * t + torch.cross(q[:, :3], t, dim=1)
@@ -305,6 +477,8 @@ def quat_to_matrix(q: torch.Tensor, do_normalize: bool = False) -> torch.Tensor:
     q: torch.Tensor = q.view(-1, 4)
     if do_normalize:
         q = quat_normalize(q)
+    if _use_quat_kernel(q):
+        return _QuatToMatrixKernel.apply(q, False).view(origin_shape[:-1] + (3, 3))
 
     
     x: torch.Tensor = q[..., 0]
@@ -450,6 +624,8 @@ def quat_from_rotvec(rotvec: torch.Tensor) -> torch.Tensor:
 
     if rotvec.shape == (3,):
         rotvec = rotvec[None, :]
+    if _use_quat_kernel(rotvec):
+        return _QuatFromRotvecKernel.apply(rotvec)
 
     norms: torch.Tensor = torch.linalg.norm(rotvec, axis=1)
     small_angle = torch.as_tensor(norms <= 1e-3)
@@ -562,6 +738,8 @@ def quat_to_rotvec(q: torch.Tensor, do_normalize: bool = False):  # Test OK
     assert q.shape[-1] == 4 and q.shape[0] > 0
     if do_normalize:
         q = quat_normalize(q)
+    if q.ndim == 2 and _use_quat_kernel(q):
+        return _QuatToRotvecKernel.apply(q)
 
     quat: torch.Tensor = flip_quat_by_w(q)
     angle: torch.Tensor = torch.as_tensor(2.0) * torch.atan2(torch.linalg.norm(quat[:, :3], dim=1), quat[:, 3])
@@ -591,6 +769,11 @@ def quat_to_rotvec(q: torch.Tensor, do_normalize: bool = False):  # Test OK
 
 def quat_to_vec6d(q: torch.Tensor, do_normalize: bool = False) -> torch.Tensor:
     assert q.shape[-1] == 4
+    if _use_quat_kernel(q):
+        q2: torch.Tensor = q.reshape(-1, 4)
+        if do_normalize:
+            q2 = quat_normalize(q2)
+        return _QuatToMatrixKernel.apply(q2, True).view(q.shape[:-1] + (3, 2))
     mat: torch.Tensor = quat_to_matrix(q, do_normalize)
     res: torch.Tensor = mat[..., :2].contiguous()
     return res
@@ -750,3 +933,94 @@ def quat_to_other_rotate(q: torch.Tensor, rotate_type: RotateType) -> torch.Tens
     ret: torch.Tensor = ret.view(*origin_shape[:-1], *ret.shape[1:])
     return ret
 
+
+def check_quat_kernel_grad(num: int = 20) -> None:
+    """
+    gradcheck of the C++ quaternion kernel autograd functions, and compare them with the torch ops.
+    Inputs include quaternions with negative w, and rotations below the small angle threshold (1e-3).
+    """
+    if not _quat_kernel_available:
+        print("VclSimuBackend is built without the quaternion kernels")
+        return
+    saved = (_quat_kernel_enabled, _quat_kernel_dtypes, _quat_kernel_min_rows)
+    set_quat_kernel_enabled(True, (torch.float32, torch.float64), 0)
+    torch.manual_seed(0)
+    p: torch.Tensor = quat_normalize(torch.randn(num, 4, dtype=torch.float64))
+    q: torch.Tensor = quat_normalize(torch.randn(num, 4, dtype=torch.float64))
+    p[0, 3] = -abs(p[0, 3].item())
+    q[:4] = quat_from_rotvec(1e-4 * torch.randn(4, 3, dtype=torch.float64))
+    q[4:6] = -q[4:6]
+    v: torch.Tensor = torch.randn(num, 3, dtype=torch.float64)
+    rotvec: torch.Tensor = 1.8 * torch.randn(num, 3, dtype=torch.float64)
+    rotvec[:4] *= 1e-4
+    cases = [
+        ("quat_multiply", quat_multiply, (p, q)),
+        ("quat_apply", quat_apply, (q, v)),
+        ("quat_to_matrix", quat_to_matrix, (q,)),
+        ("quat_to_vec6d", quat_to_vec6d, (q,)),
+        ("quat_to_rotvec", quat_to_rotvec, (q,)),
+        ("quat_from_rotvec", quat_from_rotvec, (rotvec,)),
+    ]
+    for name, func, args in cases:
+        args = tuple(x.clone().requires_grad_(True) for x in args)
+        set_quat_kernel_enabled(True)
+        res: torch.Tensor = func(*args)
+        grads = torch.autograd.grad(res, args, torch.ones_like(res))
+        passed: bool = torch.autograd.gradcheck(func, args, eps=1e-6, atol=1e-6)
+        set_quat_kernel_enabled(False)
+        ref: torch.Tensor = func(*args)
+        ref_grads = torch.autograd.grad(ref, args, torch.ones_like(ref))
+        set_quat_kernel_enabled(True)
+        res_err: float = torch.max(torch.abs(res - ref)).item()
+        grad_err: float = max(torch.max(torch.abs(a - b)).item() for a, b in zip(grads, ref_grads))
+        print(f"{name}: gradcheck {passed}, max error to torch ops: forward {res_err:.3g}, backward {grad_err:.3g}")
+    set_quat_kernel_enabled(*saved)
+
+
+def bench_quat_kernel(rows: Tuple[int, ...] = (20, 512, 512 * 20), repeat: int = 50) -> None:
+    """
+    time forward + backward of the C++ quaternion kernels against the torch ops, in float32 and float64,
+    for batches of a single character (20 bodies), and of world model batches (512 x 20 bodies).
+    """
+    if not _quat_kernel_available:
+        print("VclSimuBackend is built without the quaternion kernels")
+        return
+    saved = (_quat_kernel_enabled, _quat_kernel_dtypes, _quat_kernel_min_rows)
+    cases = [
+        ("quat_multiply", quat_multiply, lambda n, dtype: (quat_normalize(torch.randn(n, 4, dtype=dtype)),
+                                                           quat_normalize(torch.randn(n, 4, dtype=dtype)))),
+        ("quat_apply", quat_apply, lambda n, dtype: (quat_normalize(torch.randn(n, 4, dtype=dtype)),
+                                                     torch.randn(n, 3, dtype=dtype))),
+        ("quat_to_matrix", quat_to_matrix, lambda n, dtype: (quat_normalize(torch.randn(n, 4, dtype=dtype)),)),
+        ("quat_to_vec6d", quat_to_vec6d, lambda n, dtype: (quat_normalize(torch.randn(n, 4, dtype=dtype)),)),
+        ("quat_to_rotvec", quat_to_rotvec, lambda n, dtype: (quat_normalize(torch.randn(n, 4, dtype=dtype)),)),
+        ("quat_from_rotvec", quat_from_rotvec, lambda n, dtype: (torch.randn(n, 3, dtype=dtype),)),
+    ]
+
+    def run(func, args) -> float:
+        start = time.perf_counter()
+        for _ in range(repeat):
+            res: torch.Tensor = func(*args)
+            torch.autograd.grad(res, args, torch.ones_like(res))
+        return (time.perf_counter() - start) / repeat * 1e6
+
+    torch.manual_seed(0)
+    print(f"{'op':>16} {'dtype':>8} {'rows':>6} {'kernel us':>10} {'torch us':>10} {'speedup':>8}")
+    for name, func, make_args in cases:
+        for dtype in (torch.float32, torch.float64):
+            for n in rows:
+                args = tuple(x.requires_grad_(True) for x in make_args(n, dtype))
+                set_quat_kernel_enabled(True, (torch.float32, torch.float64), 0)
+                run(func, args)  # warm up
+                kernel_cost: float = run(func, args)
+                set_quat_kernel_enabled(False)
+                run(func, args)
+                torch_cost: float = run(func, args)
+                print(f"{name:>16} {str(dtype)[6:]:>8} {n:6d} {kernel_cost:10.1f} {torch_cost:10.1f} "
+                      f"{torch_cost / kernel_cost:8.2f}")
+    set_quat_kernel_enabled(*saved)
+
+
+if __name__ == "__main__":
+    check_quat_kernel_grad()
+    bench_quat_kernel()
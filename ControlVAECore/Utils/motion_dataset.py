@@ -94,8 +94,7 @@ class MotionDataSet():
         
         for i in range(target.num_frames):
             tarset.set_character_byframe(i)
-            state_tmp = character_state(character)
-            ob_tmp =  state2ob(torch.from_numpy(state_tmp)).numpy()
+            state_tmp, ob_tmp = character_state_ob(character)
             done_tmp = (i == (target.num_frames -1))
             state.append(state_tmp[None,...])
             ob.append(ob_tmp.flatten()[None,...])
@@ -91,17 +91,22 @@ def character_state(character, old_state = None, dt = None):
         :param old_state: if old state is not None, it will try to recompute avel 
         and vel according to dt, otherwise it will just return current vel and avel 
     '''
-    pos, rot = character_pos_rot(character)
+    return character_state_ob(character, old_state, dt, with_ob = False)[0]
+
+def character_state_ob(character, old_state = None, dt = None, with_ob = True):
+    '''
+        full state (as character_state) and its observation (as state2ob on the state),
+        computed in one native call on the world, without numpy / torch temporaries
+    '''
+    body_c_id = character.body_info.body_c_id
+    state = np.empty((body_c_id.size, 13), dtype=np.float32)
+    ob = np.empty(16 * body_c_id.size + 3, dtype=np.float32) if with_ob else None
     if old_state is not None:
         # recompute vel
         assert dt is not None
-        old_pos, old_rot = old_state[:,:3], old_state[:,3:7]
-        vel, avel = resample(old_pos, old_rot, pos, rot, dt)
-    else:
-        vel = character.body_info.get_body_velo()
-        avel = character.body_info.get_body_ang_velo()
-    state = np.concatenate([pos, rot, vel, avel], axis=-1, dtype=np.float32)
-    return state
+        old_state = np.ascontiguousarray(old_state, dtype=np.float32)
+    character.world.character_state(body_c_id, state, ob, old_state, dt if dt is not None else 0)
+    return state, ob
 
 def state_to_BodyInfoState(state):
     res = BodyInfoState.BodyInfoState()
@@ -0,0 +1,123 @@
+'''
+*************************************************************************
+
+BSD 3-Clause License
+
+Copyright (c) 2023,  Visual Computing and Learning Lab, Peking University
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*************************************************************************
+'''
+import numpy as np
+import torch
+from typing import Dict, List, Tuple
+import VclSimuBackend
+
+
+class TrajectoryTransport():
+    """Trajectories in shared memory, replacing gather_dict_ndarray when all processes run on one machine.
+    Every record is one step with the fields given in layout, e.g. {'state': ((20, 13), np.float32), ...},
+    so samplers write their trajectory right into the shared records and the learner reads them in place.
+    """
+    def __init__(self, name: str, layout: Dict[str, Tuple[tuple, np.dtype]], capacity: int = 0, create: bool = False) -> None:
+        self.dtype = np.dtype([(key, np.dtype(dtype), tuple(shape)) for key, (shape, dtype) in layout.items()])
+        self.ring = VclSimuBackend.ShmTrajectoryRing(name, self.dtype.itemsize, capacity, create)
+        if self.ring.record_size != self.dtype.itemsize:
+            raise ValueError("record layout does not match the shared memory ring")
+        self.records = self.ring.records().view(self.dtype).reshape(-1)
+        self.mask = self.ring.capacity - 1
+
+    def append(self, path: Dict[str, np.ndarray]):
+        """write a trajectory (or a batch of them) into the ring, keys as the layout.
+        raise RuntimeError when the ring has no room, the learner has to read before samplers write again.
+        """
+        num = len(path['done'])
+        start = self.ring.reserve(num)
+        if start < 0:
+            raise RuntimeError(f"shared memory ring is full, capacity {self.ring.capacity} records")
+        index = (start + np.arange(num)) & self.mask
+        for key in self.dtype.names:
+            self.records[key][index] = np.asarray(path[key]).reshape((num,) + self.dtype[key].shape)
+        self.ring.commit(start, num)
+
+    def read(self) -> Tuple[Dict[str, np.ndarray], int]:
+        """return the published records as a dict and their count.
+        the arrays are views of the shared memory unless the records wrap around the end of the ring,
+        so they are only valid until release is called with the count.
+        """
+        start, num = self.ring.ready()
+        begin = start & self.mask
+        if begin + num <= len(self.records):
+            records = self.records[begin: begin + num]
+        else:
+            records = self.records[(start + np.arange(num)) & self.mask]
+        return {key: records[key] for key in self.dtype.names}, num
+
+    def release(self, num: int):
+        self.ring.release(num)
+
+
+class ParameterTransport():
+    """Tensors of nested state dicts in one shared memory blob, replacing the broadcast of pickled parameters.
+    All processes must build the same modules, so the order and shapes of the tensors agree.
+    """
+    def __init__(self, name: str, capacity: int = 0, create: bool = False) -> None:
+        self.slot = VclSimuBackend.ShmParamSlot(name, capacity, create)
+        self.version = 0
+
+    @staticmethod
+    def flatten(parameters: dict) -> List[torch.Tensor]:
+        res = []
+        for value in parameters.values():
+            if isinstance(value, dict):
+                res.extend(ParameterTransport.flatten(value))
+            else:
+                res.append(value)
+        return res
+
+    @staticmethod
+    def nbytes(parameters: dict) -> int:
+        return sum(t.numel() * t.element_size() for t in ParameterTransport.flatten(parameters))
+
+    def write(self, parameters: dict):
+        blob = np.concatenate([t.detach().cpu().contiguous().view(-1).view(torch.uint8).numpy()
+                               for t in self.flatten(parameters)])
+        self.version = self.slot.write(blob)
+
+    def read(self, parameters: dict) -> bool:
+        """copy the blob into the tensors of parameters in place, return False if nothing new was written"""
+        version, blob = self.slot.read()
+        if version == self.version:
+            return False
+        offset = 0
+        for t in self.flatten(parameters):
+            nbytes = t.numel() * t.element_size()
+            src = torch.from_numpy(blob[offset: offset + nbytes]).view(t.dtype).view(t.shape)
+            t.copy_(src)
+            offset += nbytes
+        self.version = version
+        return True
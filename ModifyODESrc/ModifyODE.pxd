@@ -27,7 +27,7 @@ from libc.stdlib cimport malloc, free
 from libc.stdio cimport printf
 from libc.string cimport memcpy, memset
 
-cdef extern from "ode/ode.h":
+cdef extern from "ode/ode.h" nogil:
 
     ctypedef double dReal
 
@@ -40,6 +40,7 @@ cdef extern from "ode/ode.h":
     cdef struct dxJointGroup
     cdef struct dxTriMeshData
     cdef struct dxHeightfieldData
+    cdef struct dxCharacterPairTable
 
     # Types
     ctypedef dxWorld* dWorldID
@@ -50,6 +51,7 @@ cdef extern from "ode/ode.h":
     ctypedef dxJointGroup* dJointGroupID
     ctypedef dxTriMeshData* dTriMeshDataID
     ctypedef dxHeightfieldData* dHeightfieldDataID
+    ctypedef dxCharacterPairTable* dCharacterPairTableID
     ctypedef dReal dVector3[4]
     ctypedef dReal dVector4[4]
     ctypedef dReal dMatrix3[4*3]
@@ -72,7 +74,8 @@ cdef extern from "ode/ode.h":
         dVector3 f2
         dVector3 t2
 
-    ctypedef void dNearCallback(void* data, dGeomID o1, dGeomID o2)
+    ctypedef void dNearCallback(void* data, dGeomID o1, dGeomID o2) noexcept nogil
+    ctypedef int dSweepFilterFn(void* data, dGeomID fast_geom, dGeomID other) noexcept nogil
     ctypedef dReal dHeightfieldGetHeight( void* p_user_data, int x, int z )
 
     ctypedef struct dSurfaceParameters:
@@ -329,6 +332,20 @@ cdef extern from "ode/ode.h":
     void dWorldSetAngularDamping (dWorldID w, dReal scale)
     void dWorldImpulseToForce (dWorldID w, dReal stepsize, dReal ix, dReal iy, dReal iz, dVector3 force)
 
+    ctypedef struct dBodyStorageInfo:
+        int num_bodies
+        unsigned int generation
+        dReal * posr
+        dReal * q
+        dReal * lvel
+        dReal * avel
+
+    void dWorldSetContiguousBodyStorage (dWorldID w, int enabled)
+    int dWorldGetContiguousBodyStorage (dWorldID w)
+    void dWorldReserveBodyStorage (dWorldID w, int capacity)
+    int dWorldGetBodyStorage (dWorldID w, dBodyStorageInfo * info)
+    void dWorldBodyStorageMoved (dWorldID w)
+
     # Add by Zhenhua Song
     void dWorldDampedStep(dWorldID w, dReal stepsize)
 
@@ -592,6 +609,14 @@ cdef extern from "ode/ode.h":
     # Add by Zhenhua Song
     const dReal * dJointGetKd(dJointID)
 
+    # Add by Zhenhua Song
+    void dJointSetStablePD(dJointID, dReal kp, dReal kd, dReal torque_limit)
+    void dJointDisableStablePD(dJointID)
+    int dJointIsStablePD(dJointID)
+    void dJointSetStablePDTarget(dJointID, const dReal * q)
+    const dReal * dJointGetStablePDTarget(dJointID)
+    void dJointSetStablePDTargets(const dJointID * joints, int count, const dReal * qs, int input_in_scipy)
+
     # Add by Zhenhua Song
     dReal dJointGetContactParam(dJointID j, int parameter)
 
@@ -642,6 +667,24 @@ cdef extern from "ode/ode.h":
     void dHashSpaceSetLevels (dSpaceID space, int minlevel, int maxlevel)
     void dHashSpaceGetLevels (dSpaceID space, int *minlevel, int *maxlevel)
 
+    ctypedef struct dHashSpaceStats:
+        int minlevel
+        int maxlevel
+        int num_aabbs
+        int num_big_boxes
+        int num_nodes
+        int table_size
+        int used_buckets
+        int max_bucket_size
+        int num_cell_tests
+        int num_big_box_tests
+
+    void dHashSpaceSetAutoLevels (dSpaceID space, int enabled)
+    int dHashSpaceGetAutoLevels (dSpaceID space)
+    void dHashSpaceSetStatsEnabled (dSpaceID space, int enabled)
+    int dHashSpaceGetStatsEnabled (dSpaceID space)
+    void dHashSpaceGetStats (dSpaceID space, dHashSpaceStats * stats)
+
     void dSpaceSetCleanup (dSpaceID space, int mode)
     int dSpaceGetCleanup (dSpaceID space)
 
@@ -663,6 +706,8 @@ cdef extern from "ode/ode.h":
     # Add by Zhenhua Song
     void dSpaceResortGeoms(dSpaceID space);
 
+    int dSpaceSweepFastBodies(dSpaceID space, dWorldID w, dReal stepsize, void * data, dSweepFilterFn * filter)
+
     # Add by Zhenhua Song
     void * dSpaceGetData(dSpaceID space)
 
@@ -723,11 +768,47 @@ cdef extern from "ode/ode.h":
     # Add by Zhenhua Song
     int dGeomIsPlaceable(dGeomID geom)
 
+    enum: dGEOM_MAX_IGNORE_GEOMS
+
+    ctypedef struct dGeomContactAttrs:
+        dReal friction
+        dReal bounce
+        dReal max_friction
+        int collidable
+        int character_self_collide
+        int num_ignore_geoms
+        dGeomID ignore_geoms[dGEOM_MAX_IGNORE_GEOMS]
+
+    dGeomContactAttrs * dGeomGetContactAttrs(dGeomID g)
+
+    # Add by Zhenhua Song
+    ctypedef struct dJointGroupWithdWorld:
+        int use_max_force_contact
+        int max_contact_num
+        dReal soft_cfm
+        dReal soft_erp
+        int use_soft_contact
+        int self_collision
+        dJointGroupID group
+        dWorldID world
+
+    int dCollideContactFilter(void * data, dGeomID o1, dGeomID o2)
+    void dCollideContactCallback(void * data, dGeomID o1, dGeomID o2)
+
     # Add by Zhenhua Song
-    # void dGeomAppendIgnore(dGeomID now_id, dGeomID other_id)
+    int dGeomAppendIgnore(dGeomID now_id, dGeomID other_id)
 
     # Add by Zhenhua Song
-    # int dGeomIsIgnore(dGeomID now_id, dGeomID other_id)
+    int dGeomIsIgnore(dGeomID now_id, dGeomID other_id)
+
+    dCharacterPairTableID dCharacterPairTableCreate(int num_geoms)
+    void dCharacterPairTableDestroy(dCharacterPairTableID table)
+    int dCharacterPairTableGetNumGeoms(dCharacterPairTableID table)
+    void dCharacterPairTableSetPair(dCharacterPairTableID table, int i, int j, int allowed)
+    int dCharacterPairTableGetPair(dCharacterPairTableID table, int i, int j)
+    void dCharacterPairTableSetAll(dCharacterPairTableID table, int allowed)
+    void dGeomSetCharacterPairTable(dGeomID g, dCharacterPairTableID table)
+    dCharacterPairTableID dGeomGetCharacterPairTable(dGeomID g)
 
     # Add by Zhenhua Song
     int dGeomGetCharacterID(dGeomID g)
@@ -768,6 +849,23 @@ cdef extern from "ode/ode.h":
     # Add by Zhenhua Song
     unsigned int dBodyGetFlags(dBodyID b)
 
+    void dBodySetFastMoving(dBodyID b, int enabled)
+    int dBodyGetFastMoving(dBodyID b)
+    int dBodyGetStorageIndex(dBodyID b)
+
+    void dBodiesGetState13(const dBodyID * bodies, int num_bodies, const float * prev_state, dReal dt, float * state)
+    void dState13ToObservation(const float * state, int num_bodies, float * obs)
+    void dBodiesSetState13(const dBodyID * bodies, int num_bodies, const float * state)
+    dReal dBodiesLiftAboveGround(const dBodyID * bodies, int num_bodies, dReal clearance)
+
+    size_t dWorldGetSnapshotSize(dWorldID w)
+    size_t dWorldSnapshot(dWorldID w, void * buffer, size_t buffer_size)
+    int dWorldRestore(dWorldID w, const void * buffer, size_t buffer_size)
+    dWorldID dWorldClone(dWorldID w, dSpaceID space, dSpaceID * space_out,
+                         dBodyID * src_bodies, dBodyID * new_bodies,
+                         dJointID * src_joints, dJointID * new_joints,
+                         dGeomID * src_geoms, dGeomID * new_geoms)
+
     # Add by Zhenhua Song
     void dBodyGetInertia(dBodyID b, dReal* out)
 
@@ -831,6 +929,10 @@ cdef extern from "ode/ode.h":
 
     void dGeomTriMeshDataBuildSimple(dTriMeshDataID g, dReal* Vertices, int VertexCount, unsigned int* Indices, int IndexCount)
 
+    size_t dGeomTriMeshDataGetSerializedSize(dTriMeshDataID g)
+    size_t dGeomTriMeshDataSerialize(dTriMeshDataID g, void* buffer, size_t bufferSize)
+    int dGeomTriMeshDataBuildFromSerialized(dTriMeshDataID g, const void* blob, size_t blobSize)
+
     dGeomID dCreateTriMesh (dSpaceID space, dTriMeshDataID Data,
                             void* Callback,
                             void* ArrayCallback,
@@ -879,21 +981,43 @@ cdef extern from "ode/ode.h":
 
     # Add by Zhenhua Song
     void dRandSetSeed(unsigned long s)
+    unsigned long dRandGetSeed()
+
+    unsigned long dWorldGetRandSeed(dWorldID w)
+    void dWorldSetRandSeed(dWorldID w, unsigned long s)
+
+    # Add by Zhenhua Song
+    enum:
+        dProfileBroadphase
+        dProfileNarrowphase
+        dProfileContacts
+        dProfileIslands
+        dProfilePreprocess
+        dProfileCreateJ
+        dProfileComputeA
+        dProfileComputeRhs
+        dProfileSolveLCP
+        dProfileConstraintForce
+        dProfileIntegrateVelocity
+        dProfileIntegratePosition
+        dProfileTidyUp
+        dProfileResortGeoms
+        dProfilePhaseCount
+
+    ctypedef struct dWorldProfile:
+        double seconds[dProfilePhaseCount]
+        unsigned long long calls[dProfilePhaseCount]
+        unsigned long long steps
+
+    void dWorldSetProfiling(dWorldID w, int enabled)
+    int dWorldGetProfiling(dWorldID w)
+    void dWorldResetProfile(dWorldID w)
+    void dWorldGetProfile(dWorldID w, dWorldProfile * profile)
+    unsigned long long dWorldProfileBegin(dWorldID w)
+    void dWorldProfileEnd(dWorldID w, int phase, unsigned long long begin)
 
 # end ode.h
 
-# Add by Zhenhua Song
-
-ctypedef struct dJointGroupWithdWorld:
-    int use_max_force_contact
-    int max_contact_num
-    dReal soft_cfm
-    dReal soft_erp
-    int use_soft_contact
-    int self_collision
-    dJointGroupID group
-    dWorldID world
-
 
 # Add by Zhenhua Song
 cdef extern from "joint_local_quat_batch.h":
@@ -921,8 +1045,28 @@ cdef extern from "joint_local_quat_batch.h":
     dReal compute_total_power_by_global(dJointID * joints, int joint_count, const dReal * global_joint_torques)
     dReal compute_total_power(dJointID * joints, int joint_count, const dReal * joint_torques)
 
+    cdef cppclass CPDControlWorkspace "PDControlWorkspace":
+        void Reserve(int joint_count)
+        int GetCapacity() const
+
+    CPDControlWorkspace * PDControlWorkspaceCreate(int joint_count)
+    void PDControlWorkspaceDelete(CPDControlWorkspace * ptr)
+
     # As (stable) PD controller in python is too slow (by profile),
     # rewrite it in c++, then call it via cython
+    void pd_control_batch(
+        CPDControlWorkspace & workspace,
+        dJointID* joints,
+        int joint_count,
+        const dReal* input_target_local_qs,
+        const dReal* kps,
+        const dReal* kds,
+        const dReal* torque_limits,
+        dReal* local_res_joint_torques,
+        dReal* global_res_joint_torques,
+        int input_in_scipy
+    )
+
     void pd_control_batch(
         dJointID* joints,
         int joint_count,
@@ -1035,6 +1179,14 @@ cdef extern from "QuaternionWithGrad.h" nogil:
 
     void quat_to_vec6d_impl(const double * q, double * vec6d, size_t num_quat)
 
+    void quat_to_vec6d_backward_single(
+        const double * q,
+        const double * grad_in,
+        double * grad_out
+    )
+
+    void quat_to_vec6d_backward(const double * q, const double * grad_in, double * grad_out, size_t num_quat)
+
     void quat_to_matrix_forward_single(
         const double * q,
         double * mat
@@ -1,5 +1,6 @@
 # cython: language_level=3
 from EigenWrapper cimport *
+from ModifyODE cimport dJointID, dBodyID, dSpaceID, dJointGroupWithdWorld
 from libcpp.vector cimport vector as std_vector
 from libcpp.string cimport string as std_string
 
@@ -27,6 +28,21 @@ cdef extern from "PDControlAdd.h" nogil:
         const std_vector[int]& child_body_, size_t body_cnt_)
     void TorqueAddHelperDelete(TorqueAddHelper* ptr)
 
+    cdef cppclass CJointPDController "JointPDController":
+        int GetJointCount() const
+        bint HasKd() const
+        double GetAccumEnergy() const
+        void SetAccumEnergy(double value)
+        const double * GetLocalTorque() const
+        const double * GetGlobalTorque() const
+        double Apply(const double * target_local_qs, int input_in_scipy)
+        void SetTargetRotvec(const double * rotvecs)
+        const double * GetTarget() const
+        double ApplyTarget()
+
+    CJointPDController * JointPDControllerCreate(const dJointID * joints_, int joint_cnt, const double * kp_, const double * torque_limit_, const double * kd_)
+    void JointPDControllerDelete(CJointPDController * ptr)
+
 
 cdef extern from "MixQuaternion.h" nogil:
     void mix_quaternion(double * quat_input, size_t num, double * result) # The performance of this function is not good..
@@ -275,3 +291,84 @@ cdef extern from "QuaternionWithGrad.h" nogil:
         double * q_b,
         size_t num_quat
     )
+
+
+# Add by Zhenhua Song
+cdef extern from "QuaternionWithGradSimd.h" nogil:
+    int quat_simd_avx2_supported()
+    void quat_simd_set_enabled(int enabled)
+    int quat_simd_get_enabled()
+    int quat_simd_use_avx2()
+
+
+# Add by Zhenhua Song
+cdef extern from "batch_parallel.h" nogil:
+    void batch_parallel_set_num_threads(int num_threads)
+    int batch_parallel_get_num_threads()
+    void batch_parallel_set_min_items(size_t min_items)
+    size_t batch_parallel_get_min_items()
+
+
+# Add by Zhenhua Song
+cdef extern from "vec_track_env.h" nogil:
+    cdef cppclass VecTrackEnvConfig:
+        int num_substep
+        double control_dt
+        int recompute_velocity
+        int head_index
+        int min_length
+        int max_length
+        double err_threshold
+        int err_length
+
+    cdef cppclass CVecTrackEnv "VecTrackEnv":
+        int AddWorld(
+            const dJointGroupWithdWorld & contact_info,
+            dSpaceID space,
+            const dJointID * joints,
+            int num_joints,
+            const dBodyID * bodies,
+            int num_bodies,
+            const double * kps,
+            const double * torque_limits
+        )
+
+        int GetNumWorlds() const
+        int GetNumJoints() const
+        int GetNumBodies() const
+        int GetNumThreads() const
+        const VecTrackEnvConfig & GetConfig() const
+
+        int GetStepCount(int world_index) const
+        int GetDoneCount(int world_index) const
+        double GetAccumEnergy(int world_index) const
+
+        void Reset(int world_index, const float * state, double ground_clearance, float * state_out, float * obs_out)
+        void Step(const double * actions, const double * target_height, float * state_out, float * obs_out, int * done_out)
+
+    CVecTrackEnv * VecTrackEnvCreate(const VecTrackEnvConfig & config, int num_threads)
+    void VecTrackEnvDelete(CVecTrackEnv * ptr)
+
+cdef extern from "shm_transport.h" nogil:
+    cdef cppclass CShmTrajectoryRing "ShmTrajectoryRing":
+        size_t GetRecordSize() const
+        size_t GetCapacity() const
+        char * GetRecords() const
+        long long Reserve(size_t count)
+        void Commit(unsigned long long start, size_t count)
+        size_t Ready(unsigned long long * start, size_t max_count) const
+        void Release(size_t count)
+
+    cdef cppclass CShmParamSlot "ShmParamSlot":
+        size_t GetCapacity() const
+        unsigned long long GetVersion() const
+        unsigned long long Write(const void * src, size_t nbytes)
+        unsigned long long Read(void * dst, size_t dst_capacity, size_t * nbytes) const
+
+    CShmTrajectoryRing * ShmTrajectoryRingCreate(const char * name, size_t record_size, size_t capacity)
+    CShmTrajectoryRing * ShmTrajectoryRingOpen(const char * name)
+    void ShmTrajectoryRingDelete(CShmTrajectoryRing * ring)
+
+    CShmParamSlot * ShmParamSlotCreate(const char * name, size_t capacity)
+    CShmParamSlot * ShmParamSlotOpen(const char * name)
+    void ShmParamSlotDelete(CShmParamSlot * slot)
@@ -209,6 +209,41 @@ bool Model::Build(const OPCODECREATE& create)
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Sets up a no-leaf, non-quantized model from nodes of a previously built one, without rebuilding the tree.
+ *	\param		imesh		[in] mesh interface, same triangles as the model the nodes come from
+ *	\param		nodes		[in] borrowed tree nodes (can be null for 1-triangle meshes)
+ *	\param		nb_nodes	[in] number of nodes
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool Model::Import(const MeshInterface* imesh, const AABBNoLeafNode* nodes, udword nb_nodes)
+{
+	// Checkings
+	if(!imesh || !imesh->IsValid())	return false;
+
+	// A complete no-leaf tree has exactly N-1 nodes. Checked before Release() so a bad
+	// import keeps the current tree.
+	udword NbTris = imesh->GetNbTriangles();
+	if(NbTris!=1 && (!nodes || nb_nodes!=NbTris-1))	return false;
+
+	Release();
+
+	SetMeshInterface(imesh);
+
+	// Same special case as Build()
+	if(NbTris==1)
+	{
+		mModelCode |= OPC_SINGLE_NODE;
+		return true;
+	}
+
+	if(!CreateTree(true, false))	return false;
+
+	return static_cast<AABBNoLeafTree*>(mTree)->Import(nodes, nb_nodes);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Gets the number of bytes used by the tree.
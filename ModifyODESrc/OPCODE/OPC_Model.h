@@ -36,6 +36,17 @@
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		override(BaseModel)	bool				Build(const OPCODECREATE& create);
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Sets up a no-leaf, non-quantized model from nodes of a previously built one, without rebuilding the tree.
+		 *	\param		imesh		[in] mesh interface, same triangles as the model the nodes come from
+		 *	\param		nodes		[in] borrowed tree nodes (can be null for 1-triangle meshes)
+		 *	\param		nb_nodes	[in] number of nodes
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+							bool				Import(const MeshInterface* imesh, const AABBNoLeafNode* nodes, udword nb_nodes);
+
 #ifdef __MESHMERIZER_H__
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		/**
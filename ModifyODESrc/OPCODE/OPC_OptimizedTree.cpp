@@ -171,8 +171,8 @@ static void _BuildNoLeafTree(AABBNoLeafNode* linear, const udword box_id, udword
 	{
 		// Get a new id for positive child
 		udword PosID = current_id++;
-		// Setup box data
-		linear[box_id].mPosData = (size_t)&linear[PosID];
+		// Setup box data, as a byte offset from the current node
+		linear[box_id].mPosData = size_t(PosID - box_id) * sizeof(AABBNoLeafNode);
 		// Make sure it's not marked as leaf
 		ASSERT(!(linear[box_id].mPosData&1));
 		// Recurse
@@ -192,8 +192,8 @@ static void _BuildNoLeafTree(AABBNoLeafNode* linear, const udword box_id, udword
 	{
 		// Get a new id for negative child
 		udword NegID = current_id++;
-		// Setup box data
-		linear[box_id].mNegData = (size_t)&linear[NegID];
+		// Setup box data, as a byte offset from the current node
+		linear[box_id].mNegData = size_t(NegID - box_id) * sizeof(AABBNoLeafNode);
 		// Make sure it's not marked as leaf
 		ASSERT(!(linear[box_id].mNegData&1));
 		// Recurse
@@ -301,7 +301,7 @@ bool AABBCollisionTree::Walk(GenericWalkingCallback callback, void* user_data) c
  *	Constructor.
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-AABBNoLeafTree::AABBNoLeafTree() : mNodes(null)
+AABBNoLeafTree::AABBNoLeafTree() : mNodes(null), mBorrowedNodes(FALSE)
 {
 }
 
@@ -312,6 +312,7 @@ AABBNoLeafTree::AABBNoLeafTree() : mNodes(null)
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 AABBNoLeafTree::~AABBNoLeafTree()
 {
+	if(mBorrowedNodes)	mNodes = null;
 	DELETEARRAY(mNodes);
 }
 
@@ -331,6 +332,14 @@ bool AABBNoLeafTree::Build(AABBTree* tree)
 	udword NbNodes		= tree->GetNbNodes();
 	if(NbNodes!=NbTriangles*2-1)	return false;
 
+	// Borrowed nodes can't be rebuilt in place
+	if(mBorrowedNodes)
+	{
+		mNodes = null;
+		mNbNodes = 0;
+		mBorrowedNodes = FALSE;
+	}
+
 	// Get nodes
 	if(mNbNodes!=NbTriangles-1)	// Same number of nodes => keep moving
 	{
@@ -348,6 +357,29 @@ bool AABBNoLeafTree::Build(AABBTree* tree)
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Uses an already built node array instead of building one. Child links are relative, so the
+ *	array written by a previous Build() can be used from any address without fixups.
+ *	\param		nodes		[in] borrowed nodes, must outlive the tree
+ *	\param		nb_nodes	[in] number of nodes
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool AABBNoLeafTree::Import(const AABBNoLeafNode* nodes, udword nb_nodes)
+{
+	// Checkings
+	if(!nodes || !nb_nodes)	return false;
+
+	if(mBorrowedNodes)	mNodes = null;
+	DELETEARRAY(mNodes);
+
+	mNodes = const_cast<AABBNoLeafNode*>(nodes);
+	mNbNodes = nb_nodes;
+	mBorrowedNodes = TRUE;
+	return true;
+}
+
 inline_ void ComputeMinMax(Point& min, Point& max, const VertexPointers& vp)
 {
 	// Compute triangle's AABB = a leaf box
@@ -381,6 +413,8 @@ bool AABBNoLeafTree::Refit(const MeshInterface* mesh_interface)
 {
 	// Checkings
 	if(!mesh_interface)	return false;
+	// Borrowed nodes may live in read-only memory
+	if(mBorrowedNodes)	return false;
 
 	// Bottom-up update
 	VertexPointers VP;
@@ -557,6 +591,19 @@ bool AABBNoLeafTree::Walk(GenericWalkingCallback callback, void* user_data) cons
 	/* ...remapped */												\
 	mNodes[i].member = Data;
 
+// No-leaf links are relative byte offsets, so only the node size changes
+#define REMAP_NOLEAF_DATA(member)									\
+	/* Fix data */													\
+	Data = Nodes[i].member;											\
+	if(!(Data&1))													\
+	{																\
+		/* Compute relative box number */							\
+		size_t Nb = Data/Nodes[i].GetNodeSize();					\
+		Data = Nb * mNodes[i].GetNodeSize();						\
+	}																\
+	/* ...remapped */												\
+	mNodes[i].member = Data;
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Constructor.
@@ -733,8 +780,8 @@ bool AABBQuantizedNoLeafTree::Build(AABBTree* tree)
 		for(udword i=0;i<mNbNodes;i++)
 		{
 			PERFORM_QUANTIZATION
-			REMAP_DATA(mPosData)
-			REMAP_DATA(mNegData)
+			REMAP_NOLEAF_DATA(mPosData)
+			REMAP_NOLEAF_DATA(mNegData)
 		}
 
 		DELETEARRAY(Nodes);
@@ -47,9 +47,9 @@
 		/* Leaf tests */																					\
 		inline_			BOOL				HasPosLeaf()		const	{ return (mPosData&1)!=0;			}	\
 		inline_			BOOL				HasNegLeaf()		const	{ return (mNegData&1)!=0;			}	\
-		/* Data access */																					\
-		inline_			const base_class*	GetPos()			const	{ return (base_class*)mPosData;	}	\
-		inline_			const base_class*	GetNeg()			const	{ return (base_class*)mNegData;	}	\
+		/* Data access. Child links are byte offsets from this node, so node arrays are position-independent */	\
+		inline_			const base_class*	GetPos()			const	{ return (const base_class*)(((const char*)this) + mPosData);	}	\
+		inline_			const base_class*	GetNeg()			const	{ return (const base_class*)(((const char*)this) + mNegData);	}	\
 		inline_			/*size_t*/udword				GetPosPrimitive()	const	{ return /*size_t*/udword(mPosData>>1);			}	\
 		inline_			/*size_t*/udword				GetNegPrimitive()	const	{ return /*size_t*/udword(mNegData>>1);			}	\
 		/* Stats */																							\
@@ -183,6 +183,18 @@
 	class OPCODE_API AABBNoLeafTree : public AABBOptimizedTree
 	{
 		IMPLEMENT_COLLISION_TREE(AABBNoLeafTree, AABBNoLeafNode)
+		public:
+		/**
+		 *	Uses an already built node array (e.g. a memory-mapped blob) instead of building one.
+		 *	The nodes are borrowed: they are neither copied nor freed, and must outlive the tree.
+		 *	\param		nodes		[in] nodes written from GetNodes() of a built tree
+		 *	\param		nb_nodes	[in] number of nodes
+		 *	\return		true if success
+		 */
+						bool			Import(const AABBNoLeafNode* nodes, udword nb_nodes);
+		inline_			BOOL			HasBorrowedNodes()	const	{ return mBorrowedNodes;			}
+		private:
+						BOOL			mBorrowedNodes;
 	};
 
 	class OPCODE_API AABBQuantizedTree : public AABBOptimizedTree
@@ -1,4 +1,5 @@
 #include "PDControlAdd.h"
+#include "QuaternionWithGrad.h"
 #include <algorithm>
 #include <iostream>
 
@@ -152,6 +153,106 @@ TorqueAddHelper* TorqueAddHelperCreate(
 }
 
 void TorqueAddHelperDelete(TorqueAddHelper* ptr)
+{
+	if (ptr != NULL)
+	{
+		delete ptr;
+	}
+}
+
+JointPDController::JointPDController(const dJointID* joints_, int joint_cnt, const double* kp_, const double* torque_limit_, const double* kd_) :
+	joints(joints_, joints_ + joint_cnt),
+	kp(kp_, kp_ + joint_cnt),
+	torque_limit(torque_limit_, torque_limit_ + joint_cnt),
+	local_torque(3 * joint_cnt, 0.0),
+	global_torque(3 * joint_cnt, 0.0),
+	target_quat(4 * joint_cnt, 0.0),
+	workspace(joint_cnt)
+{
+	for (int jidx = 0; jidx < joint_cnt; jidx++)
+	{
+		child_body.push_back(dJointGetBody(joints[jidx], 0)); // 0 is child, and 1 is parent
+		parent_body.push_back(dJointGetBody(joints[jidx], 1));
+		target_quat[4 * jidx + 3] = 1; // identity
+	}
+	if (kd_ != NULL)
+	{
+		kd.assign(kd_, kd_ + joint_cnt);
+	}
+}
+
+int JointPDController::GetJointCount() const
+{
+	return static_cast<int>(joints.size());
+}
+
+bool JointPDController::HasKd() const
+{
+	return !kd.empty();
+}
+
+double JointPDController::GetAccumEnergy() const
+{
+	return accum_energy;
+}
+
+void JointPDController::SetAccumEnergy(double value)
+{
+	accum_energy = value;
+}
+
+const double* JointPDController::GetLocalTorque() const
+{
+	return local_torque.data();
+}
+
+const double* JointPDController::GetGlobalTorque() const
+{
+	return global_torque.data();
+}
+
+double JointPDController::Apply(const double* target_local_qs, int input_in_scipy)
+{
+	const int joint_cnt = GetJointCount();
+	pd_control_batch(workspace, joints.data(), joint_cnt, target_local_qs, kp.data(), HasKd() ? kd.data() : NULL,
+		torque_limit.data(), local_torque.data(), global_torque.data(), input_in_scipy);
+	double power = compute_total_power(joints.data(), joint_cnt, global_torque.data());
+	accum_energy += power;
+	for (int jidx = 0; jidx < joint_cnt; jidx++)
+	{
+		const double* torque = global_torque.data() + 3 * jidx;
+		dBodyAddTorque(child_body[jidx], torque[0], torque[1], torque[2]);
+		if (parent_body[jidx] != NULL)
+		{
+			dBodyAddTorque(parent_body[jidx], -torque[0], -torque[1], -torque[2]);
+		}
+	}
+	return power;
+}
+
+void JointPDController::SetTargetRotvec(const double* rotvecs)
+{
+	const size_t joint_cnt = joints.size();
+	quat_from_rotvec_impl(rotvecs, target_quat.data(), joint_cnt);
+	flip_quat_by_w_forward_impl(target_quat.data(), target_quat.data(), joint_cnt);
+}
+
+const double* JointPDController::GetTarget() const
+{
+	return target_quat.data();
+}
+
+double JointPDController::ApplyTarget()
+{
+	return Apply(target_quat.data(), 1);
+}
+
+JointPDController* JointPDControllerCreate(const dJointID* joints_, int joint_cnt, const double* kp_, const double* torque_limit_, const double* kd_)
+{
+	return new JointPDController(joints_, joint_cnt, kp_, torque_limit_, kd_);
+}
+
+void JointPDControllerDelete(JointPDController* ptr)
 {
 	if (ptr != NULL)
 	{
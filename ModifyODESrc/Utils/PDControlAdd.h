@@ -1,6 +1,8 @@
 #pragma once
 #include <iostream>
 #include <vector>
+#include <ode/ode.h>
+#include "joint_local_quat_batch.h"
 
 class TorqueAddHelper
 {
@@ -49,4 +51,51 @@ TorqueAddHelper* TorqueAddHelperCreate(
 	const std::vector<int>& child_body_,
 	size_t body_cnt_);
 
-void TorqueAddHelperDelete(TorqueAddHelper* ptr);
\ No newline at end of file
+void TorqueAddHelperDelete(TorqueAddHelper* ptr);
+
+// Stable PD control of a character for World.dampedStep, as DampedPDControler.add_torques_by_quat:
+// the torques of pd_control_batch are added to the child (+) and parent (-) body of each joint,
+// and their power (compute_total_power) is accumulated. Nothing is allocated per call.
+class JointPDController
+{
+	std::vector<dJointID> joints;
+	std::vector<dBodyID> child_body;
+	std::vector<dBodyID> parent_body; // NULL for a joint to the world
+	std::vector<double> kp;
+	std::vector<double> kd; // empty for the stable PD, where damping is done by the joint kd in dWorldDampedStep
+	std::vector<double> torque_limit;
+	std::vector<double> local_torque;
+	std::vector<double> global_torque;
+	std::vector<double> target_quat; // target of SetTargetRotvec, in scipy order
+	PDControlWorkspace workspace;
+	double accum_energy = 0;
+
+public:
+	// kd_ may be NULL
+	JointPDController(const dJointID* joints_, int joint_cnt, const double* kp_, const double* torque_limit_, const double* kd_ = NULL);
+
+public:
+	int GetJointCount() const;
+	bool HasKd() const;
+	double GetAccumEnergy() const;
+	void SetAccumEnergy(double value);
+
+	// torques of the last Apply, in shape (joint count, 3)
+	const double* GetLocalTorque() const;
+	const double* GetGlobalTorque() const;
+
+	// target_local_qs: joint local target quaternions in shape (joint count, 4),
+	// in scipy (x, y, z, w) or ode (w, x, y, z) order. Returns the power of this call.
+	double Apply(const double* target_local_qs, int input_in_scipy);
+
+	// rotvecs: joint local targets as rotation vectors in shape (joint count, 3), converted once
+	// (quat_from_rotvec_impl, flip_quat_by_w_forward_impl) for the ApplyTarget of every substep.
+	void SetTargetRotvec(const double* rotvecs);
+	// target of SetTargetRotvec in scipy order, in shape (joint count, 4)
+	const double* GetTarget() const;
+	double ApplyTarget();
+};
+
+JointPDController* JointPDControllerCreate(const dJointID* joints_, int joint_cnt, const double* kp_, const double* torque_limit_, const double* kd_);
+
+void JointPDControllerDelete(JointPDController* ptr);
\ No newline at end of file
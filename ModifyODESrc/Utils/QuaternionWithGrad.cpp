@@ -1,4 +1,6 @@
 #include "QuaternionWithGrad.h"
+#include "QuaternionWithGradSimd.h"
+#include "batch_parallel.h"
 #ifndef _USE_MATH_DEFINES
 #define _USE_MATH_DEFINES
 #endif
@@ -56,10 +58,13 @@ void mat3_vec3_multiply_impl(
     size_t num_mat
 )
 {
-    for (size_t i = 0; i < num_mat; i++)
+    batch_parallel_for(num_mat, [&](size_t begin, size_t end)
     {
-        mat3_vec3_multiply_single(a + 9 * i, x + 3 * i, b + 3 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            mat3_vec3_multiply_single(a + 9 * i, x + 3 * i, b + 3 * i);
+        }
+    });
 }
 
 void mat3_vec3_multiply_backward_single(
@@ -97,16 +102,19 @@ void mat3_vec3_multiply_backward(
     size_t num_mat
 )
 {
-    for(size_t i = 0; i < num_mat; i++)
+    batch_parallel_for(num_mat, [&](size_t begin, size_t end)
     {
-        mat3_vec3_multiply_backward_single(
-            a + 9 * i,
-            x + 3 * i,
-            grad_in + 3 * i,
-            grad_a + 9 * i,
-            grad_x + 3 * i
-        );
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            mat3_vec3_multiply_backward_single(
+                a + 9 * i,
+                x + 3 * i,
+                grad_in + 3 * i,
+                grad_a + 9 * i,
+                grad_x + 3 * i
+            );
+        }
+    });
 }
 
 void quat_multiply_single(
@@ -134,7 +142,7 @@ void quat_multiply_single(
     #endif
 }
 
-void quat_multiply_forward(
+void quat_multiply_forward_scalar(
     const double * q1,
     const double * q2,
     double * q,
@@ -147,6 +155,26 @@ void quat_multiply_forward(
     }
 }
 
+void quat_multiply_forward(
+    const double * q1,
+    const double * q2,
+    double * q,
+    size_t num_quat
+)
+{
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
+    {
+        if (quat_simd_use_avx2())
+        {
+            quat_multiply_forward_avx2(q1 + 4 * begin, q2 + 4 * begin, q + 4 * begin, end - begin);
+        }
+        else
+        {
+            quat_multiply_forward_scalar(q1 + 4 * begin, q2 + 4 * begin, q + 4 * begin, end - begin);
+        }
+    });
+}
+
 void quat_multiply_backward_single(
     const double * q1,
     const double * q2,
@@ -180,7 +208,7 @@ void quat_multiply_backward_single(
     grad_q2[3] = + gx * x1 + gy * y1 + gz * z1 + gw * w1;
 }
 
-void quat_multiply_backward(
+void quat_multiply_backward_scalar(
     const double * q1,
     const double * q2,
     const double * grad_q,
@@ -196,6 +224,28 @@ void quat_multiply_backward(
     }
 }
 
+void quat_multiply_backward(
+    const double * q1,
+    const double * q2,
+    const double * grad_q,
+    double * grad_q1,
+    double * grad_q2,
+    size_t num_quat
+)
+{
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
+    {
+        if (quat_simd_use_avx2())
+        {
+            quat_multiply_backward_avx2(q1 + 4 * begin, q2 + 4 * begin, grad_q + 4 * begin, grad_q1 + 4 * begin, grad_q2 + 4 * begin, end - begin);
+        }
+        else
+        {
+            quat_multiply_backward_scalar(q1 + 4 * begin, q2 + 4 * begin, grad_q + 4 * begin, grad_q1 + 4 * begin, grad_q2 + 4 * begin, end - begin);
+        }
+    });
+}
+
 
 void quat_apply_single(
     const double * q,
@@ -225,7 +275,7 @@ void quat_apply_single(
     o[2] = qw*(2*qx*vy - 2*qy*vx) + qx*(-2*qx*vz + 2*qz*vx) - qy*(2*qy*vz - 2*qz*vy) + vz;
 }
 
-void quat_apply_forward(
+void quat_apply_forward_scalar(
     const double * q,
     const double * v,
     double * o,
@@ -238,6 +288,26 @@ void quat_apply_forward(
     }
 }
 
+void quat_apply_forward(
+    const double * q,
+    const double * v,
+    double * o,
+    size_t num_quat
+)
+{
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
+    {
+        if (quat_simd_use_avx2())
+        {
+            quat_apply_forward_avx2(q + 4 * begin, v + 3 * begin, o + 3 * begin, end - begin);
+        }
+        else
+        {
+            quat_apply_forward_scalar(q + 4 * begin, v + 3 * begin, o + 3 * begin, end - begin);
+        }
+    });
+}
+
 // Add by Yulong Zhang
 void quat_apply_forward_one2many(
     const double * q,
@@ -246,10 +316,13 @@ void quat_apply_forward_one2many(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_apply_single(q, v + i * 3, o + i * 3);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_apply_single(q, v + i * 3, o + i * 3);
+        }
+    });
 }
 
 void quat_apply_backward_single(
@@ -290,7 +363,7 @@ void quat_apply_backward_single(
     v_grad[2] = o_grad[0] * (2*qw*qy + 2*qx*qz)              + o_grad[1] * (-2*qw*qx + 2*qy*qz)              + o_grad[2] * (-2*qx*qx - 2*qy*qy + 1);
 }
 
-void quat_apply_backward(
+void quat_apply_backward_scalar(
     const double * q,
     const double * v,
     const double * o_grad,
@@ -305,24 +378,49 @@ void quat_apply_backward(
     }
 }
 
-void flip_quat_by_w_forward_impl(
+void quat_apply_backward(
     const double * q,
-    double * q_out,
+    const double * v,
+    const double * o_grad,
+    double * q_grad,
+    double * v_grad,
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        double flag = 1.0;
-        if (q[i * 4 + 3] < 0)
+        if (quat_simd_use_avx2())
         {
-            flag = -1.0;
+            quat_apply_backward_avx2(q + 4 * begin, v + 3 * begin, o_grad + 3 * begin, q_grad + 4 * begin, v_grad + 3 * begin, end - begin);
         }
-        for(size_t j = 0; j < 4; j++)
+        else
         {
-            q_out[i * 4 + j] = flag * q[i * 4 + j];
+            quat_apply_backward_scalar(q + 4 * begin, v + 3 * begin, o_grad + 3 * begin, q_grad + 4 * begin, v_grad + 3 * begin, end - begin);
         }
-    }
+    });
+}
+
+void flip_quat_by_w_forward_impl(
+    const double * q,
+    double * q_out,
+    size_t num_quat
+)
+{
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            double flag = 1.0;
+            if (q[i * 4 + 3] < 0)
+            {
+                flag = -1.0;
+            }
+            for(size_t j = 0; j < 4; j++)
+            {
+                q_out[i * 4 + j] = flag * q[i * 4 + j];
+            }
+        }
+    });
 }
 
 void flip_quat_by_w_backward_impl(
@@ -332,18 +430,21 @@ void flip_quat_by_w_backward_impl(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        double flag = 1.0;
-        if (q[i * 4 + 3] < 0)
-        {
-            flag = -1.0;
-        }
-        for(size_t j = 0; j < 4; j++)
+        for(size_t i = begin; i < end; i++)
         {
-            grad_out[i * 4 + j] = flag * grad_in[i * 4 + j];
+            double flag = 1.0;
+            if (q[i * 4 + 3] < 0)
+            {
+                flag = -1.0;
+            }
+            for(size_t j = 0; j < 4; j++)
+            {
+                grad_out[i * 4 + j] = flag * grad_in[i * 4 + j];
+            }
         }
-    }
+    });
 }
 
 void quat_to_vec6d_single(
@@ -362,10 +463,38 @@ void quat_to_vec6d_single(
 
 void quat_to_vec6d_impl(const double * q, double * vec6d, size_t num_quat)
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_to_vec6d_single(q + 4 * i, vec6d + 6 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_to_vec6d_single(q + 4 * i, vec6d + 6 * i);
+        }
+    });
+}
+
+void quat_to_vec6d_backward_single(
+    const double * q,
+    const double * grad_in,
+    double * grad_out
+)
+{
+    double grad_mat[9] = {
+        grad_in[0], grad_in[1], 0.0,
+        grad_in[2], grad_in[3], 0.0,
+        grad_in[4], grad_in[5], 0.0
+    };
+    quat_to_matrix_backward_single(q, grad_mat, grad_out);
+}
+
+void quat_to_vec6d_backward(const double * q, const double * grad_in, double * grad_out, size_t num_quat)
+{
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_to_vec6d_backward_single(q + 4 * i, grad_in + 6 * i, grad_out + 4 * i);
+        }
+    });
 }
 
 void quat_to_matrix_forward_single(
@@ -382,7 +511,7 @@ void quat_to_matrix_forward_single(
     mat[6] = 2 * (xz - yw);      mat[7] = 2 * (yz + xw);        mat[8] = - x2 - y2 + z2 + w2;
 }
 
-void quat_to_matrix_impl(
+void quat_to_matrix_impl_scalar(
     const double * q,
     double * mat,
     size_t num_quat
@@ -394,6 +523,25 @@ void quat_to_matrix_impl(
     }
 }
 
+void quat_to_matrix_impl(
+    const double * q,
+    double * mat,
+    size_t num_quat
+)
+{
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
+    {
+        if (quat_simd_use_avx2())
+        {
+            quat_to_matrix_impl_avx2(q + 4 * begin, mat + 9 * begin, end - begin);
+        }
+        else
+        {
+            quat_to_matrix_impl_scalar(q + 4 * begin, mat + 9 * begin, end - begin);
+        }
+    });
+}
+
 // Add by Yulong Zhang
 void six_dim_mat_to_quat_single(
     const double * mat,
@@ -450,7 +598,7 @@ void six_dim_mat_to_quat_single(
     quat[3] = q[0];
 }
 
-void six_dim_mat_to_quat_impl(
+void six_dim_mat_to_quat_impl_scalar(
     const double * mat,
     double * q,
     size_t num_quat
@@ -462,6 +610,25 @@ void six_dim_mat_to_quat_impl(
     }
 }
 
+void six_dim_mat_to_quat_impl(
+    const double * mat,
+    double * q,
+    size_t num_quat
+)
+{
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
+    {
+        if (quat_simd_use_avx2())
+        {
+            six_dim_mat_to_quat_impl_avx2(mat + 6 * begin, q + 4 * begin, end - begin);
+        }
+        else
+        {
+            six_dim_mat_to_quat_impl_scalar(mat + 6 * begin, q + 4 * begin, end - begin);
+        }
+    });
+}
+
 void quat_to_matrix_backward_single(
     const double * q,
     const double * grad_in,
@@ -499,10 +666,13 @@ void quat_to_matrix_backward(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_to_matrix_backward_single(q + 4 * i, grad_in + 9 * i, grad_out + 4 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_to_matrix_backward_single(q + 4 * i, grad_in + 9 * i, grad_out + 4 * i);
+        }
+    });
 }
 
 void vector_cross_forward_single(
@@ -534,10 +704,13 @@ void vector_cross_forward_impl(
     size_t num_vec
 )
 {
-    for(size_t i = 0; i < num_vec; i++)
+    batch_parallel_for(num_vec, [&](size_t begin, size_t end)
     {
-        vector_cross_forward_single(a + 3 * i, b + 3 * i, result + 3 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            vector_cross_forward_single(a + 3 * i, b + 3 * i, result + 3 * i);
+        }
+    });
 }
 
 void vector_cross_backward_impl(
@@ -549,16 +722,19 @@ void vector_cross_backward_impl(
     size_t num_vec
 )
 {
-    for(size_t i = 0; i < num_vec; i++)
+    batch_parallel_for(num_vec, [&](size_t begin, size_t end)
     {
-        vector_cross_backward_single(
-            a + 3 * i,
-            b + 3 * i,
-            grad_in + 3 * i,
-            grad_a + 3 * i,
-            grad_b + 3 * i
-        );
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            vector_cross_backward_single(
+                a + 3 * i,
+                b + 3 * i,
+                grad_in + 3 * i,
+                grad_a + 3 * i,
+                grad_b + 3 * i
+            );
+        }
+    });
 }
 
 void vector_to_cross_matrix_single(
@@ -578,10 +754,13 @@ void vector_to_cross_matrix_impl(
     size_t num_vec
 )
 {
-    for(size_t i = 0; i < num_vec; i++)
+    batch_parallel_for(num_vec, [&](size_t begin, size_t end)
     {
-        vector_to_cross_matrix_single(vec + 3 * i, mat + 9 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            vector_to_cross_matrix_single(vec + 3 * i, mat + 9 * i);
+        }
+    });
 }
 
 void vector_to_cross_matrix_backward_single(
@@ -602,10 +781,13 @@ void vector_to_cross_matrix_backward(
     size_t num_vec
 )
 {
-    for(size_t i = 0; i < num_vec; i++)
+    batch_parallel_for(num_vec, [&](size_t begin, size_t end)
     {
-        vector_to_cross_matrix_backward_single(vec + 3 * i, grad_in + 9 * i, grad_out + 3 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            vector_to_cross_matrix_backward_single(vec + 3 * i, grad_in + 9 * i, grad_out + 3 * i);
+        }
+    });
 }
 
 void quat_to_rotvec_single(
@@ -639,7 +821,7 @@ void quat_to_rotvec_single(
     rotvec[2] = scale * qz;
 }
 
-void quat_to_rotvec_impl(
+void quat_to_rotvec_impl_scalar(
     const double * q,
     double * angle,
     double * rotvec,
@@ -652,6 +834,26 @@ void quat_to_rotvec_impl(
     }
 }
 
+void quat_to_rotvec_impl(
+    const double * q,
+    double * angle,
+    double * rotvec,
+    size_t num_quat
+)
+{
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
+    {
+        if (quat_simd_use_avx2())
+        {
+            quat_to_rotvec_impl_avx2(q + 4 * begin, angle + begin, rotvec + 3 * begin, end - begin);
+        }
+        else
+        {
+            quat_to_rotvec_impl_scalar(q + 4 * begin, angle + begin, rotvec + 3 * begin, end - begin);
+        }
+    });
+}
+
 void quat_to_rotvec_backward_single(
     const double * q,
     double angle,
@@ -773,10 +975,13 @@ void quat_to_rotvec_backward(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_to_rotvec_backward_single(q + 4 * i, angle[i], grad_in + 3 * i, grad_out + 4 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_to_rotvec_backward_single(q + 4 * i, angle[i], grad_in + 3 * i, grad_out + 4 * i);
+        }
+    });
 }
 
 void quat_from_rotvec_single(const double * rotvec, double * q)
@@ -801,7 +1006,7 @@ void quat_from_rotvec_single(const double * rotvec, double * q)
     q[3] = std::cos(half_angle);
 }
 
-void quat_from_rotvec_impl(const double * rotvec, double * q, size_t num_quat)
+void quat_from_rotvec_impl_scalar(const double * rotvec, double * q, size_t num_quat)
 {
     for(size_t i = 0; i < num_quat; i++)
     {
@@ -809,6 +1014,21 @@ void quat_from_rotvec_impl(const double * rotvec, double * q, size_t num_quat)
     }
 }
 
+void quat_from_rotvec_impl(const double * rotvec, double * q, size_t num_quat)
+{
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
+    {
+        if (quat_simd_use_avx2())
+        {
+            quat_from_rotvec_impl_avx2(rotvec + 3 * begin, q + 4 * begin, end - begin);
+        }
+        else
+        {
+            quat_from_rotvec_impl_scalar(rotvec + 3 * begin, q + 4 * begin, end - begin);
+        }
+    });
+}
+
 void quat_from_rotvec_backward_single(const double * rotvec, const double * grad_in, double * grad_out)
 {
     double sqr_angle = rotvec[0] * rotvec[0] + rotvec[1] * rotvec[1] + rotvec[2] * rotvec[2];
@@ -823,10 +1043,10 @@ void quat_from_rotvec_backward_single(const double * rotvec, const double * grad
     {
         double sin_div = 0.5;
         double ratio_w = -0.5 * sin_div;
-        double angle4 = angle * angle;
-        double basic0 = sqr_angle / 960 - 24;
+        double angle4 = sqr_angle * sqr_angle;
+        double basic0 = sqr_angle / 960 - 1.0 / 24;
         double basic1 = 0.5 - sqr_angle / 48 + angle4 / 3840;
-        //x*y*(sqr_angle/960 - 24)
+        //x*y*(sqr_angle/960 - 1/24)
         //-sqr_angle/48 + x*(x*sqr_angle/960 - x/24) + angle4/3840 + 0.5
         double grad_table[4][3] = {
             {x * x * basic0 + basic1, x * y * basic0         , x * z * basic0         },
@@ -876,10 +1096,13 @@ void quat_from_rotvec_backward_impl(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_from_rotvec_backward_single(rotvec + 3 * i, grad_in + 4 * i, grad_out + 3 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_from_rotvec_backward_single(rotvec + 3 * i, grad_in + 4 * i, grad_out + 3 * i);
+        }
+    });
 }
 
 void quat_from_matrix_single(
@@ -949,10 +1172,13 @@ void quat_from_matrix_impl(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_from_matrix_single(mat + 9 * i, q + 4 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_from_matrix_single(mat + 9 * i, q + 4 * i);
+        }
+    });
 }
 
 void quat_from_matrix_backward_single(
@@ -971,10 +1197,13 @@ void quat_from_matrix_backward_impl(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_from_matrix_backward_single(mat + 9 * i, grad_in + 4 * i, grad_out + 9 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_from_matrix_backward_single(mat + 9 * i, grad_in + 4 * i, grad_out + 9 * i);
+        }
+    });
 }
 
 void quat_to_hinge_angle_single(
@@ -1015,10 +1244,13 @@ void quat_to_hinge_angle_forward(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_to_hinge_angle_single(q + 4 * i, axis + 3 * i, angle[i]);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_to_hinge_angle_single(q + 4 * i, axis + 3 * i, angle[i]);
+        }
+    });
 }
 
 void quat_to_hinge_angle_backward_single(
@@ -1062,10 +1294,13 @@ void quat_to_hinge_angle_backward(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_to_hinge_angle_backward_single(q + 4 * i, axis + 3 * i, grad_in[i], grad_out + 4 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_to_hinge_angle_backward_single(q + 4 * i, axis + 3 * i, grad_in[i], grad_out + 4 * i);
+        }
+    });
 }
 
 void quat_inv_single(
@@ -1088,10 +1323,13 @@ void quat_inv_impl(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_inv_single(q + 4 * i, out_q + 4 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_inv_single(q + 4 * i, out_q + 4 * i);
+        }
+    });
 }
 
 void quat_inv_backward_single(
@@ -1113,10 +1351,13 @@ void quat_inv_backward_impl(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_inv_backward_single(q + 4 * i, grad_in + 4 * i, grad_out + 4 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_inv_backward_single(q + 4 * i, grad_in + 4 * i, grad_out + 4 * i);
+        }
+    });
 }
 
 // This function is called by diffode when compute hinge angle..
@@ -1161,10 +1402,13 @@ void parent_child_quat_to_hinge_angle(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        parent_child_quat_to_hinge_angle_single(quat0 + 4 * i, quat1 + 4 * i, init_rel_quat_inv + 4 * i, axis + 3 * i, angle[i]);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            parent_child_quat_to_hinge_angle_single(quat0 + 4 * i, quat1 + 4 * i, init_rel_quat_inv + 4 * i, axis + 3 * i, angle[i]);
+        }
+    });
 }
 
 void parent_child_quat_to_hinge_angle_backward_single(
@@ -1210,12 +1454,15 @@ void parent_child_quat_to_hinge_angle_backward(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        parent_child_quat_to_hinge_angle_backward_single(
-            quat0 + 4 * i, quat1 + 4 * i, init_rel_quat_inv + 4 * i,
-            axis + 3 * i, grad_in[i], quat0_grad + 4 * i, quat1_grad + 4 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            parent_child_quat_to_hinge_angle_backward_single(
+                quat0 + 4 * i, quat1 + 4 * i, init_rel_quat_inv + 4 * i,
+                axis + 3 * i, grad_in[i], quat0_grad + 4 * i, quat1_grad + 4 * i);
+        }
+    });
 }
 
 void vector_normalize_single(
@@ -1303,21 +1550,24 @@ void normalize_quaternion_impl(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        double sum_value = 0.0;
-        const double * q = q_in + 4 * i;
-        double * o = q_out + 4 * i;
-        for(int j = 0; j < 4; j++)
-        {
-            sum_value += q[j] * q[j];
-        }
-        sum_value = 1.0 / std::sqrt(sum_value);
-        for(int j = 0; j < 4; j++)
+        for(size_t i = begin; i < end; i++)
         {
-            o[j] = q[j] * sum_value;
+            double sum_value = 0.0;
+            const double * q = q_in + 4 * i;
+            double * o = q_out + 4 * i;
+            for(int j = 0; j < 4; j++)
+            {
+                sum_value += q[j] * q[j];
+            }
+            sum_value = 1.0 / std::sqrt(sum_value);
+            for(int j = 0; j < 4; j++)
+            {
+                o[j] = q[j] * sum_value;
+            }
         }
-    }
+    });
 }
 
 void normalize_quaternion_backward_impl(
@@ -1327,10 +1577,13 @@ void normalize_quaternion_backward_impl(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        vector_normalize_backward_single(q_in + 4 * i, 4, grad_in + 4 * i, grad_out + 4 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            vector_normalize_backward_single(q_in + 4 * i, 4, grad_in + 4 * i, grad_out + 4 * i);
+        }
+    });
 }
 
 void quat_integrate_single(
@@ -1366,10 +1619,13 @@ void quat_integrate_impl(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_integrate_single(q + 4 * i, omega + 3 * i, dt, result + 4 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_integrate_single(q + 4 * i, omega + 3 * i, dt, result + 4 * i);
+        }
+    });
 }
 
 void quat_integrate_backward_single(
@@ -1419,10 +1675,13 @@ void quat_integrate_backward(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        quat_integrate_backward_single(q + 4 * i, omega + 3 * i, dt, grad_in + 4 * i, q_grad + 4 * i, omega_grad + 3 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            quat_integrate_backward_single(q + 4 * i, omega + 3 * i, dt, grad_in + 4 * i, q_grad + 4 * i, omega_grad + 3 * i);
+        }
+    });
 }
 
 // Add by Yulong Zhang
@@ -1522,10 +1781,13 @@ void clip_vec3_arr_by_length_forward(
     size_t num_vecs
 )
 {
-    for(size_t i = 0; i < num_vecs; i++)
+    batch_parallel_for(num_vecs, [&](size_t begin, size_t end)
     {
-        clip_vec_by_length_forward(x + 3 * i, max_len[i], result + 3 * i, 3);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            clip_vec_by_length_forward(x + 3 * i, max_len[i], result + 3 * i, 3);
+        }
+    });
 }
 
 void clip_vec_by_length_backward(
@@ -1566,10 +1828,13 @@ void clip_vec3_arr_by_length_backward(
     size_t num_vecs
 )
 {
-    for(size_t i = 0; i < num_vecs; i++)
+    batch_parallel_for(num_vecs, [&](size_t begin, size_t end)
     {
-        clip_vec_by_length_backward(x + 3 * i, max_len[i], grad_in + 3 * i, grad_out + 3 * i, 3);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            clip_vec_by_length_backward(x + 3 * i, max_len[i], grad_in + 3 * i, grad_out + 3 * i, 3);
+        }
+    });
 }
 
 void decompose_rotation_single(
@@ -1600,10 +1865,13 @@ void decompose_rotation(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        decompose_rotation_single(q + 4 * i, v + 3 * i, result + 4 * i);
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            decompose_rotation_single(q + 4 * i, v + 3 * i, result + 4 * i);
+        }
+    });
 }
 
 void decompose_rotation_pair_single(
@@ -1648,15 +1916,18 @@ void decompose_rotation_pair(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        decompose_rotation_pair_single(
-            q + 4 * i,
-            vb + 3 * i,
-            q_a + 4 * i,
-            q_b + 4 * i
-        );
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            decompose_rotation_pair_single(
+                q + 4 * i,
+                vb + 3 * i,
+                q_a + 4 * i,
+                q_b + 4 * i
+            );
+        }
+    });
 }
 
 void decompose_rotation_pair_one2many(
@@ -1667,15 +1938,18 @@ void decompose_rotation_pair_one2many(
     size_t num_quat
 )
 {
-    for(size_t i = 0; i < num_quat; i++)
+    batch_parallel_for(num_quat, [&](size_t begin, size_t end)
     {
-        decompose_rotation_pair_single(
-            q + 4 * i,
-            vb,
-            q_a + 4 * i,
-            q_b + 4 * i
-        );
-    }
+        for(size_t i = begin; i < end; i++)
+        {
+            decompose_rotation_pair_single(
+                q + 4 * i,
+                vb,
+                q_a + 4 * i,
+                q_b + 4 * i
+            );
+        }
+    });
 }
 
 void decompose_rotation_backward_single(
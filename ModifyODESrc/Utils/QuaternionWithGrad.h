@@ -131,6 +131,15 @@ void quat_to_vec6d_single(
 
 void quat_to_vec6d_impl(const double * q, double * vec6d, size_t num_quat);
 
+// vec6d is the first 2 columns of the rotation matrix, so this is quat_to_matrix_backward_single
+void quat_to_vec6d_backward_single(
+    const double * q,
+    const double * grad_in,
+    double * grad_out
+);
+
+void quat_to_vec6d_backward(const double * q, const double * grad_in, double * grad_out, size_t num_quat);
+
 void quat_to_matrix_forward_single(
     const double * q,
     double * mat
@@ -0,0 +1,501 @@
+#include "QuaternionWithGrad.h"
+#include "QuaternionWithGradSimd.h"
+#include <atomic>
+#include <cmath>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define QUAT_SIMD_AVX2 1
+#define QUAT_AVX2_TARGET __attribute__((target("avx2,fma")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define QUAT_SIMD_AVX2 1
+#define QUAT_AVX2_TARGET
+#include <immintrin.h>
+#include <intrin.h>
+#else
+#define QUAT_SIMD_AVX2 0
+#endif
+
+namespace
+{
+    int detect_avx2()
+    {
+    #if QUAT_SIMD_AVX2 && defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return 0;
+        __cpuid(info, 1);
+        const bool fma = (info[2] & (1 << 12)) != 0, osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+        if (!fma || !osxsave || !avx) return 0;
+        if ((_xgetbv(0) & 6) != 6) return 0; // xmm and ymm state saved by the os
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    #elif QUAT_SIMD_AVX2
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    #else
+        return 0;
+    #endif
+    }
+
+    std::atomic<int> simd_enabled(1);
+}
+
+int quat_simd_avx2_supported()
+{
+    static const int supported = detect_avx2();
+    return supported;
+}
+
+void quat_simd_set_enabled(int enabled)
+{
+    simd_enabled.store(enabled ? 1 : 0, std::memory_order_relaxed);
+}
+
+int quat_simd_get_enabled()
+{
+    return simd_enabled.load(std::memory_order_relaxed);
+}
+
+int quat_simd_use_avx2()
+{
+    return quat_simd_get_enabled() && quat_simd_avx2_supported();
+}
+
+#if QUAT_SIMD_AVX2
+
+namespace
+{
+    // rows r0..r3 to columns, in place
+    QUAT_AVX2_TARGET inline void transpose4(__m256d & r0, __m256d & r1, __m256d & r2, __m256d & r3)
+    {
+        __m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1);
+        __m256d t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+        r0 = _mm256_permute2f128_pd(t0, t2, 0x20);
+        r1 = _mm256_permute2f128_pd(t1, t3, 0x20);
+        r2 = _mm256_permute2f128_pd(t0, t2, 0x31);
+        r3 = _mm256_permute2f128_pd(t1, t3, 0x31);
+    }
+
+    QUAT_AVX2_TARGET inline __m256i mask3()
+    {
+        return _mm256_setr_epi64x(-1, -1, -1, 0);
+    }
+
+    // 4 quaternions (x, y, z, w) starting at q
+    QUAT_AVX2_TARGET inline void load_quat4(const double * q, __m256d & x, __m256d & y, __m256d & z, __m256d & w)
+    {
+        x = _mm256_loadu_pd(q); y = _mm256_loadu_pd(q + 4); z = _mm256_loadu_pd(q + 8); w = _mm256_loadu_pd(q + 12);
+        transpose4(x, y, z, w);
+    }
+
+    QUAT_AVX2_TARGET inline void store_quat4(double * q, __m256d x, __m256d y, __m256d z, __m256d w)
+    {
+        transpose4(x, y, z, w);
+        _mm256_storeu_pd(q, x); _mm256_storeu_pd(q + 4, y); _mm256_storeu_pd(q + 8, z); _mm256_storeu_pd(q + 12, w);
+    }
+
+    // 4 vectors of 3 starting at v. The last row is a masked load, so nothing past v[11] is read.
+    QUAT_AVX2_TARGET inline void load_vec3x4(const double * v, __m256d & x, __m256d & y, __m256d & z)
+    {
+        __m256d r0 = _mm256_loadu_pd(v), r1 = _mm256_loadu_pd(v + 3), r2 = _mm256_loadu_pd(v + 6);
+        __m256d r3 = _mm256_maskload_pd(v + 9, mask3());
+        transpose4(r0, r1, r2, r3);
+        x = r0; y = r1; z = r2;
+    }
+
+    // the rows overlap by one element, and are written in order, so every element ends as its own value.
+    QUAT_AVX2_TARGET inline void store_vec3x4(double * v, __m256d x, __m256d y, __m256d z)
+    {
+        __m256d r3 = _mm256_setzero_pd();
+        transpose4(x, y, z, r3);
+        _mm256_storeu_pd(v, x);
+        _mm256_storeu_pd(v + 3, y);
+        _mm256_storeu_pd(v + 6, z);
+        _mm256_maskstore_pd(v + 9, mask3(), r3);
+    }
+
+    QUAT_AVX2_TARGET inline __m256d mul(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+    QUAT_AVX2_TARGET inline __m256d add(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+    QUAT_AVX2_TARGET inline __m256d sub(__m256d a, __m256d b) { return _mm256_sub_pd(a, b); }
+    QUAT_AVX2_TARGET inline __m256d div(__m256d a, __m256d b) { return _mm256_div_pd(a, b); }
+    // a * b + c
+    QUAT_AVX2_TARGET inline __m256d fma(__m256d a, __m256d b, __m256d c) { return _mm256_fmadd_pd(a, b, c); }
+    // a * b - c
+    QUAT_AVX2_TARGET inline __m256d fms(__m256d a, __m256d b, __m256d c) { return _mm256_fmsub_pd(a, b, c); }
+    // c - a * b
+    QUAT_AVX2_TARGET inline __m256d fnma(__m256d a, __m256d b, __m256d c) { return _mm256_fnmadd_pd(a, b, c); }
+    QUAT_AVX2_TARGET inline __m256d splat(double a) { return _mm256_set1_pd(a); }
+}
+
+QUAT_AVX2_TARGET void quat_multiply_forward_avx2(
+    const double * q1,
+    const double * q2,
+    double * q,
+    size_t num_quat
+)
+{
+    size_t i = 0;
+#if !FLIP_QUAT_AT_MULTIPLY
+    for(; i + 4 <= num_quat; i += 4)
+    {
+        __m256d x1, y1, z1, w1, x2, y2, z2, w2;
+        load_quat4(q1 + 4 * i, x1, y1, z1, w1);
+        load_quat4(q2 + 4 * i, x2, y2, z2, w2);
+        __m256d x = fma(w1, x2, fma(y1, z2, fms(x1, w2, mul(z1, y2))));
+        __m256d y = fma(z1, x2, fma(w1, y2, fms(y1, w2, mul(x1, z2))));
+        __m256d z = fma(x1, y2, fma(w1, z2, fms(z1, w2, mul(y1, x2))));
+        __m256d w = fnma(x1, x2, fnma(y1, y2, fnma(z1, z2, mul(w1, w2))));
+        store_quat4(q + 4 * i, x, y, z, w);
+    }
+#endif
+    for(; i < num_quat; i++)
+    {
+        quat_multiply_single(q1 + 4 * i, q2 + 4 * i, q + 4 * i);
+    }
+}
+
+QUAT_AVX2_TARGET void quat_multiply_backward_avx2(
+    const double * q1,
+    const double * q2,
+    const double * grad_q,
+    double * grad_q1,
+    double * grad_q2,
+    size_t num_quat
+)
+{
+    size_t i = 0;
+#if !FLIP_QUAT_AT_MULTIPLY
+    for(; i + 4 <= num_quat; i += 4)
+    {
+        __m256d x1, y1, z1, w1, x2, y2, z2, w2, gx, gy, gz, gw;
+        load_quat4(q1 + 4 * i, x1, y1, z1, w1);
+        load_quat4(q2 + 4 * i, x2, y2, z2, w2);
+        load_quat4(grad_q + 4 * i, gx, gy, gz, gw);
+        store_quat4(grad_q1 + 4 * i,
+            fnma(gy, z2, fma(gz, y2, fms(gx, w2, mul(gw, x2)))),
+            fma(gx, z2, fms(gy, w2, fma(gz, x2, mul(gw, y2)))),
+            fma(gy, x2, fms(gz, w2, fma(gx, y2, mul(gw, z2)))),
+            fma(gx, x2, fma(gy, y2, fma(gz, z2, mul(gw, w2)))));
+        store_quat4(grad_q2 + 4 * i,
+            fma(gx, w1, fms(gy, z1, fma(gz, y1, mul(gw, x1)))),
+            fma(gz, x1, fms(gy, w1, fma(gx, z1, mul(gw, y1)))),
+            fma(gx, y1, fms(gz, w1, fma(gy, x1, mul(gw, z1)))),
+            fma(gx, x1, fma(gy, y1, fma(gz, z1, mul(gw, w1)))));
+    }
+#endif
+    for(; i < num_quat; i++)
+    {
+        quat_multiply_backward_single(
+            q1 + 4 * i, q2 + 4 * i, grad_q + 4 * i, grad_q1 + 4 * i, grad_q2 + 4 * i);
+    }
+}
+
+QUAT_AVX2_TARGET void quat_apply_forward_avx2(
+    const double * q,
+    const double * v,
+    double * o,
+    size_t num_quat
+)
+{
+    const __m256d two = splat(2.0);
+    size_t i = 0;
+    for(; i + 4 <= num_quat; i += 4)
+    {
+        __m256d qx, qy, qz, qw, vx, vy, vz;
+        load_quat4(q + 4 * i, qx, qy, qz, qw);
+        load_vec3x4(v + 3 * i, vx, vy, vz);
+        // t = 2 u x v, o = v + qw * t + u x t
+        __m256d tx = mul(two, fms(qy, vz, mul(qz, vy)));
+        __m256d ty = mul(two, fms(qz, vx, mul(qx, vz)));
+        __m256d tz = mul(two, fms(qx, vy, mul(qy, vx)));
+        __m256d ox = fma(qw, tx, add(vx, fms(qy, tz, mul(qz, ty))));
+        __m256d oy = fma(qw, ty, add(vy, fms(qz, tx, mul(qx, tz))));
+        __m256d oz = fma(qw, tz, add(vz, fms(qx, ty, mul(qy, tx))));
+        store_vec3x4(o + 3 * i, ox, oy, oz);
+    }
+    for(; i < num_quat; i++)
+    {
+        quat_apply_single(q + i * 4, v + i * 3, o + i * 3);
+    }
+}
+
+QUAT_AVX2_TARGET void quat_apply_backward_avx2(
+    const double * q,
+    const double * v,
+    const double * o_grad,
+    double * q_grad,
+    double * v_grad,
+    size_t num_quat
+)
+{
+    const __m256d one = splat(1.0), two = splat(2.0);
+    size_t i = 0;
+    for(; i + 4 <= num_quat; i += 4)
+    {
+        __m256d qx, qy, qz, qw, vx, vy, vz, g0, g1, g2;
+        load_quat4(q + 4 * i, qx, qy, qz, qw);
+        load_vec3x4(v + 3 * i, vx, vy, vz);
+        load_vec3x4(o_grad + 3 * i, g0, g1, g2);
+        __m256d qx2 = mul(two, qx), qy2 = mul(two, qy), qz2 = mul(two, qz), qw2 = mul(two, qw);
+        __m256d qx4 = mul(two, qx2), qy4 = mul(two, qy2), qz4 = mul(two, qz2);
+
+        // rows of the jacobian, as in quat_apply_backward_single
+        __m256d dx0 = fma(qy2, vy, mul(qz2, vz));
+        __m256d dx1 = fma(qy2, vx, fnma(qx4, vy, mul(splat(-2.0), mul(qw, vz))));
+        __m256d dx2 = fma(qz2, vx, fnma(qx4, vz, mul(qw2, vy)));
+        __m256d dy0 = fnma(qy4, vx, fma(qx2, vy, mul(qw2, vz)));
+        __m256d dy1 = fma(qx2, vx, mul(qz2, vz));
+        __m256d dy2 = fma(qz2, vy, fnma(qy4, vz, mul(splat(-2.0), mul(qw, vx))));
+        __m256d dz0 = fnma(qz4, vx, fms(qx2, vz, mul(qw2, vy)));
+        __m256d dz1 = fnma(qz4, vy, fma(qy2, vz, mul(qw2, vx)));
+        __m256d dz2 = fma(qx2, vx, mul(qy2, vy));
+        __m256d dw0 = fms(qy2, vz, mul(qz2, vy));
+        __m256d dw1 = fms(qz2, vx, mul(qx2, vz));
+        __m256d dw2 = fms(qx2, vy, mul(qy2, vx));
+        store_quat4(q_grad + 4 * i,
+            fma(g2, dx2, fma(g1, dx1, mul(g0, dx0))),
+            fma(g2, dy2, fma(g1, dy1, mul(g0, dy0))),
+            fma(g2, dz2, fma(g1, dz1, mul(g0, dz0))),
+            fma(g2, dw2, fma(g1, dw1, mul(g0, dw0))));
+
+        // v_grad = R^T o_grad
+        __m256d xx = mul(qx2, qx), yy = mul(qy2, qy), zz = mul(qz2, qz);
+        __m256d xy = mul(qx2, qy), xz = mul(qx2, qz), yz = mul(qy2, qz);
+        __m256d wx = mul(qw2, qx), wy = mul(qw2, qy), wz = mul(qw2, qz);
+        __m256d m00 = sub(sub(one, yy), zz), m11 = sub(sub(one, xx), zz), m22 = sub(sub(one, xx), yy);
+        store_vec3x4(v_grad + 3 * i,
+            fma(g2, sub(xz, wy), fma(g1, add(wz, xy), mul(g0, m00))),
+            fma(g2, add(wx, yz), fma(g1, m11, mul(g0, sub(xy, wz)))),
+            fma(g2, m22, fma(g1, sub(yz, wx), mul(g0, add(wy, xz)))));
+    }
+    for(; i < num_quat; i++)
+    {
+        quat_apply_backward_single(q + i * 4, v + i * 3, o_grad + i * 3, q_grad + i * 4, v_grad + i * 3);
+    }
+}
+
+QUAT_AVX2_TARGET void quat_to_matrix_impl_avx2(
+    const double * q,
+    double * mat,
+    size_t num_quat
+)
+{
+    const __m256d two = splat(2.0);
+    size_t i = 0;
+    for(; i + 4 <= num_quat; i += 4)
+    {
+        __m256d x, y, z, w;
+        load_quat4(q + 4 * i, x, y, z, w);
+        __m256d x2 = mul(x, x), y2 = mul(y, y), z2 = mul(z, z), w2 = mul(w, w);
+        __m256d xy = mul(x, y), zw = mul(z, w), xz = mul(x, z), yw = mul(y, w), yz = mul(y, z), xw = mul(x, w);
+
+        __m256d m0 = add(sub(sub(x2, y2), z2), w2), m1 = mul(two, sub(xy, zw)), m2 = mul(two, add(xz, yw));
+        __m256d m3 = mul(two, add(xy, zw)), m4 = add(sub(sub(y2, x2), z2), w2), m5 = mul(two, sub(yz, xw));
+        __m256d m6 = mul(two, sub(xz, yw)), m7 = mul(two, add(yz, xw)), m8 = add(sub(sub(z2, x2), y2), w2);
+
+        // elements 0..3 and 4..7 of each matrix as two 4x4 blocks, element 8 one by one
+        double * out = mat + 9 * i;
+        transpose4(m0, m1, m2, m3);
+        transpose4(m4, m5, m6, m7);
+        _mm256_storeu_pd(out, m0); _mm256_storeu_pd(out + 4, m4);
+        _mm256_storeu_pd(out + 9, m1); _mm256_storeu_pd(out + 13, m5);
+        _mm256_storeu_pd(out + 18, m2); _mm256_storeu_pd(out + 22, m6);
+        _mm256_storeu_pd(out + 27, m3); _mm256_storeu_pd(out + 31, m7);
+        __m128d lo = _mm256_castpd256_pd128(m8), hi = _mm256_extractf128_pd(m8, 1);
+        _mm_storel_pd(out + 8, lo); _mm_storeh_pd(out + 17, lo);
+        _mm_storel_pd(out + 26, hi); _mm_storeh_pd(out + 35, hi);
+    }
+    for(; i < num_quat; i++)
+    {
+        quat_to_matrix_forward_single(q + 4 * i, mat + 9 * i);
+    }
+}
+
+QUAT_AVX2_TARGET void six_dim_mat_to_quat_impl_avx2(
+    const double * mat,
+    double * q,
+    size_t num_quat
+)
+{
+    const __m256d one = splat(1.0), four = splat(4.0);
+    size_t i = 0;
+    for(; i + 4 <= num_quat; i += 4)
+    {
+        const double * m = mat + 6 * i;
+        __m256d x1 = _mm256_loadu_pd(m), x2 = _mm256_loadu_pd(m + 6);
+        __m256d y1 = _mm256_loadu_pd(m + 12), y2 = _mm256_loadu_pd(m + 18);
+        transpose4(x1, x2, y1, y2);
+        __m256d p02 = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(m + 4)), _mm_loadu_pd(m + 16), 1);
+        __m256d p13 = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(m + 10)), _mm_loadu_pd(m + 22), 1);
+        __m256d z1 = _mm256_unpacklo_pd(p02, p13), z2 = _mm256_unpackhi_pd(p02, p13);
+
+        // same operation order as six_dim_mat_to_quat_single, without fma
+        __m256d x3 = sub(mul(y1, z2), mul(y2, z1)), y3 = add(mul(sub(_mm256_setzero_pd(), x1), z2), mul(x2, z1)), z3 = sub(mul(x1, y2), mul(x2, y1));
+        x2 = sub(mul(y3, z1), mul(y1, z3)); y2 = add(mul(sub(_mm256_setzero_pd(), x3), z1), mul(x1, z3)); z2 = sub(mul(x3, y1), mul(x1, y3));
+        __m256d norm1 = _mm256_sqrt_pd(add(add(mul(x1, x1), mul(y1, y1)), mul(z1, z1)));
+        __m256d norm2 = _mm256_sqrt_pd(add(add(mul(x2, x2), mul(y2, y2)), mul(z2, z2)));
+        __m256d norm3 = _mm256_sqrt_pd(add(add(mul(x3, x3), mul(y3, y3)), mul(z3, z3)));
+        x1 = div(x1, norm1); x2 = div(x2, norm2); x3 = div(x3, norm3);
+        y1 = div(y1, norm1); y2 = div(y2, norm2); y3 = div(y3, norm3);
+        z1 = div(z1, norm1); z2 = div(z2, norm2); z3 = div(z3, norm3);
+        __m256d w0 = add(add(x1, y2), z3);
+        __m256d w1 = sub(sub(x1, y2), z3);
+        __m256d w2 = sub(sub(y2, x1), z3);
+        __m256d w3 = sub(sub(z3, x1), y2);
+
+        // the largest of x1 (sic), w1, w2, w3 as in the scalar version, the first one on ties
+        __m256d val = x1, wsel = w0;
+        __m256d is1 = _mm256_cmp_pd(w1, val, _CMP_GT_OQ);
+        val = _mm256_blendv_pd(val, w1, is1); wsel = _mm256_blendv_pd(wsel, w1, is1);
+        __m256d is2 = _mm256_cmp_pd(w2, val, _CMP_GT_OQ);
+        val = _mm256_blendv_pd(val, w2, is2); wsel = _mm256_blendv_pd(wsel, w2, is2);
+        __m256d is3 = _mm256_cmp_pd(w3, val, _CMP_GT_OQ);
+        wsel = _mm256_blendv_pd(wsel, w3, is3);
+        // one hot masks of the chosen index
+        is2 = _mm256_andnot_pd(is3, is2);
+        is1 = _mm256_andnot_pd(_mm256_or_pd(is2, is3), is1);
+
+        __m256d s = _mm256_sqrt_pd(div(add(one, wsel), four));
+        __m256d d = mul(four, s);
+        __m256d a = div(sub(z2, y3), d), b = div(sub(x3, z1), d), c = div(sub(y1, x2), d);
+        __m256d e = div(add(x2, y1), d), f = div(add(x3, z1), d), g = div(add(y3, z2), d);
+
+        // idx 0: (s, a, b, c), idx 1: (a, s, e, f), idx 2: (b, e, s, g), idx 3: (c, f, g, s)
+        __m256d r0 = _mm256_blendv_pd(_mm256_blendv_pd(_mm256_blendv_pd(s, a, is1), b, is2), c, is3);
+        __m256d r1 = _mm256_blendv_pd(_mm256_blendv_pd(_mm256_blendv_pd(a, s, is1), e, is2), f, is3);
+        __m256d r2 = _mm256_blendv_pd(_mm256_blendv_pd(_mm256_blendv_pd(b, e, is1), s, is2), g, is3);
+        __m256d r3 = _mm256_blendv_pd(_mm256_blendv_pd(_mm256_blendv_pd(c, f, is1), g, is2), s, is3);
+        store_quat4(q + 4 * i, r1, r2, r3, r0);
+    }
+    for (; i < num_quat; i++)
+    {
+        six_dim_mat_to_quat_single(mat + 6 * i, q + 4 * i);
+    }
+}
+
+QUAT_AVX2_TARGET void quat_to_rotvec_impl_avx2(
+    const double * q,
+    double * angle,
+    double * rotvec,
+    size_t num_quat
+)
+{
+    alignas(32) double ulen_arr[4], qw_arr[4], scale_arr[4];
+    size_t i = 0;
+    for(; i + 4 <= num_quat; i += 4)
+    {
+        __m256d qx, qy, qz, qw;
+        load_quat4(q + 4 * i, qx, qy, qz, qw);
+        // flip the quaternion by w
+        __m256d ratio = _mm256_blendv_pd(splat(1.0), splat(-1.0), _mm256_cmp_pd(qw, _mm256_setzero_pd(), _CMP_LT_OQ));
+        qx = mul(ratio, qx); qy = mul(ratio, qy); qz = mul(ratio, qz); qw = mul(ratio, qw);
+        _mm256_store_pd(ulen_arr, _mm256_sqrt_pd(add(add(mul(qx, qx), mul(qy, qy)), mul(qz, qz))));
+        _mm256_store_pd(qw_arr, qw);
+        // no vector atan2 / sin, the same library calls as quat_to_rotvec_single
+        for(int k = 0; k < 4; k++)
+        {
+            double a = 2.0 * std::atan2(ulen_arr[k], qw_arr[k]);
+            angle[i + k] = a;
+            if (std::abs(a) < 1e-3)
+            {
+                double angle_2 = a * a;
+                double angle_4 = angle_2 * angle_2;
+                scale_arr[k] = 2 + angle_2 / 12 + 7 * angle_4 / 2880;
+            }
+            else
+            {
+                scale_arr[k] = a / std::sin(0.5 * a);
+            }
+        }
+        __m256d scale = _mm256_load_pd(scale_arr);
+        store_vec3x4(rotvec + 3 * i, mul(scale, qx), mul(scale, qy), mul(scale, qz));
+    }
+    for(; i < num_quat; i++)
+    {
+        quat_to_rotvec_single(q + 4 * i, angle[i], rotvec + 3 * i);
+    }
+}
+
+QUAT_AVX2_TARGET void quat_from_rotvec_impl_avx2(const double * rotvec, double * q, size_t num_quat)
+{
+    alignas(32) double angle_arr[4], ratio_arr[4], cos_arr[4];
+    size_t i = 0;
+    for(; i + 4 <= num_quat; i += 4)
+    {
+        __m256d rx, ry, rz;
+        load_vec3x4(rotvec + 3 * i, rx, ry, rz);
+        _mm256_store_pd(angle_arr, _mm256_sqrt_pd(add(add(mul(rx, rx), mul(ry, ry)), mul(rz, rz))));
+        // no vector sin / cos, the same library calls as quat_from_rotvec_single
+        for(int k = 0; k < 4; k++)
+        {
+            double angle = angle_arr[k];
+            double half_angle = 0.5 * angle;
+            if (angle < 1e-3)
+            {
+                double angle2 = angle * angle;
+                double angle4 = angle2 * angle2;
+                ratio_arr[k] = 0.5 - angle2 / 48 + angle4 / 3840;
+            }
+            else
+            {
+                ratio_arr[k] = std::sin(half_angle) / angle;
+            }
+            cos_arr[k] = std::cos(half_angle);
+        }
+        __m256d ratio = _mm256_load_pd(ratio_arr);
+        store_quat4(q + 4 * i, mul(ratio, rx), mul(ratio, ry), mul(ratio, rz), _mm256_load_pd(cos_arr));
+    }
+    for(; i < num_quat; i++)
+    {
+        quat_from_rotvec_single(rotvec + 3 * i, q + 4 * i);
+    }
+}
+
+#else
+
+// no AVX2 for this target: quat_simd_avx2_supported() is 0, these are never chosen by the dispatch
+
+void quat_multiply_forward_avx2(const double * q1, const double * q2, double * q, size_t num_quat)
+{
+    quat_multiply_forward_scalar(q1, q2, q, num_quat);
+}
+
+void quat_multiply_backward_avx2(const double * q1, const double * q2, const double * grad_q,
+    double * grad_q1, double * grad_q2, size_t num_quat)
+{
+    quat_multiply_backward_scalar(q1, q2, grad_q, grad_q1, grad_q2, num_quat);
+}
+
+void quat_apply_forward_avx2(const double * q, const double * v, double * o, size_t num_quat)
+{
+    quat_apply_forward_scalar(q, v, o, num_quat);
+}
+
+void quat_apply_backward_avx2(const double * q, const double * v, const double * o_grad,
+    double * q_grad, double * v_grad, size_t num_quat)
+{
+    quat_apply_backward_scalar(q, v, o_grad, q_grad, v_grad, num_quat);
+}
+
+void quat_to_matrix_impl_avx2(const double * q, double * mat, size_t num_quat)
+{
+    quat_to_matrix_impl_scalar(q, mat, num_quat);
+}
+
+void six_dim_mat_to_quat_impl_avx2(const double * mat, double * q, size_t num_quat)
+{
+    six_dim_mat_to_quat_impl_scalar(mat, q, num_quat);
+}
+
+void quat_to_rotvec_impl_avx2(const double * q, double * angle, double * rotvec, size_t num_quat)
+{
+    quat_to_rotvec_impl_scalar(q, angle, rotvec, num_quat);
+}
+
+void quat_from_rotvec_impl_avx2(const double * rotvec, double * q, size_t num_quat)
+{
+    quat_from_rotvec_impl_scalar(rotvec, q, num_quat);
+}
+
+#endif
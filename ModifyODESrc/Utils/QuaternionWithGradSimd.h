@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+
+// AVX2 / FMA versions of batch routines of QuaternionWithGrad.h.
+// Each loop transposes 4 quaternions (vectors, matrices) to structure of arrays,
+// computes the 4 lanes at once and transposes back. The remainder (num_quat % 4)
+// is done by the scalar single routines. atan2 / sin / cos of the rotvec routines
+// are still scalar library calls per lane. With fma the results may differ from the
+// scalar version in the last bits (bench/quat_simd_bench.cpp reports below 3e-15).
+//
+// The batch routines of QuaternionWithGrad.h choose at runtime: the AVX2 version if the
+// cpu supports AVX2 and FMA (and it is not disabled by quat_simd_set_enabled), else the
+// *_scalar version, which is the reference implementation.
+
+// 1 if the AVX2 kernels are compiled in and the cpu supports AVX2 and FMA
+int quat_simd_avx2_supported();
+
+// enable (default) or disable the AVX2 kernels in the batch routines
+void quat_simd_set_enabled(int enabled);
+int quat_simd_get_enabled();
+
+// 1 if the batch routines use the AVX2 kernels now
+int quat_simd_use_avx2();
+
+// scalar reference versions
+void quat_multiply_forward_scalar(const double * q1, const double * q2, double * q, size_t num_quat);
+void quat_multiply_backward_scalar(const double * q1, const double * q2, const double * grad_q,
+    double * grad_q1, double * grad_q2, size_t num_quat);
+void quat_apply_forward_scalar(const double * q, const double * v, double * o, size_t num_quat);
+void quat_apply_backward_scalar(const double * q, const double * v, const double * o_grad,
+    double * q_grad, double * v_grad, size_t num_quat);
+void quat_to_matrix_impl_scalar(const double * q, double * mat, size_t num_quat);
+void six_dim_mat_to_quat_impl_scalar(const double * mat, double * q, size_t num_quat);
+void quat_to_rotvec_impl_scalar(const double * q, double * angle, double * rotvec, size_t num_quat);
+void quat_from_rotvec_impl_scalar(const double * rotvec, double * q, size_t num_quat);
+
+// AVX2 / FMA versions. Only call them if quat_simd_avx2_supported().
+void quat_multiply_forward_avx2(const double * q1, const double * q2, double * q, size_t num_quat);
+void quat_multiply_backward_avx2(const double * q1, const double * q2, const double * grad_q,
+    double * grad_q1, double * grad_q2, size_t num_quat);
+void quat_apply_forward_avx2(const double * q, const double * v, double * o, size_t num_quat);
+void quat_apply_backward_avx2(const double * q, const double * v, const double * o_grad,
+    double * q_grad, double * v_grad, size_t num_quat);
+void quat_to_matrix_impl_avx2(const double * q, double * mat, size_t num_quat);
+void six_dim_mat_to_quat_impl_avx2(const double * mat, double * q, size_t num_quat);
+void quat_to_rotvec_impl_avx2(const double * q, double * angle, double * rotvec, size_t num_quat);
+void quat_from_rotvec_impl_avx2(const double * rotvec, double * q, size_t num_quat);
@@ -0,0 +1,74 @@
+#include "batch_parallel.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+	const int DEFAULT_MAX_THREADS = 8;
+
+	// held while the pool runs a batch, or is replaced
+	std::mutex pool_mutex;
+	// never freed: joining the workers while the process exits can hang (e.g. when the python module is unloaded)
+	ThreadPool* pool = nullptr;
+	// 0: not set, the default
+	std::atomic<int> num_threads{0};
+	std::atomic<size_t> min_items{65536};
+
+	int hardware_threads()
+	{
+		int res = static_cast<int>(std::thread::hardware_concurrency());
+		return res > 0 ? res : 1;
+	}
+}
+
+void batch_parallel_set_num_threads(int num_threads_)
+{
+	const int count = num_threads_ > 0 ? num_threads_ : hardware_threads();
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	if (pool != nullptr && pool->GetNumThreads() != count)
+	{
+		delete pool;
+		pool = nullptr;
+	}
+	num_threads.store(count);
+}
+
+int batch_parallel_get_num_threads()
+{
+	const int count = num_threads.load();
+	return count > 0 ? count : std::min(hardware_threads(), DEFAULT_MAX_THREADS);
+}
+
+void batch_parallel_set_min_items(size_t min_items_)
+{
+	min_items.store(min_items_);
+}
+
+size_t batch_parallel_get_min_items()
+{
+	return min_items.load(std::memory_order_relaxed);
+}
+
+void batch_parallel_run(size_t count, const std::function<void(size_t, size_t)>& func)
+{
+	const size_t num_chunks = (count + BATCH_PARALLEL_CHUNK - 1) / BATCH_PARALLEL_CHUNK;
+	std::unique_lock<std::mutex> lock(pool_mutex, std::try_to_lock);
+	const int count_threads = batch_parallel_get_num_threads();
+	if (!lock.owns_lock() || count_threads <= 1 || num_chunks <= 1)
+	{
+		func(0, count);
+		return;
+	}
+	if (pool == nullptr)
+	{
+		pool = new ThreadPool(count_threads);
+	}
+	pool->parallel_for(num_chunks, [&](size_t chunk)
+	{
+		const size_t begin = chunk * BATCH_PARALLEL_CHUNK;
+		func(begin, std::min(begin + BATCH_PARALLEL_CHUNK, count));
+	});
+}
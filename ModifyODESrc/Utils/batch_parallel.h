@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+// Process wide thread pool of the batch routines on large arrays (QuaternionWithGrad,
+// joint_local_quat_batch), e.g. frames x joints of a motion dataset.
+// A batch is cut into chunks of BATCH_PARALLEL_CHUNK items, and the chunks run on the pool.
+// The chunks do not depend on the thread count, and are a multiple of 4 items (the group of
+// QuaternionWithGradAvx2.cpp), so every item is computed by the same code as in a single
+// threaded call: the results are bitwise equal for any thread count.
+// Small batches, batches started while the pool runs another one (e.g. from the worlds of
+// VecTrackEnv, or from another python thread) and a thread count of 1 run on the calling thread.
+
+const size_t BATCH_PARALLEL_CHUNK = 8192;
+
+// 0: all hardware threads, 1: single threaded. By default the hardware threads, at most 8.
+void batch_parallel_set_num_threads(int num_threads);
+int batch_parallel_get_num_threads();
+
+// batches with fewer items run on the calling thread, 65536 by default
+void batch_parallel_set_min_items(size_t min_items);
+size_t batch_parallel_get_min_items();
+
+void batch_parallel_run(size_t count, const std::function<void(size_t, size_t)>& func);
+
+// call func(begin, end) on item ranges covering [0, count)
+template <class Func>
+inline void batch_parallel_for(size_t count, const Func& func)
+{
+	if (count < batch_parallel_get_min_items())
+	{
+		func(size_t(0), count);
+		return;
+	}
+	batch_parallel_run(count, func);
+}
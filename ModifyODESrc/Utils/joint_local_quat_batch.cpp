@@ -1,4 +1,5 @@
 #include "joint_local_quat_batch.h"
+#include "batch_parallel.h"
 
 #include <algorithm>
 #include <cmath>
@@ -35,18 +36,24 @@ void ode_quat_inv(dReal* ode_quat)
 
 void quat_arr_from_ode_to_scipy(dReal* qs, int count)
 {
-    for (int i = 0; i < count; i++)
+    batch_parallel_for((size_t)count, [&](size_t begin, size_t end)
     {
-        ode_quat_to_scipy(qs + 4 * i);
-    }
+        for (size_t i = begin; i < end; i++)
+        {
+            ode_quat_to_scipy(qs + 4 * i);
+        }
+    });
 }
 
 void quat_arr_from_scipy_to_ode(dReal* qs, int count)
 {
-    for (int i = 0; i < count; i++)
+    batch_parallel_for((size_t)count, [&](size_t begin, size_t end)
     {
-        scipy_quat_to_ode(qs + 4 * i);
-    }
+        for (size_t i = begin; i < end; i++)
+        {
+            scipy_quat_to_ode(qs + 4 * i);
+        }
+    });
 }
 
 dReal quat_dot(const dReal* q0, const dReal* q1)
@@ -122,54 +129,58 @@ void get_joint_local_quat_batch(
     dReal* parent_qs_inv,
     int convert_to_scipy = 1)
 {
-    const dReal* const_quat_0 = NULL;
-    const dReal* const_quat_1 = NULL;
+    // the joints are independent, so a large batch (e.g. many characters) is split over the batch thread pool
+    batch_parallel_for((size_t)joint_count, [&](size_t begin, size_t end)
+    {
+        const dReal* const_quat_0 = NULL;
+        const dReal* const_quat_1 = NULL;
 
-    dReal * parent_quat = NULL;
-    dReal* child_quat = NULL;
-    dReal* local_quat = NULL;
-    dReal* parent_quat_inv = NULL;
+        dReal * parent_quat = NULL;
+        dReal* child_quat = NULL;
+        dReal* local_quat = NULL;
+        dReal* parent_quat_inv = NULL;
 
-    dBodyID body0 = NULL, body1 = NULL;
-    dJointID jid = NULL;
-    dQuaternion unit_quat_ode;
-    dQSetIdentity(unit_quat_ode);
-
-    // dReal quat0_norm = 1, quat1_norm = 1;
-    for (int i = 0; i < joint_count; i++)
-    {
-        jid = joints[i];
-        body0 = dJointGetBody(jid, 0);
-        body1 = dJointGetBody(jid, 1);
-        const_quat_0 = dBodyGetQuaternion(body0);
+        dBodyID body0 = NULL, body1 = NULL;
+        dJointID jid = NULL;
+        dQuaternion unit_quat_ode;
+        dQSetIdentity(unit_quat_ode);
 
-        if (body1 != NULL)
-        {
-            const_quat_1 = dBodyGetQuaternion(body1);
-        }
-        else
+        // dReal quat0_norm = 1, quat1_norm = 1;
+        for (int i = (int)begin; i < (int)end; i++)
         {
-            const_quat_1 = unit_quat_ode;
+            jid = joints[i];
+            body0 = dJointGetBody(jid, 0);
+            body1 = dJointGetBody(jid, 1);
+            const_quat_0 = dBodyGetQuaternion(body0);
+
+            if (body1 != NULL)
+            {
+                const_quat_1 = dBodyGetQuaternion(body1);
+            }
+            else
+            {
+                const_quat_1 = unit_quat_ode;
+            }
+
+            child_quat = child_qs + 4 * i;
+            parent_quat = parent_qs + 4 * i;
+            local_quat = local_qs + 4 * i;
+            parent_quat_inv = parent_qs_inv + 4 * i;
+
+            std::copy(const_quat_0, const_quat_0 + 4, child_quat);
+            std::copy(const_quat_1, const_quat_1 + 4, parent_quat);
+            dNormalize4(child_quat);
+            dNormalize4(parent_quat);
+
+            // Compute local quaternion
+            dQMultiply1(local_quat, parent_quat, child_quat);
+            dNormalize4(local_quat);
+
+            // Compute inverse of parent quaternion
+            std::copy(parent_quat, parent_quat + 4, parent_quat_inv);
+            ode_quat_inv(parent_quat_inv);
         }
-
-        child_quat = child_qs + 4 * i;
-        parent_quat = parent_qs + 4 * i;
-        local_quat = local_qs + 4 * i;
-        parent_quat_inv = parent_qs_inv + 4 * i;
-
-        std::copy(const_quat_0, const_quat_0 + 4, child_quat);
-        std::copy(const_quat_1, const_quat_1 + 4, parent_quat);
-        dNormalize4(child_quat);
-        dNormalize4(parent_quat);
-
-        // Compute local quaternion
-        dQMultiply1(local_quat, parent_quat, child_quat);
-        dNormalize4(local_quat);
-
-        // Compute inverse of parent quaternion
-        std::copy(parent_quat, parent_quat + 4, parent_quat_inv);
-        ode_quat_inv(parent_quat_inv);
-    }
+    });
 
     if (convert_to_scipy)
     {
@@ -239,9 +250,46 @@ dReal compute_total_power(dJointID * joints, int joint_count, const dReal * join
     return total_power;
 }
 
+void PDControlWorkspace::Reserve(int joint_count)
+{
+    if (joint_count > capacity)
+    {
+        capacity = joint_count;
+        buffer.assign((size_t)NUM_ROWS * capacity, 0);
+    }
+}
+
+PDControlWorkspace* PDControlWorkspaceCreate(int joint_count)
+{
+    return new PDControlWorkspace(joint_count);
+}
+
+void PDControlWorkspaceDelete(PDControlWorkspace* ptr)
+{
+    delete ptr;
+}
+
+// ode_quat_apply on quaternion and vector components: q * (0, v) * inv(q)
+static inline void quat_apply_components(
+    dReal qw, dReal qx, dReal qy, dReal qz,
+    dReal vx_in, dReal vy_in, dReal vz_in,
+    dReal& vx_out, dReal& vy_out, dReal& vz_out)
+{
+    dReal vw = -qx * vx_in - qy * vy_in - qz * vz_in;
+    dReal vx = qw * vx_in + qy * vz_in - qz * vy_in;
+    dReal vy = qw * vy_in + qz * vx_in - qx * vz_in;
+    dReal vz = qw * vz_in + qx * vy_in - qy * vx_in;
+    vx_out = -vw * qx + vx * qw - vy * qz + vz * qy;
+    vy_out = -vw * qy + vy * qw - vz * qx + vx * qz;
+    vz_out = -vw * qz + vz * qw - vx * qy + vy * qx;
+}
+
 // As (stable) PD controller in python is too slow (by profile), rewrite it in c++, then call it via cython/
-// TODO: compare with result PD controller result in python version.
+// The arithmetic is the one of the per joint version (dNormalize4, dQMultiply1 / 2,
+// ode_quat_to_axis_angle, ode_quat_apply), done one step at a time for all joints.
+// The kd term is the one of PDControler.add_torques_by_quat in python (get_local_angvels).
 void pd_control_batch(
+    PDControlWorkspace& workspace,
     dJointID * joints,
     int joint_count,
     const dReal * input_target_local_qs,
@@ -253,99 +301,179 @@ void pd_control_batch(
     int input_in_scipy = 1
 )
 {
-    // alloc memory for calc joint local quaternion
-    const int qs_total_size = 4 * joint_count;
-    dReal* parent_qs = new dReal[qs_total_size];
-    dReal* child_qs = new dReal[qs_total_size];
-    dReal* local_qs = new dReal[qs_total_size];
-    dReal* parent_qs_inv = new dReal[qs_total_size];
-    std::fill(parent_qs, parent_qs + qs_total_size, 0);
-    std::fill(child_qs, child_qs + qs_total_size, 0);
-    std::fill(local_qs, local_qs + qs_total_size, 0);
-    std::fill(parent_qs_inv, parent_qs_inv + qs_total_size, 0);
-
-    // calc joint local quaternion
-    get_joint_local_quat_batch(
-        joints,
-        joint_count,
-        parent_qs,
-        child_qs,
-        local_qs,
-        parent_qs_inv,
-        0);
-
-    // convert target pose to ode format.
-    dReal* target_local_qs = new dReal[qs_total_size];
-    std::copy(input_target_local_qs, input_target_local_qs + qs_total_size, target_local_qs);
-    if (input_in_scipy)
-    {
-        quat_arr_from_scipy_to_ode(target_local_qs, joint_count);
-    }
-
-    dQuaternion delta_quat;
-    dReal* parent_q = NULL;
-    dReal* local_q = NULL;
-    const dReal* tar_local_q = NULL;
-    dReal axis_angle[3];
-    dReal* local_torque = NULL;
-    dReal* global_torque = NULL;
-
+    workspace.Reserve(joint_count);
+    dReal* __restrict pw = workspace.Row(PDControlWorkspace::PARENT_Q);
+    dReal* __restrict px = workspace.Row(PDControlWorkspace::PARENT_Q + 1);
+    dReal* __restrict py = workspace.Row(PDControlWorkspace::PARENT_Q + 2);
+    dReal* __restrict pz = workspace.Row(PDControlWorkspace::PARENT_Q + 3);
+    dReal* __restrict lw = workspace.Row(PDControlWorkspace::LOCAL_Q);
+    dReal* __restrict lx = workspace.Row(PDControlWorkspace::LOCAL_Q + 1);
+    dReal* __restrict ly = workspace.Row(PDControlWorkspace::LOCAL_Q + 2);
+    dReal* __restrict lz = workspace.Row(PDControlWorkspace::LOCAL_Q + 3);
+    dReal* __restrict tw = workspace.Row(PDControlWorkspace::TARGET_Q);
+    dReal* __restrict tx = workspace.Row(PDControlWorkspace::TARGET_Q + 1);
+    dReal* __restrict ty = workspace.Row(PDControlWorkspace::TARGET_Q + 2);
+    dReal* __restrict tz = workspace.Row(PDControlWorkspace::TARGET_Q + 3);
+    dReal* __restrict fx = workspace.Row(PDControlWorkspace::TORQUE);
+    dReal* __restrict fy = workspace.Row(PDControlWorkspace::TORQUE + 1);
+    dReal* __restrict fz = workspace.Row(PDControlWorkspace::TORQUE + 2);
+    dReal* __restrict wx = workspace.Row(PDControlWorkspace::ANGVEL);
+    dReal* __restrict wy = workspace.Row(PDControlWorkspace::ANGVEL + 1);
+    dReal* __restrict wz = workspace.Row(PDControlWorkspace::ANGVEL + 2);
+
+    // gather the body quaternions: child into the local rows, parent (or identity) into the parent rows
     for (int jidx = 0; jidx < joint_count; jidx++)
     {
-        // compute difference between joint local quaternion and target pose
-        parent_q = parent_qs + 4 * jidx;
-        local_q = local_qs + 4 * jidx;
-        tar_local_q = target_local_qs + 4 * jidx;
-        local_torque = local_res_joint_torques + 3 * jidx;
-        global_torque = global_res_joint_torques + 3 * jidx;
-
-        if (quat_dot(local_q, tar_local_q) < 0)
+        const dReal* child_q = dBodyGetQuaternion(dJointGetBody(joints[jidx], 0));
+        dBodyID parent = dJointGetBody(joints[jidx], 1);
+        lw[jidx] = child_q[0]; lx[jidx] = child_q[1]; ly[jidx] = child_q[2]; lz[jidx] = child_q[3];
+        if (parent != NULL)
         {
-            minus_quat(local_q);
+            const dReal* parent_q = dBodyGetQuaternion(parent);
+            pw[jidx] = parent_q[0]; px[jidx] = parent_q[1]; py[jidx] = parent_q[2]; pz[jidx] = parent_q[3];
         }
-
-        dQMultiply2(delta_quat, tar_local_q, local_q);
-        dNormalize4(delta_quat);
-        // convert quaternion to axis angle format.
-        ode_quat_to_axis_angle(delta_quat, axis_angle);
-        for (int dim = 0; dim < 3; dim++)
+        else
         {
-            local_torque[dim] = kps[jidx] * axis_angle[dim];
+            pw[jidx] = 1; px[jidx] = 0; py[jidx] = 0; pz[jidx] = 0;
         }
+    }
 
-        if (kds != NULL) // TODO: for PD controller
+    // joint angular velocity in global coordinate: child - parent
+    if (kds != NULL)
+    {
+        for (int jidx = 0; jidx < joint_count; jidx++)
         {
-            std::cout << "Warning: Add kd not implemented now." << std::endl;
+            const dReal* child_w = dBodyGetAngularVel(dJointGetBody(joints[jidx], 0));
+            dBodyID parent = dJointGetBody(joints[jidx], 1);
+            wx[jidx] = child_w[0]; wy[jidx] = child_w[1]; wz[jidx] = child_w[2];
+            if (parent != NULL)
+            {
+                const dReal* parent_w = dBodyGetAngularVel(parent);
+                wx[jidx] -= parent_w[0]; wy[jidx] -= parent_w[1]; wz[jidx] -= parent_w[2];
+            }
         }
+    }
 
-        // clip joint torque
-        dReal torque_len = dCalcVectorLength3(local_torque);
-        if (torque_len < 1e-10)
-        {
-            torque_len = 1;
-        }
-        dReal ratio = torque_len;
-        if (ratio < -torque_limits[jidx])
+    // convert target pose to ode format.
+    const dReal* target = input_target_local_qs;
+    const int w_index = input_in_scipy ? 3 : 0, xyz_index = input_in_scipy ? 0 : 1;
+    for (int jidx = 0; jidx < joint_count; jidx++)
+    {
+        tw[jidx] = target[4 * jidx + w_index];
+        tx[jidx] = target[4 * jidx + xyz_index];
+        ty[jidx] = target[4 * jidx + xyz_index + 1];
+        tz[jidx] = target[4 * jidx + xyz_index + 2];
+    }
+
+    // joint local quaternion: normalized inv(parent) * child
+    for (int jidx = 0; jidx < joint_count; jidx++)
+    {
+        dReal l = pw[jidx] * pw[jidx] + px[jidx] * px[jidx] + py[jidx] * py[jidx] + pz[jidx] * pz[jidx];
+        l = dRecipSqrt(l);
+        pw[jidx] *= l; px[jidx] *= l; py[jidx] *= l; pz[jidx] *= l;
+        l = lw[jidx] * lw[jidx] + lx[jidx] * lx[jidx] + ly[jidx] * ly[jidx] + lz[jidx] * lz[jidx];
+        l = dRecipSqrt(l);
+        dReal cw = lw[jidx] * l, cx = lx[jidx] * l, cy = ly[jidx] * l, cz = lz[jidx] * l;
+
+        dReal qw = pw[jidx] * cw + px[jidx] * cx + py[jidx] * cy + pz[jidx] * cz;
+        dReal qx = pw[jidx] * cx - px[jidx] * cw - py[jidx] * cz + pz[jidx] * cy;
+        dReal qy = pw[jidx] * cy - py[jidx] * cw - pz[jidx] * cx + px[jidx] * cz;
+        dReal qz = pw[jidx] * cz - pz[jidx] * cw - px[jidx] * cy + py[jidx] * cx;
+        l = dRecipSqrt(qw * qw + qx * qx + qy * qy + qz * qz);
+        lw[jidx] = qw * l; lx[jidx] = qx * l; ly[jidx] = qy * l; lz[jidx] = qz * l;
+    }
+
+    // difference between joint local quaternion and target pose: target * inv(local),
+    // with local in the hemisphere of target
+    for (int jidx = 0; jidx < joint_count; jidx++)
+    {
+        dReal dot = lw[jidx] * tw[jidx] + lx[jidx] * tx[jidx] + ly[jidx] * ty[jidx] + lz[jidx] * tz[jidx];
+        dReal sign = dot < 0 ? dReal(-1) : dReal(1);
+        dReal qw = sign * lw[jidx], qx = sign * lx[jidx], qy = sign * ly[jidx], qz = sign * lz[jidx];
+
+        dReal dw = tw[jidx] * qw + tx[jidx] * qx + ty[jidx] * qy + tz[jidx] * qz;
+        dReal dx = -tw[jidx] * qx + tx[jidx] * qw - ty[jidx] * qz + tz[jidx] * qy;
+        dReal dy = -tw[jidx] * qy + ty[jidx] * qw - tz[jidx] * qx + tx[jidx] * qz;
+        dReal dz = -tw[jidx] * qz + tz[jidx] * qw - tx[jidx] * qy + ty[jidx] * qx;
+        dReal l = dRecipSqrt(dw * dw + dx * dx + dy * dy + dz * dz);
+        tw[jidx] = dw * l; tx[jidx] = dx * l; ty[jidx] = dy * l; tz[jidx] = dz * l;
+    }
+
+    // convert quaternion to axis angle format (ode_quat_to_axis_angle), times kp.
+    // atan2 and sin are scalar library calls, the loop runs one joint at a time.
+    for (int jidx = 0; jidx < joint_count; jidx++)
+    {
+        dReal sign = tw[jidx] < 0 ? dReal(-1) : dReal(1);
+        dReal w = sign * tw[jidx], x = sign * tx[jidx], y = sign * ty[jidx], z = sign * tz[jidx];
+        dReal axis_len = dSqrt(x * x + y * y + z * z);
+        dReal angle = 2 * std::atan2(axis_len, w);
+        dReal scale;
+        if (std::abs(angle) <= 1e-3)
         {
-            ratio = -torque_limits[jidx];
+            dReal angle_pow_2 = angle * angle;
+            dReal angle_pow_4 = angle_pow_2 * angle_pow_2;
+            scale = 2 + angle * angle / 12 + (7.0 / 2880) * angle_pow_4;
         }
-        else if (ratio > torque_limits[jidx])
+        else
         {
-            ratio = torque_limits[jidx];
+            scale = angle / std::sin(0.5 * angle);
         }
-        for (int dim = 0; dim < 3; dim++)
+        fx[jidx] = kps[jidx] * (scale * x);
+        fy[jidx] = kps[jidx] * (scale * y);
+        fz[jidx] = kps[jidx] * (scale * z);
+    }
+
+    // damping by the joint angular velocity in parent coordinate, that is, rotated by inv(parent)
+    if (kds != NULL)
+    {
+        for (int jidx = 0; jidx < joint_count; jidx++)
         {
-            local_torque[dim] = local_torque[dim] / torque_len * ratio;
+            dReal local_wx, local_wy, local_wz;
+            quat_apply_components(pw[jidx], -px[jidx], -py[jidx], -pz[jidx],
+                wx[jidx], wy[jidx], wz[jidx], local_wx, local_wy, local_wz);
+            fx[jidx] = fx[jidx] - kds[jidx] * local_wx;
+            fy[jidx] = fy[jidx] - kds[jidx] * local_wy;
+            fz[jidx] = fz[jidx] - kds[jidx] * local_wz;
         }
+    }
 
-        // convert joint torque to global coordinate. That is, apply parent rotation to local torque
-        ode_quat_apply(parent_q, local_torque, global_torque);
+    // clip joint torque
+    for (int jidx = 0; jidx < joint_count; jidx++)
+    {
+        dReal torque_len = dSqrt(fx[jidx] * fx[jidx] + fy[jidx] * fy[jidx] + fz[jidx] * fz[jidx]);
+        torque_len = torque_len < 1e-10 ? dReal(1) : torque_len;
+        dReal ratio = std::min(std::max(torque_len, -torque_limits[jidx]), torque_limits[jidx]);
+        fx[jidx] = fx[jidx] / torque_len * ratio;
+        fy[jidx] = fy[jidx] / torque_len * ratio;
+        fz[jidx] = fz[jidx] / torque_len * ratio;
     }
 
-    delete[] parent_qs;
-    delete[] child_qs;
-    delete[] local_qs;
-    delete[] parent_qs_inv;
+    // convert joint torque to global coordinate. That is, apply parent rotation to local torque
+    for (int jidx = 0; jidx < joint_count; jidx++)
+    {
+        dReal* local_torque = local_res_joint_torques + 3 * jidx;
+        dReal* global_torque = global_res_joint_torques + 3 * jidx;
+        local_torque[0] = fx[jidx];
+        local_torque[1] = fy[jidx];
+        local_torque[2] = fz[jidx];
+        quat_apply_components(pw[jidx], px[jidx], py[jidx], pz[jidx], fx[jidx], fy[jidx], fz[jidx],
+            global_torque[0], global_torque[1], global_torque[2]);
+    }
+}
 
-    delete[] target_local_qs;
+void pd_control_batch(
+    dJointID * joints,
+    int joint_count,
+    const dReal * input_target_local_qs,
+    const dReal * kps,
+    const dReal * kds,
+    const dReal * torque_limits,
+    dReal * local_res_joint_torques,
+    dReal * global_res_joint_torques,
+    int input_in_scipy = 1
+)
+{
+    static thread_local PDControlWorkspace workspace;
+    pd_control_batch(workspace, joints, joint_count, input_target_local_qs, kps, kds, torque_limits,
+        local_res_joint_torques, global_res_joint_torques, input_in_scipy);
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <ode/ode.h>
+#include <vector>
 
 void ode_quat_to_scipy(dReal* q_ode);
 
@@ -34,8 +35,48 @@ void get_joint_local_quat_batch(
 dReal compute_total_power_by_global(dJointID * joints, int joint_count, const dReal * global_joint_torques);
 dReal compute_total_power(dJointID * joints, int joint_count, const dReal * joint_torques);
 
+// Buffers of pd_control_batch, kept by the controller so that the per substep
+// call does not allocate. Each row holds one component for all joints (SoA),
+// so the quaternion math runs in loops across joints that the compiler vectorizes.
+class PDControlWorkspace
+{
+public:
+    // rows: parent quaternion w x y z, local quaternion w x y z,
+    // target (then delta) quaternion w x y z, local torque x y z,
+    // joint angular velocity x y z (only with kds)
+    enum { PARENT_Q = 0, LOCAL_Q = 4, TARGET_Q = 8, TORQUE = 12, ANGVEL = 15, NUM_ROWS = 18 };
+
+    explicit PDControlWorkspace(int joint_count = 0) { Reserve(joint_count); }
+
+    void Reserve(int joint_count);
+    int GetCapacity() const { return capacity; }
+    dReal* Row(int row) { return buffer.data() + (size_t)row * capacity; }
+
+private:
+    std::vector<dReal> buffer;
+    int capacity = 0;
+};
+
+PDControlWorkspace* PDControlWorkspaceCreate(int joint_count);
+void PDControlWorkspaceDelete(PDControlWorkspace* ptr);
+
 // As (stable) PD controller in python is too slow (by profile), rewrite it in c++, then call it via cython
-// TODO: compare with result PD controller result in python version.
+// local torque = kp * rotvec(target * inv(local)) - kd * joint angular velocity in parent frame,
+// clipped to the torque limit. kds may be NULL: kp only, for the stable PD of World.dampedStep.
+void pd_control_batch(
+    PDControlWorkspace& workspace,
+    dJointID* joints,
+    int joint_count,
+    const dReal* input_target_local_qs,
+    const dReal* kps,
+    const dReal* kds,
+    const dReal* torque_limits,
+    dReal* local_res_joint_torques,
+    dReal* global_res_joint_torques,
+    int input_in_scipy
+);
+
+// same, with a workspace of the calling thread
 void pd_control_batch(
     dJointID* joints,
     int joint_count,
@@ -0,0 +1,425 @@
+// Shared memory ring buffer of trajectory records and a parameter slot,
+// used to replace the MPI gather / broadcast when all processes run on one machine.
+#include "shm_transport.h"
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory atomics must be lock free");
+
+static const uint64_t SHM_RING_MAGIC = 0x474e495254444f4dull; // "MODTRING"
+static const uint64_t SHM_PARAM_MAGIC = 0x4d52415054444f4dull; // "MODTPARM"
+static const uint32_t SHM_TRANSPORT_VERSION = 1;
+
+static size_t align_up(size_t x, size_t a)
+{
+	return (x + a - 1) / a * a;
+}
+
+ShmRegion::ShmRegion() : data(nullptr), size(0), owner(false)
+{
+	name[0] = '\0';
+#ifdef _WIN32
+	handle = nullptr;
+#endif
+}
+
+ShmRegion::~ShmRegion()
+{
+	Close();
+}
+
+#ifdef _WIN32
+bool ShmRegion::Create(const char* name_in, size_t size_in)
+{
+	HANDLE h = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		(DWORD)((uint64_t)size_in >> 32), (DWORD)(size_in & 0xffffffffu), name_in);
+	if (h == nullptr || GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		if (h != nullptr) CloseHandle(h);
+		return false;
+	}
+	void* ptr = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, size_in);
+	if (ptr == nullptr)
+	{
+		CloseHandle(h);
+		return false;
+	}
+	handle = h;
+	data = ptr;
+	size = size_in;
+	owner = true;
+	return true;
+}
+
+bool ShmRegion::Open(const char* name_in)
+{
+	HANDLE h = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name_in);
+	if (h == nullptr) return false;
+	void* ptr = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	MEMORY_BASIC_INFORMATION info;
+	if (ptr == nullptr || VirtualQuery(ptr, &info, sizeof(info)) == 0)
+	{
+		if (ptr != nullptr) UnmapViewOfFile(ptr);
+		CloseHandle(h);
+		return false;
+	}
+	handle = h;
+	data = ptr;
+	size = info.RegionSize;
+	owner = false;
+	return true;
+}
+
+void ShmRegion::Close()
+{
+	if (data != nullptr) UnmapViewOfFile(data);
+	if (handle != nullptr) CloseHandle(handle);
+	data = nullptr;
+	handle = nullptr;
+	size = 0;
+}
+#else
+// POSIX names have to start with a single slash
+static void shm_posix_name(const char* name_in, char* out, size_t out_size)
+{
+	snprintf(out, out_size, "%s%s", name_in[0] == '/' ? "" : "/", name_in);
+}
+
+bool ShmRegion::Create(const char* name_in, size_t size_in)
+{
+	shm_posix_name(name_in, name, sizeof(name));
+	int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0) return false;
+	if (ftruncate(fd, (off_t)size_in) != 0)
+	{
+		close(fd);
+		shm_unlink(name);
+		return false;
+	}
+	void* ptr = mmap(nullptr, size_in, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (ptr == MAP_FAILED)
+	{
+		shm_unlink(name);
+		return false;
+	}
+	data = ptr;
+	size = size_in;
+	owner = true;
+	return true;
+}
+
+bool ShmRegion::Open(const char* name_in)
+{
+	shm_posix_name(name_in, name, sizeof(name));
+	int fd = shm_open(name, O_RDWR, 0600);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+	void* ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (ptr == MAP_FAILED) return false;
+	data = ptr;
+	size = (size_t)st.st_size;
+	owner = false;
+	return true;
+}
+
+void ShmRegion::Close()
+{
+	if (data != nullptr)
+	{
+		munmap(data, size);
+		if (owner) shm_unlink(name);
+	}
+	data = nullptr;
+	size = 0;
+}
+#endif
+
+// ----------------------------------------------------------------------------------------------
+
+struct ShmTrajectoryRing::Header
+{
+	uint64_t magic;
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t record_size;
+	uint64_t capacity;
+
+	alignas(64) std::atomic<uint64_t> head; // next sequence number to reserve
+	alignas(64) std::atomic<uint64_t> tail; // next sequence number to read
+};
+
+// layout: Header | seq[capacity] | records[capacity][record_size], each part 64 byte aligned.
+// seq[s & mask] == s + 1 once record s is published. The memory starts zeroed,
+// and the value left by the previous lap is s + 1 - capacity, so no reset is needed.
+static size_t ring_seq_offset()
+{
+	return align_up(sizeof(ShmTrajectoryRing::Header), 64);
+}
+
+static size_t ring_records_offset(size_t capacity)
+{
+	return align_up(ring_seq_offset() + capacity * sizeof(std::atomic<uint64_t>), 64);
+}
+
+ShmTrajectoryRing* ShmTrajectoryRing::Create(const char* name, size_t record_size, size_t capacity)
+{
+	if (record_size == 0 || capacity == 0) return nullptr;
+	size_t cap = 1;
+	while (cap < capacity) cap <<= 1;
+
+	ShmTrajectoryRing* ring = new ShmTrajectoryRing();
+	if (!ring->region.Create(name, ring_records_offset(cap) + cap * record_size))
+	{
+		delete ring;
+		return nullptr;
+	}
+	Header* header = new (ring->region.GetData()) Header();
+	header->version = SHM_TRANSPORT_VERSION;
+	header->record_size = record_size;
+	header->capacity = cap;
+	header->head.store(0, std::memory_order_relaxed);
+	header->tail.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	header->magic = SHM_RING_MAGIC;
+	ring->Attach();
+	return ring;
+}
+
+ShmTrajectoryRing* ShmTrajectoryRing::Open(const char* name)
+{
+	ShmTrajectoryRing* ring = new ShmTrajectoryRing();
+	if (!ring->region.Open(name) || !ring->Attach())
+	{
+		delete ring;
+		return nullptr;
+	}
+	return ring;
+}
+
+bool ShmTrajectoryRing::Attach()
+{
+	if (region.GetSize() < sizeof(Header)) return false;
+	Header* h = static_cast<Header*>(region.GetData());
+	if (h->magic != SHM_RING_MAGIC || h->version != SHM_TRANSPORT_VERSION) return false;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (region.GetSize() < ring_records_offset(h->capacity) + h->capacity * h->record_size) return false;
+
+	char* base = static_cast<char*>(region.GetData());
+	header = h;
+	seq = reinterpret_cast<std::atomic<uint64_t>*>(base + ring_seq_offset());
+	records = base + ring_records_offset(h->capacity);
+	return true;
+}
+
+size_t ShmTrajectoryRing::GetRecordSize() const
+{
+	return header->record_size;
+}
+
+size_t ShmTrajectoryRing::GetCapacity() const
+{
+	return header->capacity;
+}
+
+long long ShmTrajectoryRing::Reserve(size_t count)
+{
+	if (count > header->capacity) return -1;
+	uint64_t head = header->head.load(std::memory_order_relaxed);
+	while (true)
+	{
+		uint64_t tail = header->tail.load(std::memory_order_acquire);
+		if (head + count - tail > header->capacity) return -1;
+		if (header->head.compare_exchange_weak(head, head + count, std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+			return (long long)head;
+		}
+	}
+}
+
+void ShmTrajectoryRing::Commit(unsigned long long start, size_t count)
+{
+	uint64_t mask = header->capacity - 1;
+	for (size_t i = 0; i < count; i++)
+	{
+		uint64_t s = start + i;
+		seq[s & mask].store(s + 1, std::memory_order_release);
+	}
+}
+
+size_t ShmTrajectoryRing::Ready(unsigned long long* start, size_t max_count) const
+{
+	uint64_t mask = header->capacity - 1;
+	uint64_t tail = header->tail.load(std::memory_order_relaxed);
+	size_t count = 0;
+	while (count < max_count && count < header->capacity
+		&& seq[(tail + count) & mask].load(std::memory_order_acquire) == tail + count + 1)
+	{
+		count++;
+	}
+	*start = tail;
+	return count;
+}
+
+void ShmTrajectoryRing::Release(size_t count)
+{
+	header->tail.store(header->tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
+
+// ----------------------------------------------------------------------------------------------
+
+struct ShmParamSlot::Header
+{
+	uint64_t magic;
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t capacity;
+
+	alignas(64) std::atomic<uint64_t> seq; // odd while a write is in progress
+	std::atomic<uint64_t> nbytes;
+};
+
+static size_t param_data_offset()
+{
+	return align_up(sizeof(ShmParamSlot::Header), 64);
+}
+
+ShmParamSlot* ShmParamSlot::Create(const char* name, size_t capacity)
+{
+	if (capacity == 0) return nullptr;
+	ShmParamSlot* slot = new ShmParamSlot();
+	if (!slot->region.Create(name, param_data_offset() + capacity))
+	{
+		delete slot;
+		return nullptr;
+	}
+	Header* header = new (slot->region.GetData()) Header();
+	header->version = SHM_TRANSPORT_VERSION;
+	header->capacity = capacity;
+	header->seq.store(0, std::memory_order_relaxed);
+	header->nbytes.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	header->magic = SHM_PARAM_MAGIC;
+	slot->header = header;
+	slot->data = static_cast<char*>(slot->region.GetData()) + param_data_offset();
+	return slot;
+}
+
+ShmParamSlot* ShmParamSlot::Open(const char* name)
+{
+	ShmParamSlot* slot = new ShmParamSlot();
+	Header* h = nullptr;
+	if (slot->region.Open(name) && slot->region.GetSize() >= sizeof(Header))
+	{
+		h = static_cast<Header*>(slot->region.GetData());
+		if (h->magic != SHM_PARAM_MAGIC || h->version != SHM_TRANSPORT_VERSION
+			|| slot->region.GetSize() < param_data_offset() + h->capacity)
+		{
+			h = nullptr;
+		}
+	}
+	if (h == nullptr)
+	{
+		delete slot;
+		return nullptr;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	slot->header = h;
+	slot->data = static_cast<char*>(slot->region.GetData()) + param_data_offset();
+	return slot;
+}
+
+size_t ShmParamSlot::GetCapacity() const
+{
+	return header->capacity;
+}
+
+uint64_t ShmParamSlot::GetVersion() const
+{
+	return header->seq.load(std::memory_order_acquire) / 2;
+}
+
+uint64_t ShmParamSlot::Write(const void* src, size_t nbytes)
+{
+	if (nbytes > header->capacity) return 0;
+	uint64_t s = header->seq.load(std::memory_order_relaxed);
+	header->seq.store(s + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(data, src, nbytes);
+	header->nbytes.store(nbytes, std::memory_order_relaxed);
+	header->seq.store(s + 2, std::memory_order_release);
+	return (s + 2) / 2;
+}
+
+uint64_t ShmParamSlot::Read(void* dst, size_t dst_capacity, size_t* nbytes) const
+{
+	while (true)
+	{
+		uint64_t s1 = header->seq.load(std::memory_order_acquire);
+		if (s1 & 1)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		size_t n = header->nbytes.load(std::memory_order_relaxed);
+		if (n <= dst_capacity)
+		{
+			memcpy(dst, data, n);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (header->seq.load(std::memory_order_relaxed) == s1)
+		{
+			*nbytes = n;
+			return s1 / 2;
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------------------------
+
+ShmTrajectoryRing* ShmTrajectoryRingCreate(const char* name, size_t record_size, size_t capacity)
+{
+	return ShmTrajectoryRing::Create(name, record_size, capacity);
+}
+
+ShmTrajectoryRing* ShmTrajectoryRingOpen(const char* name)
+{
+	return ShmTrajectoryRing::Open(name);
+}
+
+void ShmTrajectoryRingDelete(ShmTrajectoryRing* ring)
+{
+	delete ring;
+}
+
+ShmParamSlot* ShmParamSlotCreate(const char* name, size_t capacity)
+{
+	return ShmParamSlot::Create(name, capacity);
+}
+
+ShmParamSlot* ShmParamSlotOpen(const char* name)
+{
+	return ShmParamSlot::Open(name);
+}
+
+void ShmParamSlotDelete(ShmParamSlot* slot)
+{
+	delete slot;
+}
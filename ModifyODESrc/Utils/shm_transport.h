@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Shared memory transport between sampling processes and the learner on one machine.
+//
+// ShmTrajectoryRing is a ring of fixed size records (one simulation step each, the layout
+// is decided by the caller). Producers reserve a range of records with a CAS on the head,
+// write them in place and publish them by setting a per-record sequence number, so any
+// number of processes can append at the same time without a lock. The consumer reads the
+// published prefix in place and releases it.
+//
+// ShmParamSlot holds one byte blob (e.g. flattened policy weights) behind a seqlock:
+// one writer, any number of readers, readers retry if they raced with a write.
+//
+// The owner (created with the Create function) unlinks the shared memory on delete,
+// other processes attach with Open.
+
+class ShmRegion
+{
+public:
+	ShmRegion();
+	~ShmRegion();
+
+	ShmRegion(const ShmRegion&) = delete;
+	ShmRegion& operator=(const ShmRegion&) = delete;
+
+	// return false on failure
+	bool Create(const char* name, size_t size);
+	bool Open(const char* name);
+
+	void* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+private:
+	void Close();
+
+	void* data;
+	size_t size;
+	bool owner;
+	char name[256];
+#ifdef _WIN32
+	void* handle;
+#endif
+};
+
+class ShmTrajectoryRing
+{
+public:
+	// nullptr on failure. capacity is rounded up to a power of two.
+	static ShmTrajectoryRing* Create(const char* name, size_t record_size, size_t capacity);
+	static ShmTrajectoryRing* Open(const char* name);
+
+	size_t GetRecordSize() const;
+	size_t GetCapacity() const;
+
+	// records are stored in [0, capacity), sequence number s lives at s & (capacity - 1)
+	char* GetRecords() const { return records; }
+
+	// reserve count records for writing, return the first sequence number or -1 if full
+	long long Reserve(size_t count);
+
+	// publish the records [start, start + count) after they are written
+	void Commit(unsigned long long start, size_t count);
+
+	// number of published records from the read position on, at most max_count.
+	// the first one is returned in start.
+	size_t Ready(unsigned long long* start, size_t max_count) const;
+
+	// give back the first count ready records to producers
+	void Release(size_t count);
+
+	struct Header; // at the start of the shared memory
+
+private:
+	ShmTrajectoryRing() = default;
+	bool Attach();
+
+	ShmRegion region;
+	Header* header = nullptr;
+	std::atomic<uint64_t>* seq = nullptr;
+	char* records = nullptr;
+};
+
+class ShmParamSlot
+{
+public:
+	// nullptr on failure
+	static ShmParamSlot* Create(const char* name, size_t capacity);
+	static ShmParamSlot* Open(const char* name);
+
+	size_t GetCapacity() const;
+
+	// version of the last write, 0 if never written
+	uint64_t GetVersion() const;
+
+	// copy nbytes into the slot, return the new version or 0 if nbytes is larger than the capacity
+	uint64_t Write(const void* src, size_t nbytes);
+
+	// copy the blob into dst, return its version (0 if never written) and size in nbytes.
+	// if the blob is larger than dst_capacity, nothing is copied and the size is still returned.
+	uint64_t Read(void* dst, size_t dst_capacity, size_t* nbytes) const;
+
+	struct Header; // at the start of the shared memory
+
+private:
+	ShmParamSlot() = default;
+
+	ShmRegion region;
+	Header* header = nullptr;
+	char* data = nullptr;
+};
+
+ShmTrajectoryRing* ShmTrajectoryRingCreate(const char* name, size_t record_size, size_t capacity);
+ShmTrajectoryRing* ShmTrajectoryRingOpen(const char* name);
+void ShmTrajectoryRingDelete(ShmTrajectoryRing* ring);
+
+ShmParamSlot* ShmParamSlotCreate(const char* name, size_t capacity);
+ShmParamSlot* ShmParamSlotOpen(const char* name);
+void ShmParamSlotDelete(ShmParamSlot* slot);
@@ -0,0 +1,98 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int num_threads)
+{
+	if (num_threads <= 0)
+	{
+		num_threads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	for (int i = 1; i < num_threads; i++)
+	{
+		workers.emplace_back(&ThreadPool::worker_loop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	work_cv.notify_all();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+int ThreadPool::GetNumThreads() const
+{
+	return static_cast<int>(workers.size()) + 1;
+}
+
+void ThreadPool::run_items(const std::function<void(size_t)>& func, size_t count)
+{
+	for (size_t i = next_index.fetch_add(1); i < count; i = next_index.fetch_add(1))
+	{
+		func(i);
+	}
+}
+
+void ThreadPool::worker_loop()
+{
+	unsigned seen_generation = 0;
+	while (true)
+	{
+		const std::function<void(size_t)>* func = nullptr;
+		size_t count = 0;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			work_cv.wait(lock, [&] { return stop || generation != seen_generation; });
+			if (stop)
+			{
+				return;
+			}
+			seen_generation = generation;
+			if (job == nullptr) // woke up after the loop was finished
+			{
+				continue;
+			}
+			func = job;
+			count = job_count;
+			num_busy++;
+		}
+		run_items(*func, count);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			num_busy--;
+		}
+		done_cv.notify_one();
+	}
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& func)
+{
+	if (workers.empty() || count <= 1)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			func(i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &func;
+		job_count = count;
+		next_index.store(0);
+		generation++;
+	}
+	work_cv.notify_all();
+	run_items(func, count);
+
+	// workers that wake up late find no index left, or no job at all
+	std::unique_lock<std::mutex> lock(mutex);
+	done_cv.wait(lock, [&] { return num_busy == 0; });
+	job = nullptr;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads running parallel for loops.
+// Indices are handed out one at a time from a shared counter, so a thread that
+// finishes a cheap item takes the next one instead of waiting for a static
+// partition. The calling thread works on the loop too.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(int num_threads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// number of threads running a loop, including the calling thread
+	int GetNumThreads() const;
+
+	// call func(i) for i in [0, count), returns when all calls are done.
+	// Loops of one pool must not be nested or run from several threads at once.
+	void parallel_for(size_t count, const std::function<void(size_t)>& func);
+
+private:
+	void worker_loop();
+	void run_items(const std::function<void(size_t)>& func, size_t count);
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable work_cv;
+	std::condition_variable done_cv;
+
+	const std::function<void(size_t)>* job = nullptr;
+	size_t job_count = 0;
+	std::atomic<size_t> next_index{0};
+	unsigned generation = 0;
+	int num_busy = 0;
+	bool stop = false;
+};
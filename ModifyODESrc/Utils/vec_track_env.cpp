@@ -0,0 +1,216 @@
+#include "vec_track_env.h"
+#include "joint_local_quat_batch.h"
+#include "PDControlAdd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+struct VecTrackEnv::WorldSlot
+{
+	dJointGroupWithdWorld contact_info;
+	dSpaceID space = nullptr;
+	std::vector<dBodyID> bodies;
+	std::unique_ptr<JointPDController> pd_controller;  // stable PD torques, keeps the accumulated energy
+	std::vector<float> state;  // state of the last step, for the finite difference velocity
+
+	int step_cnt = 0;
+	int done_cnt = 0;
+};
+
+VecTrackEnv::VecTrackEnv(const VecTrackEnvConfig& config_, int num_threads) :
+	config(config_),
+	pool(num_threads)
+{
+
+}
+
+VecTrackEnv::~VecTrackEnv()
+{
+
+}
+
+int VecTrackEnv::AddWorld(
+	const dJointGroupWithdWorld& contact_info,
+	dSpaceID space,
+	const dJointID* joints,
+	int num_joints_,
+	const dBodyID* bodies,
+	int num_bodies_,
+	const double* kps,
+	const double* torque_limits)
+{
+	if (slots.empty())
+	{
+		num_joints = num_joints_;
+		num_bodies = num_bodies_;
+	}
+	else if (num_joints_ != num_joints || num_bodies_ != num_bodies)
+	{
+		return -1;
+	}
+
+	std::unique_ptr<WorldSlot> slot(new WorldSlot());
+	slot->contact_info = contact_info;
+	slot->space = space;
+	slot->bodies.assign(bodies, bodies + num_bodies);
+	slot->pd_controller.reset(new JointPDController(joints, num_joints, kps, torque_limits));
+	slot->state.resize(13 * num_bodies);
+	dBodiesGetState13(slot->bodies.data(), num_bodies, NULL, 0, slot->state.data());
+
+	slots.push_back(std::move(slot));
+	return static_cast<int>(slots.size()) - 1;
+}
+
+int VecTrackEnv::GetNumWorlds() const
+{
+	return static_cast<int>(slots.size());
+}
+
+int VecTrackEnv::GetNumJoints() const
+{
+	return num_joints;
+}
+
+int VecTrackEnv::GetNumBodies() const
+{
+	return num_bodies;
+}
+
+int VecTrackEnv::GetNumThreads() const
+{
+	return pool.GetNumThreads();
+}
+
+const VecTrackEnvConfig& VecTrackEnv::GetConfig() const
+{
+	return config;
+}
+
+int VecTrackEnv::GetStepCount(int world_index) const
+{
+	return slots[world_index]->step_cnt;
+}
+
+int VecTrackEnv::GetDoneCount(int world_index) const
+{
+	return slots[world_index]->done_cnt;
+}
+
+double VecTrackEnv::GetAccumEnergy(int world_index) const
+{
+	return slots[world_index]->pd_controller->GetAccumEnergy();
+}
+
+void VecTrackEnv::Reset(int world_index, const float* state, double ground_clearance, float* state_out, float* obs_out)
+{
+	WorldSlot& slot = *slots[world_index];
+	dBodiesSetState13(slot.bodies.data(), num_bodies, state);
+	dBodiesLiftAboveGround(slot.bodies.data(), num_bodies, ground_clearance);
+	dBodiesGetState13(slot.bodies.data(), num_bodies, NULL, 0, slot.state.data());
+	slot.step_cnt = 0;
+	slot.done_cnt = 0;
+	slot.pd_controller->SetAccumEnergy(0);
+
+	if (state_out != NULL)
+	{
+		std::copy(slot.state.begin(), slot.state.end(), state_out);
+	}
+	if (obs_out != NULL)
+	{
+		dState13ToObservation(slot.state.data(), num_bodies, obs_out);
+	}
+}
+
+void VecTrackEnv::Step(const double* actions, const double* target_height, float* state_out, float* obs_out, int* done_out)
+{
+	const size_t state_size = 13 * num_bodies, obs_size = 16 * num_bodies + 3;
+	pool.parallel_for(slots.size(), [&](size_t i)
+	{
+		step_world(*slots[i], actions + 3 * num_joints * i, target_height[i],
+			state_out + state_size * i, obs_out + obs_size * i, done_out + i);
+	});
+}
+
+void VecTrackEnv::step_world(WorldSlot& slot, const double* action, double target_height, float* state_out, float* obs_out, int* done_out)
+{
+	slot.pd_controller->SetTargetRotvec(action);
+
+	dJointGroupWithdWorld* info = &slot.contact_info;
+	const dReal sim_dt = config.control_dt / config.num_substep;
+	for (int sub = 0; sub < config.num_substep; sub++)
+	{
+		// DampedPDControler.add_torques_by_quat
+		slot.pd_controller->ApplyTarget();
+
+		// World.damped_step_fast_collision
+		dSpaceSweepFastBodies(slot.space, info->world, sim_dt, info, &dCollideContactFilter);
+		unsigned long long profile_begin = dWorldProfileBegin(info->world);
+		dSpaceCollide(slot.space, info, &dCollideContactCallback);
+		dWorldProfileEnd(info->world, dProfileBroadphase, profile_begin);
+		dWorldDampedStep(info->world, sim_dt);
+		dJointGroupEmpty(info->group);
+		profile_begin = dWorldProfileBegin(info->world);
+		dSpaceResortGeoms(slot.space);
+		dWorldProfileEnd(info->world, dProfileResortGeoms, profile_begin);
+	}
+
+	dBodiesGetState13(slot.bodies.data(), num_bodies,
+		config.recompute_velocity ? slot.state.data() : NULL, config.control_dt, slot.state.data());
+	std::copy(slot.state.begin(), slot.state.end(), state_out);
+	dState13ToObservation(state_out, num_bodies, obs_out);
+
+	*done_out = cal_done(slot, state_out, obs_out, target_height);
+	slot.step_cnt++;
+}
+
+int VecTrackEnv::cal_done(WorldSlot& slot, const float* state, const float* obs, double target_height) const
+{
+	const float height = state[13 * config.head_index + 1];
+	if (std::abs(height - target_height) > config.err_threshold)
+	{
+		slot.done_cnt++;
+	}
+	else
+	{
+		slot.done_cnt = std::max(0, slot.done_cnt - 1);
+	}
+
+	const int state_size = 13 * num_bodies, obs_size = 16 * num_bodies + 3;
+	for (int i = 0; i < state_size; i++)
+	{
+		if (!std::isfinite(state[i]))
+		{
+			return 2;
+		}
+	}
+	for (int i = 0; i < obs_size; i++)
+	{
+		if (std::abs(obs[i]) > 50)
+		{
+			return 2;
+		}
+	}
+
+	if (slot.step_cnt >= config.min_length)
+	{
+		if (slot.done_cnt >= config.err_length)
+		{
+			return 2;
+		}
+		if (slot.step_cnt >= config.max_length)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+VecTrackEnv* VecTrackEnvCreate(const VecTrackEnvConfig& config, int num_threads)
+{
+	return new VecTrackEnv(config, num_threads);
+}
+
+void VecTrackEnvDelete(VecTrackEnv* ptr)
+{
+	delete ptr;
+}
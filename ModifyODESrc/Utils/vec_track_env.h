@@ -0,0 +1,76 @@
+#pragma once
+#include <ode/ode.h>
+#include <memory>
+#include <vector>
+#include "thread_pool.h"
+
+// Parameters shared by all worlds of a VecTrackEnv, as the env_* arguments of VCLODETrackEnv
+struct VecTrackEnvConfig
+{
+	int num_substep = 6;
+	double control_dt = 1.0 / 20;  // dt of a control step, substeps use control_dt / num_substep
+	int recompute_velocity = 1;    // velocity of the state by finite difference over a control step
+	int head_index = 0;            // body used in the height test of cal_done
+	int min_length = 26;
+	int max_length = 512;
+	double err_threshold = 0.5;
+	int err_length = 20;
+};
+
+// N copies of a tracking scene stepped together, as VCLODETrackEnv.step_core does for one scene:
+// rotvec actions to target quaternions, stable PD torques and damped steps for every substep,
+// state and observation of the character, and the termination test cal_done.
+// Worlds are stepped on a ThreadPool. The worlds, spaces, joints and bodies are owned by the caller.
+class VecTrackEnv
+{
+public:
+	VecTrackEnv(const VecTrackEnvConfig& config_, int num_threads);
+	~VecTrackEnv();
+
+	// add a world, return its index, or -1 if the joint or body count differs from the first world
+	int AddWorld(
+		const dJointGroupWithdWorld& contact_info,
+		dSpaceID space,
+		const dJointID* joints,
+		int num_joints,
+		const dBodyID* bodies,
+		int num_bodies,
+		const double* kps,
+		const double* torque_limits
+	);
+
+	int GetNumWorlds() const;
+	int GetNumJoints() const;
+	int GetNumBodies() const;
+	int GetNumThreads() const;
+	const VecTrackEnvConfig& GetConfig() const;
+
+	int GetStepCount(int world_index) const;
+	int GetDoneCount(int world_index) const;
+	double GetAccumEnergy(int world_index) const;
+
+	// load a state in shape (num_bodies, 13), lift it above the ground as load_character_state,
+	// and restart the episode of the world. state_out and obs_out may be NULL.
+	void Reset(int world_index, const float* state, double ground_clearance, float* state_out, float* obs_out);
+
+	// actions:       (num_worlds, num_joints, 3) rotation vectors of the joint targets
+	// target_height: (num_worlds,) height of the head in the reference motion
+	// state_out:     (num_worlds, num_bodies, 13)
+	// obs_out:       (num_worlds, 16 * num_bodies + 3)
+	// done_out:      (num_worlds,) 0, 1 for reaching max_length, 2 for failure
+	void Step(const double* actions, const double* target_height, float* state_out, float* obs_out, int* done_out);
+
+private:
+	struct WorldSlot;
+	void step_world(WorldSlot& slot, const double* action, double target_height, float* state_out, float* obs_out, int* done_out);
+	int cal_done(WorldSlot& slot, const float* state, const float* obs, double target_height) const;
+
+	VecTrackEnvConfig config;
+	ThreadPool pool;
+	int num_joints = 0;
+	int num_bodies = 0;
+	std::vector<std::unique_ptr<WorldSlot> > slots;
+};
+
+VecTrackEnv* VecTrackEnvCreate(const VecTrackEnvConfig& config, int num_threads);
+void VecTrackEnvDelete(VecTrackEnv* ptr);
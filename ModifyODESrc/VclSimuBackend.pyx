@@ -24,6 +24,7 @@ from ModifyODE cimport *
 import numpy as np
 cimport numpy as np
 cimport cython
+import mmap
 import weakref
 np.import_array()
 
@@ -1133,6 +1134,57 @@ cdef class Contact:
         self.contactGeom1 = g1
         self.contactGeom2 = g2
 
+
+# Add by Zhenhua Song
+def _remap_ids(np.ndarray src_ids, np.ndarray new_ids, ids = None) -> np.ndarray:
+    """
+    map each id in ids from src_ids to the id at the same position in new_ids.
+    return new_ids if ids is None.
+    """
+    if ids is None:
+        return new_ids
+    ids = np.asarray(ids, dtype=np_size_t)
+    order = np.argsort(src_ids)
+    sorted_ids = src_ids[order]
+    pos = np.minimum(np.searchsorted(sorted_ids, ids), max(len(sorted_ids) - 1, 0))
+    if len(sorted_ids) == 0 or np.any(sorted_ids[pos] != ids):
+        raise ValueError("id not found in the cloned world")
+    return new_ids[order[pos]]
+
+# Add by Zhenhua Song
+# phases of World.get_profile, in the order of dProfileBroadphase ... dProfileResortGeoms
+profile_phase_names = (
+    "broadphase", "narrowphase", "contacts", "islands",
+    "preprocess", "create_j", "compute_a", "compute_rhs", "solve_lcp", "constraint_force",
+    "integrate_velocity", "integrate_position", "tidy_up", "resort_geoms"
+)
+
+profile_dtype = np.dtype([
+    ("steps", np.uint64),
+    ("seconds", [(name, np.float64) for name in profile_phase_names]),
+    ("calls", [(name, np.uint64) for name in profile_phase_names]),
+])
+
+# Add by Zhenhua Song
+cdef class PDControlWorkspace:
+    """
+    Buffers of World.get_pd_control_torque, kept by the PD controller so that
+    the per substep call does not allocate.
+    """
+    cdef CPDControlWorkspace * ptr
+
+    def __cinit__(self, int joint_count = 0):
+        self.ptr = PDControlWorkspaceCreate(joint_count)
+
+    def __dealloc__(self):
+        if self.ptr != NULL:
+            PDControlWorkspaceDelete(self.ptr)
+            self.ptr = NULL
+
+    @property
+    def capacity(self) -> int:
+        return self.ptr.GetCapacity()
+
 # World
 cdef class World:
     """Dynamics world.
@@ -1146,8 +1198,15 @@ cdef class World:
 
     cdef dWorldID wid  # pointer of the world
 
+    # numpy views on the contiguous body storage, read only and writeable, see body_state_views
+    cdef BodyStateViews state_views
+    cdef BodyStateViews state_views_writeable
+    cdef unsigned int state_views_epoch  # incremented when the storage is turned on or off
+
     def __cinit__(self):
         self.wid = dWorldCreate()
+        self.state_views = None
+        self.state_views_writeable = None
 
         # Add by Zhenhua Song
         self.contact_group.max_contact_num = 4
@@ -1165,6 +1224,8 @@ cdef class World:
 
     # Add by Zhenhua Song
     def destroy_immediate(self):
+        self.state_views = None
+        self.state_views_writeable = None
         if self.wid != NULL:
             dWorldDestroy(self.wid)
             self.wid = NULL
@@ -1222,6 +1283,300 @@ cdef class World:
     def soft_erp(self, value):
         self.contact_group.soft_erp = value
 
+    @property
+    def rand_seed(self) -> int:
+        """
+        random state used while stepping this world, separate from SetInitSeed,
+        so worlds stepped in parallel are deterministic each on its own.
+        A new world starts from the global seed.
+        Only the random constraint reordering of the quick step draws from it, which is
+        compiled in only with RANDOMLY_REORDER_CONSTRAINTS (off by default in quickstep.cpp),
+        so by default it has no effect on stepping.
+        """
+        return dWorldGetRandSeed(self.wid)
+
+    @rand_seed.setter
+    def rand_seed(self, unsigned long value):
+        dWorldSetRandSeed(self.wid, value)
+
+    # Add by Zhenhua Song
+    @property
+    def profiling(self) -> bool:
+        return dWorldGetProfiling(self.wid) != 0
+
+    @profiling.setter
+    def profiling(self, bint value):
+        """
+        Time the phases of collision detection and stepping of this world.
+        Accumulated times are kept when profiling is turned off.
+        """
+        dWorldSetProfiling(self.wid, value)
+
+    def reset_profile(self):
+        dWorldResetProfile(self.wid)
+
+    def get_profile(self) -> np.ndarray:
+        """
+        Accumulated phase times as a 0-d array of profile_dtype, e.g.
+        profile["seconds"]["solve_lcp"] / profile["steps"] is the LCP time per step.
+        broadphase and resort_geoms are only timed by the *_fast_collision steps.
+        """
+        cdef dWorldProfile prof
+        dWorldGetProfile(self.wid, &prof)
+        cdef np.ndarray res = np.zeros((), dtype=profile_dtype)
+        res["steps"] = prof.steps
+        cdef int i
+        for i in range(dProfilePhaseCount):
+            res["seconds"][profile_phase_names[i]] = prof.seconds[i]
+            res["calls"][profile_phase_names[i]] = prof.calls[i]
+        return res
+
+    @property
+    def contiguous_body_storage(self) -> bool:
+        return dWorldGetContiguousBodyStorage(self.wid) != 0
+
+    @contiguous_body_storage.setter
+    def contiguous_body_storage(self, bint value):
+        """
+        Keep the position, rotation, quaternion and velocities of all bodies in
+        contiguous arrays, which can be read in place through body_state_views.
+        """
+        dWorldSetContiguousBodyStorage(self.wid, value)
+        self.state_views_epoch += 1
+        self.state_views = None
+        self.state_views_writeable = None
+
+    def reserve_body_storage(self, int capacity):
+        """
+        Make room for capacity bodies in the contiguous storage, so creating
+        bodies up to that number does not invalidate the state views.
+        """
+        dWorldReserveBodyStorage(self.wid, capacity)
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_body_storage_index(self, np.ndarray np_id) -> np.ndarray:
+        """
+        input: np.ndarray in shape (num_body,) with dtype == np.uint64 for body pointer
+        return: the rows of the bodies in body_state_views, -1 for NULL bodies
+        """
+        cdef size_t cnt = np_id.size
+        cdef np.ndarray[np.int64_t, ndim=1] np_index = np.empty(cnt, np.int64)
+        cdef dBodyID * res_id = <dBodyID *> np_id.data
+        cdef size_t idx = 0
+        while idx < cnt:
+            np_index[idx] = dBodyGetStorageIndex(res_id[idx]) if res_id[idx] != NULL else -1
+            idx += 1
+        return np_index
+
+    def body_state_views(self, bint writeable = False):
+        """
+        numpy views on the contiguous body storage, without copy, as a BodyStateViews:
+        'pos' (nb, 3), 'rot' (nb, 3, 3), 'quat' (nb, 4) in ODE order (w, x, y, z),
+        'linvel' (nb, 3) and 'angvel' (nb, 3). Row i is the body with storage_index i.
+
+        The same object is returned for the same writeable mode until a body is created
+        or destroyed, which may move or reorder the storage. Indexing the object after
+        that raises RuntimeError, so keep the BodyStateViews and index it where the
+        arrays are used, not the arrays themselves. With writeable=True, pos, linvel and
+        angvel can be written in place; call body_storage_moved afterwards so the geoms follow.
+        """
+        cdef dBodyStorageInfo info
+        if not dWorldGetBodyStorage(self.wid, &info):
+            raise ValueError("contiguous_body_storage is not enabled")
+
+        cdef BodyStateViews views = self.state_views_writeable if writeable else self.state_views
+        if views is not None and views.valid:
+            return views
+
+        views = BodyStateViews.__new__(BodyStateViews)
+        views.world = self
+        views.epoch = self.state_views_epoch
+        views.generation = info.generation
+        views.num_bodies = info.num_bodies
+        views.writeable = writeable
+        posr = self._storage_array(info.posr, info.num_bodies, 16)
+        views.views = {
+            "pos": posr[:, 0:3],
+            "rot": posr[:, 4:16].reshape((info.num_bodies, 3, 4))[:, :, 0:3],
+            "quat": self._storage_array(info.q, info.num_bodies, 4),
+            "linvel": self._storage_array(info.lvel, info.num_bodies, 4)[:, 0:3],
+            "angvel": self._storage_array(info.avel, info.num_bodies, 4)[:, 0:3],
+        }
+        for key, value in views.views.items():
+            value.flags.writeable = writeable and key in ("pos", "linvel", "angvel")
+        if writeable:
+            self.state_views_writeable = views
+        else:
+            self.state_views = views
+        return views
+
+    cdef np.ndarray _storage_array(self, dReal * data, int num_bodies, int row_size):
+        cdef np.npy_intp dims[2]
+        dims[0] = num_bodies
+        dims[1] = row_size
+        cdef np.ndarray arr = np.PyArray_SimpleNewFromData(2, dims, np.NPY_FLOAT64, <void *> data)
+        np.set_array_base(arr, self)  # the world must outlive the views
+        return arr
+
+    def body_storage_moved(self):
+        """
+        Mark the geoms of all bodies as moved, after writing positions through body_state_views.
+        """
+        dWorldBodyStorageMoved(self.wid)
+
+    @property
+    def snapshot_size(self) -> int:
+        """
+        bytes needed by snapshot(). It changes when bodies, joints or geoms are added or removed.
+        """
+        return dWorldGetSnapshotSize(self.wid)
+
+    def snapshot(self, buffer = None):
+        """snapshot(buffer = None)
+
+        Copy the dynamic state of the world (bodies, joints, random seed, geom order in the spaces,
+        hash space auto levels) into buffer, a writable bytes-like object of at least snapshot_size bytes.
+        If buffer is None, a new np.uint8 array is allocated. Return the written part of the buffer.
+        Take the snapshot between steps, when the contact joint group is empty.
+        Raise ValueError if body geoms are in a sweep-and-prune or quadtree space, whose order cannot be restored.
+        """
+        if buffer is None:
+            buffer = np.empty(dWorldGetSnapshotSize(self.wid), dtype=np.uint8)
+        cdef unsigned char[::1] view = buffer
+        cdef size_t written
+        with nogil:
+            written = dWorldSnapshot(self.wid, <void *> &view[0], view.shape[0])
+        if written == 0:
+            if <size_t> view.shape[0] >= dWorldGetSnapshotSize(self.wid):
+                raise ValueError("snapshot supports simple and hash spaces only, not sweep-and-prune or quadtree spaces")
+            raise ValueError("buffer of %d bytes is too small, %d bytes are needed" % (view.shape[0], dWorldGetSnapshotSize(self.wid)))
+        return buffer[:written]
+
+    def restore(self, buffer):
+        """restore(buffer)
+
+        Restore a snapshot taken from this world. Stepping afterwards reproduces the original
+        trajectory bit for bit, also with HashSpace.auto_levels on. Raise ValueError if the buffer
+        does not match the world.
+        """
+        cdef const unsigned char[::1] view = buffer
+        cdef int ok
+        with nogil:
+            ok = dWorldRestore(self.wid, <const void *> &view[0], view.shape[0])
+        if not ok:
+            raise ValueError("snapshot does not match the world")
+
+    def clone(self, SpaceBase space, body_ids = None, joint_ids = None):
+        """clone(space, body_ids = None, joint_ids = None)
+
+        Deep copy of the world and of the geoms in space, in native code (see dWorldClone).
+        Bodies, joints (with damping), geoms (with character ids, indices and contact attributes)
+        and the contact parameters of this World are copied, and the copy steps exactly like this world.
+        Return (world, space, body_ids, joint_ids): the new World and space, and the ids of the copies
+        of body_ids and joint_ids (all bodies / joints in list order if None), as np_size_t arrays.
+        The copied geoms have no GeomObject, they are owned by the new space.
+        Take the copy between steps, when the contact joint group is empty.
+        """
+        cdef int nb = dWorldGetNumBody(self.wid)
+        cdef int nj = dWorldGetNumJoints(self.wid)
+        cdef int ng = dSpaceGetNumGeoms(space.sid)
+        cdef np.ndarray src_body = np.zeros(nb, dtype=np_size_t)
+        cdef np.ndarray new_body = np.zeros(nb, dtype=np_size_t)
+        cdef np.ndarray src_joint = np.zeros(nj, dtype=np_size_t)
+        cdef np.ndarray new_joint = np.zeros(nj, dtype=np_size_t)
+        cdef np.ndarray src_geom = np.zeros(ng, dtype=np_size_t)
+        cdef np.ndarray new_geom = np.zeros(ng, dtype=np_size_t)
+        cdef dSpaceID new_sid = NULL
+        cdef dWorldID new_wid = NULL
+        with nogil:
+            new_wid = dWorldClone(self.wid, space.sid, &new_sid,
+                                  <dBodyID *> src_body.data, <dBodyID *> new_body.data,
+                                  <dJointID *> src_joint.data, <dJointID *> new_joint.data,
+                                  <dGeomID *> src_geom.data, <dGeomID *> new_geom.data)
+        if new_wid == NULL:
+            raise ValueError("the space can not be cloned: it should be a simple or hash space without sub spaces, "
+                             "holding sphere, box, capsule, cylinder, plane, ray or trimesh geoms of this world")
+
+        cdef World res = World()
+        dWorldDestroy(res.wid)
+        res.wid = new_wid
+        res.contact_group.world = new_wid
+        res.contact_group.max_contact_num = self.contact_group.max_contact_num
+        res.contact_group.use_max_force_contact = self.contact_group.use_max_force_contact
+        res.contact_group.use_soft_contact = self.contact_group.use_soft_contact
+        res.contact_group.soft_cfm = self.contact_group.soft_cfm
+        res.contact_group.soft_erp = self.contact_group.soft_erp
+        res.contact_group.self_collision = self.contact_group.self_collision
+
+        cdef SpaceBase res_space = HashSpace() if dGeomGetClass(<dGeomID> new_sid) == dHashSpaceClass else SimpleSpace()
+        dSpaceDestroy(res_space.sid)
+        res_space.sid = new_sid
+        res_space.gid = <dGeomID> new_sid
+        res_space._setData(res_space)
+
+        return res, res_space, _remap_ids(src_body, new_body, body_ids), _remap_ids(src_joint, new_joint, joint_ids)
+
+    def character_state(self, np.ndarray np_id, np.ndarray state_out, np.ndarray obs_out = None,
+                        np.ndarray prev_state = None, dReal dt = 0):
+        """
+        Write the state of the bodies into state_out, float32 in shape (num_body, 13):
+        position, quaternion in scipy order with w >= 0, linear and angular velocity.
+        If prev_state is given (it can be state_out itself), the velocities are the
+        backward finite difference over dt from it, as resample in motion_utils.py.
+        If obs_out is given, the observation of state2ob is written there too,
+        float32 in shape (16 * num_body + 3,), the first body being the root.
+        """
+        cdef int cnt = np_id.size
+        cdef const float * prev_ptr = NULL
+        if np_id.dtype != np.uint64:
+            raise ValueError("body id should be np.uint64")
+        if state_out.dtype != np.float32 or not state_out.flags.c_contiguous or state_out.size != 13 * cnt:
+            raise ValueError("state_out should be a contiguous float32 array with 13 * num_body elements")
+        if prev_state is not None:
+            if prev_state.dtype != np.float32 or not prev_state.flags.c_contiguous or prev_state.size != 13 * cnt:
+                raise ValueError("prev_state should be a contiguous float32 array with 13 * num_body elements")
+            if dt <= 0:
+                raise ValueError("dt should be positive with prev_state")
+            prev_ptr = <const float *> prev_state.data
+        if obs_out is not None and (obs_out.dtype != np.float32 or not obs_out.flags.c_contiguous
+                                    or obs_out.size != 16 * cnt + 3):
+            raise ValueError("obs_out should be a contiguous float32 array with 16 * num_body + 3 elements")
+
+        cdef const dBodyID * res_id = <const dBodyID *> np_id.data
+        cdef float * state_ptr = <float *> state_out.data
+        cdef float * obs_ptr = <float *> obs_out.data if obs_out is not None else NULL
+        with nogil:
+            dBodiesGetState13(res_id, cnt, prev_ptr, dt, state_ptr)
+            if obs_ptr != NULL:
+                dState13ToObservation(state_ptr, cnt, obs_ptr)
+
+    def load_state13(self, np.ndarray np_id, np.ndarray state, ground_clearance = None) -> float:
+        """
+        Set position, quaternion, rotation matrix, linear and angular velocity of the bodies
+        from a state in shape (num_body, 13), in the layout of character_state.
+        If ground_clearance is not None and the lowest geom AABB is below y = 0, the bodies
+        are moved up so that it is at y = ground_clearance.
+        return: the distance the bodies were moved up
+        """
+        cdef int cnt = np_id.size
+        if np_id.dtype != np.uint64:
+            raise ValueError("body id should be np.uint64")
+        cdef np.ndarray state_buf = np.ascontiguousarray(state, dtype=np.float32)
+        if state_buf.size != 13 * cnt:
+            raise ValueError("state should have 13 * num_body elements")
+
+        cdef const dBodyID * res_id = <const dBodyID *> np_id.data
+        cdef const float * state_ptr = <const float *> state_buf.data
+        cdef bint lift = ground_clearance is not None
+        cdef dReal clearance = ground_clearance if lift else 0
+        cdef dReal res = 0
+        with nogil:
+            dBodiesSetState13(res_id, cnt, state_ptr)
+            if lift:
+                res = dBodiesLiftAboveGround(res_id, cnt, clearance)
+        return res
+
     # Add by Zhenhua Song
     def __eq__(self, World other):
         return self.wid == other.wid
@@ -1317,16 +1672,43 @@ cdef class World:
         dWorldSetCFM(self.wid, cfm)
 
     # Add by Zhenhua Song
+    # The stepping methods release the GIL, so independent worlds can be stepped from several threads.
     def dampedStep(self, dReal stepsize):
         # Add Damping in Simulation
-        dWorldDampedStep(self.wid, stepsize)  # Add by Libin Liu in C++ code
+        cdef dWorldID wid = self.wid
+        with nogil:
+            dWorldDampedStep(wid, stepsize)  # Add by Libin Liu in C++ code
 
     # Add by Zhenhua Song
     def damped_step_fast_collision(self, SpaceBase space, dReal stepsize):
-        space.fast_collide(&(self.contact_group))  # collision detection
-        dWorldDampedStep(self.wid, stepsize)  # forward simulation
-        dJointGroupEmpty(self.contact_group.group)  # clear the contact joint
-        dSpaceResortGeoms(space.sid)  # resort geometries, make sure simulation result is same when state is same
+        cdef dWorldID wid = self.wid
+        cdef dSpaceID sid = space.sid
+        cdef dJointGroupWithdWorld * info = &(self.contact_group)
+        cdef unsigned long long profile_begin
+        with nogil:
+            dSpaceSweepFastBodies(sid, info.world, stepsize, <void*> info, &dCollideContactFilter)  # advance fast moving bodies to their time of impact
+            profile_begin = dWorldProfileBegin(wid)
+            dSpaceCollide(sid, <void*> info, &dCollideContactCallback)  # collision detection
+            dWorldProfileEnd(wid, dProfileBroadphase, profile_begin)
+            dWorldDampedStep(wid, stepsize)  # forward simulation
+            dJointGroupEmpty(info.group)  # clear the contact joint
+            profile_begin = dWorldProfileBegin(wid)
+            dSpaceResortGeoms(sid)  # resort geometries, make sure simulation result is same when state is same
+            dWorldProfileEnd(wid, dProfileResortGeoms, profile_begin)
+
+    # Add by Zhenhua Song
+    def sweep_fast_bodies(self, SpaceBase space, dReal stepsize) -> int:
+        """
+        Advance the bodies with fast_moving set to their time of impact in space,
+        for stepping paths that collide in python (ODEScene.pre_simulate_step).
+        Call it right before space.collide, return the number of advanced bodies.
+        """
+        cdef dSpaceID sid = space.sid
+        cdef dJointGroupWithdWorld * info = &(self.contact_group)
+        cdef int advanced
+        with nogil:
+            advanced = dSpaceSweepFastBodies(sid, info.world, stepsize, <void*> info, &dCollideContactFilter)
+        return advanced
 
     def step(self, dReal stepsize):
         """step(stepsize)
@@ -1348,15 +1730,27 @@ cdef class World:
         # 5. Solve LCP
         # 6. Calc Constraint Force
         # 7. Calc Acc, Velocity, Position
-        dWorldStep(self.wid, stepsize)
+        cdef dWorldID wid = self.wid
+        with nogil:
+            dWorldStep(wid, stepsize)
 
     # Add by Zhenhua Song. Collision detection is done in cython, not in python.
     def step_fast_collision(self, SpaceBase space, dReal stepsize):
         # This will accelerate by 1.2 times
-        space.fast_collide(&self.contact_group)
-        dWorldStep(self.wid, stepsize)
-        dJointGroupEmpty(self.contact_group.group)
-        dSpaceResortGeoms(space.sid)  # resort geometries, make sure simulation result is same when state is same
+        cdef dWorldID wid = self.wid
+        cdef dSpaceID sid = space.sid
+        cdef dJointGroupWithdWorld * info = &(self.contact_group)
+        cdef unsigned long long profile_begin
+        with nogil:
+            dSpaceSweepFastBodies(sid, info.world, stepsize, <void*> info, &dCollideContactFilter)
+            profile_begin = dWorldProfileBegin(wid)
+            dSpaceCollide(sid, <void*> info, &dCollideContactCallback)
+            dWorldProfileEnd(wid, dProfileBroadphase, profile_begin)
+            dWorldStep(wid, stepsize)
+            dJointGroupEmpty(info.group)
+            profile_begin = dWorldProfileBegin(wid)
+            dSpaceResortGeoms(sid)  # resort geometries, make sure simulation result is same when state is same
+            dWorldProfileEnd(wid, dProfileResortGeoms, profile_begin)
 
     def quickStep(self, dReal stepsize):
         """quickStep(stepsize)
@@ -1372,7 +1766,9 @@ cdef class World:
         @param stepsize: Time step
         @type stepsize: float
         """
-        dWorldQuickStep(self.wid, stepsize)
+        cdef dWorldID wid = self.wid
+        with nogil:
+            dWorldQuickStep(wid, stepsize)
 
     @property
     def QuickStepNumIterations(self):
@@ -1801,15 +2197,16 @@ cdef class World:
 
         cdef const dReal* p
 
-        while idx < cnt:
-            b = res_id[idx]
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
 
-            p  = dBodyGetPosition(b)
-            res_pos[3 * idx + 0] = p[0]
-            res_pos[3 * idx + 1] = p[1]
-            res_pos[3 * idx + 2] = p[2]
+                p  = dBodyGetPosition(b)
+                res_pos[3 * idx + 0] = p[0]
+                res_pos[3 * idx + 1] = p[1]
+                res_pos[3 * idx + 2] = p[2]
 
-            idx += 1
+                idx += 1
 
         return np_pos
 
@@ -1828,21 +2225,22 @@ cdef class World:
         cdef dBodyID b
         cdef const dReal * q_ode
 
-        while idx < cnt:
-            b = res_id[idx]
-            if b == NULL:
-                res_quat[4 * idx + 0] = 0
-                res_quat[4 * idx + 1] = 0
-                res_quat[4 * idx + 2] = 0
-                res_quat[4 * idx + 3] = 1
-            else:
-                q_ode = dBodyGetQuaternion(b)
-                res_quat[4 * idx + 0] = q_ode[1]
-                res_quat[4 * idx + 1] = q_ode[2]
-                res_quat[4 * idx + 2] = q_ode[3]
-                res_quat[4 * idx + 3] = q_ode[0]
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                if b == NULL:
+                    res_quat[4 * idx + 0] = 0
+                    res_quat[4 * idx + 1] = 0
+                    res_quat[4 * idx + 2] = 0
+                    res_quat[4 * idx + 3] = 1
+                else:
+                    q_ode = dBodyGetQuaternion(b)
+                    res_quat[4 * idx + 0] = q_ode[1]
+                    res_quat[4 * idx + 1] = q_ode[2]
+                    res_quat[4 * idx + 2] = q_ode[3]
+                    res_quat[4 * idx + 3] = q_ode[0]
 
-            idx += 1
+                idx += 1
 
         return np_quat
 
@@ -1859,17 +2257,18 @@ cdef class World:
         cdef int idx = 0
         cdef dBodyID b = NULL
         cdef const dReal * m = NULL
-        while idx < cnt:
-            b = res_id[idx]
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
 
-            if b != NULL:
-                m = dBodyGetRotation(b)
-                ODEMat3ToDenseMat3(m, res_rot, 9 * idx)
-            else:
-                memset(res_rot + 9 * idx, 0, sizeof(dReal) * 9)
-                res_rot[9 * idx + 0] = res_rot[9 * idx + 4] = res_rot[9 * idx + 8] = 1
+                if b != NULL:
+                    m = dBodyGetRotation(b)
+                    ODEMat3ToDenseMat3(m, res_rot, 9 * idx)
+                else:
+                    memset(res_rot + 9 * idx, 0, sizeof(dReal) * 9)
+                    res_rot[9 * idx + 0] = res_rot[9 * idx + 4] = res_rot[9 * idx + 8] = 1
 
-            idx += 1
+                idx += 1
 
         return np_rot
 
@@ -1888,18 +2287,19 @@ cdef class World:
         cdef int idx = 0
         cdef dBodyID b
 
-        while idx < cnt:
-            b = res_id[idx]
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
 
-            if b != NULL:
-                linvel = dBodyGetLinearVel(b)
-                res_lin_vel[3 * idx + 0] = linvel[0]
-                res_lin_vel[3 * idx + 1] = linvel[1]
-                res_lin_vel[3 * idx + 2] = linvel[2]
-            else:
-                res_lin_vel[3 * idx + 0] = res_lin_vel[3 * idx + 1] = res_lin_vel[3 * idx + 2] = 0
+                if b != NULL:
+                    linvel = dBodyGetLinearVel(b)
+                    res_lin_vel[3 * idx + 0] = linvel[0]
+                    res_lin_vel[3 * idx + 1] = linvel[1]
+                    res_lin_vel[3 * idx + 2] = linvel[2]
+                else:
+                    res_lin_vel[3 * idx + 0] = res_lin_vel[3 * idx + 1] = res_lin_vel[3 * idx + 2] = 0
 
-            idx += 1
+                idx += 1
 
         return np_lin_vel
 
@@ -1918,18 +2318,19 @@ cdef class World:
         cdef int idx = 0
         cdef dBodyID b
 
-        while idx < cnt:
-            b = res_id[idx]
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
 
-            if b != NULL:
-                angvel = dBodyGetAngularVel(b)
-                res_ang_vel[3 * idx + 0] = angvel[0]
-                res_ang_vel[3 * idx + 1] = angvel[1]
-                res_ang_vel[3 * idx + 2] = angvel[2]
-            else:
-                res_ang_vel[3 * idx + 0] = res_ang_vel[3 * idx + 1] = res_ang_vel[3 * idx + 2] = 0
+                if b != NULL:
+                    angvel = dBodyGetAngularVel(b)
+                    res_ang_vel[3 * idx + 0] = angvel[0]
+                    res_ang_vel[3 * idx + 1] = angvel[1]
+                    res_ang_vel[3 * idx + 2] = angvel[2]
+                else:
+                    res_ang_vel[3 * idx + 0] = res_ang_vel[3 * idx + 1] = res_ang_vel[3 * idx + 2] = 0
 
-            idx += 1
+                idx += 1
         return np_ang_vel
 
     # Add by Zhenhua Song
@@ -1946,12 +2347,13 @@ cdef class World:
         cdef int idx = 0
         cdef dBodyID b
         cdef const dReal * force
-        while idx < cnt:
-            b = res_id[idx]
-            if b != NULL:
-                force = dBodyGetForce(b)
-                memcpy(np_force_ptr + 3 * idx, force, sizeof(dReal) * 3)
-            idx += 1
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                if b != NULL:
+                    force = dBodyGetForce(b)
+                    memcpy(np_force_ptr + 3 * idx, force, sizeof(dReal) * 3)
+                idx += 1
 
         return np_force
 
@@ -1969,12 +2371,13 @@ cdef class World:
         cdef int idx = 0
         cdef dBodyID b
         cdef const dReal * torque
-        while idx < cnt:
-            b = res_id[idx]
-            if b != NULL:
-                torque = dBodyGetTorque(b)
-                memcpy(np_torque_ptr + 3 * idx, torque, sizeof(dReal) * 3)
-            idx += 1
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                if b != NULL:
+                    torque = dBodyGetTorque(b)
+                    memcpy(np_torque_ptr + 3 * idx, torque, sizeof(dReal) * 3)
+                idx += 1
 
         return np_torque
 
@@ -1991,12 +2394,13 @@ cdef class World:
         cdef int idx = 0
         cdef dBodyID b
         cdef dMatrix3 res
-        while idx < cnt:
-            b = res_id[idx]
-            if b != NULL:
-                dBodyGetInertia(b, res)
-                ODEMat3ToDenseMat3(res, np_inertia_ptr, 9 * idx)
-            idx += 1
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                if b != NULL:
+                    dBodyGetInertia(b, res)
+                    ODEMat3ToDenseMat3(res, np_inertia_ptr, 9 * idx)
+                idx += 1
 
         return np_inertia
 
@@ -2012,12 +2416,13 @@ cdef class World:
         cdef int idx = 0
         cdef dBodyID b
         cdef dMatrix3 res
-        while idx < cnt:
-            b = res_id[idx]
-            if b != NULL:
-                dBodyGetInertiaInv(b, res)
-                ODEMat3ToDenseMat3(res, np_inertia_inv_ptr, 9 * idx)
-            idx += 1
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                if b != NULL:
+                    dBodyGetInertiaInv(b, res)
+                    ODEMat3ToDenseMat3(res, np_inertia_inv_ptr, 9 * idx)
+                idx += 1
 
         return np_inertia_inv
 
@@ -2069,11 +2474,13 @@ cdef class World:
 
         cdef int idx = 0
         cdef int cnt = np_id_buff.size
+        cdef dBodyID b = NULL
 
-        while idx < cnt:
-            b = res_id[idx]
-            dBodySetPosition(b, res_pos[3 * idx], res_pos[3 * idx + 1], res_pos[3 * idx + 2])
-            idx += 1
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                dBodySetPosition(b, res_pos[3 * idx], res_pos[3 * idx + 1], res_pos[3 * idx + 2])
+                idx += 1
 
     # Add by Zhenhua Song
     # input
@@ -2088,18 +2495,21 @@ cdef class World:
         cdef const dReal * res_quat = <const dReal *> np_quat_buff.data
         cdef int idx = 0
         cdef int cnt = np_id_buff.size
+        cdef dBodyID b = NULL
         cdef dQuaternion q_ode
-        while idx < cnt:
-            b = res_id[idx]
+        cdef const dReal * q_scipy = NULL
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
 
-            q_scipy = &res_quat[4 * idx]
-            q_ode[0] = q_scipy[3]
-            q_ode[1] = q_scipy[0]
-            q_ode[2] = q_scipy[1]
-            q_ode[3] = q_scipy[2]
-            dBodySetQuaternion(b, q_ode)
+                q_scipy = &res_quat[4 * idx]
+                q_ode[0] = q_scipy[3]
+                q_ode[1] = q_scipy[0]
+                q_ode[2] = q_scipy[1]
+                q_ode[3] = q_scipy[2]
+                dBodySetQuaternion(b, q_ode)
 
-            idx += 1
+                idx += 1
 
     # Add by Zhenhua Song
     # input
@@ -2124,18 +2534,19 @@ cdef class World:
         cdef dQuaternion q_ode
         cdef const dReal * q_scipy = NULL
 
-        while idx < cnt:
-            b = res_id[idx]
-            DenseMat3ToODEMat3(m, res_rot, 9 * idx)
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                DenseMat3ToODEMat3(m, res_rot, 9 * idx)
 
-            q_scipy = &res_quat[4 * idx]
-            q_ode[0] = q_scipy[3]
-            q_ode[1] = q_scipy[0]
-            q_ode[2] = q_scipy[1]
-            q_ode[3] = q_scipy[2]
-            dBodySetRotAndQuatNoNorm(b, m, q_ode)
+                q_scipy = &res_quat[4 * idx]
+                q_ode[0] = q_scipy[3]
+                q_ode[1] = q_scipy[0]
+                q_ode[2] = q_scipy[1]
+                q_ode[3] = q_scipy[2]
+                dBodySetRotAndQuatNoNorm(b, m, q_ode)
 
-            idx += 1
+                idx += 1
 
     # Add by Zhenhua Song
     # input
@@ -2150,10 +2561,11 @@ cdef class World:
         cdef dBodyID b = NULL
         cdef int idx = 0
         cdef int cnt = np_id.size
-        while idx < cnt:
-            b = res_id[idx]
-            dBodySetLinearVel(b, res_linvel[3 * idx + 0], res_linvel[3 * idx + 1], res_linvel[3 * idx + 2])
-            idx += 1
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                dBodySetLinearVel(b, res_linvel[3 * idx + 0], res_linvel[3 * idx + 1], res_linvel[3 * idx + 2])
+                idx += 1
 
     # Add by Zhenhua Song
     # input
@@ -2168,10 +2580,11 @@ cdef class World:
         cdef dBodyID b = NULL
         cdef int idx = 0
         cdef int cnt = np_id.size
-        while idx < cnt:
-            b = res_id[idx]
-            dBodySetAngularVel(b, res_angvel[3 * idx + 0], res_angvel[3 * idx + 1], res_angvel[3 * idx + 2])
-            idx += 1
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                dBodySetAngularVel(b, res_angvel[3 * idx + 0], res_angvel[3 * idx + 1], res_angvel[3 * idx + 2])
+                idx += 1
 
     # Add by Zhenhua Song
     # input
@@ -2185,10 +2598,11 @@ cdef class World:
         cdef const dReal * res_force = <const dReal *> np_force_buff.data
         cdef dBodyID b = NULL
         cdef int idx = 0, cnt = np_id.size
-        while idx < cnt:
-            b = res_id[idx]
-            dBodySetForce(b, res_force[3 * idx + 0], res_force[3 * idx + 1], res_force[3 * idx + 2])
-            idx += 1
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                dBodySetForce(b, res_force[3 * idx + 0], res_force[3 * idx + 1], res_force[3 * idx + 2])
+                idx += 1
 
     # Add by Zhenhua Song
     # - np_id    : np.ndarray in shape (num_body,) with dtype == np.uint64 for body pointer
@@ -2201,10 +2615,11 @@ cdef class World:
         cdef const dReal * res_torque = <const dReal *> np_torque_buff.data
         cdef dBodyID b = NULL
         cdef int idx = 0, cnt = np_id.size
-        while idx < cnt:
-            b = res_id[idx]
-            dBodySetTorque(b, res_torque[3 * idx + 0], res_torque[3 * idx + 1], res_torque[3 * idx + 2])
-            idx += 1
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                dBodySetTorque(b, res_torque[3 * idx + 0], res_torque[3 * idx + 1], res_torque[3 * idx + 2])
+                idx += 1
 
     # Add by Zhenhua Song
     @cython.boundscheck(False)
@@ -2240,10 +2655,11 @@ cdef class World:
         cdef dBodyID b = NULL
         cdef int idx = 0
         cdef int cnt = np_id.size
-        while idx < cnt:
-            b = res_id[idx]
-            dBodyAddForce(b, res_f[3 * idx + 0], res_f[3 * idx + 1], res_f[3 * idx + 2])
-            idx += 1
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                dBodyAddForce(b, res_f[3 * idx + 0], res_f[3 * idx + 1], res_f[3 * idx + 2])
+                idx += 1
 
     # Add by Zhenhua Song
     # - np_id  : np.ndarray in shape (num_body,) with dtype == np.uint64 for body pointer
@@ -2258,10 +2674,11 @@ cdef class World:
         cdef int idx = 0
         cdef int cnt = np_id.size
         # print(np_id, np_tor)
-        while idx < cnt:
-            b = res_id[idx]
-            dBodyAddTorque(b, res_tor[3 * idx + 0], res_tor[3 * idx + 1], res_tor[3 * idx + 2])
-            idx += 1
+        with nogil:
+            while idx < cnt:
+                b = res_id[idx]
+                dBodyAddTorque(b, res_tor[3 * idx + 0], res_tor[3 * idx + 1], res_tor[3 * idx + 2])
+                idx += 1
 
     # Add by Zhenhua Song
     # return raw anchor1, raw anchor 2
@@ -2490,30 +2907,121 @@ cdef class World:
                               np.ndarray joint_id,
                               local_target_quat_in: np.ndarray,
                               kps_in: np.ndarray,
-                              tor_lim_in: np.ndarray):
+                              tor_lim_in: np.ndarray,
+                              np.ndarray local_torque_out = None,
+                              np.ndarray global_torque_out = None,
+                              PDControlWorkspace workspace = None,
+                              kds_in = None):
+        """
+        local_torque_out, global_torque_out: if given, C contiguous float64 arrays of shape (joint_count, 3)
+        the torques are written into (and returned). Else new arrays are returned.
+        workspace: buffers reused between calls, else a workspace of the calling thread is used.
+        kds_in: if given, the full PD of World.step: kd * joint angular velocity (in parent frame) is subtracted.
+        """
         assert joint_id.dtype == np_size_t
         cdef int joint_count = joint_id.size
-        cdef np.ndarray[np.float64_t, ndim=2] local_torque = np.zeros((joint_count, 3), dtype=np.float64)
-        cdef np.ndarray[np.float64_t, ndim=2] global_torque = np.zeros((joint_count, 3), dtype=np.float64)
+        cdef np.ndarray local_torque = local_torque_out
+        cdef np.ndarray global_torque = global_torque_out
+        if local_torque is None:
+            local_torque = np.zeros((joint_count, 3), dtype=np.float64)
+        if global_torque is None:
+            global_torque = np.zeros((joint_count, 3), dtype=np.float64)
+        for out in (local_torque, global_torque):
+            if out.dtype != np.float64 or not out.flags.c_contiguous or out.size != 3 * joint_count:
+                raise ValueError("torque output should be a C contiguous float64 array of shape (joint_count, 3)")
         cdef np.ndarray[np.float64_t, ndim=2] local_target = np.ascontiguousarray(local_target_quat_in, dtype=np.float64)
         cdef np.ndarray[np.float64_t, ndim=1] kps = np.ascontiguousarray(kps_in, dtype=np.float64)
         cdef np.ndarray[np.float64_t, ndim=1] tor_lim = np.ascontiguousarray(tor_lim_in, dtype=np.float64)
-        pd_control_batch(
-            <dJointID*> joint_id.data,
-            joint_count,
-            <const dReal*> local_target.data,
-            <const dReal*> kps.data,
-            NULL,
-            <const dReal*> tor_lim.data,
-            <dReal*> local_torque.data,
-            <dReal*> global_torque.data,
-            1
-        )
+        cdef np.ndarray[np.float64_t, ndim=1] kds
+        cdef const dReal * kds_ptr = NULL
+        if kds_in is not None:
+            kds = np.ascontiguousarray(kds_in, dtype=np.float64).reshape(-1)
+            if kds.size != joint_count:
+                raise ValueError("kds should have one value per joint")
+            kds_ptr = <const dReal*> kds.data
+        if workspace is not None:
+            pd_control_batch(
+                workspace.ptr[0],
+                <dJointID*> joint_id.data,
+                joint_count,
+                <const dReal*> local_target.data,
+                <const dReal*> kps.data,
+                kds_ptr,
+                <const dReal*> tor_lim.data,
+                <dReal*> local_torque.data,
+                <dReal*> global_torque.data,
+                1
+            )
+        else:
+            pd_control_batch(
+                <dJointID*> joint_id.data,
+                joint_count,
+                <const dReal*> local_target.data,
+                <const dReal*> kps.data,
+                kds_ptr,
+                <const dReal*> tor_lim.data,
+                <dReal*> local_torque.data,
+                <dReal*> global_torque.data,
+                1
+            )
 
         cdef dReal total_power = compute_total_power(<dJointID*> joint_id.data, joint_count, <dReal*> global_torque.data)
 
         return local_torque, global_torque, total_power
 
+    # Add by Zhenhua Song
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def set_stable_pd(self, np.ndarray joint_id, kps_in, kds_in = None, tor_lim_in = None):
+        """
+        Implicit stable PD of the joints in dampedStep / damped_step_fast_collision:
+        the spring kp * rotvec(target * inv(local)), clipped by tor_lim, is computed inside the step,
+        and kp * h + kd is added to the joint damping of the implicit solve. This keeps very low substep
+        counts stable (1 substep per control step, where the torques of get_pd_control_torque lose the pose),
+        and otherwise costs and tracks about the same at the same substep count. kds add to the joint kd.
+        Set the targets by set_stable_pd_targets.
+        """
+        if joint_id.dtype != np_size_t:
+            raise ValueError("joint id should be np.uint64")
+        cdef np.ndarray joint_buf = np.ascontiguousarray(joint_id)
+        cdef int joint_count = joint_buf.size
+        cdef np.ndarray[np.float64_t, ndim=1] kps = np.ascontiguousarray(kps_in, dtype=np.float64).reshape(-1)
+        cdef np.ndarray[np.float64_t, ndim=1] kds = np.zeros(joint_count) if kds_in is None else \
+            np.ascontiguousarray(kds_in, dtype=np.float64).reshape(-1)
+        cdef np.ndarray[np.float64_t, ndim=1] tor_lim = np.zeros(joint_count) if tor_lim_in is None else \
+            np.ascontiguousarray(tor_lim_in, dtype=np.float64).reshape(-1)
+        if kps.size != joint_count or kds.size != joint_count or tor_lim.size != joint_count:
+            raise ValueError("kps, kds and torque limits should have one value per joint")
+        cdef dJointID * joints = <dJointID *> joint_buf.data
+        cdef int idx
+        for idx in range(joint_count):
+            dJointSetStablePD(joints[idx], kps[idx], kds[idx], tor_lim[idx])
+
+    # Add by Zhenhua Song
+    def disable_stable_pd(self, np.ndarray joint_id):
+        if joint_id.dtype != np_size_t:
+            raise ValueError("joint id should be np.uint64")
+        cdef np.ndarray joint_buf = np.ascontiguousarray(joint_id)
+        cdef dJointID * joints = <dJointID *> joint_buf.data
+        cdef int idx
+        for idx in range(joint_buf.size):
+            dJointDisableStablePD(joints[idx])
+
+    # Add by Zhenhua Song
+    def set_stable_pd_targets(self, np.ndarray joint_id, targets, bint input_in_scipy = True):
+        """
+        targets: local target quaternions of the joints (child in parent frame) in shape (num_joint, 4),
+        in scipy (x, y, z, w) order unless input_in_scipy is False. Set once per control step.
+        """
+        if joint_id.dtype != np_size_t:
+            raise ValueError("joint id should be np.uint64")
+        cdef np.ndarray joint_buf = np.ascontiguousarray(joint_id)
+        cdef np.ndarray target_buf = np.ascontiguousarray(targets, dtype=np.float64)
+        if target_buf.size != 4 * joint_buf.size:
+            raise ValueError("targets should be in shape (num_joint, 4)")
+        dJointSetStablePDTargets(<const dJointID *> joint_buf.data, joint_buf.size,
+                                 <const dReal *> target_buf.data, input_in_scipy)
+
     # Add by Zhenhua Song
     def createBody(self):
         return Body(self)
@@ -2547,6 +3055,43 @@ cdef class World:
         return ContactJointMaxForce(self, jointgroup, contact)
 
 
+# Add by Zhenhua Song
+cdef class BodyStateViews:
+    """
+    numpy views on the contiguous body storage of a world, see World.body_state_views.
+    Indexing checks that the storage was not moved, resized or freed since the views were made.
+    """
+    cdef World world
+    cdef dict views
+    cdef unsigned int epoch
+    cdef unsigned int generation
+    cdef int num_bodies
+    cdef readonly bint writeable
+
+    @property
+    def valid(self) -> bool:
+        """
+        False after a body was created or destroyed, contiguous_body_storage was
+        turned off or the world was destroyed.
+        """
+        cdef dBodyStorageInfo info
+        if self.world is None or self.world.wid == NULL or self.world.state_views_epoch != self.epoch \
+                or not dWorldGetBodyStorage(self.world.wid, &info):
+            return False
+        return info.generation == self.generation and info.num_bodies == self.num_bodies
+
+    def __getitem__(self, str key) -> np.ndarray:
+        if not self.valid:
+            raise RuntimeError("the body storage changed, call World.body_state_views again")
+        return self.views[key]
+
+    def __contains__(self, key) -> bool:
+        return key in self.views
+
+    def keys(self):
+        return self.views.keys()
+
+
 # Body
 cdef class Body:
     """The rigid body class encapsulating the ODE body.
@@ -2659,6 +3204,27 @@ cdef class Body:
     def body_flags(self):
         return dBodyGetFlags(self.bid)
 
+    @property
+    def fast_moving(self) -> bool:
+        return dBodyGetFastMoving(self.bid) != 0
+
+    @fast_moving.setter
+    def fast_moving(self, bint value):
+        """
+        Sweep this body along its linear velocity before collision detection in
+        World.step_fast_collision / World.damped_step_fast_collision and in the
+        ODEScene simulate paths (World.sweep_fast_bodies), so that a fast
+        projectile does not pass through thin geoms in one step.
+        """
+        dBodySetFastMoving(self.bid, value)
+
+    @property
+    def storage_index(self) -> int:
+        """
+        Row of this body in World.body_state_views, -1 without contiguous body storage.
+        """
+        return dBodyGetStorageIndex(self.bid)
+
     # Add by Zhenhua Song
     # def joint_iter(self):
     #    """
@@ -4030,6 +4596,41 @@ cdef class Joint:
     def setKd_arrNumpy(self, np.ndarray kd):
         dJointSetKd_arr(self.jid, <const dReal *> kd.data)
 
+    # Add by Zhenhua Song
+    def setStablePD(self, dReal kp, dReal kd = 0, dReal torque_limit = 0):
+        """
+        implicit stable PD in World.dampedStep, see World.set_stable_pd
+        """
+        dJointSetStablePD(self.jid, kp, kd, torque_limit)
+
+    # Add by Zhenhua Song
+    def disableStablePD(self):
+        dJointDisableStablePD(self.jid)
+
+    # Add by Zhenhua Song
+    @property
+    def stable_pd_enabled(self) -> bool:
+        return dJointIsStablePD(self.jid) != 0
+
+    # Add by Zhenhua Song
+    @property
+    def stable_pd_target(self) -> np.ndarray:
+        """
+        target of the child body in parent frame, in scipy (x, y, z, w) order
+        """
+        cdef const dReal * q = dJointGetStablePDTarget(self.jid)
+        return np.array([q[1], q[2], q[3], q[0]])
+
+    @stable_pd_target.setter
+    def stable_pd_target(self, q):
+        cdef np.ndarray[np.float64_t, ndim=1] q_scipy = np.ascontiguousarray(q, dtype=np.float64).reshape(-1)
+        cdef dQuaternion q_ode
+        q_ode[0] = q_scipy[3]
+        q_ode[1] = q_scipy[0]
+        q_ode[2] = q_scipy[1]
+        q_ode[3] = q_scipy[2]
+        dJointSetStablePDTarget(self.jid, q_ode)
+
     # Add by Zhenhua Song
     def getType(self) -> int:
         return dJointGetType(self.jid)
@@ -5865,44 +6466,26 @@ cdef class PRJoint(Joint):
 
 
 # Add by Zhenhua Song
+# friction, bounce, collidable and the ignored geoms are stored in the geom (dGeomGetContactAttrs),
+# so that the near callback can run without the GIL
 cdef class _GeomAttrs:
     cdef str name
-    cdef dReal friction
-    cdef dReal bounce
-
-    cdef dReal max_friction
 
     cdef int clung_env
     cdef list ignore_geom_id
-    cdef int collidable
     cdef object character
 
-    cdef dGeomID ignore_geom_buf[64]
-    cdef size_t ignore_geom_buf_len
-
     cdef int instance_id
 
-    cdef int character_self_collide  # collision detection with same character
-
     def __cinit__(self):
         self.name = ""
-        self.friction = 0.8
-        self.bounce = 0
-
-        self.max_friction = dInfinity  # default value is +infty
 
         self.clung_env = 0
         self.ignore_geom_id = list()
-        self.collidable = 1
         self.character = None
 
-        memset(self.ignore_geom_buf, 0, sizeof(dGeomID) * 64)
-        self.ignore_geom_buf_len = 0
-
         self.instance_id = 0
 
-        self.character_self_collide = 1
-
 # Geom base class
 cdef class GeomObject:
     """This is the abstract base class for all geom objects."""
@@ -5966,42 +6549,49 @@ cdef class GeomObject:
     def __eq__(self, GeomObject other):
         return self.gid == other.gid
 
+    cdef dGeomContactAttrs * contact_attrs(self) except NULL:
+        if self.gid == NULL:
+            raise ValueError("geom is destroyed")
+        return dGeomGetContactAttrs(self.gid)
+
     # Add by Zhenhua Song
     def extend_ignore_geom_id(self, list res):
+        cdef dGeomContactAttrs * attrs = self.contact_attrs()
+        if attrs.num_ignore_geoms + len(res) > dGEOM_MAX_IGNORE_GEOMS:
+            raise ValueError("only support %d ignore geoms" % dGEOM_MAX_IGNORE_GEOMS)
         self.geom_attrs.ignore_geom_id.extend(res)
         for i in res:
-            self.geom_attrs.ignore_geom_buf[self.geom_attrs.ignore_geom_buf_len] = <dGeomID>(<size_t>i)
-            self.geom_attrs.ignore_geom_buf_len += 1
+            dGeomAppendIgnore(self.gid, <dGeomID>(<size_t>i))
 
     # Add by Zhenhua Song
     @property
     def bounce(self) -> dReal:
-        return self.geom_attrs.bounce
+        return self.contact_attrs().bounce
 
     # Add by Zhenhua Song
     @bounce.setter
     def bounce(self, dReal value):
-        self.geom_attrs.bounce = value
+        self.contact_attrs().bounce = value
 
     # Add by Zhenhua Song
     @property
     def max_friction(self) -> dReal:
-        return self.geom_attrs.max_friction
+        return self.contact_attrs().max_friction
 
     # Add by Zhenhua Song
     @max_friction.setter
     def max_friction(self, dReal value):
-        self.geom_attrs.max_friction = value
+        self.contact_attrs().max_friction = value
 
     # Add by Zhenhua Song
     @property
     def character_self_collide(self) -> int:
-        return self.geom_attrs.character_self_collide
+        return self.contact_attrs().character_self_collide
 
     # Add by Zhenhua Song
     @character_self_collide.setter
     def character_self_collide(self, int value):
-        self.geom_attrs.character_self_collide = value
+        self.contact_attrs().character_self_collide = value
 
     # Add by Zhenhua Song
     @property
@@ -6074,22 +6664,22 @@ cdef class GeomObject:
     # Add by Zhenhua Song
     @property
     def friction(self) -> dReal:
-        return self.geom_attrs.friction
+        return self.contact_attrs().friction
 
     # Add by Zhenhua Song
     @friction.setter
     def friction(self, dReal value):
-        self.geom_attrs.friction = value
+        self.contact_attrs().friction = value
 
     # Add by Zhenhua Song
     @property
     def collidable(self):
-        return self.geom_attrs.collidable
+        return self.contact_attrs().collidable
 
     # Add by Zhenhua Song
     @collidable.setter
     def collidable(self, object value):
-        self.geom_attrs.collidable = value
+        self.contact_attrs().collidable = value
 
     # Add by Zhenhua Song
     @property
@@ -6105,11 +6695,9 @@ cdef class GeomObject:
     @cython.boundscheck(False)
     @cython.wraparound(False)
     def append_ignore_geom(self, GeomObject other):
-        if self.geom_attrs.ignore_geom_buf_len >= 64:
-            raise ValueError("only support 64 ignore geoms")
-
-        self.geom_attrs.ignore_geom_buf[self.geom_attrs.ignore_geom_buf_len] = other.gid
-        self.geom_attrs.ignore_geom_buf_len += 1
+        self.contact_attrs()
+        if not dGeomAppendIgnore(self.gid, other.gid):
+            raise ValueError("only support %d ignore geoms" % dGEOM_MAX_IGNORE_GEOMS)
 
     # Add by Zhenhua Song
     def get_gid(self) -> size_t:
@@ -6517,6 +7105,81 @@ cdef class GeomObject:
         dGeomRenderInDefaultColor(self.gid, value)
 
 
+cdef class CharacterPairTable:
+    """
+    Bit matrix of the geom pairs of one character that may collide, indexed by geom_index.
+    Geoms sharing the table are paired by the space only when the table allows it,
+    so excluded self collision pairs never reach the collision callback.
+    """
+    cdef dCharacterPairTableID tid
+
+    def __cinit__(self, int num_geoms):
+        self.tid = dCharacterPairTableCreate(num_geoms)
+
+    def __dealloc__(self):
+        if self.tid != NULL:
+            dCharacterPairTableDestroy(self.tid)
+            self.tid = NULL
+
+    @property
+    def num_geoms(self) -> int:
+        return dCharacterPairTableGetNumGeoms(self.tid)
+
+    def set_pair(self, int i, int j, bint allowed):
+        if i < 0 or j < 0 or i >= self.num_geoms or j >= self.num_geoms:
+            raise IndexError("geom index out of range")
+        dCharacterPairTableSetPair(self.tid, i, j, allowed)
+
+    def get_pair(self, int i, int j) -> bool:
+        return dCharacterPairTableGetPair(self.tid, i, j) != 0
+
+    def set_all(self, bint allowed):
+        dCharacterPairTableSetAll(self.tid, allowed)
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def build(self, list geoms, bint self_collide = True):
+        """
+        Compute the table from the skeleton and attach it to the geoms.
+        geoms[i] must have geom_index == i. A pair is excluded when the geoms are on
+        the same body or on bodies connected by a joint, when one geom ignores the other,
+        or when self_collide is False.
+        """
+        cdef size_t num = len(geoms)
+        if num != <size_t> self.num_geoms:
+            raise ValueError("table has %d geoms, got %d" % (self.num_geoms, num))
+
+        cdef size_t i, j
+        cdef GeomObject g1, g2
+        cdef dBodyID b1, b2
+        cdef int allowed
+        dCharacterPairTableSetAll(self.tid, self_collide)
+        for i in range(num):
+            g1 = geoms[i]
+            if dGeomGetIndex(g1.gid) != <int> i:
+                raise ValueError("geom_index of geoms[%d] is %d" % (i, dGeomGetIndex(g1.gid)))
+            dGeomSetCharacterPairTable(g1.gid, self.tid)
+            if not self_collide:
+                continue
+            b1 = dGeomGetBody(g1.gid)
+            for j in range(i + 1, num):
+                g2 = geoms[j]
+                b2 = dGeomGetBody(g2.gid)
+                allowed = 1
+                if b1 == b2 or (b1 != NULL and b2 != NULL and dAreConnected(b1, b2)):
+                    allowed = 0
+                if allowed and (dGeomIsIgnore(g1.gid, g2.gid) or dGeomIsIgnore(g2.gid, g1.gid)):
+                    allowed = 0
+                if not allowed:
+                    dCharacterPairTableSetPair(self.tid, i, j, 0)
+
+    def detach(self, list geoms):
+        cdef GeomObject geom
+        for geom in geoms:
+            if dGeomGetCharacterPairTable(geom.gid) == self.tid:
+                dGeomSetCharacterPairTable(geom.gid, NULL)
+
+
 # Add by Zhenhua Song. Test OK
 cdef class _SpaceIterator2:
     cdef dGeomID g
@@ -6911,8 +7574,12 @@ cdef class SpaceBase(GeomObject):
         dSpaceCollide(self.sid, <void*>tup, collide_callback)
 
     # Add by Zhenhua Song
-    cdef void fast_collide(self, dJointGroupWithdWorld * info):
-        dSpaceCollide(self.sid, <void*> info, &fast_collide_callback)
+    cdef void fast_collide(self, dJointGroupWithdWorld * info) noexcept nogil:
+        dSpaceCollide(self.sid, <void*> info, &dCollideContactCallback)
+
+    # Conservative advancement of bodies with fast_moving set, using the same pair filter as fast_collide
+    cdef int sweep_fast_bodies(self, dJointGroupWithdWorld * info, dReal stepsize) noexcept nogil:
+        return dSpaceSweepFastBodies(self.sid, info.world, stepsize, <void*> info, &dCollideContactFilter)
 
 
 # Callback function for the dSpaceCollide() call in the Space.collide() method
@@ -6922,120 +7589,23 @@ cdef class SpaceBase(GeomObject):
 # Geom1 and Geom2 are instances of GeomXyz classes.
 @cython.boundscheck(False)
 @cython.wraparound(False)
-cdef void collide_callback(void* data, dGeomID o1, dGeomID o2):
+cdef void collide_callback(void* data, dGeomID o1, dGeomID o2) noexcept with gil:
     if (dGeomGetBody(o1)==dGeomGetBody(o2)):  # contains dGeomGetBody(o1) == NULL and dGeomGetBody(o2) == NULL
         return
 
-    cdef GeomObject g1 = <GeomObject> dGeomGetData(o1)
-    cdef GeomObject g2 = <GeomObject> dGeomGetData(o2)
-
-    if not g1.geom_attrs.collidable or not g2.geom_attrs.collidable:
+    if not dGeomGetContactAttrs(o1).collidable or not dGeomGetContactAttrs(o2).collidable:
         return
 
-    cdef int i = 0
-    
-    while i < g1.geom_attrs.ignore_geom_buf_len:
-        if o2 == g1.geom_attrs.ignore_geom_buf[i]:
-            return
-        i += 1
+    if dGeomIsIgnore(o1, o2) or dGeomIsIgnore(o2, o1):
+        return
 
-    i = 0
-    while i < g2.geom_attrs.ignore_geom_buf_len:
-        if o1 == g2.geom_attrs.ignore_geom_buf[i]:
-            return
-        i += 1
-    
+    cdef GeomObject g1 = <GeomObject> dGeomGetData(o1)
+    cdef GeomObject g2 = <GeomObject> dGeomGetData(o2)
     cdef object tup = <object>data
     callback, arg = tup
     callback(arg, g1, g2)
     
 
-# Add by Zhenhua Song, collision detection in cython (not using python)
-@cython.boundscheck(False)
-@cython.wraparound(False)
-cdef void fast_collide_callback(void * data, dGeomID o1, dGeomID o2):  # should not use nogil because GeomObject exists:
-    cdef dBodyID b1 = dGeomGetBody(o1)
-    cdef dBodyID b2 = dGeomGetBody(o2)
-
-    if b1 == b2:  # contains dGeomGetBody(o1) == NULL and dGeomGetBody(o2) == NULL
-        return
-
-    if b1 != NULL and b2 != NULL and dAreConnected(b1, b2):
-        return
-
-    cdef GeomObject g1 = <GeomObject> dGeomGetData(o1)
-    cdef GeomObject g2 = <GeomObject> dGeomGetData(o2)
-
-    cdef int class_1 = dGeomGetClass(o1)
-    cdef int class_2 = dGeomGetClass(o2)
-
-    cdef dJointGroupWithdWorld * group_info = <dJointGroupWithdWorld *> data
-    cdef dWorldID world = group_info.world
-    cdef dJointGroupID contact_group = group_info.group
-    cdef int max_contact_num = group_info.max_contact_num
-    cdef int use_max_force = group_info.use_max_force_contact
-    cdef int use_soft_contact = group_info.use_soft_contact
-    cdef dReal soft_cfm = group_info.soft_cfm
-    cdef dReal soft_erp = group_info.soft_erp
-
-    if (dGeomGetCharacterID(o1) == dGeomGetCharacterID(o2)) and (not g1.geom_attrs.character_self_collide or not group_info.self_collision):
-        return
-
-    cdef size_t i = 0
-    while i < g1.geom_attrs.ignore_geom_buf_len:
-        if o2 == g1.geom_attrs.ignore_geom_buf[i]:
-            return
-        i += 1
-
-    i = 0
-    while i < g2.geom_attrs.ignore_geom_buf_len:
-        if o1 == g2.geom_attrs.ignore_geom_buf[i]:
-            return
-        i += 1
-
-    cdef dContactGeom c[256] # Zhenhua Song: I don't know why ode python binding uses 150..for fast, I use 4 instead
-    cdef int n
-    cdef dContact contact[256]
-    cdef dJointID joint = NULL
-
-    n = dCollide(o1, o2, max_contact_num, c, sizeof(dContactGeom))
-
-    i = 0
-    while i < n:
-        contact[i].surface.mode = dContactApprox1  #
-        if not use_max_force:
-            if g1.geom_attrs.friction < g2.geom_attrs.friction:
-                contact[i].surface.mu = g1.geom_attrs.friction
-            else:
-                contact[i].surface.mu = g2.geom_attrs.friction
-        else:
-            if g1.geom_attrs.max_friction < g2.geom_attrs.max_friction:
-                contact[i].surface.mu = g1.geom_attrs.max_friction
-            else:
-                contact[i].surface.mu = g2.geom_attrs.max_friction
-
-        # mu2 is ignored..
-        if g1.geom_attrs.bounce < g2.geom_attrs.bounce:
-            contact[i].surface.bounce = g1.geom_attrs.bounce
-        else:
-            contact[i].surface.bounce = g2.geom_attrs.bounce
-
-        if use_soft_contact:
-            contact[i].surface.soft_cfm = soft_cfm
-            contact[i].surface.soft_erp = soft_erp
-            contact[i].surface.mode = contact[i].surface.mode | dContactSoftCFM | dContactSoftERP
-
-        contact[i].geom = c[i]
-        # Note: here we should judge the contact type.
-        if use_max_force:
-            joint = dJointCreateContactMaxForce(world, contact_group, &contact[i])
-        else:
-            joint = dJointCreateContact(world, contact_group, &contact[i])
-        dJointAttach(joint, b1, b2)
-        i += 1
-
-    # remove joint group after simulation
-
 # SimpleSpace
 cdef class SimpleSpace(SpaceBase):
     """Simple space.
@@ -7124,6 +7694,50 @@ cdef class HashSpace(SpaceBase):
         dHashSpaceGetLevels(self.sid, &minlevel, &maxlevel)
         return minlevel, maxlevel
 
+    @property
+    def auto_levels(self) -> bool:
+        return dHashSpaceGetAutoLevels(self.sid) != 0
+
+    @auto_levels.setter
+    def auto_levels(self, bint value):
+        """
+        Tune minlevel / maxlevel at every collision detection from the running
+        distribution of geom AABB sizes, instead of the levels set by setLevels.
+        """
+        dHashSpaceSetAutoLevels(self.sid, value)
+
+    @property
+    def stats_enabled(self) -> bool:
+        return dHashSpaceGetStatsEnabled(self.sid) != 0
+
+    @stats_enabled.setter
+    def stats_enabled(self, bint value):
+        """
+        Collect the cell occupancy returned by get_stats at every collision detection.
+        Off by default, as it walks every hash bucket.
+        """
+        dHashSpaceSetStatsEnabled(self.sid, value)
+
+    def get_stats(self) -> dict:
+        """
+        Cell occupancy of the last collision detection of this space.
+        All zero unless stats_enabled is set.
+        """
+        cdef dHashSpaceStats stats
+        dHashSpaceGetStats(self.sid, &stats)
+        return {
+            "minlevel": stats.minlevel,
+            "maxlevel": stats.maxlevel,
+            "num_aabbs": stats.num_aabbs,
+            "num_big_boxes": stats.num_big_boxes,
+            "num_nodes": stats.num_nodes,
+            "table_size": stats.table_size,
+            "used_buckets": stats.used_buckets,
+            "max_bucket_size": stats.max_bucket_size,
+            "num_cell_tests": stats.num_cell_tests,
+            "num_big_box_tests": stats.num_big_box_tests,
+        }
+
 
 # QuadTreeSpace
 cdef class QuadTreeSpace(SpaceBase):
@@ -7871,6 +8485,10 @@ def InitODE():
 
 
 def SetInitSeed(int value):
+    """
+    set the global ODE random seed. Worlds created afterwards start from it,
+    use World.rand_seed to seed a world that already exists.
+    """
     dRandSetSeed(value)
 
 
@@ -7951,11 +8569,13 @@ cdef class TriMeshData:
     cdef dTriMeshDataID tmdid
     cdef dReal* vertex_buffer
     cdef unsigned int* face_buffer
+    cdef object blob  # serialized mesh in use (mmap or buffer object), see load()
 
     def __cinit__(self):
         self.tmdid = dGeomTriMeshDataCreate()
         self.vertex_buffer = NULL
         self.face_buffer = NULL
+        self.blob = None
 
     def __dealloc__(self):
         if self.tmdid != NULL:
@@ -8011,6 +8631,52 @@ cdef class TriMeshData:
         dGeomTriMeshDataBuildSimple(self.tmdid, self.vertex_buffer, numverts,
                                     self.face_buffer, numfaces * 3)
 
+    def serialize(self) -> bytes:
+        """serialize() -> bytes
+
+        Save the built mesh (vertices, indices and OPCODE tree) as a flat blob,
+        which can be loaded by load_buffer() / load() without rebuilding the tree.
+        """
+        cdef size_t size = dGeomTriMeshDataGetSerializedSize(self.tmdid)
+        if size == 0:
+            raise ValueError("TriMeshData is not built")
+        cdef np.ndarray[np.uint8_t, ndim=1] buf = np.zeros(size, dtype=np.uint8)
+        if dGeomTriMeshDataSerialize(self.tmdid, <void *> buf.data, size) != size:
+            raise RuntimeError("serialize TriMeshData failed")
+        return buf.tobytes()
+
+    def save(self, str fname):
+        """save(fname)
+
+        Write the serialized mesh to a file, see serialize().
+        """
+        with open(fname, "wb") as fout:
+            fout.write(self.serialize())
+
+    def load_buffer(self, buffer):
+        """load_buffer(buffer)
+
+        Use a serialized mesh in place. The buffer is not copied, and a reference
+        is kept as long as this object lives. It must be 8 byte aligned.
+        """
+        cdef const unsigned char[::1] view = buffer
+        cdef const unsigned char * ptr = &view[0]
+        if (<size_t> ptr) % 8 != 0:
+            raise ValueError("serialized TriMeshData buffer must be 8 byte aligned")
+        if not dGeomTriMeshDataBuildFromSerialized(self.tmdid, <const void *> ptr, view.shape[0]):
+            raise ValueError("invalid or incompatible serialized TriMeshData")
+        self.blob = buffer
+
+    def load(self, str fname):
+        """load(fname)
+
+        Memory-map a file written by save() read-only, and use it in place.
+        The pages are shared by all processes loading the same file.
+        """
+        with open(fname, "rb") as fin:
+            mapped = mmap.mmap(fin.fileno(), 0, access=mmap.ACCESS_READ)
+        self.load_buffer(mapped)
+
 ######################################################################
 # _geom_c2py_lut = weakref.WeakValueDictionary()
 
@@ -8651,6 +9317,137 @@ def mix_quat_by_slerp(np.ndarray quat_input):  # This method is not good at all.
     return result
 
 
+# Add by Zhenhua Song
+def quat_simd_available() -> bool:
+    """
+    The batch quaternion functions (quat_multiply_forward_fast, quat_apply_forward_fast, quat_to_rotvec_fast, ...)
+    use AVX2 / FMA kernels when the cpu supports them. The scalar kernels are used otherwise.
+    """
+    return quat_simd_avx2_supported() != 0
+
+
+# Add by Zhenhua Song
+def set_quat_simd_enabled(bint enabled):
+    """
+    Enable (default) or disable the AVX2 / FMA kernels of the batch quaternion functions, e.g. to compare with the scalar ones.
+    """
+    quat_simd_set_enabled(enabled)
+
+
+# Add by Zhenhua Song
+def quat_simd_enabled() -> bool:
+    """
+    whether the batch quaternion functions use the AVX2 / FMA kernels now
+    """
+    return quat_simd_use_avx2() != 0
+
+
+# Add by Zhenhua Song
+def set_batch_num_threads(int num_threads):
+    """
+    Threads used by the batch quaternion functions (quat_*_fast, and get_joint_local_quat_batch) on large arrays,
+    e.g. frames x joints of a motion dataset. 0: all hardware threads, 1: single threaded.
+    By default the hardware threads, at most 8. The results do not depend on the thread count.
+    """
+    batch_parallel_set_num_threads(num_threads)
+
+
+# Add by Zhenhua Song
+def get_batch_num_threads() -> int:
+    return batch_parallel_get_num_threads()
+
+
+# Add by Zhenhua Song
+def set_batch_parallel_min_items(size_t min_items):
+    """
+    Arrays with fewer items (quaternions, vectors, joints) are processed on the calling thread. 65536 by default.
+    """
+    batch_parallel_set_min_items(min_items)
+
+
+# Add by Zhenhua Song
+def get_batch_parallel_min_items() -> int:
+    return batch_parallel_get_min_items()
+
+
+# Add by Zhenhua Song
+# The quat_*_ptr functions take the addresses of contiguous float64 buffers (e.g. torch.Tensor.data_ptr()),
+# and write the results in place. They are used by the torch autograd functions of ControlVAECore/Utils/diff_quat.py,
+# so the kernels work on the tensor storage directly. The caller must check the shapes and keep the buffers alive.
+def quat_multiply_forward_ptr(size_t q1, size_t q2, size_t q, size_t num_quat):
+    with nogil:
+        quat_multiply_forward(<const double *> q1, <const double *> q2, <double *> q, num_quat)
+
+
+# Add by Zhenhua Song
+def quat_multiply_backward_ptr(size_t q1, size_t q2, size_t grad_q, size_t grad_q1, size_t grad_q2, size_t num_quat):
+    with nogil:
+        quat_multiply_backward(<const double *> q1, <const double *> q2, <const double *> grad_q,
+            <double *> grad_q1, <double *> grad_q2, num_quat)
+
+
+# Add by Zhenhua Song
+def quat_apply_forward_ptr(size_t q, size_t v, size_t o, size_t num_quat):
+    with nogil:
+        quat_apply_forward(<const double *> q, <const double *> v, <double *> o, num_quat)
+
+
+# Add by Zhenhua Song
+def quat_apply_backward_ptr(size_t q, size_t v, size_t o_grad, size_t q_grad, size_t v_grad, size_t num_quat):
+    with nogil:
+        quat_apply_backward(<const double *> q, <const double *> v, <const double *> o_grad,
+            <double *> q_grad, <double *> v_grad, num_quat)
+
+
+# Add by Zhenhua Song
+def quat_to_matrix_ptr(size_t q, size_t mat, size_t num_quat):
+    with nogil:
+        quat_to_matrix_impl(<const double *> q, <double *> mat, num_quat)
+
+
+# Add by Zhenhua Song
+def quat_to_matrix_backward_ptr(size_t q, size_t grad_in, size_t grad_out, size_t num_quat):
+    with nogil:
+        quat_to_matrix_backward(<const double *> q, <const double *> grad_in, <double *> grad_out, num_quat)
+
+
+# Add by Zhenhua Song
+def quat_to_vec6d_ptr(size_t q, size_t vec6d, size_t num_quat):
+    with nogil:
+        quat_to_vec6d_impl(<const double *> q, <double *> vec6d, num_quat)
+
+
+# Add by Zhenhua Song
+def quat_to_vec6d_backward_ptr(size_t q, size_t grad_in, size_t grad_out, size_t num_quat):
+    with nogil:
+        quat_to_vec6d_backward(<const double *> q, <const double *> grad_in, <double *> grad_out, num_quat)
+
+
+# Add by Zhenhua Song
+def quat_to_rotvec_ptr(size_t q, size_t angle, size_t rotvec, size_t num_quat):
+    with nogil:
+        quat_to_rotvec_impl(<const double *> q, <double *> angle, <double *> rotvec, num_quat)
+
+
+# Add by Zhenhua Song
+def quat_to_rotvec_backward_ptr(size_t q, size_t angle, size_t grad_in, size_t grad_out, size_t num_quat):
+    with nogil:
+        quat_to_rotvec_backward(<const double *> q, <const double *> angle, <const double *> grad_in,
+            <double *> grad_out, num_quat)
+
+
+# Add by Zhenhua Song
+def quat_from_rotvec_ptr(size_t rotvec, size_t q, size_t num_quat):
+    with nogil:
+        quat_from_rotvec_impl(<const double *> rotvec, <double *> q, num_quat)
+
+
+# Add by Zhenhua Song
+def quat_from_rotvec_backward_ptr(size_t rotvec, size_t grad_in, size_t grad_out, size_t num_quat):
+    with nogil:
+        quat_from_rotvec_backward_impl(<const double *> rotvec, <const double *> grad_in, <double *> grad_out, num_quat)
+
+
 # Add by Zhenhua Song
 @cython.boundscheck(False)
 @cython.wraparound(False)
@@ -9041,6 +9838,390 @@ def decompose_rotation_pair_one2many_fast(np.ndarray q, np.ndarray vb):
     return qa, qb
 
 
+# Add by Zhenhua Song
+cdef class JointPDController:
+    """
+    PD control in one native call (Utils/PDControlAdd.h): apply computes the torques as
+    World.get_pd_control_torque, adds them to the child (+) and parent (-) body of each joint,
+    and accumulates their power. It allocates nothing.
+    Without kds_in it is the stable PD for World.dampedStep (damping by the joint kd in ODE),
+    with kds_in it is the full PD (kp and kd) of PDControler, for World.step.
+    The joints and bodies are owned by the caller and must outlive this object.
+    """
+    cdef CJointPDController * ptr
+
+    def __cinit__(self, np.ndarray joint_id, kps_in, torque_limit_in, kds_in = None):
+        if joint_id.dtype != np_size_t:
+            raise ValueError("joint id should be np.uint64")
+        cdef np.ndarray joint_buf = np.ascontiguousarray(joint_id)
+        cdef np.ndarray[np.float64_t, ndim=1] kps = np.ascontiguousarray(kps_in, dtype=np.float64).reshape(-1)
+        cdef np.ndarray[np.float64_t, ndim=1] tor_lim = np.ascontiguousarray(torque_limit_in, dtype=np.float64).reshape(-1)
+        cdef int num_joints = joint_buf.size
+        if kps.size != num_joints or tor_lim.size != num_joints:
+            raise ValueError("kps and torque limits should have one value per joint")
+        cdef np.ndarray[np.float64_t, ndim=1] kds
+        cdef const double * kds_ptr = NULL
+        if kds_in is not None:
+            kds = np.ascontiguousarray(kds_in, dtype=np.float64).reshape(-1)
+            if kds.size != num_joints:
+                raise ValueError("kds should have one value per joint")
+            kds_ptr = <const double *> kds.data
+        self.ptr = JointPDControllerCreate(<const dJointID *> joint_buf.data, num_joints,
+                                           <const double *> kps.data, <const double *> tor_lim.data, kds_ptr)
+
+    def __dealloc__(self):
+        if self.ptr != NULL:
+            JointPDControllerDelete(self.ptr)
+            self.ptr = NULL
+
+    @property
+    def num_joints(self) -> int:
+        return self.ptr.GetJointCount()
+
+    @property
+    def has_kd(self) -> bool:
+        return self.ptr.HasKd()
+
+    @property
+    def accum_energy(self) -> float:
+        return self.ptr.GetAccumEnergy()
+
+    @accum_energy.setter
+    def accum_energy(self, double value):
+        self.ptr.SetAccumEnergy(value)
+
+    cdef np.ndarray _torque_view(self, const double * data):
+        cdef np.npy_intp dims[2]
+        dims[0] = self.ptr.GetJointCount()
+        dims[1] = 3
+        cdef np.ndarray arr = np.PyArray_SimpleNewFromData(2, dims, np.NPY_FLOAT64, <void *> data)
+        arr.flags.writeable = False
+        np.set_array_base(arr, self)
+        return arr
+
+    @property
+    def local_torque(self) -> np.ndarray:
+        """read only view of the joint torques in parent local frame of the last apply, in shape (num_joint, 3)"""
+        return self._torque_view(self.ptr.GetLocalTorque())
+
+    @property
+    def global_torque(self) -> np.ndarray:
+        """read only view of the joint torques in global frame of the last apply, in shape (num_joint, 3)"""
+        return self._torque_view(self.ptr.GetGlobalTorque())
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def apply(self, np.ndarray targets, bint input_in_scipy = True) -> float:
+        """
+        targets: joint local target quaternions in shape (num_joint, 4), C contiguous float64
+                 (else it is converted), in scipy (x, y, z, w) order unless input_in_scipy is False.
+        return: power of the torques of this call, also added to accum_energy
+        """
+        if targets.dtype != np.float64 or not targets.flags.c_contiguous:
+            targets = np.ascontiguousarray(targets, dtype=np.float64)
+        if targets.size != 4 * self.ptr.GetJointCount():
+            raise ValueError("targets should be in shape (num_joint, 4)")
+        return self.ptr.Apply(<const double *> targets.data, input_in_scipy)
+
+    def set_target_rotvec(self, np.ndarray rotvecs):
+        """
+        rotvecs: joint local targets as rotation vectors in shape (num_joint, 3), C contiguous float64
+                 (else it is converted). They are converted to quaternions (flipped to w >= 0) in C++,
+                 once for the apply_target of every substep.
+        """
+        if rotvecs.dtype != np.float64 or not rotvecs.flags.c_contiguous:
+            rotvecs = np.ascontiguousarray(rotvecs, dtype=np.float64)
+        if rotvecs.size != 3 * self.ptr.GetJointCount():
+            raise ValueError("rotvecs should be in shape (num_joint, 3)")
+        self.ptr.SetTargetRotvec(<const double *> rotvecs.data)
+
+    @property
+    def target(self) -> np.ndarray:
+        """read only view of the target quaternions of set_target_rotvec, in scipy order, in shape (num_joint, 4)"""
+        cdef np.npy_intp dims[2]
+        dims[0] = self.ptr.GetJointCount()
+        dims[1] = 4
+        cdef np.ndarray arr = np.PyArray_SimpleNewFromData(2, dims, np.NPY_FLOAT64, <void *> self.ptr.GetTarget())
+        arr.flags.writeable = False
+        np.set_array_base(arr, self)
+        return arr
+
+    def apply_target(self) -> float:
+        """
+        apply with the target of set_target_rotvec. return: power of the torques of this call
+        """
+        return self.ptr.ApplyTarget()
+
+
+# Add by Zhenhua Song
+cdef class VecTrackEnv:
+    """
+    N copies of a tracking scene stepped together by a C++ thread pool (Utils/vec_track_env.h).
+    step does what VCLODETrackEnv.step_core does for every world: rotvec actions to target
+    quaternions, stable PD control and damped_step_fast_collision for every substep,
+    character state and observation, and cal_done.
+    The worlds, spaces, joints and bodies are owned by the caller and must outlive this object.
+    """
+    cdef CVecTrackEnv * ptr
+    cdef list worlds  # keep the worlds and spaces alive
+
+    def __cinit__(self, int num_substep, double control_dt, int head_index,
+                  int min_length = 26, int max_length = 512, double err_threshold = 0.5,
+                  int err_length = 20, bint recompute_velocity = True, int num_threads = 0):
+        cdef VecTrackEnvConfig config
+        config.num_substep = num_substep
+        config.control_dt = control_dt
+        config.recompute_velocity = recompute_velocity
+        config.head_index = head_index
+        config.min_length = min_length
+        config.max_length = max_length
+        config.err_threshold = err_threshold
+        config.err_length = err_length
+        self.ptr = VecTrackEnvCreate(config, num_threads)
+        self.worlds = list()
+
+    def __dealloc__(self):
+        if self.ptr != NULL:
+            VecTrackEnvDelete(self.ptr)
+            self.ptr = NULL
+
+    def add_world(self, World world, SpaceBase space, np.ndarray joint_id, np.ndarray body_id,
+                  kps_in, torque_limit_in) -> int:
+        """
+        joint_id: joints of the character in the order of the actions, as joint_info.joint_c_id
+        body_id:  bodies of the character in the order of the state, as body_info.body_c_id
+        kps_in, torque_limit_in: per joint, as DampedPDControler
+        return: index of the world
+        """
+        if joint_id.dtype != np_size_t or body_id.dtype != np_size_t:
+            raise ValueError("joint id and body id should be np.uint64")
+        cdef np.ndarray joint_buf = np.ascontiguousarray(joint_id)
+        cdef np.ndarray body_buf = np.ascontiguousarray(body_id)
+        cdef np.ndarray[np.float64_t, ndim=1] kps = np.ascontiguousarray(kps_in, dtype=np.float64).reshape(-1)
+        cdef np.ndarray[np.float64_t, ndim=1] tor_lim = np.ascontiguousarray(torque_limit_in, dtype=np.float64).reshape(-1)
+        cdef int num_joints = joint_buf.size
+        if kps.size != num_joints or tor_lim.size != num_joints:
+            raise ValueError("kps and torque limits should have one value per joint")
+        cdef int head_index = self.ptr.GetConfig().head_index
+        if head_index < 0 or head_index >= body_buf.size:
+            raise ValueError("head index %d out of %d bodies" % (head_index, body_buf.size))
+
+        cdef int index = self.ptr.AddWorld(world.contact_group, space.sid,
+            <const dJointID *> joint_buf.data, num_joints, <const dBodyID *> body_buf.data, body_buf.size,
+            <const double *> kps.data, <const double *> tor_lim.data)
+        if index < 0:
+            raise ValueError("all worlds should have %d joints and %d bodies" % (self.ptr.GetNumJoints(), self.ptr.GetNumBodies()))
+        self.worlds.append((world, space))
+        return index
+
+    @property
+    def num_worlds(self) -> int:
+        return self.ptr.GetNumWorlds()
+
+    @property
+    def num_joints(self) -> int:
+        return self.ptr.GetNumJoints()
+
+    @property
+    def num_bodies(self) -> int:
+        return self.ptr.GetNumBodies()
+
+    @property
+    def num_threads(self) -> int:
+        return self.ptr.GetNumThreads()
+
+    @property
+    def step_cnt(self) -> np.ndarray:
+        return np.array([self.ptr.GetStepCount(i) for i in range(self.ptr.GetNumWorlds())], dtype=np.int32)
+
+    @property
+    def done_cnt(self) -> np.ndarray:
+        return np.array([self.ptr.GetDoneCount(i) for i in range(self.ptr.GetNumWorlds())], dtype=np.int32)
+
+    @property
+    def accum_energy(self) -> np.ndarray:
+        return np.array([self.ptr.GetAccumEnergy(i) for i in range(self.ptr.GetNumWorlds())], dtype=np.float64)
+
+    def reset(self, int index, np.ndarray state, double ground_clearance = 1e-8):
+        """
+        load a state in shape (num_body, 13) into world index and restart its episode.
+        return: state (num_body, 13) and observation (16 * num_body + 3,) after loading
+        """
+        if index < 0 or index >= self.ptr.GetNumWorlds():
+            raise IndexError("world index %d out of range" % index)
+        cdef int nb = self.ptr.GetNumBodies()
+        cdef np.ndarray state_buf = np.ascontiguousarray(state, dtype=np.float32)
+        if state_buf.size != 13 * nb:
+            raise ValueError("state should have 13 * num_body elements")
+        cdef np.ndarray state_out = np.empty((nb, 13), dtype=np.float32)
+        cdef np.ndarray obs_out = np.empty(16 * nb + 3, dtype=np.float32)
+        with nogil:
+            self.ptr.Reset(index, <const float *> state_buf.data, ground_clearance,
+                           <float *> state_out.data, <float *> obs_out.data)
+        return state_out, obs_out
+
+    def step(self, np.ndarray actions, np.ndarray target_height):
+        """
+        actions:       (num_world, num_joint, 3) rotation vectors of the joint targets
+        target_height: (num_world,) head height of the reference motion at the target frame
+        return: state (num_world, num_body, 13), observation (num_world, 16 * num_body + 3),
+                done (num_world,) with 1 for reaching max_length and 2 for failure
+        """
+        cdef int nw = self.ptr.GetNumWorlds(), nb = self.ptr.GetNumBodies()
+        cdef np.ndarray action_buf = np.ascontiguousarray(actions, dtype=np.float64)
+        cdef np.ndarray height_buf = np.ascontiguousarray(target_height, dtype=np.float64)
+        if action_buf.size != 3 * nw * self.ptr.GetNumJoints():
+            raise ValueError("actions should be in shape (num_world, num_joint, 3)")
+        if height_buf.size != nw:
+            raise ValueError("target_height should be in shape (num_world,)")
+        cdef np.ndarray state_out = np.empty((nw, nb, 13), dtype=np.float32)
+        cdef np.ndarray obs_out = np.empty((nw, 16 * nb + 3), dtype=np.float32)
+        cdef np.ndarray done_out = np.empty(nw, dtype=np.int32)
+        with nogil:
+            self.ptr.Step(<const double *> action_buf.data, <const double *> height_buf.data,
+                          <float *> state_out.data, <float *> obs_out.data, <int *> done_out.data)
+        return state_out, obs_out, done_out
+
+
+# Add by Zhenhua Song
+cdef class ShmTrajectoryRing:
+    """
+    Ring of fixed size records in shared memory (Utils/shm_transport.h), for sending
+    trajectories from sampling processes to the learner on the same machine.
+    Several processes may reserve / write / commit at the same time; one process reads.
+    The owner is created with create=True and removes the shared memory when deleted,
+    the others attach by name.
+    """
+    cdef CShmTrajectoryRing * ptr
+
+    def __cinit__(self, str name, size_t record_size = 0, size_t capacity = 0, bint create = False):
+        cdef bytes b_name = name.encode('ascii')
+        if create:
+            self.ptr = ShmTrajectoryRingCreate(b_name, record_size, capacity)
+        else:
+            self.ptr = ShmTrajectoryRingOpen(b_name)
+        if self.ptr == NULL:
+            raise OSError("can not %s shared memory ring %s" % ("create" if create else "open", name))
+
+    def __dealloc__(self):
+        if self.ptr != NULL:
+            ShmTrajectoryRingDelete(self.ptr)
+            self.ptr = NULL
+
+    @property
+    def record_size(self) -> int:
+        return self.ptr.GetRecordSize()
+
+    @property
+    def capacity(self) -> int:
+        return self.ptr.GetCapacity()
+
+    def records(self) -> np.ndarray:
+        """
+        uint8 view of the records in shape (capacity, record_size), without copy.
+        sequence number s is stored at row s & (capacity - 1).
+        """
+        cdef np.npy_intp dims[2]
+        dims[0] = self.ptr.GetCapacity()
+        dims[1] = self.ptr.GetRecordSize()
+        cdef np.ndarray arr = np.PyArray_SimpleNewFromData(2, dims, np.NPY_UINT8, <void *> self.ptr.GetRecords())
+        np.set_array_base(arr, self)  # the mapping must outlive the view
+        return arr
+
+    def reserve(self, size_t count) -> int:
+        """
+        reserve count records for writing, return the first sequence number, or -1 if the ring is full
+        """
+        cdef long long start
+        with nogil:
+            start = self.ptr.Reserve(count)
+        return start
+
+    def commit(self, unsigned long long start, size_t count):
+        """
+        publish the reserved records [start, start + count) after writing them
+        """
+        with nogil:
+            self.ptr.Commit(start, count)
+
+    def ready(self, size_t max_count = 0):
+        """
+        return (start, count) of the published records from the read position on.
+        max_count = 0 means no limit.
+        """
+        cdef unsigned long long start = 0
+        cdef size_t count
+        if max_count == 0:
+            max_count = self.ptr.GetCapacity()
+        with nogil:
+            count = self.ptr.Ready(&start, max_count)
+        return start, count
+
+    def release(self, size_t count):
+        """
+        give back the first count ready records to the producers
+        """
+        self.ptr.Release(count)
+
+
+# Add by Zhenhua Song
+cdef class ShmParamSlot:
+    """
+    One byte blob in shared memory behind a seqlock (Utils/shm_transport.h),
+    for broadcasting policy weights from the learner to sampling processes.
+    """
+    cdef CShmParamSlot * ptr
+
+    def __cinit__(self, str name, size_t capacity = 0, bint create = False):
+        cdef bytes b_name = name.encode('ascii')
+        if create:
+            self.ptr = ShmParamSlotCreate(b_name, capacity)
+        else:
+            self.ptr = ShmParamSlotOpen(b_name)
+        if self.ptr == NULL:
+            raise OSError("can not %s shared memory slot %s" % ("create" if create else "open", name))
+
+    def __dealloc__(self):
+        if self.ptr != NULL:
+            ShmParamSlotDelete(self.ptr)
+            self.ptr = NULL
+
+    @property
+    def capacity(self) -> int:
+        return self.ptr.GetCapacity()
+
+    @property
+    def version(self) -> int:
+        """
+        number of writes so far
+        """
+        return self.ptr.GetVersion()
+
+    def write(self, np.ndarray data) -> int:
+        """
+        copy the bytes of data into the slot, return the new version
+        """
+        cdef np.ndarray buf = np.ascontiguousarray(data)
+        cdef size_t nbytes = buf.nbytes
+        cdef unsigned long long version
+        if nbytes > self.ptr.GetCapacity():
+            raise ValueError("%d bytes do not fit in the slot of %d bytes" % (nbytes, self.ptr.GetCapacity()))
+        with nogil:
+            version = self.ptr.Write(<const void *> buf.data, nbytes)
+        return version
+
+    def read(self):
+        """
+        return (version, data) where data is a uint8 copy of the blob
+        """
+        cdef np.ndarray out = np.empty(self.ptr.GetCapacity(), dtype=np.uint8)
+        cdef size_t nbytes = 0
+        cdef unsigned long long version
+        with nogil:
+            version = self.ptr.Read(<void *> out.data, out.size, &nbytes)
+        return version, out[:nbytes]
+
+
 ######################################################################
 environment = None
 InitODE()
@@ -12908,6 +14089,7 @@ class ODESim:
                 self.fall_down: bool = False  # Fall Down Flag. Will be set in collision callback
                 self.falldown_ratio = 0.0  # if com <= falldown_ratio * initial_com, we can say the character fall down
                 self._self_collision: bool = True  # self collision detaction
+                self.pair_table: Optional[CharacterPairTable] = None  # geom pairs allowed in self collision
 
                 self._is_enable: bool = True
                 self._is_kinematic: bool = False
@@ -13046,6 +14228,18 @@ class ODESim:
                         geom: GeomObject = _geom
                         geom.character_self_collide = int(value)
                 self._self_collision = value
+                if self.pair_table is not None:
+                    self.build_self_collision_table()
+
+            def build_self_collision_table(self):
+                """
+                Precompute the geom pairs of this character that may collide (not on adjacent bodies,
+                not ignored, self collision enabled), so the space never generates the other pairs.
+                Call it again after changing joints or ignored geoms of the character.
+                """
+                geoms: List[GeomObject] = [geom for body in self.bodies for geom in body.geom_iter()]
+                self.pair_table = CharacterPairTable(len(geoms))
+                self.pair_table.build(geoms, self._self_collision)
 
             @property
             def is_enable(self) -> bool:
@@ -13120,6 +14314,16 @@ class ODESim:
                 body_state.load(self.world, self.body_info.body_c_id)
                 self.accum_energy: float = 0.0
 
+            def load_state13(self, state: np.ndarray, ground_clearance: Optional[float] = None) -> float:
+                """
+                Load a state in shape (num body, 13) as given by character_state,
+                see World.load_state13
+                """
+                if self.body_info.body_c_id is None:
+                    self.body_info.calc_body_c_id()
+                self.accum_energy: float = 0.0
+                return self.world.load_state13(self.body_info.body_c_id, state, ground_clearance)
+
             # get joint name list.
             def get_joint_names(self, with_root: bool = False) -> List[str]:
                 result = self.joint_info.joint_names()
@@ -13448,6 +14652,7 @@ class ODESim:
             self.set_geom_character_id(character_id)
             self.set_geom_max_friction()
             self.set_geom_index()
+            self.character.build_self_collision_table()
             self.calc_joint_parent_body_c_id()
             self.calc_joint_child_body_c_id()
             self.character.save_init_state()
@@ -14266,20 +15471,77 @@ class ODESim:
                 self.kps = joint_info.kps.flatten()
                 self.world = joint_info.world
                 self.joint_info = joint_info
-                self.cache_global_torque: Optional[np.ndarray] = None
-                self.cache_local_torque: Optional[np.ndarray] = None
+                # torques, body torque accumulation and power in one native call
+                self.pd_control = JointPDController(self.joint_c_id, self.kps, self.tor_lim)
 
-            def add_torques_by_quat(self, tar_local_qs: np.ndarray) -> np.ndarray:
-                c_local_torque, c_global_torque, tot_power = self.world.get_pd_control_torque(self.joint_c_id, tar_local_qs, self.kps, self.tor_lim)
-                self.cache_global_torque = c_global_torque
-                self.cache_local_torque = c_local_torque
-                self.world.add_global_torque(c_global_torque, self.joint_info.parent_body_c_id, self.joint_info.child_body_c_id)
-                self.character.accum_energy += tot_power
-                return c_global_torque
+            @property
+            def cache_global_torque(self) -> np.ndarray:
+                return self.pd_control.global_torque
+
+            @property
+            def cache_local_torque(self) -> np.ndarray:
+                return self.pd_control.local_torque
+
+            def add_torques_by_quat(self, tar_local_qs: np.ndarray) -> None:
+                """
+                the torques are in cache_global_torque / cache_local_torque, as views (no copy per substep)
+                """
+                self.character.accum_energy += self.pd_control.apply(tar_local_qs)
+
+            def set_target_rotvec(self, action: np.ndarray) -> None:
+                """
+                action: joint local targets as rotation vectors, converted once per control step in C++
+                """
+                self.pd_control.set_target_rotvec(action)
+
+            def add_torques_by_target(self) -> None:
+                """
+                add_torques_by_quat with the target of set_target_rotvec
+                """
+                self.character.accum_energy += self.pd_control.apply_target()
+
+
+        class ImplicitDampedPDControler:
+            """
+            stable PD solved inside World.dampedStep (World.set_stable_pd): no torque is added here,
+            add_torques_by_quat only sets the targets, so it can be called once per control step.
+            Only pays off at very low substep counts (1 per control step), where DampedPDControler loses
+            the pose; at the same substep count it otherwise costs and tracks about the same.
+            """
+            def __init__(self, character):
+                self.character = character
+                joint_info = character.joint_info
+                self.joint_c_id: np.ndarray = joint_info.joint_c_id
+                self.world = joint_info.world
+                self.joint_info = joint_info
+                self.world.set_stable_pd(self.joint_c_id, joint_info.kps.flatten(), None, joint_info.torque_limit.flatten())
+
+            def add_torques_by_quat(self, tar_local_qs: np.ndarray) -> None:
+                self.world.set_stable_pd_targets(self.joint_c_id, tar_local_qs)
+
+            def disable(self):
+                self.world.disable_stable_pd(self.joint_c_id)
 
 
         # For World.step
         class PDControler(PDControlerBase):
+            def __init__(self, joint_info):
+                super().__init__(joint_info)
+                # kp, kd, clip and body torque accumulation in one native call
+                self.pd_control = JointPDController(joint_info.joint_c_id, self.kps, self.tor_lim, self.kds)
+
+            def add_torques_by_quat(self, tar_local_qs: np.ndarray) -> np.ndarray:
+                """
+                the torques are in cache_global_torque / cache_local_torque, as views (no copy per substep)
+                """
+                self.pd_control.apply(tar_local_qs)
+                self.cache_global_torque = self.pd_control.global_torque
+                self.cache_local_torque = self.pd_control.local_torque
+                return self.cache_global_torque
+
+
+        # Reference implementation of PDControler in python
+        class PDControlerSlow(PDControlerBase):
             def __init__(self, joint_info):
                 super().__init__(joint_info)
 
@@ -15639,6 +16901,7 @@ class ODESim:
             def pre_simulate_step(self) -> JointGroup:
                 for character in self.characters:
                     character.fall_down = False
+                self.world.sweep_fast_bodies(self.space, self.sim_dt)  # bodies with fast_moving set
                 self.space.collide((self.world, self.contact), self.near_callback)
                 return self.contact
                 # self.space.fast_collide()
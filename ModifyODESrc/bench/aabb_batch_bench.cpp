@@ -0,0 +1,207 @@
+// Micro benchmark of the AABB update done by cleanGeoms, on a 20 body
+// character like scene: capsule limbs, box torso / feet and sphere head /
+// hands, some of them with an offset from their body. Every iteration moves
+// all bodies, so every geom is dirty, then updates the AABBs two ways:
+// - per geom: the recomputeAABB() loop of the spaces
+// - batched: dirty geoms grouped by class, then one non virtual loop per
+//   class with the same arithmetic as its computeAABB
+// Both must give bitwise equal AABBs. On a character sized scene the batched
+// update is not faster, most of the time goes to recomputePosr and the
+// virtual call is well predicted, so the spaces keep the per geom loop.
+//
+// usage: aabb_batch_bench [iterations]
+
+#include <ode/ode.h>
+#include "config.h"
+#include "collision_kernel.h"
+#include "collision_std.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const int NUM_BODIES = 20;
+
+    void moveBodies(const std::vector<dBodyID>& bodies, int iter)
+    {
+        for (size_t i = 0; i < bodies.size(); i++)
+        {
+            dReal t = REAL(0.001) * (iter + (int)i);
+            dBodySetPosition(bodies[i], dSin(t) + REAL(0.1) * i, REAL(1.0) + REAL(0.05) * i, dCos(t));
+            dMatrix3 R;
+            dRFromAxisAndAngle(R, REAL(0.3), REAL(1.0), REAL(0.2) * i, t);
+            dBodySetRotation(bodies[i], R);
+        }
+    }
+
+    // what cleanGeoms does
+    void cleanPerGeom(dxSpace* space)
+    {
+        for (dxGeom* g = space->first; g && (g->gflags & GEOM_DIRTY); g = g->next)
+        {
+            g->recomputeAABB();
+            g->gflags &= ~(GEOM_DIRTY | GEOM_AABB_BAD);
+        }
+    }
+
+    void setAABB(dxGeom* g, const dReal* pos, dReal xrange, dReal yrange, dReal zrange)
+    {
+        g->aabb[0] = pos[0] - xrange;
+        g->aabb[1] = pos[0] + xrange;
+        g->aabb[2] = pos[1] - yrange;
+        g->aabb[3] = pos[1] + yrange;
+        g->aabb[4] = pos[2] - zrange;
+        g->aabb[5] = pos[2] + zrange;
+    }
+
+    // each loop matches the computeAABB of its class
+    void updateSpheres(const std::vector<dxGeom*>& geoms)
+    {
+        for (dxGeom* geom : geoms)
+        {
+            dxSphere* g = (dxSphere*)geom;
+            g->recomputePosr();
+            setAABB(g, g->final_posr->pos, g->radius, g->radius, g->radius);
+        }
+    }
+
+    void updateBoxes(const std::vector<dxGeom*>& geoms)
+    {
+        for (dxGeom* geom : geoms)
+        {
+            dxBox* g = (dxBox*)geom;
+            g->recomputePosr();
+            const dReal* R = g->final_posr->R;
+            const dReal* side = g->side;
+            dReal xrange = REAL(0.5) * (dFabs(R[0] * side[0]) + dFabs(R[1] * side[1]) + dFabs(R[2] * side[2]));
+            dReal yrange = REAL(0.5) * (dFabs(R[4] * side[0]) + dFabs(R[5] * side[1]) + dFabs(R[6] * side[2]));
+            dReal zrange = REAL(0.5) * (dFabs(R[8] * side[0]) + dFabs(R[9] * side[1]) + dFabs(R[10] * side[2]));
+            setAABB(g, g->final_posr->pos, xrange, yrange, zrange);
+        }
+    }
+
+    void updateCapsules(const std::vector<dxGeom*>& geoms)
+    {
+        for (dxGeom* geom : geoms)
+        {
+            dxCapsule* g = (dxCapsule*)geom;
+            g->recomputePosr();
+            const dReal* R = g->final_posr->R;
+            dReal xrange = dFabs(R[2] * g->lz) * REAL(0.5) + g->radius;
+            dReal yrange = dFabs(R[6] * g->lz) * REAL(0.5) + g->radius;
+            dReal zrange = dFabs(R[10] * g->lz) * REAL(0.5) + g->radius;
+            setAABB(g, g->final_posr->pos, xrange, yrange, zrange);
+        }
+    }
+
+    void cleanBatched(dxSpace* space)
+    {
+        static std::vector<dxGeom*> spheres, boxes, capsules;
+        spheres.clear();
+        boxes.clear();
+        capsules.clear();
+        for (dxGeom* g = space->first; g && (g->gflags & GEOM_DIRTY); g = g->next)
+        {
+            if (!(g->gflags & GEOM_AABB_BAD)) continue;
+            switch (g->type)
+            {
+            case dSphereClass: spheres.push_back(g); break;
+            case dBoxClass: boxes.push_back(g); break;
+            case dCapsuleClass: capsules.push_back(g); break;
+            default: g->recomputeAABB(); break;
+            }
+        }
+        updateSpheres(spheres);
+        updateBoxes(boxes);
+        updateCapsules(capsules);
+        for (dxGeom* g = space->first; g && (g->gflags & GEOM_DIRTY); g = g->next)
+        {
+            g->gflags &= ~(GEOM_DIRTY | GEOM_AABB_BAD);
+        }
+    }
+
+    void saveAABBs(dxSpace* space, std::vector<dReal>& out)
+    {
+        out.clear();
+        for (dxGeom* g = space->first; g; g = g->next)
+        {
+            out.insert(out.end(), g->aabb, g->aabb + 6);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+    dInitODE();
+    dWorldID world = dWorldCreate();
+    dSpaceID space = dHashSpaceCreate(0);
+
+    std::vector<dBodyID> bodies;
+    for (int i = 0; i < NUM_BODIES; i++)
+    {
+        dBodyID body = dBodyCreate(world);
+        dGeomID geom;
+        if (i < 12)
+        {
+            geom = dCreateCapsule(space, REAL(0.04) + REAL(0.005) * i, REAL(0.25));
+        }
+        else if (i < 17)
+        {
+            geom = dCreateBox(space, REAL(0.3), REAL(0.2), REAL(0.1) + REAL(0.02) * i);
+        }
+        else
+        {
+            geom = dCreateSphere(space, REAL(0.05) + REAL(0.03) * (i - 17));
+        }
+        dGeomSetBody(geom, body);
+        if (i % 2)
+        {
+            dGeomSetOffsetPosition(geom, 0, REAL(0.1), 0);
+        }
+        bodies.push_back(body);
+    }
+    dxSpace* sp = (dxSpace*)space;
+
+    // both paths must give the same AABBs, bit for bit
+    std::vector<dReal> a, b;
+    moveBodies(bodies, 7);
+    cleanPerGeom(sp);
+    saveAABBs(sp, a);
+    moveBodies(bodies, 7);
+    cleanBatched(sp);
+    saveAABBs(sp, b);
+    if (memcmp(&a[0], &b[0], sizeof(dReal) * a.size()) != 0)
+    {
+        printf("AABB mismatch between batched and per geom update\n");
+        return 1;
+    }
+
+    double cost[2] = { 0, 0 };
+    for (int iter = 0; iter < iterations; iter++)
+    {
+        // alternate which path runs first, so neither gets the warmer cache
+        for (int k = 0; k < 2; k++)
+        {
+            int mode = (iter + k) & 1;
+            moveBodies(bodies, iter);
+            auto start = std::chrono::steady_clock::now();
+            if (mode == 0) cleanPerGeom(sp);
+            else cleanBatched(sp);
+            cost[mode] += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    printf("%d geoms, %d iterations\n", NUM_BODIES, iterations);
+    printf("per geom: %8.1f ns / update\n", cost[0] / iterations);
+    printf("batched:  %8.1f ns / update\n", cost[1] / iterations);
+    printf("speedup:  %8.2fx\n", cost[0] / cost[1]);
+
+    dSpaceDestroy(space);
+    dWorldDestroy(world);
+    dCloseODE();
+    return 0;
+}
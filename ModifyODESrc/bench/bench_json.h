@@ -0,0 +1,228 @@
+// Minimal JSON reader for the benchmarks: scene exports and baseline files.
+// Numbers are doubles, objects keep their key order. Throws
+// std::runtime_error on malformed input.
+
+#ifndef _ODE_BENCH_JSON_H_
+#define _ODE_BENCH_JSON_H_
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench
+{
+    struct JsonValue
+    {
+        enum Type { Null, Bool, Number, String, Array, Object };
+
+        Type type = Null;
+        bool boolean = false;
+        double number = 0;
+        std::string str;
+        std::vector<JsonValue> items;
+        std::vector<std::pair<std::string, JsonValue> > members;
+
+        // NULL if this is not an object or has no such key
+        const JsonValue* find(const std::string& key) const
+        {
+            for (size_t i = 0; i < members.size(); i++)
+            {
+                if (members[i].first == key)
+                    return &members[i].second;
+            }
+            return NULL;
+        }
+
+        const JsonValue& operator[](const std::string& key) const
+        {
+            const JsonValue* v = find(key);
+            if (v == NULL)
+                throw std::runtime_error("missing key " + key);
+            return *v;
+        }
+
+        const JsonValue& operator[](size_t i) const
+        {
+            if (i >= items.size())
+                throw std::runtime_error("index out of range");
+            return items[i];
+        }
+
+        size_t size() const { return type == Array ? items.size() : members.size(); }
+
+        double asNumber(double default_value = 0) const { return type == Number ? number : (type == Bool ? boolean : default_value); }
+        bool asBool(bool default_value = false) const { return type == Bool ? boolean : (type == Number ? number != 0 : default_value); }
+    };
+
+    class JsonParser
+    {
+    public:
+        explicit JsonParser(const std::string& text): s(text), pos(0) {}
+
+        JsonValue parse()
+        {
+            JsonValue v = parseValue();
+            skipSpace();
+            if (pos != s.size())
+                fail("trailing characters");
+            return v;
+        }
+
+    private:
+        const std::string& s;
+        size_t pos;
+
+        void fail(const char* what) const
+        {
+            throw std::runtime_error(std::string("json: ") + what + " at offset " + std::to_string(pos));
+        }
+
+        void skipSpace()
+        {
+            while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\n' || s[pos] == '\r'))
+                pos++;
+        }
+
+        bool consume(const char* word)
+        {
+            size_t n = 0;
+            while (word[n]) n++;
+            if (s.compare(pos, n, word) != 0)
+                return false;
+            pos += n;
+            return true;
+        }
+
+        JsonValue parseValue()
+        {
+            skipSpace();
+            if (pos >= s.size())
+                fail("unexpected end");
+            JsonValue v;
+            char c = s[pos];
+            if (c == '{')
+            {
+                v.type = JsonValue::Object;
+                pos++;
+                skipSpace();
+                if (pos < s.size() && s[pos] == '}') { pos++; return v; }
+                for (;;)
+                {
+                    skipSpace();
+                    if (pos >= s.size() || s[pos] != '"')
+                        fail("expected key");
+                    std::string key = parseString();
+                    skipSpace();
+                    if (pos >= s.size() || s[pos] != ':')
+                        fail("expected ':'");
+                    pos++;
+                    v.members.emplace_back(key, parseValue());
+                    skipSpace();
+                    if (pos < s.size() && s[pos] == ',') { pos++; continue; }
+                    if (pos < s.size() && s[pos] == '}') { pos++; return v; }
+                    fail("expected ',' or '}'");
+                }
+            }
+            if (c == '[')
+            {
+                v.type = JsonValue::Array;
+                pos++;
+                skipSpace();
+                if (pos < s.size() && s[pos] == ']') { pos++; return v; }
+                for (;;)
+                {
+                    v.items.push_back(parseValue());
+                    skipSpace();
+                    if (pos < s.size() && s[pos] == ',') { pos++; continue; }
+                    if (pos < s.size() && s[pos] == ']') { pos++; return v; }
+                    fail("expected ',' or ']'");
+                }
+            }
+            if (c == '"')
+            {
+                v.type = JsonValue::String;
+                v.str = parseString();
+                return v;
+            }
+            if (consume("true")) { v.type = JsonValue::Bool; v.boolean = true; return v; }
+            if (consume("false")) { v.type = JsonValue::Bool; return v; }
+            if (consume("null")) return v;
+            // json.dump writes these for non finite floats
+            if (consume("NaN")) { v.type = JsonValue::Number; v.number = NAN; return v; }
+            if (consume("Infinity")) { v.type = JsonValue::Number; v.number = INFINITY; return v; }
+            if (consume("-Infinity")) { v.type = JsonValue::Number; v.number = -INFINITY; return v; }
+
+            const char* begin = s.c_str() + pos;
+            char* end = NULL;
+            v.type = JsonValue::Number;
+            v.number = strtod(begin, &end);
+            if (end == begin)
+                fail("unexpected character");
+            pos += end - begin;
+            return v;
+        }
+
+        std::string parseString()
+        {
+            std::string out;
+            pos++; // opening quote
+            while (pos < s.size() && s[pos] != '"')
+            {
+                char c = s[pos++];
+                if (c != '\\')
+                {
+                    out += c;
+                    continue;
+                }
+                if (pos >= s.size())
+                    fail("bad escape");
+                c = s[pos++];
+                switch (c)
+                {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u':
+                {
+                    if (pos + 4 > s.size())
+                        fail("bad escape");
+                    unsigned code = (unsigned)strtoul(s.substr(pos, 4).c_str(), NULL, 16);
+                    pos += 4;
+                    // names in the exports are ascii, other code points are kept as utf-8 without surrogate handling
+                    if (code < 0x80) out += (char)code;
+                    else if (code < 0x800) { out += (char)(0xc0 | (code >> 6)); out += (char)(0x80 | (code & 0x3f)); }
+                    else { out += (char)(0xe0 | (code >> 12)); out += (char)(0x80 | ((code >> 6) & 0x3f)); out += (char)(0x80 | (code & 0x3f)); }
+                    break;
+                }
+                default: out += c; break;
+                }
+            }
+            if (pos >= s.size())
+                fail("unterminated string");
+            pos++;
+            return out;
+        }
+    };
+
+    inline JsonValue loadJsonFile(const char* fname)
+    {
+        FILE* f = fopen(fname, "rb");
+        if (f == NULL)
+            throw std::runtime_error(std::string("cannot open ") + fname);
+        std::string text;
+        char buf[65536];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            text.append(buf, n);
+        fclose(f);
+        return JsonParser(text).parse();
+    }
+}
+
+#endif
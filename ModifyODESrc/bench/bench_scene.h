@@ -0,0 +1,437 @@
+// Humanoid scene of the benchmarks, read from the JSON export written by
+// export_scene.py and built like JsonSceneLoader / JsonCharacterLoader do:
+// body mass from the geoms and the body density (or the stored mass /
+// inertia), geoms at their world offset, ball joints with an euler AMotor for
+// the angle limits, hinges with stops, joint damping and the parent /
+// grandparent ignore lists. The motors of the joints get an FMax of 0.1
+// TorqueLimit (the PD servo of ode_bench); set it to 0 to drive the joints
+// by torques.
+
+#ifndef _ODE_BENCH_SCENE_H_
+#define _ODE_BENCH_SCENE_H_
+
+#include <ode/ode.h>
+#include "bench_json.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    struct BenchJoint
+    {
+        dJointID joint;
+        dJointID amotor;    // euler axes of a ball joint, or NULL
+        bool hinge;
+        int num_axes;       // driven angles: 1 for a hinge, 3 for a ball joint with an AMotor
+        dReal lo[3], hi[3]; // angle range of the tracked sine
+        dReal gain;         // Kp / Damping
+        dReal torque_limit; // motor FMax, 0.1 TorqueLimit
+        dReal kp;           // Kps and TorqueLimit of PDControlParam, Damping of the joint
+        dReal max_torque;
+        dReal damping;
+    };
+
+    struct BenchScene
+    {
+        dWorldID world = NULL;
+        dSpaceID space = NULL;
+        dJointGroupWithdWorld info;
+        dReal dt = REAL(1.0) / 120;
+        std::vector<dBodyID> bodies;
+        std::vector<int> parent;
+        std::vector<BenchJoint> joints;
+        std::vector<unsigned char> initial_state;
+
+        ~BenchScene()
+        {
+            if (info.group) dJointGroupDestroy(info.group);
+            if (space) dSpaceDestroy(space);
+            if (world) dWorldDestroy(world);
+        }
+    };
+
+    inline void vec3(const JsonValue& v, dReal* out)
+    {
+        for (int i = 0; i < 3; i++) out[i] = v[i].asNumber();
+    }
+
+    // scipy (x, y, z, w) to ode (w, x, y, z)
+    inline void quatScipy(const JsonValue& v, dQuaternion q)
+    {
+        q[0] = v[3].asNumber(); q[1] = v[0].asNumber(); q[2] = v[1].asNumber(); q[3] = v[2].asNumber();
+        dNormalize4(q);
+    }
+
+    inline dGeomID createGeom(dSpaceID space, const JsonValue& g, dReal density, dMass* mass)
+    {
+        const std::string& type = g["GeomType"].str;
+        const JsonValue& scale = g["Scale"];
+        dGeomID geom = NULL;
+        if (type == "Sphere")
+        {
+            geom = dCreateSphere(space, scale[0].asNumber());
+            if (mass) dMassSetSphere(mass, density, scale[0].asNumber());
+        }
+        else if (type == "Capsule")
+        {
+            geom = dCreateCapsule(space, scale[0].asNumber(), scale[1].asNumber());
+            if (mass) dMassSetCapsule(mass, density, 3, scale[0].asNumber(), scale[1].asNumber());
+        }
+        else if (type == "Cube")
+        {
+            geom = dCreateBox(space, scale[0].asNumber(), scale[1].asNumber(), scale[2].asNumber());
+            if (mass) dMassSetBox(mass, density, scale[0].asNumber(), scale[1].asNumber(), scale[2].asNumber());
+        }
+        else if (type == "Plane")
+        {
+            dQuaternion q;
+            quatScipy(g["Quaternion"], q);
+            dVector3 up = { 0, 1, 0 }, n;
+            dMatrix3 R;
+            dRfromQ(R, q);
+            dMultiply0_331(n, R, up);
+            dVector3 p;
+            vec3(g["Position"], p);
+            geom = dCreatePlane(space, n[0], n[1], n[2], dCalcVectorDot3(p, n));
+        }
+        else
+        {
+            throw std::runtime_error("unsupported geom type " + type);
+        }
+
+        dGeomContactAttrs* attrs = dGeomGetContactAttrs(geom);
+        attrs->friction = g["Friction"].asNumber(REAL(0.8));
+        attrs->collidable = g["Collidable"].asBool(true);
+        return geom;
+    }
+
+    inline void loadEnvironment(BenchScene& scene, const JsonValue& env)
+    {
+        const JsonValue& geoms = env["Geoms"];
+        for (size_t i = 0; i < geoms.size(); i++)
+        {
+            dGeomID g = createGeom(scene.space, geoms[i], 0, NULL);
+            if (dGeomGetClass(g) != dPlaneClass)
+            {
+                dVector3 p;
+                dQuaternion q;
+                vec3(geoms[i]["Position"], p);
+                quatScipy(geoms[i]["Quaternion"], q);
+                dGeomSetPosition(g, p[0], p[1], p[2]);
+                dGeomSetQuaternion(g, q);
+            }
+            dGeomSetCharacterID(g, -1);
+        }
+    }
+
+    inline void loadBody(BenchScene& scene, const JsonValue& jb, int character_id)
+    {
+        dBodyID body = dBodyCreate(scene.world);
+        dReal density = jb["Density"].asNumber();
+        if (density == 0)
+            density = 1;
+
+        // geoms sorted by GeomID, in the order of the export
+        const JsonValue& jgeoms = jb["Geoms"];
+        std::vector<const JsonValue*> order;
+        for (size_t i = 0; i < jgeoms.size(); i++) order.push_back(&jgeoms[i]);
+        std::stable_sort(order.begin(), order.end(), [](const JsonValue* a, const JsonValue* b) {
+            return (*a)["GeomID"].asNumber() < (*b)["GeomID"].asNumber();
+        });
+
+        // the body position is the center of mass of its geoms
+        std::vector<dGeomID> geoms;
+        std::vector<dMass> masses(order.size());
+        dVector3 com = { 0, 0, 0 };
+        dReal total = 0;
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            geoms.push_back(createGeom(scene.space, *order[i], density, &masses[i]));
+            dVector3 c;
+            vec3((*order[i])["Position"], c);
+            for (int k = 0; k < 3; k++) com[k] += masses[i].mass * c[k];
+            total += masses[i].mass;
+        }
+        for (int k = 0; k < 3; k++) com[k] /= total;
+        dBodySetPosition(body, com[0], com[1], com[2]);
+
+        dMass mass_total;
+        dMassSetZero(&mass_total);
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            dVector3 c;
+            dQuaternion q;
+            dMatrix3 R;
+            vec3((*order[i])["Position"], c);
+            quatScipy((*order[i])["Quaternion"], q);
+            dRfromQ(R, q);
+
+            dGeomSetBody(geoms[i], body);
+            dGeomSetOffsetWorldPosition(geoms[i], c[0], c[1], c[2]);
+            dGeomSetOffsetWorldRotation(geoms[i], R);
+            dGeomSetCharacterID(geoms[i], character_id);
+
+            dMassRotate(&masses[i], R);
+            dMassTranslate(&masses[i], c[0] - com[0], c[1] - com[1], c[2] - com[2]);
+            dMassAdd(&mass_total, &masses[i]);
+        }
+        mass_total.c[0] = mass_total.c[1] = mass_total.c[2] = 0;
+
+        const JsonValue* inertia_mode = jb.find("InertiaMode");
+        if (inertia_mode && inertia_mode->str == "InertiaValue")
+        {
+            const JsonValue& I = jb["Inertia"];
+            for (int r = 0; r < 3; r++)
+                for (int c = 0; c < 3; c++)
+                    mass_total.I[4 * r + c] = I[3 * r + c].asNumber();
+        }
+        const JsonValue* mass_mode = jb.find("MassMode");
+        if (mass_mode && mass_mode->str == "MassValue")
+            mass_total.mass = jb["Mass"].asNumber();
+        dBodySetMass(body, &mass_total);
+
+        dQuaternion q;
+        quatScipy(jb["Quaternion"], q);
+        dBodySetQuaternion(body, q);
+        if (const JsonValue* v = jb.find("LinearVelocity"))
+            if (v->size() == 3) dBodySetLinearVel(body, (*v)[0].asNumber(), (*v)[1].asNumber(), (*v)[2].asNumber());
+        if (const JsonValue* v = jb.find("AngularVelocity"))
+            if (v->size() == 3) dBodySetAngularVel(body, (*v)[0].asNumber(), (*v)[1].asNumber(), (*v)[2].asNumber());
+
+        scene.bodies.push_back(body);
+        scene.parent.push_back((int)jb["ParentBodyID"].asNumber(-1));
+    }
+
+    inline void ignoreBody(BenchScene& scene, int body, int other)
+    {
+        if (other < 0 || other >= (int)scene.bodies.size())
+            return;
+        for (dGeomID g = dBodyGetFirstGeom(scene.bodies[body]); g; g = dBodyGetNextGeom(g))
+            for (dGeomID o = dBodyGetFirstGeom(scene.bodies[other]); o; o = dBodyGetNextGeom(o))
+                dGeomAppendIgnore(g, o);
+    }
+
+    // dParamVel / dParamFMax of the hinge, or of axis i of the AMotor
+    const int VEL_PARAMS[3] = { dParamVel, dParamVel2, dParamVel3 };
+    const int FMAX_PARAMS[3] = { dParamFMax, dParamFMax2, dParamFMax3 };
+
+    inline void loadJoint(BenchScene& scene, const JsonValue& jj, const JsonValue* kps, const JsonValue* limits, bool use_limits)
+    {
+        BenchJoint bj;
+        int parent_id = (int)jj["ParentBodyID"].asNumber(-1);
+        bj.hinge = jj["JointType"].str == "HingeJoint";
+        bj.amotor = NULL;
+        bj.num_axes = 0;
+        size_t index = scene.joints.size();
+        dReal kp = kps && index < kps->size() ? (*kps)[index].asNumber() : 0;
+        dReal damping = jj.find("Damping") ? jj["Damping"].asNumber() : 0;
+        bj.gain = kp / (damping > 1 ? damping : 1);
+        bj.max_torque = limits && index < limits->size() ? (*limits)[index].asNumber() : dInfinity;
+        bj.torque_limit = REAL(0.1) * bj.max_torque;
+        bj.kp = kp;
+        bj.damping = damping;
+
+        dBodyID child = scene.bodies[(int)jj["ChildBodyID"].asNumber()];
+        dBodyID parent = parent_id >= 0 ? scene.bodies[parent_id] : NULL;
+        dVector3 anchor;
+        vec3(jj["Position"], anchor);
+
+        // euler axis of the joint in the parent frame
+        dQuaternion axis_q = { 1, 0, 0, 0 };
+        if (const JsonValue* a = jj.find("EulerAxisLocalRot"))
+            if (a->size() == 4) quatScipy(*a, axis_q);
+        dMatrix3 axis_mat;
+        dRfromQ(axis_mat, axis_q);
+        const std::string& order = jj["EulerOrder"].str;
+        // row i of the rotation, like calc_hinge_axis
+        auto eulerAxis = [&](char c, dReal* out) {
+            int i = (c & ~0x20) - 'X';
+            for (int k = 0; k < 3; k++) out[k] = axis_mat[4 * i + k];
+        };
+
+        if (bj.hinge)
+        {
+            bj.joint = dJointCreateHinge(scene.world, 0);
+            dJointAttach(bj.joint, child, parent);
+            dJointSetHingeAnchor(bj.joint, anchor[0], anchor[1], anchor[2]);
+            dVector3 axis;
+            eulerAxis(order[0], axis);
+            dJointSetHingeAxis(bj.joint, axis[0], axis[1], axis[2]);
+            bj.num_axes = 1;
+            bj.lo[0] = jj["AngleLoLimit"][0].asNumber() * M_PI / 180;
+            bj.hi[0] = jj["AngleHiLimit"][0].asNumber() * M_PI / 180;
+            if (use_limits)
+            {
+                dJointSetHingeParam(bj.joint, dParamLoStop, bj.lo[0]);
+                dJointSetHingeParam(bj.joint, dParamHiStop, bj.hi[0]);
+            }
+        }
+        else
+        {
+            bj.joint = dJointCreateBall(scene.world, 0);
+            dJointAttach(bj.joint, child, parent);
+            dJointSetBallAnchor(bj.joint, anchor[0], anchor[1], anchor[2]);
+            if (parent != NULL && order.size() == 3)
+            {
+                // JointInfoInit.set_ball_joint_limit
+                dReal lim[3][2];
+                for (int i = 0; i < 3; i++)
+                {
+                    lim[i][0] = jj["AngleLoLimit"][i].asNumber() * M_PI / 180;
+                    lim[i][1] = jj["AngleHiLimit"][i].asNumber() * M_PI / 180;
+                }
+                if (order == "XZY" || order == "YXZ" || order == "ZYX")
+                {
+                    int i = order[2] - 'X';
+                    dReal lo = lim[i][0];
+                    lim[i][0] = -lim[i][1];
+                    lim[i][1] = -lo;
+                }
+                bj.amotor = dJointCreateAMotor(scene.world, 0);
+                dJointAttach(bj.amotor, child, parent);
+                dJointSetAMotorMode(bj.amotor, dAMotorEuler);
+                dJointSetAMotorNumAxes(bj.amotor, 3);
+                dVector3 a0, a2;
+                eulerAxis(order[0], a0);
+                eulerAxis(order[2], a2);
+                dJointSetAMotorAxis(bj.amotor, 0, 1, a0[0], a0[1], a0[2]);
+                dJointSetAMotorAxis(bj.amotor, 2, 2, a2[0], a2[1], a2[2]);
+                if (use_limits)
+                {
+                    dJointSetAMotorParam(bj.amotor, dParamLoStop, lim[0][0]);
+                    dJointSetAMotorParam(bj.amotor, dParamHiStop, lim[0][1]);
+                    dJointSetAMotorParam(bj.amotor, dParamLoStop2, lim[1][0]);
+                    dJointSetAMotorParam(bj.amotor, dParamHiStop2, lim[1][1]);
+                    dJointSetAMotorParam(bj.amotor, dParamLoStop3, lim[2][0]);
+                    dJointSetAMotorParam(bj.amotor, dParamHiStop3, lim[2][1]);
+                }
+                bj.num_axes = 3;
+                for (int i = 0; i < 3; i++)
+                {
+                    bj.lo[i] = lim[i][0];
+                    bj.hi[i] = lim[i][1];
+                }
+            }
+        }
+
+        for (int i = 0; i < bj.num_axes; i++)
+        {
+            if (bj.hinge)
+                dJointSetHingeParam(bj.joint, dParamFMax, bj.torque_limit);
+            else
+                dJointSetAMotorParam(bj.amotor, FMAX_PARAMS[i], bj.torque_limit);
+        }
+        if (damping != 0)
+            dJointSetKd(bj.joint, damping, damping, damping);
+        scene.joints.push_back(bj);
+    }
+
+    inline void loadScene(BenchScene& scene, const JsonValue& root)
+    {
+        scene.world = dWorldCreate();
+        scene.space = dHashSpaceCreate(0);
+
+        // World.__cinit__
+        memset(&scene.info, 0, sizeof(scene.info));
+        scene.info.max_contact_num = 4;
+        scene.info.soft_cfm = REAL(1e-10);
+        scene.info.soft_erp = REAL(0.2);
+        scene.info.group = dJointGroupCreate(10000);
+        scene.info.world = scene.world;
+
+        bool use_limits = true;
+        if (const JsonValue* attr = root.find("WorldAttr"))
+        {
+            if (const JsonValue* change = attr->find("ChangeAttr"))
+            {
+                dVector3 g;
+                vec3((*change)["Gravity"], g);
+                dWorldSetGravity(scene.world, g[0], g[1], g[2]);
+            }
+            if (const JsonValue* fixed = attr->find("FixedAttr"))
+            {
+                if (const JsonValue* fps = fixed->find("SimulateFPS")) scene.dt = 1 / fps->asNumber(120);
+                if (const JsonValue* v = fixed->find("UseAngleLimit")) use_limits = v->asBool(true);
+                if (const JsonValue* v = fixed->find("CFM")) dWorldSetCFM(scene.world, v->asNumber());
+                if (const JsonValue* v = fixed->find("SelfCollision")) scene.info.self_collision = v->asBool();
+            }
+        }
+
+        if (const JsonValue* env = root.find("Environment"))
+            loadEnvironment(scene, *env);
+
+        const JsonValue& characters = root["CharacterList"]["Characters"];
+        if (characters.size() == 0)
+            throw std::runtime_error("no character in the scene");
+        const JsonValue& ch = characters[0];
+
+        std::vector<const JsonValue*> jbodies;
+        for (size_t i = 0; i < ch["Bodies"].size(); i++) jbodies.push_back(&ch["Bodies"][i]);
+        std::stable_sort(jbodies.begin(), jbodies.end(), [](const JsonValue* a, const JsonValue* b) {
+            return (*a)["BodyID"].asNumber() < (*b)["BodyID"].asNumber();
+        });
+        for (size_t i = 0; i < jbodies.size(); i++)
+            loadBody(scene, *jbodies[i], 0);
+
+        const JsonValue* pd = ch.find("PDControlParam");
+        const JsonValue* kps = pd ? pd->find("Kps") : NULL;
+        const JsonValue* limits = pd ? pd->find("TorqueLimit") : NULL;
+        std::vector<const JsonValue*> jjoints;
+        for (size_t i = 0; i < ch["Joints"].size(); i++) jjoints.push_back(&ch["Joints"][i]);
+        std::stable_sort(jjoints.begin(), jjoints.end(), [](const JsonValue* a, const JsonValue* b) {
+            return (*a)["JointID"].asNumber() < (*b)["JointID"].asNumber();
+        });
+        for (size_t i = 0; i < jjoints.size(); i++)
+            loadJoint(scene, *jjoints[i], kps, limits, use_limits);
+
+        // BodyInfo.calc_geom_ignore_id, and IgnoreBodyID of each body
+        bool ignore_parent = ch.find("IgnoreParentCollision") ? ch["IgnoreParentCollision"].asBool(true) : true;
+        bool ignore_grandpa = ch.find("IgnoreGrandpaCollision") ? ch["IgnoreGrandpaCollision"].asBool(true) : true;
+        for (size_t i = 0; i < scene.bodies.size(); i++)
+        {
+            int p = scene.parent[i];
+            if (ignore_parent && p >= 0)
+                ignoreBody(scene, (int)i, p);
+            if (ignore_grandpa && p >= 0 && scene.parent[p] >= 0)
+                ignoreBody(scene, (int)i, scene.parent[p]);
+            if (const JsonValue* ids = jbodies[i]->find("IgnoreBodyID"))
+                for (size_t k = 0; k < ids->size(); k++)
+                    ignoreBody(scene, (int)i, (int)(*ids)[k].asNumber());
+        }
+
+        scene.initial_state.resize(dWorldGetSnapshotSize(scene.world));
+        dWorldSnapshot(scene.world, scene.initial_state.data(), scene.initial_state.size());
+    }
+
+
+    inline uint64_t hashState(const BenchScene& scene, bool* finite)
+    {
+        uint64_t h = 14695981039346656037ULL; // fnv-1a
+        *finite = true;
+        for (size_t i = 0; i < scene.bodies.size(); i++)
+        {
+            const dReal* parts[4] = { dBodyGetPosition(scene.bodies[i]), dBodyGetQuaternion(scene.bodies[i]),
+                dBodyGetLinearVel(scene.bodies[i]), dBodyGetAngularVel(scene.bodies[i]) };
+            const int sizes[4] = { 3, 4, 3, 3 };
+            for (int p = 0; p < 4; p++)
+            {
+                for (int k = 0; k < sizes[p]; k++)
+                    if (!std::isfinite(parts[p][k])) *finite = false;
+                const unsigned char* bytes = (const unsigned char*)parts[p];
+                for (size_t b = 0; b < sizes[p] * sizeof(dReal); b++)
+                {
+                    h ^= bytes[b];
+                    h *= 1099511628211ULL;
+                }
+            }
+        }
+        return h;
+    }
+}
+
+#endif
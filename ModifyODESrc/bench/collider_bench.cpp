@@ -0,0 +1,459 @@
+// Micro benchmark of the narrow phase: every pair of geom classes that has a
+// collider in the dCollide dispatch table (collision_kernel.cpp), including
+// the reversed dispatch, the geom transform and the trimesh / heightfield /
+// convex colliders. Classes without a collider (e.g. cylinder - cylinder
+// without libccd) are listed as unsupported. dCollideConvexBox and
+// dCollideConvexCapsule are stubs without contacts, their pairs (and convex -
+// transform, of a box) only time the dispatch.
+//
+// For each pair a pose set is drawn from a seeded xorshift generator, so the
+// poses are the same on every platform and do not depend on --pair: the
+// first geom at the origin with a random rotation, the second one at a
+// random point of a ball around it (about half the pairs touch). A plane or
+// a heightfield is the ground under the other geom, a ray starts outside the
+// other geom and points roughly at it. Each pose has its own geoms, with
+// their AABBs already computed as after the broad phase, so only dCollide is
+// timed. Reported per pair: ns / dCollide call (best of 5 repetitions),
+// contacts / call and the fraction of calls with a contact.
+//
+// The shapes: sphere r 0.5, box 1 x 0.6 x 0.4, capsule r 0.25 length 1,
+// cylinder r 0.3 length 1, ray length 3, convex cube of side 0.8, transform
+// of an offset 0.6 box, trimesh icosphere r 0.5 (80 triangles) and a 2 x 2
+// heightfield with 17 x 17 samples.
+//
+// usage: collider_bench [--pair sphere-box] [--poses n] [--seed n]
+//                       [--contacts n] [--time seconds] [--json file]
+
+#include <ode/ode.h>
+#include "config.h"
+#include "collision_kernel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // geom classes, without the spaces and the user classes
+    const int CLASS_COUNT = dHeightfieldClass + 1;
+    const char* const CLASS_NAMES[CLASS_COUNT] = {
+        "sphere", "box", "capsule", "cylinder", "plane", "ray", "convex", "transform", "trimesh", "heightfield"
+    };
+
+    // xorshift64*, the pose sets do not depend on the <random> implementation
+    struct Rng
+    {
+        uint64_t s;
+        explicit Rng(uint64_t seed) : s(seed * 0x9E3779B97F4A7C15ULL + 0x2545F4914F6CDD1DULL) {}
+        uint64_t next()
+        {
+            s ^= s >> 12;
+            s ^= s << 25;
+            s ^= s >> 27;
+            return s * 0x2545F4914F6CDD1DULL;
+        }
+        dReal uniform() { return dReal((next() >> 11) * (1.0 / 9007199254740992.0)); } // [0, 1)
+        dReal range(dReal lo, dReal hi) { return lo + (hi - lo) * uniform(); }
+    };
+
+    // shape data shared by all the geoms of a class
+    struct SharedShapes
+    {
+        std::vector<dReal> convex_planes;
+        std::vector<dReal> convex_points;
+        std::vector<unsigned int> convex_polygons;
+        std::vector<dReal> mesh_vertices;
+        std::vector<dTriIndex> mesh_indices;
+        dTriMeshDataID mesh;
+        std::vector<double> heights;
+        dHeightfieldDataID heightfield;
+    };
+
+    void buildConvexCube(SharedShapes& shapes, dReal half)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            shapes.convex_points.push_back(i & 1 ? half : -half);
+            shapes.convex_points.push_back(i & 2 ? half : -half);
+            shapes.convex_points.push_back(i & 4 ? half : -half);
+        }
+        // one face per axis and sign, the corners counter clockwise seen from outside
+        for (int axis = 0; axis < 3; axis++)
+        {
+            for (int sign = 0; sign < 2; sign++)
+            {
+                dReal n[3] = { 0, 0, 0 };
+                n[axis] = sign ? REAL(1.0) : REAL(-1.0);
+                shapes.convex_planes.insert(shapes.convex_planes.end(), { n[0], n[1], n[2], half });
+                int u = (axis + 1) % 3, v = (axis + 2) % 3;
+                std::vector<std::pair<dReal, unsigned int> > corners;
+                for (unsigned int i = 0; i < 8; i++)
+                {
+                    const dReal* p = &shapes.convex_points[3 * i];
+                    if ((p[axis] > 0) == (sign == 1))
+                        corners.push_back(std::make_pair(dReal(atan2(p[v], p[u])) * n[axis], i));
+                }
+                std::sort(corners.begin(), corners.end());
+                shapes.convex_polygons.push_back(4);
+                for (size_t i = 0; i < corners.size(); i++)
+                    shapes.convex_polygons.push_back(corners[i].second);
+            }
+        }
+    }
+
+    // icosahedron subdivided once, projected on a sphere
+    void buildIcosphere(SharedShapes& shapes, dReal radius)
+    {
+        const dReal t = REAL(0.5) * (1 + dSqrt(REAL(5.0)));
+        const dReal base[12][3] = {
+            { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+            { 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+            { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 }
+        };
+        const int faces[20][3] = {
+            { 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+            { 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+            { 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+            { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+        };
+        std::vector<dReal>& vtx = shapes.mesh_vertices;
+        auto addVertex = [&vtx, radius](const dReal* a, const dReal* b) {
+            dReal p[3] = { a[0] + b[0], a[1] + b[1], a[2] + b[2] };
+            dReal scale = radius / dSqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+            vtx.insert(vtx.end(), { p[0] * scale, p[1] * scale, p[2] * scale });
+            return dTriIndex(vtx.size() / 3 - 1);
+        };
+        const dReal zero[3] = { 0, 0, 0 };
+        for (int i = 0; i < 12; i++)
+            addVertex(base[i], zero);
+        for (int f = 0; f < 20; f++)
+        {
+            dTriIndex a = faces[f][0], b = faces[f][1], c = faces[f][2];
+            // the midpoints are not shared between faces, the mesh does not need them to be
+            dTriIndex ab = addVertex(base[a], base[b]);
+            dTriIndex bc = addVertex(base[b], base[c]);
+            dTriIndex ca = addVertex(base[c], base[a]);
+            shapes.mesh_indices.insert(shapes.mesh_indices.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+        }
+        shapes.mesh = dGeomTriMeshDataCreate();
+        dGeomTriMeshDataBuildDouble(shapes.mesh, &vtx[0], 3 * sizeof(dReal), int(vtx.size() / 3),
+            &shapes.mesh_indices[0], int(shapes.mesh_indices.size()), 3 * sizeof(dTriIndex));
+    }
+
+    void buildHeightfield(SharedShapes& shapes)
+    {
+        const int samples = 17;
+        for (int z = 0; z < samples; z++)
+            for (int x = 0; x < samples; x++)
+                shapes.heights.push_back(0.1 * sin(3.0 * x / (samples - 1) * 2) * cos(3.0 * z / (samples - 1) * 2));
+        shapes.heightfield = dGeomHeightfieldDataCreate();
+        dGeomHeightfieldDataBuildDouble(shapes.heightfield, &shapes.heights[0], 0, REAL(2.0), REAL(2.0),
+            samples, samples, REAL(1.0), REAL(0.0), REAL(0.5), 0);
+    }
+
+    dGeomID createGeom(int geom_class, SharedShapes& shapes)
+    {
+        switch (geom_class)
+        {
+        case dSphereClass: return dCreateSphere(0, REAL(0.5));
+        case dBoxClass: return dCreateBox(0, REAL(1.0), REAL(0.6), REAL(0.4));
+        case dCapsuleClass: return dCreateCapsule(0, REAL(0.25), REAL(1.0));
+        case dCylinderClass: return dCreateCylinder(0, REAL(0.3), REAL(1.0));
+        case dPlaneClass: return dCreatePlane(0, 0, 1, 0, 0);
+        case dRayClass: return dCreateRay(0, REAL(3.0));
+        case dConvexClass:
+            return dCreateConvex(0, &shapes.convex_planes[0], unsigned(shapes.convex_planes.size() / 4),
+                &shapes.convex_points[0], unsigned(shapes.convex_points.size() / 3), &shapes.convex_polygons[0]);
+        case dGeomTransformClass:
+        {
+            dGeomID transform = dCreateGeomTransform(0);
+            dGeomID inner = dCreateBox(0, REAL(0.6), REAL(0.6), REAL(0.6));
+            dGeomSetPosition(inner, REAL(0.2), 0, 0);
+            dGeomTransformSetGeom(transform, inner);
+            dGeomTransformSetCleanup(transform, 1);
+            dGeomTransformSetInfo(transform, 1);
+            return transform;
+        }
+        case dTriMeshClass: return dCreateTriMesh(0, shapes.mesh, NULL, NULL, NULL);
+        case dHeightfieldClass: return dCreateHeightfield(0, shapes.heightfield, 1);
+        }
+        return NULL;
+    }
+
+    bool isGround(int geom_class)
+    {
+        return geom_class == dPlaneClass || geom_class == dHeightfieldClass;
+    }
+
+    void randomRotation(Rng& rng, dMatrix3 R)
+    {
+        // uniform unit quaternion (Shoemake)
+        dReal u1 = rng.uniform(), u2 = rng.range(0, 2 * M_PI), u3 = rng.range(0, 2 * M_PI);
+        dReal a = dSqrt(1 - u1), b = dSqrt(u1);
+        dQuaternion q = { a * dSin(u2), a * dCos(u2), b * dSin(u3), b * dCos(u3) };
+        dRfromQ(R, q);
+    }
+
+    void randomUnit(Rng& rng, dReal* v)
+    {
+        dReal z = rng.range(-1, 1), phi = rng.range(0, 2 * M_PI), r = dSqrt(1 - z * z);
+        v[0] = r * dCos(phi);
+        v[1] = r * dSin(phi);
+        v[2] = z;
+    }
+
+    // a plane or a heightfield: slightly tilted, through the origin
+    void placeGround(dGeomID g, Rng& rng)
+    {
+        dMatrix3 R;
+        dRFromEulerAngles(R, rng.range(-0.3, 0.3), 0, rng.range(-0.3, 0.3));
+        if (dGeomGetClass(g) == dPlaneClass)
+            dGeomPlaneSetParams(g, R[1], R[5], R[9], 0);
+        else
+            dGeomSetRotation(g, R);
+    }
+
+    // place probe around anchor, which is at the origin
+    void placeProbe(dGeomID probe, bool on_ground, Rng& rng)
+    {
+        if (dGeomGetClass(probe) == dRayClass)
+        {
+            dReal start[3], dir[3], jitter[3];
+            randomUnit(rng, start);
+            if (on_ground) start[1] = dFabs(start[1]);
+            randomUnit(rng, jitter);
+            for (int i = 0; i < 3; i++)
+            {
+                start[i] *= REAL(1.5);
+                dir[i] = -start[i] + REAL(0.6) * jitter[i];
+            }
+            dGeomRaySet(probe, start[0], start[1], start[2], dir[0], dir[1], dir[2]);
+            return;
+        }
+        dReal p[3];
+        if (on_ground)
+        {
+            p[0] = rng.range(-0.8, 0.8);
+            p[1] = rng.range(-0.3, 0.9);
+            p[2] = rng.range(-0.8, 0.8);
+        }
+        else
+        {
+            dReal dir[3];
+            randomUnit(rng, dir);
+            dReal r = REAL(1.2) * std::cbrt(rng.uniform());
+            for (int i = 0; i < 3; i++) p[i] = r * dir[i];
+        }
+        dMatrix3 R;
+        randomRotation(rng, R);
+        dGeomSetPosition(probe, p[0], p[1], p[2]);
+        dGeomSetRotation(probe, R);
+    }
+
+    void placePair(dGeomID a, dGeomID b, Rng& rng)
+    {
+        int ca = dGeomGetClass(a), cb = dGeomGetClass(b);
+        // the anchor stays at the origin: the ground, else anything but a ray
+        bool swap = ca == dRayClass || (isGround(cb) && !isGround(ca));
+        dGeomID anchor = swap ? b : a, probe = swap ? a : b;
+        if (isGround(dGeomGetClass(anchor)))
+        {
+            placeGround(anchor, rng);
+            if (isGround(dGeomGetClass(probe))) placeGround(probe, rng);
+            else placeProbe(probe, true, rng);
+        }
+        else
+        {
+            dMatrix3 R;
+            randomRotation(rng, R);
+            dGeomSetRotation(anchor, R);
+            placeProbe(probe, false, rng);
+        }
+        // the AABBs are up to date after the broad phase, some colliders read them
+        dReal aabb[6];
+        dGeomGetAABB(a, aabb);
+        dGeomGetAABB(b, aabb);
+    }
+
+    struct PairResult
+    {
+        int class1, class2;
+        double ns_per_pair;
+        double contacts_per_pair;
+        double hit_rate;
+    };
+
+    double seconds(std::chrono::steady_clock::duration d)
+    {
+        return std::chrono::duration<double>(d).count();
+    }
+
+    PairResult benchPair(int class1, int class2, SharedShapes& shapes, int poses, uint64_t seed,
+        int max_contacts, double min_time)
+    {
+        // each pair has its own stream, the poses do not depend on the pairs that run
+        Rng rng(seed ^ (uint64_t(class1 * CLASS_COUNT + class2 + 1) << 32));
+        std::vector<dGeomID> a(poses), b(poses);
+        for (int k = 0; k < poses; k++)
+        {
+            a[k] = createGeom(class1, shapes);
+            b[k] = createGeom(class2, shapes);
+            placePair(a[k], b[k], rng);
+        }
+
+        std::vector<dContactGeom> contacts(max_contacts);
+        auto pass = [&]() {
+            long long count = 0;
+            for (int k = 0; k < poses; k++)
+                count += dCollide(a[k], b[k], max_contacts, &contacts[0], sizeof(dContactGeom));
+            return count;
+        };
+
+        PairResult r;
+        r.class1 = class1;
+        r.class2 = class2;
+        long long total = 0;
+        int hits = 0;
+        for (int k = 0; k < poses; k++)
+        {
+            int n = dCollide(a[k], b[k], max_contacts, &contacts[0], sizeof(dContactGeom));
+            total += n;
+            hits += n > 0;
+        }
+        r.contacts_per_pair = double(total) / poses;
+        r.hit_rate = double(hits) / poses;
+
+        // enough passes for a repetition to take min_time
+        auto start = std::chrono::steady_clock::now();
+        volatile long long sink = pass();
+        double once = seconds(std::chrono::steady_clock::now() - start);
+        int passes = std::max(1, int(min_time / std::max(once, 1e-9)));
+        double best = 1e300;
+        for (int rep = 0; rep < 5; rep++)
+        {
+            start = std::chrono::steady_clock::now();
+            for (int p = 0; p < passes; p++) sink = sink + pass();
+            best = std::min(best, seconds(std::chrono::steady_clock::now() - start));
+        }
+        r.ns_per_pair = best * 1e9 / (double(passes) * poses);
+
+        for (int k = 0; k < poses; k++)
+        {
+            dGeomDestroy(a[k]);
+            dGeomDestroy(b[k]);
+        }
+        return r;
+    }
+
+    std::string pairName(int class1, int class2)
+    {
+        return std::string(CLASS_NAMES[class1]) + "-" + CLASS_NAMES[class2];
+    }
+
+    bool writeJson(const char* fname, int poses, unsigned long long seed, int max_contacts,
+        const std::vector<PairResult>& results, const std::vector<std::string>& unsupported)
+    {
+        FILE* f = fopen(fname, "w");
+        if (f == NULL)
+            return false;
+        fprintf(f, "{\n  \"poses\": %d,\n  \"seed\": %llu,\n  \"max_contacts\": %d,\n  \"pairs\": [\n", poses, seed, max_contacts);
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const PairResult& r = results[i];
+            fprintf(f, "    {\"pair\": \"%s\", \"ns_per_pair\": %.2f, \"contacts_per_pair\": %.4f, \"hit_rate\": %.4f}%s\n",
+                pairName(r.class1, r.class2).c_str(), r.ns_per_pair, r.contacts_per_pair, r.hit_rate,
+                i + 1 < results.size() ? "," : "");
+        }
+        fprintf(f, "  ],\n  \"unsupported\": [");
+        for (size_t i = 0; i < unsupported.size(); i++)
+            fprintf(f, "%s\"%s\"", i ? ", " : "", unsupported[i].c_str());
+        fprintf(f, "]\n}\n");
+        fclose(f);
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* json_file = NULL;
+    std::string pair_arg;
+    int poses = 512, max_contacts = 4;
+    unsigned long long seed = 1;
+    double min_time = 0.02;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string a = argv[i];
+        const char* next = i + 1 < argc ? argv[i + 1] : NULL;
+        if (a == "--pair" && next) { pair_arg = next; i++; }
+        else if (a == "--poses" && next) { poses = atoi(next); i++; }
+        else if (a == "--seed" && next) { seed = strtoull(next, NULL, 10); i++; }
+        else if (a == "--contacts" && next) { max_contacts = atoi(next); i++; }
+        else if (a == "--time" && next) { min_time = atof(next); i++; }
+        else if (a == "--json" && next) { json_file = next; i++; }
+        else
+        {
+            printf("usage: %s [--pair sphere-box] [--poses n] [--seed n] [--contacts n] [--time seconds] [--json file]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (poses <= 0 || max_contacts <= 0 || max_contacts > 0xffff)
+    {
+        printf("bad --poses or --contacts\n");
+        return 2;
+    }
+
+    dInitODE2(0);
+    SharedShapes shapes;
+    buildConvexCube(shapes, REAL(0.4));
+    buildIcosphere(shapes, REAL(0.5));
+    buildHeightfield(shapes);
+
+    std::vector<PairResult> results;
+    std::vector<std::string> unsupported;
+    printf("%d poses per pair, seed %llu, at most %d contacts\n", poses, seed, max_contacts);
+    printf("%-24s %10s %10s %8s\n", "pair", "ns/pair", "contacts", "hits");
+    for (int i = 0; i < CLASS_COUNT; i++)
+    {
+        for (int j = i; j < CLASS_COUNT; j++)
+        {
+            std::string name = pairName(i, j);
+            if (!pair_arg.empty() && pair_arg != name && pair_arg != pairName(j, i))
+                continue;
+            if (!dHasCollider(i, j))
+            {
+                unsupported.push_back(name);
+                continue;
+            }
+            PairResult r = benchPair(i, j, shapes, poses, seed, max_contacts, min_time);
+            printf("%-24s %10.1f %10.3f %7.1f%%\n", name.c_str(), r.ns_per_pair, r.contacts_per_pair, 100 * r.hit_rate);
+            results.push_back(r);
+        }
+    }
+    if (!unsupported.empty())
+    {
+        printf("no collider:");
+        for (size_t i = 0; i < unsupported.size(); i++) printf(" %s", unsupported[i].c_str());
+        printf("\n");
+    }
+
+    int ret = 0;
+    if (json_file)
+    {
+        if (writeJson(json_file, poses, seed, max_contacts, results, unsupported))
+            printf("write %s\n", json_file);
+        else
+        {
+            printf("cannot write %s\n", json_file);
+            ret = 2;
+        }
+    }
+
+    dGeomTriMeshDataDestroy(shapes.mesh);
+    dGeomHeightfieldDataDestroy(shapes.heightfield);
+    dCloseODE();
+    return ret;
+}
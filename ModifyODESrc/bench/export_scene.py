@@ -0,0 +1,25 @@
+"""
+Export a scene pickle (as written by the Unity exporter, e.g. odecharacter_scene.pickle)
+to the JSON form read by ode_bench. JsonSceneLoader.load_from_file reads the same file.
+
+usage: python export_scene.py [scene.pickle] [scene.json]
+"""
+import json
+import os
+import pickle
+import sys
+
+
+def main():
+    root = os.path.dirname(os.path.abspath(__file__))
+    src = sys.argv[1] if len(sys.argv) > 1 else os.path.join(root, "..", "..", "odecharacter_scene.pickle")
+    dst = sys.argv[2] if len(sys.argv) > 2 else os.path.join(root, "humanoid_scene.json")
+    with open(src, "rb") as fin:
+        scene = pickle.load(fin)
+    with open(dst, "w") as fout:
+        json.dump(scene, fout, indent=1)
+    print(f"write {dst}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,323 @@
+// Simulation benchmark of the humanoid of odecharacter_scene.pickle, without
+// Python. The scene is read from the JSON export written by export_scene.py
+// and built by bench_scene.h.
+//
+// Each stepper (dWorldStep, dWorldDampedStep, dWorldQuickStep) runs the same
+// PD tracking episodes: every joint angle follows a sine inside its limits.
+// Tracking uses the joint motors as a PD servo (velocity Kp / Damping times
+// the angle error, at most 0.1 TorqueLimit), not torques of pd_control_batch:
+// explicit torques with the Kps of the scene are only stable with the joint
+// damping of dWorldDampedStep, and the motors are solved the same way by
+// all three steppers (with the full TorqueLimit, the motors of the light
+// toes and hands make dWorldQuickStep diverge). Contacts are created by
+// dCollideContactCallback as in World.damped_step_fast_collision, and every
+// episode starts from a snapshot of the initial state. Reported are steps /
+// sec, the time of each phase (world profiler), the number of contact joints
+// and a hash of the final body state.
+//
+// bench/ode_bench_baseline.json is recorded with a Release build
+// (-DCMAKE_BUILD_TYPE=Release):
+//   ode_bench --write-baseline bench/ode_bench_baseline.json
+//   ode_bench --baseline bench/ode_bench_baseline.json
+// The comparison fails (exit code 1) if a stepper is slower than the
+// baseline by more than --tolerance percent, its contact count differs by
+// more than --contact-tolerance percent, or a final body position moved by
+// more than --state-eps. The hash is bitwise, it only matches a baseline of
+// the same binary on the same kind of cpu, so a different hash is reported
+// but not counted. steps/s depend on the box: rewrite the baseline there
+// before comparing timings.
+//
+// usage: ode_bench [--scene file] [--stepper step|damped|quick|all]
+//                  [--episodes n] [--steps n] [--baseline file]
+//                  [--write-baseline file] [--tolerance percent]
+//                  [--contact-tolerance percent] [--state-eps meters]
+
+#include <ode/ode.h>
+#include "bench_scene.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef ODE_BENCH_SCENE
+#define ODE_BENCH_SCENE "bench/humanoid_scene.json"
+#endif
+
+namespace
+{
+    using bench::JsonValue;
+    using bench::BenchJoint;
+    using bench::BenchScene;
+    using bench::VEL_PARAMS;
+
+    enum StepperType { STEPPER_STEP, STEPPER_DAMPED, STEPPER_QUICK, STEPPER_COUNT };
+    const char* const STEPPER_NAMES[STEPPER_COUNT] = { "step", "damped", "quick" };
+
+    const char* const PHASE_NAMES[dProfilePhaseCount] = {
+        "broadphase", "narrowphase", "contacts", "islands",
+        "preprocess", "create_j", "compute_a", "compute_rhs", "solve_lcp", "constraint_force",
+        "integrate_velocity", "integrate_position", "tidy_up", "resort_geoms"
+    };
+
+
+    struct BenchResult
+    {
+        double seconds = 0;
+        double steps_per_sec = 0;
+        long long total_steps = 0;
+        long long contacts = 0;
+        int max_contacts = 0;
+        uint64_t hash = 0;
+        bool finite = true;
+        std::vector<double> final_pos;	// position of each body at the end
+        dWorldProfile profile;
+    };
+
+    struct CompareTolerance
+    {
+        double steps_per_sec = 25;	// percent, run to run noise of a shared box is ~20%
+        double contacts = 1;		// percent
+        double state = 1e-3;		// meters
+    };
+
+    // drive every joint angle toward a sine around the middle of its range
+    void applyPDTracking(BenchScene& scene, dReal time)
+    {
+        for (size_t j = 0; j < scene.joints.size(); j++)
+        {
+            const BenchJoint& bj = scene.joints[j];
+            for (int i = 0; i < bj.num_axes; i++)
+            {
+                dReal mid = REAL(0.5) * (bj.lo[i] + bj.hi[i]);
+                dReal amp = REAL(0.25) * (bj.hi[i] - bj.lo[i]);
+                dReal target = mid + amp * dSin(REAL(2.0) * M_PI * REAL(0.8) * time + REAL(0.7) * j + REAL(1.3) * i);
+                dReal angle = bj.hinge ? dJointGetHingeAngle(bj.joint) : dJointGetAMotorAngle(bj.amotor, i);
+                dReal vel = bj.gain * (target - angle);
+                if (bj.hinge)
+                    dJointSetHingeParam(bj.joint, dParamVel, vel);
+                else
+                    dJointSetAMotorParam(bj.amotor, VEL_PARAMS[i], vel);
+            }
+        }
+    }
+
+
+    BenchResult runStepper(BenchScene& scene, StepperType stepper, int episodes, int steps)
+    {
+        BenchResult res;
+        dJointGroupWithdWorld* info = &scene.info;
+        int base_joints = dWorldGetNumJoints(scene.world);
+        dWorldResetProfile(scene.world);
+        dWorldSetProfiling(scene.world, 1);
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int e = 0; e < episodes; e++)
+        {
+            dWorldRestore(scene.world, scene.initial_state.data(), scene.initial_state.size());
+            for (int t = 0; t < steps; t++)
+            {
+                applyPDTracking(scene, t * scene.dt);
+
+                // World.damped_step_fast_collision
+                unsigned long long profile_begin = dWorldProfileBegin(scene.world);
+                dSpaceCollide(scene.space, info, &dCollideContactCallback);
+                dWorldProfileEnd(scene.world, dProfileBroadphase, profile_begin);
+
+                int contacts = dWorldGetNumJoints(scene.world) - base_joints;
+                res.contacts += contacts;
+                if (contacts > res.max_contacts) res.max_contacts = contacts;
+
+                switch (stepper)
+                {
+                case STEPPER_STEP: dWorldStep(scene.world, scene.dt); break;
+                case STEPPER_DAMPED: dWorldDampedStep(scene.world, scene.dt); break;
+                default: dWorldQuickStep(scene.world, scene.dt); break;
+                }
+                dJointGroupEmpty(info->group);
+                profile_begin = dWorldProfileBegin(scene.world);
+                dSpaceResortGeoms(scene.space);
+                dWorldProfileEnd(scene.world, dProfileResortGeoms, profile_begin);
+            }
+        }
+        res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        dWorldSetProfiling(scene.world, 0);
+        dWorldGetProfile(scene.world, &res.profile);
+        res.total_steps = (long long)episodes * steps;
+        res.steps_per_sec = res.total_steps / res.seconds;
+        res.hash = bench::hashState(scene, &res.finite);
+        for (size_t i = 0; i < scene.bodies.size(); i++)
+        {
+            const dReal* pos = dBodyGetPosition(scene.bodies[i]);
+            res.final_pos.insert(res.final_pos.end(), pos, pos + 3);
+        }
+        return res;
+    }
+
+    void printResult(const char* name, const BenchResult& res)
+    {
+        printf("%-7s %10.1f steps/s  %8.2f us/step  contacts %.2f/step (max %d)  hash %016llx%s\n",
+            name, res.steps_per_sec, 1e6 / res.steps_per_sec, (double)res.contacts / res.total_steps,
+            res.max_contacts, (unsigned long long)res.hash, res.finite ? "" : "  NOT FINITE");
+        for (int i = 0; i < dProfilePhaseCount; i++)
+        {
+            if (res.profile.calls[i] == 0)
+                continue;
+            printf("    %-20s %8.2f us/step\n", PHASE_NAMES[i], res.profile.seconds[i] * 1e6 / res.total_steps);
+        }
+    }
+
+    bool writeBaseline(const char* fname, const char* scene_name, int episodes, int steps,
+        const std::vector<int>& steppers, const std::vector<BenchResult>& results)
+    {
+        FILE* f = fopen(fname, "w");
+        if (f == NULL)
+            return false;
+        fprintf(f, "{\n  \"scene\": \"%s\",\n  \"episodes\": %d,\n  \"steps\": %d,\n  \"results\": [\n", scene_name, episodes, steps);
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const BenchResult& r = results[i];
+            fprintf(f, "    {\"stepper\": \"%s\", \"steps_per_sec\": %.3f, \"contacts\": %lld, \"hash\": \"%016llx\", \"phases_us_per_step\": {",
+                STEPPER_NAMES[steppers[i]], r.steps_per_sec, r.contacts, (unsigned long long)r.hash);
+            for (int p = 0; p < dProfilePhaseCount; p++)
+                fprintf(f, "%s\"%s\": %.4f", p ? ", " : "", PHASE_NAMES[p], r.profile.seconds[p] * 1e6 / r.total_steps);
+            fprintf(f, "},\n     \"final_pos\": [");
+            for (size_t k = 0; k < r.final_pos.size(); k++)
+                fprintf(f, "%s%.17g", k ? ", " : "", r.final_pos[k]);
+            fprintf(f, "]}%s\n", i + 1 < results.size() ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+        fclose(f);
+        return true;
+    }
+
+    // number of regressions against the baseline
+    int compareBaseline(const JsonValue& base, int episodes, int steps, const CompareTolerance& tol,
+        const std::vector<int>& steppers, const std::vector<BenchResult>& results)
+    {
+        if ((int)base["episodes"].asNumber() != episodes || (int)base["steps"].asNumber() != steps)
+        {
+            printf("baseline has %d episodes of %d steps, run with the same --episodes / --steps\n",
+                (int)base["episodes"].asNumber(), (int)base["steps"].asNumber());
+            return 1;
+        }
+        int failures = 0;
+        const JsonValue& items = base["results"];
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const JsonValue* b = NULL;
+            for (size_t k = 0; k < items.size(); k++)
+                if (items[k]["stepper"].str == STEPPER_NAMES[steppers[i]]) b = &items[k];
+            if (b == NULL)
+            {
+                printf("%-7s not in the baseline\n", STEPPER_NAMES[steppers[i]]);
+                continue;
+            }
+            const BenchResult& r = results[i];
+            double base_rate = (*b)["steps_per_sec"].asNumber();
+            double change = (r.steps_per_sec / base_rate - 1) * 100;
+            double base_contacts = (*b)["contacts"].asNumber();
+            double contact_change = base_contacts > 0 ? (r.contacts / base_contacts - 1) * 100 : (r.contacts ? 100.0 : 0.0);
+            const JsonValue& base_pos = (*b)["final_pos"];
+            double pos_diff = base_pos.size() == r.final_pos.size() ? 0 : INFINITY;
+            for (size_t k = 0; k < base_pos.size() && k < r.final_pos.size(); k++)
+                pos_diff = std::max(pos_diff, std::fabs(base_pos[k].asNumber() - r.final_pos[k]));
+            char hash[32];
+            snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)r.hash);
+            bool slow = change < -tol.steps_per_sec;
+            bool contacts = std::fabs(contact_change) > tol.contacts;
+            bool state = !r.finite || !(pos_diff <= tol.state);
+            printf("%-7s %+6.1f%% steps/s, %+.2f%% contacts, final pos %.2e vs baseline%s%s%s%s\n",
+                STEPPER_NAMES[steppers[i]], change, contact_change, pos_diff,
+                slow ? "  SLOWER" : "", contacts ? "  CONTACTS DIFFER" : "", state ? "  STATE DIFFERS" : "",
+                (*b)["hash"].str != hash ? "  (hash differs)" : "");
+            failures += slow + contacts + state;
+        }
+        return failures;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* scene_file = ODE_BENCH_SCENE;
+    const char* baseline_file = NULL;
+    const char* write_file = NULL;
+    std::string stepper_arg = "all";
+    int episodes = 4, steps = 600;
+    CompareTolerance tol;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string a = argv[i];
+        const char* next = i + 1 < argc ? argv[i + 1] : NULL;
+        if (a == "--scene" && next) { scene_file = next; i++; }
+        else if (a == "--stepper" && next) { stepper_arg = next; i++; }
+        else if (a == "--episodes" && next) { episodes = atoi(next); i++; }
+        else if (a == "--steps" && next) { steps = atoi(next); i++; }
+        else if (a == "--baseline" && next) { baseline_file = next; i++; }
+        else if (a == "--write-baseline" && next) { write_file = next; i++; }
+        else if (a == "--tolerance" && next) { tol.steps_per_sec = atof(next); i++; }
+        else if (a == "--contact-tolerance" && next) { tol.contacts = atof(next); i++; }
+        else if (a == "--state-eps" && next) { tol.state = atof(next); i++; }
+        else
+        {
+            printf("usage: %s [--scene file] [--stepper step|damped|quick|all] [--episodes n] [--steps n]\n"
+                "          [--baseline file] [--write-baseline file] [--tolerance percent]\n"
+                "          [--contact-tolerance percent] [--state-eps meters]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<int> steppers;
+    for (int s = 0; s < STEPPER_COUNT; s++)
+        if (stepper_arg == "all" || stepper_arg == STEPPER_NAMES[s]) steppers.push_back(s);
+    if (steppers.empty() || episodes <= 0 || steps <= 0)
+    {
+        printf("bad --stepper, --episodes or --steps\n");
+        return 2;
+    }
+
+    dInitODE2(0);
+    int ret = 0;
+    try
+    {
+        JsonValue root = bench::loadJsonFile(scene_file);
+        BenchScene scene;
+        bench::loadScene(scene, root);
+        printf("scene %s: %d bodies, %d joints, %d geoms, dt %g, %d episodes x %d steps\n", scene_file,
+            (int)scene.bodies.size(), dWorldGetNumJoints(scene.world), dSpaceGetNumGeoms(scene.space),
+            scene.dt, episodes, steps);
+
+        std::vector<BenchResult> results;
+        for (size_t i = 0; i < steppers.size(); i++)
+        {
+            runStepper(scene, (StepperType)steppers[i], 1, steps < 60 ? steps : 60); // warm up
+            results.push_back(runStepper(scene, (StepperType)steppers[i], episodes, steps));
+            printResult(STEPPER_NAMES[steppers[i]], results.back());
+        }
+
+        if (write_file)
+        {
+            if (!writeBaseline(write_file, scene_file, episodes, steps, steppers, results))
+                throw std::runtime_error(std::string("cannot write ") + write_file);
+            printf("write %s\n", write_file);
+        }
+        if (baseline_file)
+        {
+            int failures = compareBaseline(bench::loadJsonFile(baseline_file), episodes, steps, tol, steppers, results);
+            printf("%s\n", failures ? "REGRESSION against the baseline" : "baseline ok");
+            ret = failures ? 1 : 0;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        printf("error: %s\n", e.what());
+        ret = 2;
+    }
+    dCloseODE();
+    return ret;
+}
@@ -0,0 +1,255 @@
+// Benchmark of the AVX2 / FMA batch quaternion routines (QuaternionWithGradAvx2.cpp)
+// against the scalar reference versions, for batch sizes from a character (20 joints)
+// to a large dataset (1e6 frames). Inputs are random unit quaternions, vectors,
+// rotation vectors (some of them below the small angle threshold) and non orthogonal
+// 6d matrices. For every routine and size it prints the time per element of both
+// versions and the max abs difference of the outputs, which fails the run above 1e-12.
+// Then for the sizes from batch_parallel_get_min_items() on, it times the public routines
+// (the ones called by the python wrappers) single threaded and on the batch thread pool
+// of batch_parallel.h, whose results must be bitwise equal.
+// bench/quat_simd_bench.py compares the python wrappers with scipy.
+//
+// usage: quat_simd_bench [--sizes n[,n...]] [--elements n] [--threads n]
+//   --elements: elements processed per measurement (default 2e7), at least 3 calls
+//   --threads: threads of the batch thread pool (default batch_parallel_get_num_threads())
+
+#include "QuaternionWithGrad.h"
+#include "QuaternionWithGradSimd.h"
+#include "batch_parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Inputs
+    {
+        std::vector<double> q1, q2, v, grad_q, grad_v, rotvec, mat6d;
+    };
+
+    struct Outputs
+    {
+        std::vector<double> a, b;
+    };
+
+    void makeInputs(size_t n, Inputs& in)
+    {
+        std::mt19937_64 rng(12345 + n);
+        std::normal_distribution<double> normal;
+        std::uniform_real_distribution<double> uniform(-1, 1);
+        in.q1.resize(4 * n); in.q2.resize(4 * n); in.grad_q.resize(4 * n);
+        in.v.resize(3 * n); in.grad_v.resize(3 * n); in.rotvec.resize(3 * n); in.mat6d.resize(6 * n);
+        for (size_t i = 0; i < n; i++)
+        {
+            for (std::vector<double>* q : { &in.q1, &in.q2 })
+            {
+                double* p = q->data() + 4 * i;
+                double len = 0;
+                for (int k = 0; k < 4; k++) { p[k] = normal(rng); len += p[k] * p[k]; }
+                len = std::sqrt(len);
+                for (int k = 0; k < 4; k++) p[k] /= len;
+            }
+            for (int k = 0; k < 4; k++) in.grad_q[4 * i + k] = uniform(rng);
+            for (int k = 0; k < 3; k++)
+            {
+                in.v[3 * i + k] = uniform(rng);
+                in.grad_v[3 * i + k] = uniform(rng);
+                // every 8th rotation vector is below the 1e-3 threshold of the series expansion
+                in.rotvec[3 * i + k] = (i % 8 == 0 ? 1e-4 : 1.8) * uniform(rng);
+            }
+        }
+        quat_to_vec6d_impl(in.q1.data(), in.mat6d.data(), n);
+        for (size_t i = 0; i < 6 * n; i++) in.mat6d[i] += 0.05 * uniform(rng);
+    }
+
+    struct Kernel
+    {
+        const char* name;
+        size_t a_size, b_size; // output sizes per element
+        std::function<void(const Inputs&, Outputs&, size_t, bool)> run;
+        std::function<void(const Inputs&, Outputs&, size_t)> run_public;
+    };
+
+    std::vector<Kernel> kernels()
+    {
+        std::vector<Kernel> res;
+        res.push_back({ "quat_multiply_forward", 4, 0, [](const Inputs& in, Outputs& o, size_t n, bool simd)
+            { (simd ? quat_multiply_forward_avx2 : quat_multiply_forward_scalar)(in.q1.data(), in.q2.data(), o.a.data(), n); },
+            [](const Inputs& in, Outputs& o, size_t n) { quat_multiply_forward(in.q1.data(), in.q2.data(), o.a.data(), n); } });
+        res.push_back({ "quat_multiply_backward", 4, 4, [](const Inputs& in, Outputs& o, size_t n, bool simd)
+            { (simd ? quat_multiply_backward_avx2 : quat_multiply_backward_scalar)(in.q1.data(), in.q2.data(), in.grad_q.data(), o.a.data(), o.b.data(), n); },
+            [](const Inputs& in, Outputs& o, size_t n) { quat_multiply_backward(in.q1.data(), in.q2.data(), in.grad_q.data(), o.a.data(), o.b.data(), n); } });
+        res.push_back({ "quat_apply_forward", 3, 0, [](const Inputs& in, Outputs& o, size_t n, bool simd)
+            { (simd ? quat_apply_forward_avx2 : quat_apply_forward_scalar)(in.q1.data(), in.v.data(), o.a.data(), n); },
+            [](const Inputs& in, Outputs& o, size_t n) { quat_apply_forward(in.q1.data(), in.v.data(), o.a.data(), n); } });
+        res.push_back({ "quat_apply_backward", 4, 3, [](const Inputs& in, Outputs& o, size_t n, bool simd)
+            { (simd ? quat_apply_backward_avx2 : quat_apply_backward_scalar)(in.q1.data(), in.v.data(), in.grad_v.data(), o.a.data(), o.b.data(), n); },
+            [](const Inputs& in, Outputs& o, size_t n) { quat_apply_backward(in.q1.data(), in.v.data(), in.grad_v.data(), o.a.data(), o.b.data(), n); } });
+        res.push_back({ "quat_to_matrix", 9, 0, [](const Inputs& in, Outputs& o, size_t n, bool simd)
+            { (simd ? quat_to_matrix_impl_avx2 : quat_to_matrix_impl_scalar)(in.q1.data(), o.a.data(), n); },
+            [](const Inputs& in, Outputs& o, size_t n) { quat_to_matrix_impl(in.q1.data(), o.a.data(), n); } });
+        res.push_back({ "six_dim_mat_to_quat", 4, 0, [](const Inputs& in, Outputs& o, size_t n, bool simd)
+            { (simd ? six_dim_mat_to_quat_impl_avx2 : six_dim_mat_to_quat_impl_scalar)(in.mat6d.data(), o.a.data(), n); },
+            [](const Inputs& in, Outputs& o, size_t n) { six_dim_mat_to_quat_impl(in.mat6d.data(), o.a.data(), n); } });
+        res.push_back({ "quat_to_rotvec", 1, 3, [](const Inputs& in, Outputs& o, size_t n, bool simd)
+            { (simd ? quat_to_rotvec_impl_avx2 : quat_to_rotvec_impl_scalar)(in.q1.data(), o.a.data(), o.b.data(), n); },
+            [](const Inputs& in, Outputs& o, size_t n) { quat_to_rotvec_impl(in.q1.data(), o.a.data(), o.b.data(), n); } });
+        res.push_back({ "quat_from_rotvec", 4, 0, [](const Inputs& in, Outputs& o, size_t n, bool simd)
+            { (simd ? quat_from_rotvec_impl_avx2 : quat_from_rotvec_impl_scalar)(in.rotvec.data(), o.a.data(), n); },
+            [](const Inputs& in, Outputs& o, size_t n) { quat_from_rotvec_impl(in.rotvec.data(), o.a.data(), n); } });
+        return res;
+    }
+
+    void allocOutputs(const Kernel& k, size_t n, Outputs& o)
+    {
+        o.a.assign(k.a_size * n, 0); o.b.assign(k.b_size * n, 0);
+    }
+
+    double maxAbsDiff(const std::vector<double>& x, const std::vector<double>& y)
+    {
+        double res = 0;
+        for (size_t i = 0; i < x.size(); i++)
+        {
+            double d = std::fabs(x[i] - y[i]);
+            if (!(d <= res)) res = d; // NaN counts
+        }
+        return res;
+    }
+
+    // ns per element
+    double timeKernel(const Kernel& k, const Inputs& in, Outputs& o, size_t n, bool simd, double elements)
+    {
+        size_t calls = (size_t)(elements / n);
+        if (calls < 3) calls = 3;
+        k.run(in, o, n, simd); // warm up
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t c = 0; c < calls; c++)
+            k.run(in, o, n, simd);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        return seconds * 1e9 / ((double)calls * n);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes = { 20, 100, 1000, 10000, 100000, 1000000 };
+    double elements = 2e7;
+    int threads = batch_parallel_get_num_threads();
+    for (int i = 1; i < argc; i++)
+    {
+        std::string a = argv[i];
+        const char* next = i + 1 < argc ? argv[i + 1] : NULL;
+        if (a == "--sizes" && next)
+        {
+            sizes.clear();
+            std::stringstream ss(next);
+            std::string item;
+            while (std::getline(ss, item, ','))
+                sizes.push_back((size_t)atof(item.c_str()));
+            i++;
+        }
+        else if (a == "--elements" && next) { elements = atof(next); i++; }
+        else if (a == "--threads" && next) { threads = atoi(next); i++; }
+        else
+        {
+            printf("usage: %s [--sizes n[,n...]] [--elements n] [--threads n]\n", argv[0]);
+            return 2;
+        }
+    }
+    bool bad_size = sizes.empty();
+    for (size_t i = 0; i < sizes.size(); i++)
+        bad_size = bad_size || sizes[i] == 0;
+    if (bad_size || !(elements > 0) || threads <= 0)
+    {
+        printf("bad --sizes, --elements or --threads\n");
+        return 2;
+    }
+
+    std::vector<Kernel> ks = kernels();
+    int ret = 0;
+    if (!quat_simd_avx2_supported())
+        printf("AVX2 / FMA is not supported here, the batch routines use the scalar versions\n");
+    else
+        printf("%-24s %8s %12s %12s %8s %12s\n", "routine", "n", "scalar ns", "avx2 ns", "speedup", "max error");
+    for (size_t s = 0; s < sizes.size() && quat_simd_avx2_supported(); s++)
+    {
+        const size_t n = sizes[s];
+        Inputs in;
+        makeInputs(n, in);
+        for (size_t i = 0; i < ks.size(); i++)
+        {
+            Outputs ref, out;
+            allocOutputs(ks[i], n, ref);
+            allocOutputs(ks[i], n, out);
+            double t_scalar = timeKernel(ks[i], in, ref, n, false, elements);
+            double t_simd = timeKernel(ks[i], in, out, n, true, elements);
+            double err = std::max(maxAbsDiff(ref.a, out.a), maxAbsDiff(ref.b, out.b));
+            printf("%-24s %8zu %12.3f %12.3f %7.2fx %12.3g\n", ks[i].name, n, t_scalar, t_simd, t_scalar / t_simd, err);
+            if (!(err < 1e-12)) ret = 1;
+        }
+    }
+
+    // remainder of a batch which is not a multiple of 4
+    Inputs in;
+    makeInputs(4099, in);
+    for (size_t i = 0; i < ks.size() && quat_simd_avx2_supported(); i++)
+    {
+        for (size_t n = 4093; n <= 4099; n++)
+        {
+            Outputs ref, out;
+            allocOutputs(ks[i], n, ref);
+            allocOutputs(ks[i], n, out);
+            ks[i].run(in, ref, n, false);
+            ks[i].run(in, out, n, true);
+            double err = std::max(maxAbsDiff(ref.a, out.a), maxAbsDiff(ref.b, out.b));
+            if (!(err < 1e-12))
+            {
+                printf("%s: max error %g with %zu elements\n", ks[i].name, err, n);
+                ret = 1;
+            }
+        }
+    }
+    if (ret)
+        printf("AVX2 and scalar versions differ\n");
+
+    // the public routines on the batch thread pool
+    const size_t min_items = batch_parallel_get_min_items();
+    printf("\n%-24s %8s %12s %12s %8s %12s\n", "routine", "n", "1 thread ns", "pool ns", "speedup", "bitwise");
+    for (size_t s = 0; s < sizes.size(); s++)
+    {
+        const size_t n = sizes[s];
+        if (n < min_items)
+            continue;
+        makeInputs(n, in);
+        for (size_t i = 0; i < ks.size(); i++)
+        {
+            Outputs ref, out;
+            allocOutputs(ks[i], n, ref);
+            allocOutputs(ks[i], n, out);
+            double t[2];
+            for (int mode = 0; mode < 2; mode++)
+            {
+                batch_parallel_set_num_threads(mode == 0 ? 1 : threads);
+                Outputs& o = mode == 0 ? ref : out;
+                size_t calls = std::max((size_t)3, (size_t)(elements / n));
+                ks[i].run_public(in, o, n); // warm up, and the pool is created
+                auto t0 = std::chrono::steady_clock::now();
+                for (size_t c = 0; c < calls; c++)
+                    ks[i].run_public(in, o, n);
+                t[mode] = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() * 1e9 / ((double)calls * n);
+            }
+            bool equal = ref.a == out.a && ref.b == out.b;
+            printf("%-24s %8zu %12.3f %12.3f %7.2fx %12s\n", ks[i].name, n, t[0], t[1], t[0] / t[1], equal ? "yes" : "NO");
+            if (!equal) ret = 1;
+        }
+    }
+    printf("batch thread pool: %d threads, from %zu items\n", threads, min_items);
+    return ret;
+}
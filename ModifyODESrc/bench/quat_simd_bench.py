@@ -0,0 +1,74 @@
+"""
+Compare the batch quaternion functions of VclSimuBackend (AVX2 / FMA kernels and the scalar
+kernels, switched by set_quat_simd_enabled) with scipy.spatial.transform.Rotation, for batch
+sizes from 20 to 1e6. Prints the time per call and the max abs error to scipy.
+Quaternions are compared up to sign. bench/quat_simd_bench.cpp compares the C++ kernels directly.
+
+usage: python quat_simd_bench.py [n ...]
+"""
+import sys
+import time
+import numpy as np
+from scipy.spatial.transform import Rotation
+import VclSimuBackend
+
+
+def quat_error(a: np.ndarray, b: np.ndarray) -> float:
+    sign = np.where(np.sum(a * b, axis=-1, keepdims=True) < 0, -1.0, 1.0)
+    return float(np.max(np.abs(a - sign * b)))
+
+
+def vec_error(a: np.ndarray, b: np.ndarray) -> float:
+    return float(np.max(np.abs(a - b)))
+
+
+def time_call(func, *args) -> float:
+    func(*args)
+    repeat = max(3, int(2e6 / args[0].shape[0]))
+    start = time.perf_counter()
+    for _ in range(repeat):
+        func(*args)
+    return (time.perf_counter() - start) / repeat
+
+
+def main():
+    sizes = [int(float(s)) for s in sys.argv[1:]] or [20, 100, 1000, 10000, 100000, 1000000]
+    print(f"AVX2 / FMA kernels available: {VclSimuBackend.quat_simd_available()}")
+    rng = np.random.default_rng(0)
+    print(f"{'function':<24} {'n':>8} {'scipy us':>12} {'scalar us':>12} {'simd us':>12} {'scalar err':>11} {'simd err':>11}")
+    for n in sizes:
+        q1 = Rotation.random(n, random_state=1).as_quat()
+        q2 = Rotation.random(n, random_state=2).as_quat()
+        v = rng.uniform(-1, 1, (n, 3))
+        rotvec = rng.uniform(-1.8, 1.8, (n, 3))
+        mat = Rotation.from_quat(q1).as_matrix()
+        vec6d = np.ascontiguousarray(mat[:, :, :2].reshape(n, 6))
+
+        cases = [
+            ("quat_multiply", lambda: (Rotation.from_quat(q1) * Rotation.from_quat(q2)).as_quat(),
+                VclSimuBackend.quat_multiply_forward_fast, (q1, q2), quat_error),
+            ("quat_apply", lambda: Rotation.from_quat(q1).apply(v),
+                VclSimuBackend.quat_apply_forward_fast, (q1, v), vec_error),
+            ("quat_to_matrix", lambda: Rotation.from_quat(q1).as_matrix().reshape(n, 9),
+                lambda q: VclSimuBackend.quat_to_matrix_fast(q).reshape(n, 9), (q1,), vec_error),
+            ("six_dim_mat_to_quat", lambda: Rotation.from_matrix(mat).as_quat(),
+                VclSimuBackend.six_dim_mat_to_quat_fast, (vec6d,), quat_error),
+            ("quat_to_rotvec", lambda: Rotation.from_quat(q1).as_rotvec(),
+                VclSimuBackend.quat_to_rotvec_fast2, (q1,), vec_error),
+            ("quat_from_rotvec", lambda: Rotation.from_rotvec(rotvec).as_quat(),
+                VclSimuBackend.quat_from_rotvec_fast, (rotvec,), quat_error),
+        ]
+        for name, scipy_func, fast_func, args, error in cases:
+            ref = scipy_func()
+            t_scipy = time_call(lambda *_: scipy_func(), *args)
+            result = []
+            for enabled in [False, True]:
+                VclSimuBackend.set_quat_simd_enabled(enabled)
+                result.append((time_call(fast_func, *args), error(fast_func(*args), ref)))
+            VclSimuBackend.set_quat_simd_enabled(True)
+            print(f"{name:<24} {n:>8} {t_scipy * 1e6:12.1f} {result[0][0] * 1e6:12.1f} {result[1][0] * 1e6:12.1f} "
+                  f"{result[0][1]:11.3g} {result[1][1]:11.3g}")
+
+
+if __name__ == "__main__":
+    main()
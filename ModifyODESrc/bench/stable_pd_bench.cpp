@@ -0,0 +1,281 @@
+// Control step benchmark of stable PD tracking with dWorldDampedStep, on the
+// humanoid of bench_scene.h (Kps, TorqueLimit and joint Damping of the scene,
+// joint motors off). Two ways to drive the joints:
+//   explicit: JointPDController torques (pd_control_batch, kp only) before
+//             every substep, damping by the joint kd of the implicit solve.
+//             This is DampedPDControler of the python side.
+//   implicit: targets set once per control step by dJointSetStablePDTargets.
+//             The spring torque and the kp * h damping of the stable PD are
+//             part of the damped step.
+// Every control step sets new local targets (each joint turns about a fixed
+// axis of its child body by a sine, from its initial local rotation), then
+// runs the substeps with collision as World.damped_step_fast_collision does.
+// The tracking error is the angle between the local rotation and the target
+// of every joint at the end of the control step, averaged over joints and
+// steps. For each count of --substep, both paths run with that many substeps
+// and the wall time per control step and the error are printed side by side.
+//
+// On the humanoid the two paths cost and track about the same from 2
+// substeps up; the implicit solve only pays off at 1 substep, where the
+// explicit torques lose the pose (mean error about 18 deg, max about 176 deg,
+// against about 7 deg implicit).
+//
+// usage: stable_pd_bench [--scene file] [--control-fps f] [--substep n[,n...]]
+//                        [--episodes n] [--steps n]
+
+#include <ode/ode.h>
+#include "bench_scene.h"
+#include "PDControlAdd.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef ODE_BENCH_SCENE
+#define ODE_BENCH_SCENE "bench/humanoid_scene.json"
+#endif
+
+namespace
+{
+    using bench::BenchScene;
+
+    struct TrackResult
+    {
+        double us_per_control_step = 0;
+        double mean_error_deg = 0;
+        double max_error_deg = 0;
+        bool finite = true;
+    };
+
+    struct TrackTask
+    {
+        std::vector<dJointID> joints;
+        std::vector<double> kps, torque_limits;
+        std::vector<dReal> axis;           // turning axis of each joint in child frame, (joint count, 3)
+        std::vector<dReal> initial_local;  // local rotation in the initial state, (joint count, 4)
+        std::vector<dReal> targets;        // local targets of the control step, (joint count, 4)
+    };
+
+    // rotation of the child body in the parent body frame
+    void jointLocalQuat(dJointID joint, dQuaternion local)
+    {
+        const dReal* child = dBodyGetQuaternion(dJointGetBody(joint, 0));
+        dBodyID parent = dJointGetBody(joint, 1);
+        if (parent)
+            dQMultiply1(local, dBodyGetQuaternion(parent), child);
+        else
+            for (int k = 0; k < 4; k++) local[k] = child[k];
+        dNormalize4(local);
+    }
+
+    void setupTask(BenchScene& scene, TrackTask& task)
+    {
+        uint64_t seed = 0x9e3779b97f4a7c15ULL;
+        for (size_t j = 0; j < scene.joints.size(); j++)
+        {
+            const bench::BenchJoint& bj = scene.joints[j];
+            dJointID joint = bj.joint;
+            task.joints.push_back(joint);
+            task.kps.push_back(bj.kp);
+            task.torque_limits.push_back(std::isfinite(bj.max_torque) ? bj.max_torque : 1e30);
+
+            // the motors would brake the joints
+            if (bj.hinge)
+                dJointSetHingeParam(joint, dParamFMax, 0);
+            else if (bj.amotor)
+                for (int i = 0; i < 3; i++)
+                    dJointSetAMotorParam(bj.amotor, bench::FMAX_PARAMS[i], 0);
+
+            dQuaternion local;
+            jointLocalQuat(joint, local);
+            task.initial_local.insert(task.initial_local.end(), local, local + 4);
+
+            // the hinge axis, or a fixed pseudo random axis for a ball joint
+            dVector3 axis;
+            if (bj.hinge)
+            {
+                dVector3 global_axis;
+                dJointGetHingeAxis(joint, global_axis);
+                dMultiply1_331(axis, dBodyGetRotation(dJointGetBody(joint, 0)), global_axis);
+            }
+            else
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    seed ^= seed >> 12; seed ^= seed << 25; seed ^= seed >> 27;
+                    axis[k] = (dReal)((seed * 2685821657736338717ULL) >> 11) / (dReal)(1ULL << 53) - REAL(0.5);
+                }
+            }
+            dNormalize3(axis);
+            task.axis.insert(task.axis.end(), axis, axis + 3);
+        }
+        task.targets.resize(4 * task.joints.size());
+    }
+
+    void computeTargets(TrackTask& task, dReal time)
+    {
+        for (size_t j = 0; j < task.joints.size(); j++)
+        {
+            dReal angle = REAL(0.3) * dSin(REAL(2.0) * M_PI * REAL(0.8) * time + REAL(0.7) * j);
+            dQuaternion turn;
+            dQFromAxisAndAngle(turn, task.axis[3 * j], task.axis[3 * j + 1], task.axis[3 * j + 2], angle);
+            dQMultiply0(&task.targets[4 * j], &task.initial_local[4 * j], turn);
+        }
+    }
+
+    // sum of the joint errors, in radian
+    double trackingError(const TrackTask& task, double* max_error)
+    {
+        double sum = 0;
+        for (size_t j = 0; j < task.joints.size(); j++)
+        {
+            dQuaternion local;
+            jointLocalQuat(task.joints[j], local);
+            const dReal* t = &task.targets[4 * j];
+            double dot = std::fabs(local[0] * t[0] + local[1] * t[1] + local[2] * t[2] + local[3] * t[3]);
+            double err = 2 * std::acos(dot < 1 ? dot : 1);
+            sum += err;
+            if (err > *max_error) *max_error = err;
+        }
+        return sum;
+    }
+
+    void dampedSubstep(BenchScene& scene, dReal dt)
+    {
+        dSpaceCollide(scene.space, &scene.info, &dCollideContactCallback);
+        dWorldDampedStep(scene.world, dt);
+        dJointGroupEmpty(scene.info.group);
+        dSpaceResortGeoms(scene.space);
+    }
+
+    // num_substep explicit (JointPDController) or implicit (dJointSetStablePD) substeps per control step
+    TrackResult runTracking(BenchScene& scene, TrackTask& task, bool implicit_pd, int num_substep,
+        double control_dt, int episodes, int steps)
+    {
+        TrackResult res;
+        const int joint_count = (int)task.joints.size();
+        const dReal sim_dt = (dReal)(control_dt / num_substep);
+        JointPDController controller(task.joints.data(), joint_count, task.kps.data(), task.torque_limits.data());
+        for (int j = 0; j < joint_count; j++)
+        {
+            if (implicit_pd)
+                dJointSetStablePD(task.joints[j], task.kps[j], 0, task.torque_limits[j]);
+            else
+                dJointDisableStablePD(task.joints[j]);
+        }
+
+        double error_sum = 0, max_error = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int e = 0; e < episodes; e++)
+        {
+            dWorldRestore(scene.world, scene.initial_state.data(), scene.initial_state.size());
+            for (int t = 0; t < steps; t++)
+            {
+                computeTargets(task, (dReal)((t + 1) * control_dt));
+                if (implicit_pd)
+                    dJointSetStablePDTargets(task.joints.data(), joint_count, task.targets.data(), 0);
+                for (int s = 0; s < num_substep; s++)
+                {
+                    if (!implicit_pd)
+                        controller.Apply(task.targets.data(), 0);
+                    dampedSubstep(scene, sim_dt);
+                }
+                error_sum += trackingError(task, &max_error);
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        for (int j = 0; j < joint_count; j++)
+            dJointDisableStablePD(task.joints[j]);
+
+        bench::hashState(scene, &res.finite);
+        res.us_per_control_step = seconds * 1e6 / ((double)episodes * steps);
+        res.mean_error_deg = error_sum / ((double)episodes * steps * joint_count) * 180 / M_PI;
+        res.max_error_deg = max_error * 180 / M_PI;
+        return res;
+    }
+
+    void printResult(const TrackResult& res)
+    {
+        printf(" %9.1f %7.2f %7.2f%s", res.us_per_control_step, res.mean_error_deg, res.max_error_deg,
+            res.finite ? "  " : " !");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* scene_file = ODE_BENCH_SCENE;
+    double control_fps = 20;
+    std::vector<int> substeps = { 6, 3, 2, 1 };
+    int episodes = 4, steps = 100;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string a = argv[i];
+        const char* next = i + 1 < argc ? argv[i + 1] : NULL;
+        if (a == "--scene" && next) { scene_file = next; i++; }
+        else if (a == "--control-fps" && next) { control_fps = atof(next); i++; }
+        else if (a == "--substep" && next)
+        {
+            substeps.clear();
+            std::stringstream ss(next);
+            std::string item;
+            while (std::getline(ss, item, ','))
+                substeps.push_back(atoi(item.c_str()));
+            i++;
+        }
+        else if (a == "--episodes" && next) { episodes = atoi(next); i++; }
+        else if (a == "--steps" && next) { steps = atoi(next); i++; }
+        else
+        {
+            printf("usage: %s [--scene file] [--control-fps f] [--substep n[,n...]]\n"
+                "          [--episodes n] [--steps n]\n", argv[0]);
+            return 2;
+        }
+    }
+    bool bad_substep = substeps.empty();
+    for (size_t i = 0; i < substeps.size(); i++)
+        bad_substep = bad_substep || substeps[i] <= 0;
+    if (control_fps <= 0 || bad_substep || episodes <= 0 || steps <= 0)
+    {
+        printf("bad --control-fps, --substep, --episodes or --steps\n");
+        return 2;
+    }
+    const double control_dt = 1 / control_fps;
+
+    dInitODE2(0);
+    int ret = 0;
+    try
+    {
+        bench::JsonValue root = bench::loadJsonFile(scene_file);
+        BenchScene scene;
+        bench::loadScene(scene, root);
+        TrackTask task;
+        setupTask(scene, task);
+        printf("scene %s: %d bodies, %d joints, control dt %g, %d episodes x %d control steps\n", scene_file,
+            (int)scene.bodies.size(), (int)task.joints.size(), control_dt, episodes, steps);
+
+        runTracking(scene, task, false, substeps[0], control_dt, 1, steps < 10 ? steps : 10); // warm up
+        printf("%8s %9s | %-28s| %s\n", "", "", "explicit (JointPDController)", "implicit (stable PD)");
+        printf("%8s %9s | %9s %7s %7s   | %9s %7s %7s\n", "substeps", "dt", "us/step", "mean", "max",
+            "us/step", "mean", "max");
+        for (size_t i = 0; i < substeps.size(); i++)
+        {
+            printf("%8d %9.5f |", substeps[i], control_dt / substeps[i]);
+            printResult(runTracking(scene, task, false, substeps[i], control_dt, episodes, steps));
+            printf(" |");
+            printResult(runTracking(scene, task, true, substeps[i], control_dt, episodes, steps));
+            printf("\n");
+        }
+        printf("errors in degrees, ! marks a state that is not finite\n");
+    }
+    catch (const std::exception& e)
+    {
+        printf("error: %s\n", e.what());
+        ret = 2;
+    }
+    dCloseODE();
+    return ret;
+}
@@ -753,11 +753,73 @@ ODE_API void dGeomGetOffsetQuaternion (dGeomID geom, dQuaternion result);
 // Add by Zhenhua Song
 ODE_API int dGeomIsPlaceable(dGeomID geom);
 
+#define dGEOM_MAX_IGNORE_GEOMS 64
+
+/**
+ * @brief Contact attributes of a geom, read by the near callback of the bindings.
+ *
+ * They live in the geom so that the near callback does not touch Python
+ * objects and collision detection can run without the GIL.
+ * Defaults: friction 0.8, bounce 0, max_friction dInfinity, collidable and
+ * character_self_collide 1, no ignored geoms.
+ * @ingroup collide
+ */
+typedef struct dGeomContactAttrs {
+  dReal friction;
+  dReal bounce;
+  dReal max_friction;
+  int collidable;
+  int character_self_collide; /* collide with geoms of the same character */
+  int num_ignore_geoms;
+  dGeomID ignore_geoms[dGEOM_MAX_IGNORE_GEOMS];
+} dGeomContactAttrs;
+
+ODE_API dGeomContactAttrs *dGeomGetContactAttrs(dGeomID g);
+
+/**
+ * @brief Contact parameters passed as data to dCollideContactCallback.
+ * @ingroup collide
+ */
+typedef struct dJointGroupWithdWorld {
+  int use_max_force_contact;  /* create dJointCreateContactMaxForce joints */
+  int max_contact_num;        /* at most 256 */
+  dReal soft_cfm;
+  dReal soft_erp;
+  int use_soft_contact;
+  int self_collision;
+  dJointGroupID group;
+  dWorldID world;
+} dJointGroupWithdWorld;
+
+/**
+ * @brief Pair filter of dCollideContactCallback, usable with dSpaceSweepFastBodies.
+ *
+ * Rejects geoms of the same body, bodies connected by a joint, pairs excluded by
+ * the character pair table or by self collision, and ignored geoms.
+ * @param data a dJointGroupWithdWorld
+ * @return 0 if the pair should not collide
+ * @ingroup collide
+ */
+ODE_API int dCollideContactFilter(void *data, dGeomID o1, dGeomID o2);
+
+/**
+ * @brief Near callback creating contact joints from the geom contact attributes.
+ *
+ * mu is the smaller friction (max_friction with max force contacts) and bounce
+ * the smaller bounce of the two geoms. The callback does not touch user data,
+ * so spaces of different worlds can be collided from several threads.
+ * @param data a dJointGroupWithdWorld
+ * @ingroup collide
+ */
+ODE_API void dCollideContactCallback(void *data, dGeomID o1, dGeomID o2);
+
 // Add by Zhenhua Song
-//ODE_API void dGeomAppendIgnore(dGeomID now_id, dGeomID other_id);
+// return 0 if the ignore list of now_id is full
+ODE_API int dGeomAppendIgnore(dGeomID now_id, dGeomID other_id);
 
 // Add by Zhenhua Song
-//ODE_API int dGeomIsIgnore(dGeomID now_id, dGeomID other_id);
+// return 1 if other_id is in the ignore list of now_id
+ODE_API int dGeomIsIgnore(dGeomID now_id, dGeomID other_id);
 
 // Add by Zhenhua Song
 ODE_API int dGeomGetCharacterID(dGeomID g);
@@ -771,6 +833,35 @@ ODE_API int dGeomGetIndex(dGeomID g);
 // Add by Zhenhua Song
 ODE_API void dGeomSetIndex(dGeomID g, int index);
 
+/**
+ * @brief Create a table of the geom pairs of one character allowed to collide.
+ *
+ * The table is a symmetric bit matrix indexed by dGeomGetIndex. Geoms of the
+ * same character sharing a table (dGeomSetCharacterPairTable) are paired by
+ * the space only when the table allows it, so pairs excluded once from the
+ * skeleton (adjacent bodies, ignored pairs, self collision disabled) are never
+ * passed to the near callback. Geom indices outside of the table are allowed.
+ *
+ * The table is reference counted: every geom using it holds a reference, and
+ * dCharacterPairTableDestroy releases the reference of the creator.
+ *
+ * @param num_geoms number of geoms of the character, all pairs are allowed.
+ * @ingroup collide
+ */
+ODE_API dCharacterPairTableID dCharacterPairTableCreate(int num_geoms);
+ODE_API void dCharacterPairTableDestroy(dCharacterPairTableID table);
+ODE_API int dCharacterPairTableGetNumGeoms(dCharacterPairTableID table);
+ODE_API void dCharacterPairTableSetPair(dCharacterPairTableID table, int i, int j, int allowed);
+ODE_API int dCharacterPairTableGetPair(dCharacterPairTableID table, int i, int j);
+ODE_API void dCharacterPairTableSetAll(dCharacterPairTableID table, int allowed);
+
+/**
+ * @brief Attach a pair table to a geom, NULL to detach.
+ * @ingroup collide
+ */
+ODE_API void dGeomSetCharacterPairTable(dGeomID g, dCharacterPairTableID table);
+ODE_API dCharacterPairTableID dGeomGetCharacterPairTable(dGeomID g);
+
 // Add by Zhenhua Song, for visualize in Long Ge's draw stuff framework
 void dGeomRenderGetUserColor(dGeomID g, dReal * result);
 
@@ -72,6 +72,49 @@ ODE_API void dSpaceDestroy (dSpaceID);
 ODE_API void dHashSpaceSetLevels (dSpaceID space, int minlevel, int maxlevel);
 ODE_API void dHashSpaceGetLevels (dSpaceID space, int *minlevel, int *maxlevel);
 
+/**
+ * @brief Let a hash space tune its levels from the geoms it holds.
+ *
+ * Each dSpaceCollide() then blends the AABB levels of the finite geoms into a
+ * running histogram, sets minlevel to the level of the smallest geoms (a 2%
+ * tail excluded) and maxlevel to the largest level seen recently, so that
+ * small geoms get small cells and only infinite geoms are tested against
+ * everything. dHashSpaceGetLevels returns the tuned levels, and
+ * dHashSpaceSetLevels only sets the levels used until the next collide.
+ *
+ * The levels change the order in which pairs are reported, so with this mode
+ * the contacts of a state also depend on the geoms seen in earlier frames.
+ *
+ * @param enabled 1 to tune the levels, 0 to keep the levels as they are.
+ * @ingroup collide
+ */
+ODE_API void dHashSpaceSetAutoLevels (dSpaceID space, int enabled);
+ODE_API int dHashSpaceGetAutoLevels (dSpaceID space);
+
+/**
+ * @brief Cell occupancy of the last dSpaceCollide() of a hash space.
+ *
+ * Only filled while dHashSpaceSetStatsEnabled is on (off by default), since
+ * counting the bucket chains walks the whole hash table at every collide.
+ * Zero until the first collide after enabling.
+ * @ingroup collide
+ */
+typedef struct dHashSpaceStats {
+  int minlevel, maxlevel;	/* levels used */
+  int num_aabbs;		/* geoms put in the hash table */
+  int num_big_boxes;		/* geoms too big for the hash table */
+  int num_nodes;		/* (geom, cell) entries in the hash table */
+  int table_size;		/* number of hash buckets */
+  int used_buckets;		/* non-empty hash buckets */
+  int max_bucket_size;		/* longest chain of a hash bucket */
+  int num_cell_tests;		/* pairs found sharing a cell */
+  int num_big_box_tests;	/* pairs with a big geom, tested brute force */
+} dHashSpaceStats;
+
+ODE_API void dHashSpaceSetStatsEnabled (dSpaceID space, int enabled);
+ODE_API int dHashSpaceGetStatsEnabled (dSpaceID space);
+ODE_API void dHashSpaceGetStats (dSpaceID space, dHashSpaceStats *stats);
+
 ODE_API void dSpaceSetCleanup (dSpaceID space, int mode);
 ODE_API int dSpaceGetCleanup (dSpaceID space);
 
@@ -168,6 +211,41 @@ ODE_API int dSpaceGetPlaceableAndPlaneCount(dSpaceID space);
 // Add by Zhenhua Song
 ODE_API void dSpaceResortGeoms(dSpaceID space);
 
+/**
+ * @brief Filter used by dSpaceSweepFastBodies, return 0 to ignore the pair.
+ * @ingroup collide
+ */
+typedef int dSweepFilterFn (void *data, dGeomID fast_geom, dGeomID other);
+
+/**
+ * @brief Conservative advancement for fast moving bodies.
+ *
+ * Call this right before dSpaceCollide() with the step size of the coming
+ * step. Every enabled body of the world marked with dBodySetFastMoving whose
+ * displacement lvel * stepsize is longer than its thinnest geom is swept
+ * along that displacement against the geoms of the space. When the sweep
+ * hits a geom that did not already touch the body, the body is moved to the
+ * first penetrating pose found, so the next dSpaceCollide() reports the
+ * contact instead of the body passing through a thin geom in one step.
+ * The velocity of the advanced body is kept: the contact joints created at
+ * that pose resolve the impact, and the next step only integrates the linear
+ * motion over the part of the step left after the time of impact, so the body
+ * does not move lvel * stepsize again on top of the advance.
+ *
+ * Only the linear motion of the fast body is swept, other bodies are treated
+ * as static over the step. Geoms of the same body, bodies connected by a
+ * joint and pairs rejected by category/collide bits are skipped.
+ *
+ * @param space the space holding the geoms to sweep against
+ * @param w the world holding the fast bodies
+ * @param stepsize the step size of the coming step
+ * @param data passed to the filter
+ * @param filter optional pair filter, may be NULL
+ * @returns the number of bodies that were advanced
+ * @ingroup collide
+ */
+ODE_API int dSpaceSweepFastBodies (dSpaceID space, dWorldID w, dReal stepsize, void *data, dSweepFilterFn *filter);
+
 /**
  * @brief Given a space, this returns its class.
  *
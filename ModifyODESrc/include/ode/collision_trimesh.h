@@ -108,6 +108,24 @@ ODE_API void dGeomTriMeshDataPreprocess(dTriMeshDataID g);
 ODE_API void dGeomTriMeshDataGetBuffer(dTriMeshDataID g, unsigned char** buf, int* bufLen);
 ODE_API void dGeomTriMeshDataSetBuffer(dTriMeshDataID g, unsigned char* buf);
 
+/*
+ * Save a built TriMesh data object (vertices, indices, OPCODE tree and the
+ * preprocessed flags if any) as one flat, relocatable blob, so that static
+ * meshes can be loaded without rebuilding the tree. The blob can be written
+ * to a file, memory-mapped read-only, and shared between processes of the
+ * same build. Face normals set by dGeomTriMeshDataSet are not saved.
+ */
+ODE_API size_t dGeomTriMeshDataGetSerializedSize(dTriMeshDataID g);
+/* returns the number of bytes written, or 0 if the buffer is too small */
+ODE_API size_t dGeomTriMeshDataSerialize(dTriMeshDataID g, void* buffer, size_t bufferSize);
+/*
+ * Set up a TriMesh data object from a blob written by dGeomTriMeshDataSerialize.
+ * The blob is used in place (not copied) and must stay alive and unchanged
+ * while the data is in use. Its address must be 8 byte aligned.
+ * Returns 0 if the blob is invalid or comes from an incompatible build.
+ */
+ODE_API int dGeomTriMeshDataBuildFromSerialized(dTriMeshDataID g, const void* blob, size_t blobSize);
+
 
 /*
  * Per triangle callback. Allows the user to say if he wants a collision with
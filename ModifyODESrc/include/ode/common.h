@@ -235,6 +235,7 @@ typedef struct dxGeom *dGeomID;
 typedef struct dxJoint *dJointID;
 typedef struct dxJointGroup *dJointGroupID;
 typedef struct dxWorldProcessThreadingManager *dWorldStepThreadingManagerID;
+typedef struct dxCharacterPairTable *dCharacterPairTableID;
 
 /* error numbers */
 
@@ -93,3 +93,13 @@ int sparseInverse(
     In unsigned int ninvskip,
     In void* memarea   // pre-allocated memory space for internal usage, if this parameter is zero, the function will estimate a maximum usage
 );
+
+// Add by Zhenhua Song
+// Implicit stable PD of a joint (dJointSetStablePD): add the clipped spring torque
+// kp * rotvec(target * inv(local)) to the body torques, and return the damping
+// (kp * h + kd) * h of the stable PD to add to the joint block of (I + D).
+// Returns 0 for a joint without stable PD.
+dReal addStablePDSpringTorque(
+    InOut dxJoint* joint,
+    In dReal stepsize
+);
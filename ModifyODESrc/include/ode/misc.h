@@ -53,6 +53,14 @@ ODE_API int dRandInt (int n);
 /* return a random real number between 0..1 */
 ODE_API dReal dRandReal(void);
 
+/* the same generators on a caller owned seed instead of the global one,
+ * e.g. the seed of a world (see dWorldSetRandSeed), so worlds stepped in
+ * parallel do not share state.
+ */
+ODE_API unsigned long dRandR(unsigned long *seed);
+ODE_API int dRandIntR(unsigned long *seed, int n);
+ODE_API dReal dRandRealR(unsigned long *seed);
+
 /* print out a matrix */
 #ifdef __cplusplus
 ODE_API void dPrintMatrix (const dReal *A, int n, int m, const char *fmt = "%10.4f ",
@@ -733,6 +733,175 @@ ODE_API dReal dWorldGetMaxAngularSpeed (dWorldID w);
 ODE_API void dWorldSetMaxAngularSpeed (dWorldID w, dReal max_speed);
 
 
+/**
+ * @brief Get the random seed of the world.
+ *
+ * Random numbers drawn while stepping the world come from this seed rather
+ * than the global dRand one, so worlds stepped in parallel stay deterministic
+ * each on its own. A new world starts from the global seed (dRandGetSeed()).
+ *
+ * The only such draw is the constraint reordering of dWorldQuickStep, which
+ * is compiled in only with RANDOMLY_REORDER_CONSTRAINTS (quickstep.cpp).
+ * That macro is off in this build, so the seed does not change the result of
+ * any stepper unless it is enabled.
+ * @ingroup world
+ */
+ODE_API unsigned long dWorldGetRandSeed (dWorldID w);
+
+
+/**
+ * @brief Set the random seed of the world.
+ * @ingroup world
+ * @sa dWorldGetRandSeed()
+ */
+ODE_API void dWorldSetRandSeed (dWorldID w, unsigned long s);
+
+
+/**
+ * @brief Phases timed by the world profiler.
+ *
+ * The stepper phases follow the IFTIMING markers of dWorldStep,
+ * dWorldDampedStep and dWorldQuickStep. dWorldQuickStep has no
+ * compute A and constraint force phases.
+ * @ingroup world
+ */
+enum {
+  dProfileBroadphase = 0,     /* dSpaceCollide, without the two phases below */
+  dProfileNarrowphase,        /* dCollide in dCollideContactCallback */
+  dProfileContacts,           /* contact joint creation in dCollideContactCallback */
+  dProfileIslands,            /* island build and stepper memory estimate */
+  dProfilePreprocess,
+  dProfileCreateJ,
+  dProfileComputeA,
+  dProfileComputeRhs,
+  dProfileSolveLCP,
+  dProfileConstraintForce,
+  dProfileIntegrateVelocity,
+  dProfileIntegratePosition,
+  dProfileTidyUp,
+  dProfileResortGeoms,        /* dSpaceResortGeoms */
+  dProfilePhaseCount
+};
+
+/**
+ * @brief Accumulated time of each profiler phase.
+ * @ingroup world
+ * @sa dWorldGetProfile
+ */
+typedef struct dWorldProfile {
+  double seconds[dProfilePhaseCount];
+  unsigned long long calls[dProfilePhaseCount];
+  unsigned long long steps;   /* world steps taken while profiling */
+} dWorldProfile;
+
+/**
+ * @brief Enable or disable the profiler of the world.
+ *
+ * The profiler is off for a new world. When off, each timing point costs
+ * one branch. Accumulated times are kept when it is disabled again.
+ * @ingroup world
+ */
+ODE_API void dWorldSetProfiling (dWorldID w, int enabled);
+
+/**
+ * @brief Return 1 if the profiler of the world is enabled.
+ * @ingroup world
+ */
+ODE_API int dWorldGetProfiling (dWorldID w);
+
+/**
+ * @brief Zero the accumulated times of the world profiler.
+ * @ingroup world
+ */
+ODE_API void dWorldResetProfile (dWorldID w);
+
+/**
+ * @brief Copy the accumulated times of the world profiler.
+ * @ingroup world
+ */
+ODE_API void dWorldGetProfile (dWorldID w, dWorldProfile *profile);
+
+/**
+ * @brief Start timing a phase run outside the stepper, such as dSpaceCollide
+ * or dSpaceResortGeoms called by the caller.
+ * @return the current tick, or 0 if the profiler is disabled
+ * @ingroup world
+ * @sa dWorldProfileEnd
+ */
+ODE_API unsigned long long dWorldProfileBegin (dWorldID w);
+
+/**
+ * @brief Add the time since dWorldProfileBegin to a phase.
+ * Does nothing if begin is 0.
+ * @ingroup world
+ */
+ODE_API void dWorldProfileEnd (dWorldID w, int phase, unsigned long long begin);
+
+
+/**
+ * @brief Contiguous body state arrays of a world.
+ *
+ * Row i of each array is the state of the body with storage index i.
+ * Rows are padded like the ODE vector types, so the stride of a row is
+ * 16 dReals for posr (pos[4] then the 3x4 rotation matrix) and 4 dReals
+ * for q (w, x, y, z), lvel and avel.
+ * @ingroup world
+ * @sa dWorldGetBodyStorage
+ */
+typedef struct dBodyStorageInfo {
+  int num_bodies;
+  unsigned int generation;  /* changes whenever the arrays move or rows are reordered */
+  dReal *posr;
+  dReal *q;
+  dReal *lvel;
+  dReal *avel;
+} dBodyStorageInfo;
+
+/**
+ * @brief Keep the position, rotation, quaternion and velocities of all
+ * bodies of the world in contiguous arrays.
+ *
+ * Each body points into the arrays instead of holding its own state, so
+ * the state of all bodies can be read (or written) in place, see
+ * dWorldGetBodyStorage. Creating or destroying bodies may move the arrays
+ * or reorder their rows, which changes the generation of the storage.
+ * @param enabled 1 for contiguous storage, 0 to let each body hold its state.
+ * @ingroup world
+ */
+ODE_API void dWorldSetContiguousBodyStorage (dWorldID w, int enabled);
+
+/**
+ * @brief Get whether the world keeps its body state in contiguous arrays.
+ * @ingroup world
+ */
+ODE_API int dWorldGetContiguousBodyStorage (dWorldID w);
+
+/**
+ * @brief Reserve room for a number of bodies in the contiguous storage,
+ * so that creating up to that many bodies does not move the arrays.
+ * @ingroup world
+ */
+ODE_API void dWorldReserveBodyStorage (dWorldID w, int capacity);
+
+/**
+ * @brief Get the contiguous body state arrays of the world.
+ * @returns 0 and leaves info untouched if the world has no contiguous storage.
+ * @remarks
+ * After writing positions or velocities in place, call dWorldBodyStorageMoved
+ * so the geoms of the bodies get their AABBs updated. The rotation matrices
+ * must match the quaternions, so they should only be written together.
+ * @ingroup world
+ */
+ODE_API int dWorldGetBodyStorage (dWorldID w, dBodyStorageInfo *info);
+
+/**
+ * @brief Tell the world that the body state was written through the
+ * contiguous arrays, which marks the geoms of all bodies as moved.
+ * @ingroup world
+ */
+ODE_API void dWorldBodyStorageMoved (dWorldID w);
+
+
 
 /**
  * @defgroup bodies Rigid Bodies
@@ -1483,6 +1652,124 @@ ODE_API int dBodyGetGyroscopicMode(dBodyID b);
  */
 ODE_API void dBodySetGyroscopicMode(dBodyID b, int enabled);
 
+/**
+ * @brief Mark a body as a fast mover (e.g. a thrown projectile).
+ *
+ * Fast movers are swept along their linear velocity by dSpaceSweepFastBodies
+ * before collision detection, so they do not tunnel through thin geoms.
+ * @param enabled   1 to sweep the body, 0 for normal discrete collision.
+ * @ingroup bodies
+ */
+ODE_API void dBodySetFastMoving(dBodyID b, int enabled);
+
+/**
+ * @brief Get whether the body is swept as a fast mover.
+ * @ingroup bodies
+ */
+ODE_API int dBodyGetFastMoving(dBodyID b);
+
+/**
+ * @brief Get the row of the body in the contiguous body storage of its world.
+ * @returns -1 if the world has no contiguous storage.
+ * @ingroup bodies
+ * @sa dWorldGetBodyStorage
+ */
+ODE_API int dBodyGetStorageIndex(dBodyID b);
+
+/**
+ * @brief Get the state of a list of bodies, 13 floats per body:
+ * position, quaternion (x, y, z, w) with w >= 0, linear and angular velocity.
+ * @param prev_state  if not NULL, the state of the same bodies dt earlier;
+ * the velocities are then computed by backward finite difference from it.
+ * @param state       output, num_bodies * 13 floats.
+ * @ingroup bodies
+ */
+ODE_API void dBodiesGetState13(const dBodyID* bodies, int num_bodies, const float* prev_state, dReal dt, float* state);
+
+/**
+ * @brief Compute the observation of a character from its 13 float state
+ * (see dBodiesGetState13), the first body being the root.
+ *
+ * The observation has 16 * num_bodies + 3 floats: position (3), 6d rotation
+ * (the first two columns of the rotation matrix, row major), linear and
+ * angular velocity (3 each) of every body in the root frame, then the height
+ * of every body and the up direction (0, 1, 0) in the root frame.
+ * @ingroup bodies
+ */
+ODE_API void dState13ToObservation(const float* state, int num_bodies, float* obs);
+
+/**
+ * @brief Set position, quaternion, rotation and velocities of a list of
+ * bodies from their 13 float state (see dBodiesGetState13).
+ * @ingroup bodies
+ */
+ODE_API void dBodiesSetState13(const dBodyID* bodies, int num_bodies, const float* state);
+
+/**
+ * @brief If the lowest point of the geoms of the bodies is below y = 0,
+ * move the bodies up so that it is at y = clearance.
+ * @returns the distance the bodies were moved up, 0 if they were not moved.
+ * @ingroup bodies
+ */
+ODE_API dReal dBodiesLiftAboveGround(const dBodyID* bodies, int num_bodies, dReal clearance);
+
+/**
+ * @brief Size in bytes of a snapshot of the world (see dWorldSnapshot).
+ * It changes when bodies, joints or geoms are added or removed.
+ * @ingroup world
+ */
+ODE_API size_t dWorldGetSnapshotSize(dWorldID w);
+
+/**
+ * @brief Copy the dynamic state of the world into a caller owned buffer.
+ *
+ * Saved are the body state, force / torque accumulators and auto-disable
+ * state, the joint lambda and flags, the random seed of the world, the
+ * order of the geoms in the spaces of the body geoms and the adaptive level
+ * state of hash spaces (dHashSpaceSetAutoLevels). Restoring the buffer and
+ * stepping reproduces the original trajectory bit for bit. Take the
+ * snapshot between steps, when the contact joint group is empty.
+ *
+ * Only simple and hash spaces can be restored: sweep-and-prune and quadtree
+ * spaces keep their collision order outside of the geom list.
+ * @returns the number of bytes written, 0 if buffer_size is too small or a
+ * body geom is in a sweep-and-prune or quadtree space.
+ * @ingroup world
+ */
+ODE_API size_t dWorldSnapshot(dWorldID w, void* buffer, size_t buffer_size);
+
+/**
+ * @brief Restore a snapshot taken with dWorldSnapshot from the same world.
+ * @returns 1 on success, 0 (and the world is unchanged) if the buffer does
+ * not match the world: other version, world, bodies, joints or geoms.
+ * @ingroup world
+ */
+ODE_API int dWorldRestore(dWorldID w, const void* buffer, size_t buffer_size);
+
+/**
+ * @brief Deep copy of a world and of the geoms of a space.
+ *
+ * Bodies (mass and state), joints (with damping and damping reference
+ * body), world parameters and the geoms of space (offsets, contact
+ * attributes, character ids and indices) are copied, keeping the order of
+ * all lists, so the copy steps exactly like the source. The new space owns
+ * its geoms (cleanup mode 1), a hash space keeps the levels and auto-level
+ * state (dHashSpaceSetAutoLevels) of the source. Contact joints are not copied, and trimesh
+ * data and character pair tables are shared with the source.
+ *
+ * The optional arrays receive the source objects in list order and their
+ * copies: dWorldGetNumBody / dWorldGetNumJoints / dSpaceGetNumGeoms entries,
+ * with 0 in new_joints for contact joints.
+ * @returns the new world, or 0 if space holds sub spaces, geoms of another
+ * world or geom classes other than sphere, box, capsule, cylinder, plane,
+ * ray and trimesh, or is not a simple or hash space.
+ * @ingroup world
+ */
+ODE_API dWorldID dWorldClone(dWorldID w, dSpaceID space, dSpaceID* space_out,
+                             dBodyID* src_bodies, dBodyID* new_bodies,
+                             dJointID* src_joints, dJointID* new_joints,
+                             dGeomID* src_geoms, dGeomID* new_geoms);
+
 // Add by Zhenhua Song
 ODE_API int dBodyGetNumGeoms(dBodyID b);
 
@@ -3047,6 +3334,49 @@ ODE_API void dJointSetKd(dJointID, dReal kdx, dReal kdy, dReal kdz);
 // Add by Zhenhua Song
 ODE_API const dReal * dJointGetKd(dJointID);
 
+// Add by Zhenhua Song
+/**
+ * @brief Implicit stable PD of the joint in dWorldDampedStep.
+ *
+ * Every damped step, the spring torque kp * rotvec(target * inv(local)) of
+ * the current pose, clipped to torque_limit (no limit if <= 0), is added to
+ * the child body and subtracted from the parent body. The velocity term
+ * (kp * h + kd) of the stable PD is added to the joint damping of the
+ * implicit (I + D) solve. This keeps very low substep counts stable (one
+ * substep per control step, where the explicit torques of pd_control_batch
+ * lose the pose); at the same substep count it otherwise costs and tracks
+ * about the same as the explicit torques (bench/stable_pd_bench.cpp).
+ * kd adds to the joint kd (dJointSetKd).
+ * The target is the identity until dJointSetStablePDTarget.
+ * @ingroup joints
+ */
+ODE_API void dJointSetStablePD(dJointID, dReal kp, dReal kd, dReal torque_limit);
+
+// Add by Zhenhua Song
+ODE_API void dJointDisableStablePD(dJointID);
+
+// Add by Zhenhua Song
+ODE_API int dJointIsStablePD(dJointID);
+
+// Add by Zhenhua Song
+/**
+ * @brief Target of the stable PD: rotation of the child body in the parent
+ * body frame (in global frame for a joint to the world), in (w, x, y, z).
+ * @ingroup joints
+ */
+ODE_API void dJointSetStablePDTarget(dJointID, const dReal * q);
+
+// Add by Zhenhua Song
+ODE_API const dReal * dJointGetStablePDTarget(dJointID);
+
+// Add by Zhenhua Song
+/**
+ * @brief dJointSetStablePDTarget for count joints. qs is in shape (count, 4),
+ * in scipy (x, y, z, w) order if input_in_scipy, else in (w, x, y, z).
+ * @ingroup joints
+ */
+ODE_API void dJointSetStablePDTargets(dJointID const * joints, int count, const dReal * qs, int input_in_scipy);
+
 // Add by Zhenhua Song
 ODE_API dReal dJointGetContactParam(dJointID j, int parameter);
 
@@ -67,6 +67,7 @@ elif system_type == 'Linux':  # WSL 1 of Ubuntu 20.04 also returns 'Linux'
     ModifiedODE_link_args = [
         # '-Wl,--no-undefined', 
         'libModifyODE.a', 'libMotionUtils.a','libDrawStuff.a',
+        '-lrt',  # shm_open in Utils/shm_transport.cpp
         '-L%s'%get_config_var('LIBPL'),
         '-lpython%s'%get_config_var('LDVERSION')
     ]
@@ -0,0 +1,222 @@
+// State and observation of a character, as computed by character_state and
+// state2ob in ControlVAECore/Utils/motion_utils.py, without the numpy / torch
+// temporaries. Quaternions are in scipy order (x, y, z, w) and flipped so
+// that w >= 0. The state is computed in dReal and stored as float, the
+// observation is computed in float from the stored state, like state2ob does
+// on the float32 tensor. dBodiesSetState13 loads such a state back.
+
+#include <ode/common.h>
+#include <ode/objects.h>
+#include <ode/collision.h>
+#include <ode/rotation.h>
+#include <ode/odemath.h>
+#include "config.h"
+#include "objects.h"
+
+namespace
+{
+    template<typename T>
+    void cross3(const T* a, const T* b, T* out)
+    {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    // rotate v by q (x, y, z, w), same arithmetic as quat_apply in diff_quat.py
+    void quatApply(const float* q, const float* v, float* out)
+    {
+        float c[3], t[3], ct[3];
+        cross3(q, v, c);
+        t[0] = 2 * c[0];
+        t[1] = 2 * c[1];
+        t[2] = 2 * c[2];
+        cross3(q, t, ct);
+        for (int k = 0; k < 3; k++)
+        {
+            out[k] = v[k] + q[3] * t[k] + ct[k];
+        }
+    }
+
+    // p * q, same arithmetic as quat_multiply in diff_quat.py
+    template<typename T>
+    void quatMultiply(const T* p, const T* q, T* out)
+    {
+        T c[3];
+        cross3(p, q, c);
+        T w = p[3] * q[3] - (p[0] * q[0] + p[1] * q[1] + p[2] * q[2]);
+        for (int k = 0; k < 3; k++)
+        {
+            out[k] = p[3] * q[k] + q[3] * p[k] + c[k];
+        }
+        out[3] = w;
+    }
+}
+
+void dBodiesGetState13(const dBodyID* bodies, int num_bodies, const float* prev_state, dReal dt, float* state)
+{
+    dAASSERT(bodies && state);
+    dAASSERT(prev_state == NULL || dt > 0);
+    for (int i = 0; i < num_bodies; i++)
+    {
+        const dxBody* b = bodies[i];
+        const dReal* pos = b->posr->pos;
+        dReal rot[4] = { b->q[1], b->q[2], b->q[3], b->q[0] };
+        if (rot[3] < 0)
+        {
+            rot[0] = -rot[0];
+            rot[1] = -rot[1];
+            rot[2] = -rot[2];
+            rot[3] = -rot[3];
+        }
+
+        float* out = state + 13 * i;
+        if (prev_state == NULL)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                out[7 + k] = (float)b->lvel[k];
+                out[10 + k] = (float)b->avel[k];
+            }
+        }
+        else
+        {
+            // backward finite difference over dt, as resample() does.
+            // prev is read before out is written, so both can be the same buffer
+            const float* prev = prev_state + 13 * i;
+            dReal old_rot[4] = { prev[3], prev[4], prev[5], prev[6] };
+            for (int k = 0; k < 3; k++)
+            {
+                out[7 + k] = (float)((pos[k] - (dReal)prev[k]) / dt);
+            }
+            dReal dot = rot[0] * old_rot[0] + rot[1] * old_rot[1] + rot[2] * old_rot[2] + rot[3] * old_rot[3];
+            dReal sign = dot > 0 ? 1 : (dot < 0 ? -1 : 0);
+            dReal qd[4], conj[4] = { -old_rot[0], -old_rot[1], -old_rot[2], old_rot[3] }, avel[4];
+            for (int k = 0; k < 4; k++)
+            {
+                qd[k] = (rot[k] * sign - old_rot[k]) / dt;
+            }
+            quatMultiply(qd, conj, avel);
+            for (int k = 0; k < 3; k++)
+            {
+                out[10 + k] = (float)(2 * avel[k]);
+            }
+        }
+
+        for (int k = 0; k < 3; k++)
+        {
+            out[k] = (float)pos[k];
+        }
+        for (int k = 0; k < 4; k++)
+        {
+            out[3 + k] = (float)rot[k];
+        }
+    }
+}
+
+void dState13ToObservation(const float* state, int num_bodies, float* obs)
+{
+    dAASSERT(state && obs && num_bodies > 0);
+    float* local_pos = obs;
+    float* local_rot = local_pos + 3 * num_bodies;
+    float* local_vel = local_rot + 6 * num_bodies;
+    float* local_avel = local_vel + 3 * num_bodies;
+    float* height = local_avel + 3 * num_bodies;
+    float* up_dir = height + num_bodies;
+
+    // inverse of the root rotation, as quat_inv: (x, y, z, -w)
+    const float* root = state;
+    const float root_inv[4] = { root[3], root[4], root[5], -root[6] };
+
+    for (int i = 0; i < num_bodies; i++)
+    {
+        const float* s = state + 13 * i;
+        float rel_pos[3] = { s[0] - root[0], s[1] - root[1], s[2] - root[2] };
+        quatApply(root_inv, rel_pos, local_pos + 3 * i);
+        quatApply(root_inv, s + 7, local_vel + 3 * i);
+        quatApply(root_inv, s + 10, local_avel + 3 * i);
+        height[i] = s[1];
+
+        float q[4];
+        quatMultiply(root_inv, s + 3, q);
+        if (q[3] < 0)
+        {
+            q[0] = -q[0];
+            q[1] = -q[1];
+            q[2] = -q[2];
+            q[3] = -q[3];
+        }
+        // first two columns of the rotation matrix, row major, as quat_to_vec6d
+        float x = q[0], y = q[1], z = q[2], w = q[3];
+        float x2 = x * x, y2 = y * y, z2 = z * z, w2 = w * w;
+        float* r = local_rot + 6 * i;
+        r[0] = x2 - y2 - z2 + w2;
+        r[1] = 2 * (x * y - z * w);
+        r[2] = 2 * (x * y + z * w);
+        r[3] = -x2 + y2 - z2 + w2;
+        r[4] = 2 * (x * z - y * w);
+        r[5] = 2 * (y * z + x * w);
+    }
+
+    const float up[3] = { 0, 1, 0 };
+    quatApply(root_inv, up, up_dir);
+}
+
+void dBodiesSetState13(const dBodyID* bodies, int num_bodies, const float* state)
+{
+    dAASSERT(bodies && state);
+    for (int i = 0; i < num_bodies; i++)
+    {
+        dxBody* b = bodies[i];
+        const float* s = state + 13 * i;
+        for (int k = 0; k < 3; k++)
+        {
+            b->posr->pos[k] = s[k];
+            b->lvel[k] = s[7 + k];
+            b->avel[k] = s[10 + k];
+        }
+        // the quaternion is kept as given, the rotation matrix is built from
+        // the normalized one (as Rotation.from_quat(q).as_matrix())
+        dQuaternion q = { s[6], s[3], s[4], s[5] };
+        b->q[0] = q[0];
+        b->q[1] = q[1];
+        b->q[2] = q[2];
+        b->q[3] = q[3];
+        dNormalize4(q);
+        dQtoR(q, b->posr->R);
+
+        for (dGeomID g = dBodyGetFirstGeom(b); g; g = dGeomGetBodyNext(g))
+        {
+            dGeomMoved(g);
+        }
+    }
+}
+
+dReal dBodiesLiftAboveGround(const dBodyID* bodies, int num_bodies, dReal clearance)
+{
+    dAASSERT(bodies);
+    dReal lowest = dInfinity, aabb[6];
+    for (int i = 0; i < num_bodies; i++)
+    {
+        for (dGeomID g = dBodyGetFirstGeom(bodies[i]); g; g = dGeomGetBodyNext(g))
+        {
+            dGeomGetAABB(g, aabb);
+            if (aabb[2] < lowest)
+            {
+                lowest = aabb[2];
+            }
+        }
+    }
+    if (!(lowest < 0))
+    {
+        return 0;
+    }
+
+    dReal lift = clearance - lowest;
+    for (int i = 0; i < num_bodies; i++)
+    {
+        const dReal* pos = dBodyGetPosition(bodies[i]);
+        dBodySetPosition(bodies[i], pos[0], pos[1] + lift, pos[2]);
+    }
+    return lift;
+}
@@ -0,0 +1,93 @@
+// Near callback creating the contact joints of a simulation step, shared by
+// World.step_fast_collision / damped_step_fast_collision in the bindings and
+// the native VecTrackEnv. Contact parameters come from dJointGroupWithdWorld
+// and from the contact attributes stored in the geoms. dCollide and the
+// contact creation are timed by the profiler of the world, if enabled.
+
+#include <ode/common.h>
+#include <ode/objects.h>
+#include <ode/collision.h>
+#include <ode/contact.h>
+#include "config.h"
+#include "objects.h"
+#include "world_profile.h"
+
+int dCollideContactFilter(void *data, dxGeom *o1, dxGeom *o2)
+{
+    dBodyID b1 = dGeomGetBody(o1);
+    dBodyID b2 = dGeomGetBody(o2);
+
+    if (b1 == b2) // contains dGeomGetBody(o1) == NULL and dGeomGetBody(o2) == NULL
+        return 0;
+
+    const dJointGroupWithdWorld *group_info = (const dJointGroupWithdWorld *)data;
+
+    // pairs of one character sharing a pair table are already filtered by the space
+    dCharacterPairTableID table = dGeomGetCharacterPairTable(o1);
+    if (table != NULL && table == dGeomGetCharacterPairTable(o2))
+        return group_info->self_collision;
+
+    if (b1 != NULL && b2 != NULL && dAreConnected(b1, b2))
+        return 0;
+
+    if (dGeomGetCharacterID(o1) == dGeomGetCharacterID(o2) &&
+        (!dGeomGetContactAttrs(o1)->character_self_collide || !group_info->self_collision))
+        return 0;
+
+    if (dGeomIsIgnore(o1, o2) || dGeomIsIgnore(o2, o1))
+        return 0;
+
+    return 1;
+}
+
+void dCollideContactCallback(void *data, dxGeom *o1, dxGeom *o2)
+{
+    if (!dCollideContactFilter(data, o1, o2))
+        return;
+
+    const int max_contacts = 256;
+    const dJointGroupWithdWorld *group_info = (const dJointGroupWithdWorld *)data;
+    const dGeomContactAttrs *a1 = dGeomGetContactAttrs(o1);
+    const dGeomContactAttrs *a2 = dGeomGetContactAttrs(o2);
+    dBodyID b1 = dGeomGetBody(o1);
+    dBodyID b2 = dGeomGetBody(o2);
+
+    dContactGeom c[max_contacts];
+    unsigned long long profile_begin = dxProfileBegin(group_info->world);
+    int n = dCollide(o1, o2, group_info->max_contact_num < max_contacts ? group_info->max_contact_num : max_contacts,
+        c, sizeof(dContactGeom));
+    if (profile_begin)
+    {
+        dxProfileEnd(group_info->world, dProfileNarrowphase, profile_begin);
+        profile_begin = n > 0 ? dxProfileBegin(group_info->world) : 0;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        dContact contact = {};
+        contact.surface.mode = dContactApprox1;
+        if (!group_info->use_max_force_contact)
+            contact.surface.mu = a1->friction < a2->friction ? a1->friction : a2->friction;
+        else
+            contact.surface.mu = a1->max_friction < a2->max_friction ? a1->max_friction : a2->max_friction;
+
+        // mu2 is ignored..
+        contact.surface.bounce = a1->bounce < a2->bounce ? a1->bounce : a2->bounce;
+
+        if (group_info->use_soft_contact)
+        {
+            contact.surface.soft_cfm = group_info->soft_cfm;
+            contact.surface.soft_erp = group_info->soft_erp;
+            contact.surface.mode |= dContactSoftCFM | dContactSoftERP;
+        }
+
+        contact.geom = c[i];
+        dJointID joint;
+        if (group_info->use_max_force_contact)
+            joint = dJointCreateContactMaxForce(group_info->world, group_info->group, &contact);
+        else
+            joint = dJointCreateContact(group_info->world, group_info->group, &contact);
+        dJointAttach(joint, b1, b2);
+    }
+    dxProfileEnd(group_info->world, dProfileContacts, profile_begin);
+}
@@ -273,6 +273,15 @@ static void setAllColliders (int i, dColliderFn *fn)
 	colliders_initialized = 0;
 }
 
+bool dHasCollider (int class1, int class2)
+{
+	dIASSERT( colliders_initialized );
+	dAASSERT( class1 >= 0 && class1 < dGeomNumClasses );
+	dAASSERT( class2 >= 0 && class2 < dGeomNumClasses );
+
+	return colliders[class1][class2].fn != 0;
+}
+
 void dSetColliderOverride (int i, int j, dColliderFn *fn)
 {
 	dIASSERT( colliders_initialized );
@@ -376,8 +385,13 @@ dxGeom::dxGeom (dSpaceID _space, int is_placeable)
     // std::cout<<"!"<<parent_space<<std::endl;
     dSpaceAdd (_space,this);
   }
-  // Add by Zhenhua Song
-  // ignore_geom_cnt = 0;
+  contact_attrs.friction = REAL(0.8);
+  contact_attrs.bounce = 0;
+  contact_attrs.max_friction = dInfinity;
+  contact_attrs.collidable = 1;
+  contact_attrs.character_self_collide = 1;
+  contact_attrs.num_ignore_geoms = 0;
+  memset(contact_attrs.ignore_geoms, 0, sizeof(contact_attrs.ignore_geoms));
 }
 
 
@@ -388,6 +402,7 @@ dxGeom::~dxGeom()
      dFreePosr(final_posr);
    if (offset_posr) dFreePosr(offset_posr);
    bodyRemove();
+   if (pair_table) dCharacterPairTableDestroy (pair_table);
 }
 
 unsigned dxGeom::getParentSpaceTLSKind() const
@@ -484,22 +499,22 @@ void dxGeom::computePosr()
   dIASSERT(offset_posr);  
   dIASSERT(body);
   
-  dMultiply0_331 (final_posr->pos,body->posr.R,offset_posr->pos);
-  final_posr->pos[0] += body->posr.pos[0];
-  final_posr->pos[1] += body->posr.pos[1];
-  final_posr->pos[2] += body->posr.pos[2];
-  dMultiply0_333 (final_posr->R,body->posr.R,offset_posr->R);
+  dMultiply0_331 (final_posr->pos,body->posr->R,offset_posr->pos);
+  final_posr->pos[0] += body->posr->pos[0];
+  final_posr->pos[1] += body->posr->pos[1];
+  final_posr->pos[2] += body->posr->pos[2];
+  dMultiply0_333 (final_posr->R,body->posr->R,offset_posr->R);
 }
 
 // add by Yulong Zhang
 void dxGeom::computePosr2Copy(dxPosR *tar_posr){
   if (!(gflags & GEOM_POSR_BAD))
     return;
-  dMultiply0_331 (tar_posr->pos, body->posr.R, offset_posr->pos);
-  tar_posr->pos[0] += body->posr.pos[0];
-  tar_posr->pos[1] += body->posr.pos[1];
-  tar_posr->pos[2] += body->posr.pos[2];
-  dMultiply0_333 (tar_posr->R, body->posr.R, offset_posr->R);
+  dMultiply0_331 (tar_posr->pos, body->posr->R, offset_posr->pos);
+  tar_posr->pos[0] += body->posr->pos[0];
+  tar_posr->pos[1] += body->posr->pos[1];
+  tar_posr->pos[2] += body->posr->pos[2];
+  dMultiply0_333 (tar_posr->R, body->posr->R, offset_posr->R);
 }
 
 bool dxGeom::controlGeometry(int controlClass, int controlCode, void *dataValue, int *dataSize)
@@ -541,6 +556,14 @@ void *dGeomGetData (dxGeom *g)
 }
 
 
+void dxBodyPosrMoved (dxBody *b, dxPosR *old_posr)
+{
+  for (dxGeom *g = b->geom; g; g = g->body_next) {
+    if (g->final_posr == old_posr) g->final_posr = b->posr;
+  }
+}
+
+
 void dGeomSetBody (dxGeom *g, dxBody *b)
 {
   dAASSERT (g);
@@ -554,7 +577,7 @@ void dGeomSetBody (dxGeom *g, dxBody *b)
         dFreePosr(g->offset_posr);
         g->offset_posr = 0;
       }
-      g->final_posr = &b->posr;
+      g->final_posr = b->posr;
       g->bodyRemove();
       g->bodyAdd (b);
     }
@@ -572,8 +595,8 @@ void dGeomSetBody (dxGeom *g, dxBody *b)
       else
       {
         g->final_posr = dAllocPosr();
-        memcpy (g->final_posr->pos,g->body->posr.pos,sizeof(dVector3));
-        memcpy (g->final_posr->R,g->body->posr.R,sizeof(dMatrix3));
+        memcpy (g->final_posr->pos,g->body->posr->pos,sizeof(dVector3));
+        memcpy (g->final_posr->R,g->body->posr->R,sizeof(dMatrix3));
       }
       g->bodyRemove();
     }
@@ -599,7 +622,7 @@ void dGeomSetPosition (dxGeom *g, dReal x, dReal y, dReal z)
   if (g->offset_posr) {
     // move body such that body+offset = position
 	dVector3 world_offset;
-	dMultiply0_331(world_offset, g->body->posr.R, g->offset_posr->pos);
+	dMultiply0_331(world_offset, g->body->posr->R, g->offset_posr->pos);
 	dBodySetPosition(g->body,
 	    x - world_offset[0],
 	    y - world_offset[1],
@@ -1087,7 +1110,7 @@ void dGeomCreateOffset (dxGeom *g)
   {
 	return; // already created
   }
-  dIASSERT (g->final_posr == &g->body->posr);
+  dIASSERT (g->final_posr == g->body->posr);
   
   g->final_posr = dAllocPosr();
   g->offset_posr = dAllocPosr();
@@ -1171,7 +1194,7 @@ void dGeomSetOffsetWorldRotation (dxGeom *g, const dMatrix3 R)
   memcpy(new_final_posr.pos, g->final_posr->pos, sizeof(dVector3));
   memcpy(new_final_posr.R, R, sizeof(dMatrix3));
   
-  getWorldOffsetPosr(g->body->posr, new_final_posr, *g->offset_posr);
+  getWorldOffsetPosr(*g->body->posr, new_final_posr, *g->offset_posr);
   dGeomMoved (g);
 }
 
@@ -1192,7 +1215,7 @@ void dGeomSetOffsetWorldQuaternion (dxGeom *g, const dQuaternion quat)
   memcpy(new_final_posr.pos, g->final_posr->pos, sizeof(dVector3));
   dQtoR (quat, new_final_posr.R);
   
-  getWorldOffsetPosr(g->body->posr, new_final_posr, *g->offset_posr);
+  getWorldOffsetPosr(*g->body->posr, new_final_posr, *g->offset_posr);
   dGeomMoved (g);
 }
 
@@ -1208,7 +1231,7 @@ void dGeomClearOffset(dxGeom *g)
 	g->offset_posr = 0;
     // the geom will now share the position of the body
     dFreePosr(g->final_posr);
-    g->final_posr = &g->body->posr;
+    g->final_posr = g->body->posr;
     // geom has moved
     g->gflags &= ~GEOM_POSR_BAD;
     dGeomMoved (g);
@@ -1319,6 +1342,33 @@ int dGeomIsPlaceable(dxGeom * g)
     return g->gflags & GEOM_PLACEABLE;
 }
 
+dGeomContactAttrs *dGeomGetContactAttrs(dxGeom* g)
+{
+    dAASSERT (g);
+    return &g->contact_attrs;
+}
+
+// Add by Zhenhua Song
+int dGeomAppendIgnore(dxGeom* now_id, dxGeom* other_id)
+{
+    dAASSERT (now_id);
+    dGeomContactAttrs &attrs = now_id->contact_attrs;
+    if (attrs.num_ignore_geoms >= dGEOM_MAX_IGNORE_GEOMS) return 0;
+    attrs.ignore_geoms[attrs.num_ignore_geoms++] = other_id;
+    return 1;
+}
+
+// Add by Zhenhua Song
+int dGeomIsIgnore(dxGeom* now_id, dxGeom* other_id)
+{
+    dAASSERT (now_id);
+    const dGeomContactAttrs &attrs = now_id->contact_attrs;
+    for (int i = 0; i < attrs.num_ignore_geoms; i++) {
+        if (attrs.ignore_geoms[i] == other_id) return 1;
+    }
+    return 0;
+}
+
 // Add by Zhenhua Song
 int dGeomGetCharacterID(dxGeom* g)
 {
@@ -1347,6 +1397,77 @@ void dGeomSetIndex(dxGeom* g, int index)
     g->geom_index = index;
 }
 
+dxCharacterPairTable* dCharacterPairTableCreate(int num_geoms)
+{
+    dAASSERT (num_geoms >= 0);
+    dxCharacterPairTable* table = (dxCharacterPairTable*) dAlloc(sizeof(dxCharacterPairTable));
+    table->num_geoms = num_geoms;
+    table->row_bytes = (num_geoms + 7) >> 3;
+    table->ref_count = 1;
+    size_t size = (size_t)num_geoms * table->row_bytes;
+    table->bits = size ? (unsigned char*) dAlloc(size) : NULL;
+    if (size) memset(table->bits, 0xff, size);
+    return table;
+}
+
+void dCharacterPairTableDestroy(dxCharacterPairTable* table)
+{
+    dAASSERT (table);
+    if (--table->ref_count > 0)
+        return;
+    if (table->bits)
+        dFree(table->bits, (size_t)table->num_geoms * table->row_bytes);
+    dFree(table, sizeof(dxCharacterPairTable));
+}
+
+int dCharacterPairTableGetNumGeoms(dxCharacterPairTable* table)
+{
+    dAASSERT (table);
+    return table->num_geoms;
+}
+
+void dCharacterPairTableSetPair(dxCharacterPairTable* table, int i, int j, int allowed)
+{
+    dAASSERT (table);
+    dUASSERT (i >= 0 && j >= 0 && i < table->num_geoms && j < table->num_geoms, "geom index out of range");
+    unsigned char* row_i = table->bits + (size_t)i * table->row_bytes;
+    unsigned char* row_j = table->bits + (size_t)j * table->row_bytes;
+    if (allowed) {
+        row_i[j >> 3] |= (unsigned char)(1 << (j & 7));
+        row_j[i >> 3] |= (unsigned char)(1 << (i & 7));
+    } else {
+        row_i[j >> 3] &= (unsigned char)~(1 << (j & 7));
+        row_j[i >> 3] &= (unsigned char)~(1 << (i & 7));
+    }
+}
+
+int dCharacterPairTableGetPair(dxCharacterPairTable* table, int i, int j)
+{
+    dAASSERT (table);
+    return table->allowed(i, j);
+}
+
+void dCharacterPairTableSetAll(dxCharacterPairTable* table, int allowed)
+{
+    dAASSERT (table);
+    size_t size = (size_t)table->num_geoms * table->row_bytes;
+    if (size) memset(table->bits, allowed ? 0xff : 0, size);
+}
+
+void dGeomSetCharacterPairTable(dxGeom* g, dxCharacterPairTable* table)
+{
+    dAASSERT (g);
+    if (table) table->ref_count++;
+    if (g->pair_table) dCharacterPairTableDestroy(g->pair_table);
+    g->pair_table = table;
+}
+
+dxCharacterPairTable* dGeomGetCharacterPairTable(dxGeom* g)
+{
+    dAASSERT (g);
+    return g->pair_table;
+}
+
 // Add by Zhenhua Song, for visualize in Long Ge's draw stuff framework
 void dGeomRenderGetUserColor(dxGeom * g, dReal * result)
 {
@@ -112,16 +112,16 @@ struct dxGeom : public dBase {
   dReal aabb[6];	// cached AABB for this space
   unsigned long category_bits,collide_bits;
 
-  // Add by Zhenhua Song
-  //dxGeom* ignore_geom_id[MAX_GEOM_IGNORE_COUNT];
-
-  // Add by Zhenhua Song
-  //int ignore_geom_cnt;
+  // friction, bounce and ignored geoms used by the near callback of the bindings
+  dGeomContactAttrs contact_attrs;
 
   // Add by Zhenhua Song
   int character_id = -1;
   int geom_index = 0;
 
+  // geom pairs of the same character allowed to collide, indexed by geom_index
+  dxCharacterPairTable *pair_table = 0;
+
   // Add by Zhenhua Song, for visualize color in Long Ge's drawstuff framework
   int render_by_default_color = 1;
   dVector3 render_user_color = {0, 0, 0, 0};
@@ -201,6 +201,30 @@ struct dxGeom : public dBase {
   void bodyRemove();
 };
 
+//****************************************************************************
+// symmetric bit matrix of the geom pairs of one character that may collide.
+// it is shared by the geoms of the character and reference counted, so it
+// lives as long as the last geom or handle using it.
+
+struct dxCharacterPairTable {
+  int num_geoms;
+  int row_bytes;
+  int ref_count;
+  unsigned char *bits;
+
+  int allowed (int i, int j) const {
+    if (i < 0 || j < 0 || i >= num_geoms || j >= num_geoms) return 1;
+    return (bits[i * row_bytes + (j >> 3)] >> (j & 7)) & 1;
+  }
+};
+
+// return 1 if both geoms share a pair table which excludes their pair
+static inline int dxGeomPairExcluded (const dxGeom *g1, const dxGeom *g2)
+{
+  return g1->pair_table && g1->pair_table == g2->pair_table &&
+    !g1->pair_table->allowed (g1->geom_index, g2->geom_index);
+}
+
 //****************************************************************************
 // the base space class
 //
@@ -270,9 +294,25 @@ struct dxSpace : public dxGeom {
 
 void dInitColliders();
 void dFinitColliders();
+// true if dCollide has a collider for geoms of the two classes
+bool dHasCollider (int class1, int class2);
 
 void dClearPosrCache(void);
 void dFinitUserClasses();
 
+// adaptive level state of a hash space (dHashSpaceSetAutoLevels), saved and
+// restored by world snapshots so the levels of the next collide match.
+#define dHASH_SPACE_AUTO_LEVELS 32
+
+struct dxHashSpaceLevelState {
+  int minlevel, maxlevel;
+  int auto_levels;
+  int level_hist_frames;
+  dReal level_hist[dHASH_SPACE_AUTO_LEVELS];
+};
+
+void dHashSpaceGetLevelState (dxSpace *space, dxHashSpaceLevelState *state);
+void dHashSpaceSetLevelState (dxSpace *space, const dxHashSpaceLevelState *state);
+
 
 #endif
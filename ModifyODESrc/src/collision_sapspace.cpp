@@ -245,6 +245,9 @@ static void collideGeomsNoAABBs( dxGeom *g1, dxGeom *g2, void *data, dNearCallba
 		return;
 	}
 
+	// pairs of the same character excluded by its pair table
+	if (dxGeomPairExcluded (g1,g2)) return;
+
 	dReal *bounds1 = g1->aabb;
 	dReal *bounds2 = g2->aabb;
 
@@ -35,6 +35,7 @@ spaces
 #include "collision_space_internal.h"
 #include "util.h"
 #include <iostream>
+#include <vector>
 
 #ifdef _MSC_VER
 #pragma warning(disable:4291)  // for VC++, no complaints about "no matching operator delete found"
@@ -366,14 +367,41 @@ static unsigned long getVirtualAddress (int level, int x, int y, int z)
 //****************************************************************************
 // hash space
 
+// levels tracked by the adaptive mode. AABB levels outside of this range are
+// clamped into the first or the last bin.
+#define HASH_AUTO_MIN_LEVEL (-16)
+#define HASH_AUTO_NUM_LEVELS dHASH_SPACE_AUTO_LEVELS
+
+// weight of the previous frames in the running level histogram
+#define HASH_AUTO_DECAY REAL(0.9)
+
+// share of the smallest geoms allowed below the tuned minlevel
+#define HASH_AUTO_MIN_QUANTILE REAL(0.02)
+
 struct dxHashSpace : public dxSpace {
   int global_minlevel;	// smallest hash table level to put AABBs in
   int global_maxlevel;	// objects that need a level larger than this will be
 			// put in a "big objects" list instead of a hash table
 
+  // adaptive levels: running histogram of the levels of finite AABBs
+  int auto_levels;
+  dReal level_hist[HASH_AUTO_NUM_LEVELS];
+  int level_hist_frames;
+
+  // buffers kept between calls of collide(), they only grow
+  std::vector<dxAABB> aabb_buf;
+  std::vector<unsigned char> tested_buf;
+  std::vector<Node*> table_buf;
+  std::vector<Node> node_buf;
+
+  int stats_enabled;		// fill stats in collide(), off by default
+  dHashSpaceStats stats;	// statistics of the last collide()
+
   dxHashSpace (dSpaceID _space);
   void setLevels (int minlevel, int maxlevel);
   void getLevels (int *minlevel, int *maxlevel);
+  void setAutoLevels (int enabled);
+  void updateAutoLevels (const int *level_count, int num_finite);
   void cleanGeoms();
   void collide (void *data, dNearCallback *callback);
   void collide2 (void *data, dxGeom *geom, dNearCallback *callback);
@@ -385,6 +413,11 @@ dxHashSpace::dxHashSpace (dSpaceID _space) : dxSpace (_space)
   type = dHashSpaceClass;
   global_minlevel = -3;
   global_maxlevel = 10;
+  auto_levels = 0;
+  level_hist_frames = 0;
+  for (int i=0; i<HASH_AUTO_NUM_LEVELS; i++) level_hist[i] = 0;
+  stats_enabled = 0;
+  memset (&stats,0,sizeof(stats));
 }
 
 
@@ -403,6 +436,44 @@ void dxHashSpace::getLevels (int *minlevel, int *maxlevel)
 }
 
 
+void dxHashSpace::setAutoLevels (int enabled)
+{
+  auto_levels = (enabled != 0);
+  // start a new history, the levels set by hand are kept until the first collide
+  level_hist_frames = 0;
+  for (int i=0; i<HASH_AUTO_NUM_LEVELS; i++) level_hist[i] = 0;
+}
+
+
+// blend the level counts of this frame into the running histogram, then put
+// minlevel at the level of the smallest geoms (ignoring a few outliers) so
+// that small geoms do not share one big cell, and maxlevel at the largest
+// level still seen, so that only infinite geoms go to the big boxes list.
+void dxHashSpace::updateAutoLevels (const int *level_count, int num_finite)
+{
+  if (num_finite == 0) return;
+
+  dReal decay = level_hist_frames ? HASH_AUTO_DECAY : REAL(0.0);
+  for (int i=0; i<HASH_AUTO_NUM_LEVELS; i++) {
+    level_hist[i] = decay * level_hist[i] +
+      (REAL(1.0) - decay) * (dReal) level_count[i] / (dReal) num_finite;
+  }
+  level_hist_frames++;
+
+  int lo = 0, hi = HASH_AUTO_NUM_LEVELS-1;
+  dReal acc = 0;
+  for (lo = 0; lo < HASH_AUTO_NUM_LEVELS-1; lo++) {
+    acc += level_hist[lo];
+    if (acc > HASH_AUTO_MIN_QUANTILE) break;
+  }
+  // levels seen in the last few dozen frames keep maxlevel up
+  while (hi > lo && level_hist[hi] < REAL(1e-3) / (dReal) num_finite) hi--;
+
+  global_minlevel = HASH_AUTO_MIN_LEVEL + lo;
+  global_maxlevel = HASH_AUTO_MIN_LEVEL + hi;
+}
+
+
 void dxHashSpace::cleanGeoms()
 {
   // compute the AABBs of all dirty geoms, and clear the dirty flags
@@ -435,6 +506,28 @@ void dxHashSpace::collide (void *data, dNearCallback *callback)
   lock_count++;
   cleanGeoms();
 
+  // all the auxiliary information lives in buffers of the space, which are
+  // reused by the next call. make room for every geom up front, so pointers
+  // into aabb_buf stay valid while the lists are built.
+  if ((int) aabb_buf.size() < count) aabb_buf.resize (count);
+
+  // in the adaptive mode, retune the levels from the AABB sizes first
+  if (auto_levels) {
+    int level_count[HASH_AUTO_NUM_LEVELS] = {0};
+    int num_finite = 0;
+    for (geom = first; geom; geom=geom->next) {
+      if (!GEOM_ENABLED(geom)) continue;
+      int level = findLevel (geom->aabb);
+      if (level == MAXINT) continue;
+      level -= HASH_AUTO_MIN_LEVEL;
+      if (level < 0) level = 0;
+      if (level >= HASH_AUTO_NUM_LEVELS) level = HASH_AUTO_NUM_LEVELS-1;
+      level_count[level]++;
+      num_finite++;
+    }
+    updateAutoLevels (level_count,num_finite);
+  }
+
   // create a list of auxiliary information for all geom axis aligned bounding
   // boxes. set the level for all AABBs. put AABBs larger than the space's
   // global_maxlevel in the big_boxes list, check everything else against
@@ -442,6 +535,8 @@ void dxHashSpace::collide (void *data, dNearCallback *callback)
   // level that we need.
 
   int n = 0;			// number of AABBs in main list
+  int num_big = 0;		// number of AABBs in the big_boxes list
+  int num_nodes = 0;		// number of cells covered by the main list
   dxAABB *first_aabb = 0;	// list of AABBs in hash table
   dxAABB *big_boxes = 0;	// list of AABBs too big for hash table
   maxlevel = global_minlevel - 1;
@@ -449,7 +544,7 @@ void dxHashSpace::collide (void *data, dNearCallback *callback)
     if (!GEOM_ENABLED(geom)){
       continue;
     }
-    dxAABB *aabb = (dxAABB*) ALLOCA (sizeof(dxAABB));
+    dxAABB *aabb = &aabb_buf[n + num_big];
     aabb->geom = geom;
     // compute level, but prevent cells from getting too small
     int level = findLevel (geom->aabb);
@@ -465,6 +560,9 @@ void dxHashSpace::collide (void *data, dNearCallback *callback)
       // discretize AABB position to cell size
       for (i=0; i < 6; i++) aabb->dbounds[i] = (int)
 			      floor (geom->aabb[i]/cellsize);
+      num_nodes += (aabb->dbounds[1] - aabb->dbounds[0] + 1) *
+	(aabb->dbounds[3] - aabb->dbounds[2] + 1) *
+	(aabb->dbounds[5] - aabb->dbounds[4] + 1);
       // set AABB index
       aabb->index = n;
       n++;
@@ -474,19 +572,16 @@ void dxHashSpace::collide (void *data, dNearCallback *callback)
       // setting level, dbounds, index, or the maxlevel
       aabb->next = big_boxes;
       big_boxes = aabb;
+      num_big++;
     }
   }
 
   // for `n' objects, an n*n array of bits is used to record if those objects
   // have been intersection-tested against each other yet. this array can
   // grow large with high n, but oh well...
-  /////////////////////
-  // Added by Libin
-  // sometimes n is very large... we have to alloc this array on stack
-  bool flagVeryLargeN = n > 1000;
   int tested_rowsize = (n+7) >> 3;	// number of bytes needed for n bits
-  unsigned char *tested = flagVeryLargeN ? (unsigned char *)malloc(n * tested_rowsize) : (unsigned char *) ALLOCA (n * tested_rowsize);
-  memset (tested,0,n * tested_rowsize);
+  tested_buf.assign ((size_t) n * tested_rowsize,0);
+  unsigned char *tested = tested_buf.empty() ? 0 : &tested_buf[0];
 
   // create a hash table to store all AABBs. each AABB may take up to 8 cells.
   // we use chaining to resolve collisions, but we use a relatively large table
@@ -499,56 +594,31 @@ void dxHashSpace::collide (void *data, dNearCallback *callback)
   if (i >= NUM_PRIMES) i = NUM_PRIMES-1;	// probably pointless
   int sz = prime[i];
 
-  // allocate and initialize hash table node pointers
-  Node **table = flagVeryLargeN ? (Node **) malloc (sizeof(Node*) * sz) : (Node **) ALLOCA (sizeof(Node*) * sz);
-  for (i=0; i<sz; i++) table[i] = 0;
+  // initialize hash table node pointers
+  table_buf.assign (sz,(Node*) 0);
+  Node **table = &table_buf[0];
 
   // add each AABB to the hash table (may need to add it to up to 8 cells)
-  Node *nodeBuf = flagVeryLargeN ? (Node *) malloc (sizeof (Node) * sz) : NULL;
-  Node *nodeBufNext = nodeBuf;
-  if (flagVeryLargeN)
-  {
-      for (aabb=first_aabb; aabb; aabb=aabb->next) {
-        int *dbounds = aabb->dbounds;
-        for (int xi = dbounds[0]; xi <= dbounds[1]; xi++) {
-          for (int yi = dbounds[2]; yi <= dbounds[3]; yi++) {
-	        for (int zi = dbounds[4]; zi <= dbounds[5]; zi++) {
-	          // get the hash index
-	          unsigned long hi = getVirtualAddress (aabb->level,xi,yi,zi) % sz;
-	          // add a new node to the hash table
-	          Node *node = nodeBufNext++;//(Node*) malloc (sizeof (Node));
-	          node->x = xi;
-	          node->y = yi;
-	          node->z = zi;
-	          node->aabb = aabb;
-	          node->next = table[hi];
-	          table[hi] = node;
-	        }
-          }
-        }
-      }
-  }
-  else
-  {
-      for (aabb=first_aabb; aabb; aabb=aabb->next) {
-        int *dbounds = aabb->dbounds;
-        for (int xi = dbounds[0]; xi <= dbounds[1]; xi++) {
-          for (int yi = dbounds[2]; yi <= dbounds[3]; yi++) {
-	        for (int zi = dbounds[4]; zi <= dbounds[5]; zi++) {
-	          // get the hash index
-	          unsigned long hi = getVirtualAddress (aabb->level,xi,yi,zi) % sz;
-	          // add a new node to the hash table
-	          Node *node = (Node*) ALLOCA (sizeof (Node));
-	          node->x = xi;
-	          node->y = yi;
-	          node->z = zi;
-	          node->aabb = aabb;
-	          node->next = table[hi];
-	          table[hi] = node;
-	        }
-          }
-        }
+  if ((int) node_buf.size() < num_nodes) node_buf.resize (num_nodes);
+  Node *nodeBufNext = num_nodes ? &node_buf[0] : 0;
+  for (aabb=first_aabb; aabb; aabb=aabb->next) {
+    int *dbounds = aabb->dbounds;
+    for (int xi = dbounds[0]; xi <= dbounds[1]; xi++) {
+      for (int yi = dbounds[2]; yi <= dbounds[3]; yi++) {
+	for (int zi = dbounds[4]; zi <= dbounds[5]; zi++) {
+	  // get the hash index
+	  unsigned long hi = getVirtualAddress (aabb->level,xi,yi,zi) % sz;
+	  // add a new node to the hash table
+	  Node *node = nodeBufNext++;
+	  node->x = xi;
+	  node->y = yi;
+	  node->z = zi;
+	  node->aabb = aabb;
+	  node->next = table[hi];
+	  table[hi] = node;
+	}
       }
+    }
   }
 
   // now that all AABBs are loaded into the hash table, we do the actual
@@ -556,6 +626,7 @@ void dxHashSpace::collide (void *data, dNearCallback *callback)
   // same cells for collisions, and then check for other AABBs in all
   // intersecting higher level cells.
 
+  int num_tests = 0;
   int db[6];			// discrete bounds at current level
   for (aabb=first_aabb; aabb; aabb=aabb->next) {
     // we are searching for collisions with aabb
@@ -587,6 +658,7 @@ void dxHashSpace::collide (void *data, dNearCallback *callback)
 		dIASSERT (i >= 0 && i < (tested_rowsize*n));
 		if ((tested[i] & mask)==0) {
 		  collideAABBs (aabb->geom,node->aabb->geom,data,callback);
+		  num_tests++;
 		}
 		tested[i] |= mask;
 	      }
@@ -615,14 +687,25 @@ void dxHashSpace::collide (void *data, dNearCallback *callback)
     }
   }
 
-  ///////////////////////////
-  // add by libin
-  // clear stack for very large n
-  if (flagVeryLargeN)
-  {
-      free(tested);
-      free(table);
-      free(nodeBuf);
+  // cell occupancy of this call. walking the buckets costs about as much as
+  // filling the table, so it is only done when someone reads the stats.
+  if (stats_enabled) {
+    memset (&stats,0,sizeof(stats));
+    stats.minlevel = global_minlevel;
+    stats.maxlevel = global_maxlevel;
+    stats.num_aabbs = n;
+    stats.num_big_boxes = num_big;
+    stats.num_nodes = num_nodes;
+    stats.table_size = sz;
+    for (i=0; i<sz; i++) {
+      if (!table[i]) continue;
+      int len = 0;
+      for (Node *node = table[i]; node; node=node->next) len++;
+      stats.used_buckets++;
+      if (len > stats.max_bucket_size) stats.max_bucket_size = len;
+    }
+    stats.num_cell_tests = num_tests;
+    stats.num_big_box_tests = num_big * n + num_big * (num_big - 1) / 2;
   }
 
   lock_count--;
@@ -683,6 +766,78 @@ void dHashSpaceGetLevels (dxSpace *space, int *minlevel, int *maxlevel)
 }
 
 
+void dHashSpaceSetAutoLevels (dxSpace *space, int enabled)
+{
+  dAASSERT (space);
+  dUASSERT (space->type == dHashSpaceClass,"argument must be a hash space");
+  dxHashSpace *hspace = (dxHashSpace*) space;
+  hspace->setAutoLevels (enabled);
+}
+
+
+int dHashSpaceGetAutoLevels (dxSpace *space)
+{
+  dAASSERT (space);
+  dUASSERT (space->type == dHashSpaceClass,"argument must be a hash space");
+  dxHashSpace *hspace = (dxHashSpace*) space;
+  return hspace->auto_levels;
+}
+
+
+void dHashSpaceGetLevelState (dxSpace *space, dxHashSpaceLevelState *state)
+{
+  dAASSERT (space && state);
+  dUASSERT (space->type == dHashSpaceClass,"argument must be a hash space");
+  dxHashSpace *hspace = (dxHashSpace*) space;
+  state->minlevel = hspace->global_minlevel;
+  state->maxlevel = hspace->global_maxlevel;
+  state->auto_levels = hspace->auto_levels;
+  state->level_hist_frames = hspace->level_hist_frames;
+  for (int i=0; i<HASH_AUTO_NUM_LEVELS; i++) state->level_hist[i] = hspace->level_hist[i];
+}
+
+
+void dHashSpaceSetLevelState (dxSpace *space, const dxHashSpaceLevelState *state)
+{
+  dAASSERT (space && state);
+  dUASSERT (space->type == dHashSpaceClass,"argument must be a hash space");
+  dxHashSpace *hspace = (dxHashSpace*) space;
+  hspace->global_minlevel = state->minlevel;
+  hspace->global_maxlevel = state->maxlevel;
+  hspace->auto_levels = state->auto_levels;
+  hspace->level_hist_frames = state->level_hist_frames;
+  for (int i=0; i<HASH_AUTO_NUM_LEVELS; i++) hspace->level_hist[i] = state->level_hist[i];
+}
+
+
+void dHashSpaceSetStatsEnabled (dxSpace *space, int enabled)
+{
+  dAASSERT (space);
+  dUASSERT (space->type == dHashSpaceClass,"argument must be a hash space");
+  dxHashSpace *hspace = (dxHashSpace*) space;
+  hspace->stats_enabled = (enabled != 0);
+  memset (&hspace->stats,0,sizeof(hspace->stats));
+}
+
+
+int dHashSpaceGetStatsEnabled (dxSpace *space)
+{
+  dAASSERT (space);
+  dUASSERT (space->type == dHashSpaceClass,"argument must be a hash space");
+  dxHashSpace *hspace = (dxHashSpace*) space;
+  return hspace->stats_enabled;
+}
+
+
+void dHashSpaceGetStats (dxSpace *space, dHashSpaceStats *stats)
+{
+  dAASSERT (space && stats);
+  dUASSERT (space->type == dHashSpaceClass,"argument must be a hash space");
+  dxHashSpace *hspace = (dxHashSpace*) space;
+  *stats = hspace->stats;
+}
+
+
 void dSpaceDestroy (dxSpace *space)
 {
   dAASSERT (space);
@@ -60,6 +60,9 @@ static inline void collideAABBs (dxGeom *g1, dxGeom *g2,
     return;
   }
 
+  // pairs of the same character excluded by its pair table
+  if (dxGeomPairExcluded (g1,g2)) return;
+
   // if the bounding boxes are disjoint then don't do anything
   dReal *bounds1 = g1->aabb;
   dReal *bounds2 = g2->aabb;
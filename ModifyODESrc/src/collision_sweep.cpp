@@ -0,0 +1,232 @@
+// Conservative advancement for bodies flagged with dBodySetFastMoving.
+// A fast body whose linear motion in the coming step is longer than its own
+// thickness is swept along lvel * stepsize against the geoms of the space.
+// If the sweep hits something, the body is advanced to the first penetrating
+// pose, so the following dSpaceCollide() creates the contacts that would
+// otherwise be skipped (tunneling through thin geoms). lvel is kept, the contact
+// joints resolve the impact, and the step only integrates the linear motion over
+// the part of the step left after the time of impact (dxBody::sweep_step_scale).
+
+#include <ode/common.h>
+#include <ode/objects.h>
+#include <ode/collision.h>
+#include <ode/collision_space.h>
+#include <ode/odemath.h>
+#include "config.h"
+#include "objects.h"
+#include "collision_kernel.h"
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    // number of bisection steps used to refine the time of impact
+    const int SWEEP_REFINE_STEPS = 4;
+
+    struct dxSweepContext
+    {
+        dxBody* body;
+        dReal sweep_aabb[6];
+        void* data;
+        dSweepFilterFn* filter;
+        std::vector<dxGeom*> fast_geoms;
+        std::vector<std::pair<dxGeom*, dxGeom*> > pairs;
+    };
+
+    bool aabbOverlap(const dReal* a, const dReal* b)
+    {
+        return !(a[0] > b[1] || a[1] < b[0] || a[2] > b[3] || a[3] < b[2] || a[4] > b[5] || a[5] < b[4]);
+    }
+
+    bool bitsMatch(const dxGeom* g1, const dxGeom* g2)
+    {
+        return (g1->category_bits & g2->collide_bits) || (g2->category_bits & g1->collide_bits);
+    }
+
+    void collectCandidates(dxSweepContext& ctx, dxSpace* space)
+    {
+        for (dxGeom* g = space->first; g != NULL; g = g->next)
+        {
+            if ((g->gflags & GEOM_ENABLE_TEST_MASK) != GEOM_ENABLE_TEST_VALUE)
+            {
+                continue;
+            }
+            if (IS_SPACE(g))
+            {
+                collectCandidates(ctx, (dxSpace*)g);
+                continue;
+            }
+            if (g->body == ctx.body)
+            {
+                continue;
+            }
+            if (g->body != NULL && dAreConnected(ctx.body, g->body))
+            {
+                continue;
+            }
+            g->recomputeAABB();
+            if (!aabbOverlap(g->aabb, ctx.sweep_aabb))
+            {
+                continue;
+            }
+            for (size_t i = 0; i < ctx.fast_geoms.size(); i++)
+            {
+                dxGeom* f = ctx.fast_geoms[i];
+                if (!bitsMatch(f, g))
+                {
+                    continue;
+                }
+                if (ctx.filter != NULL && !ctx.filter(ctx.data, f, g))
+                {
+                    continue;
+                }
+                ctx.pairs.push_back(std::make_pair(f, g));
+            }
+        }
+    }
+
+    // Check whether any candidate pair penetrates at the current body pose.
+    bool anyPenetration(const dxSweepContext& ctx)
+    {
+        dContactGeom c;
+        for (size_t i = 0; i < ctx.pairs.size(); i++)
+        {
+            if (dCollide(ctx.pairs[i].first, ctx.pairs[i].second, 1, &c, sizeof(dContactGeom)) > 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void setBodyPos(dxBody* b, const dVector3 p0, const dVector3 d, dReal t)
+    {
+        dBodySetPosition(b, p0[0] + t * d[0], p0[1] + t * d[1], p0[2] + t * d[2]);
+    }
+
+    bool sweepBody(dxBody* b, dxSpace* space, dReal stepsize, void* data, dSweepFilterFn* filter)
+    {
+        dVector3 d = { b->lvel[0] * stepsize, b->lvel[1] * stepsize, b->lvel[2] * stepsize };
+        dReal len = dSqrt(dCalcVectorDot3(d, d));
+
+        dxSweepContext ctx;
+        ctx.body = b;
+        ctx.data = data;
+        ctx.filter = filter;
+
+        // the thinnest half extent of the body's geoms bounds the step of the sweep.
+        dReal radius = dInfinity;
+        for (dxGeom* g = b->geom; g != NULL; g = g->body_next)
+        {
+            if ((g->gflags & GEOM_ENABLE_TEST_MASK) != GEOM_ENABLE_TEST_VALUE || g->parent_space == NULL)
+            {
+                continue;
+            }
+            g->recomputeAABB();
+            for (int k = 0; k < 3; k++)
+            {
+                dReal half = REAL(0.5) * (g->aabb[2 * k + 1] - g->aabb[2 * k]);
+                if (half < radius) radius = half;
+            }
+            ctx.fast_geoms.push_back(g);
+        }
+        if (ctx.fast_geoms.empty() || !(radius > 0) || len <= radius)
+        {
+            return false;
+        }
+
+        // swept AABB of the body's geoms over the step
+        for (int k = 0; k < 3; k++)
+        {
+            ctx.sweep_aabb[2 * k] = dInfinity;
+            ctx.sweep_aabb[2 * k + 1] = -dInfinity;
+        }
+        for (size_t i = 0; i < ctx.fast_geoms.size(); i++)
+        {
+            const dReal* aabb = ctx.fast_geoms[i]->aabb;
+            for (int k = 0; k < 3; k++)
+            {
+                ctx.sweep_aabb[2 * k] = std::min(ctx.sweep_aabb[2 * k], std::min(aabb[2 * k], aabb[2 * k] + d[k]));
+                ctx.sweep_aabb[2 * k + 1] = std::max(ctx.sweep_aabb[2 * k + 1], std::max(aabb[2 * k + 1], aabb[2 * k + 1] + d[k]));
+            }
+        }
+        collectCandidates(ctx, space);
+        if (ctx.pairs.empty())
+        {
+            return false;
+        }
+
+        // pairs already touching at the start of the step are handled by the normal contacts
+        dContactGeom c;
+        size_t n_pairs = 0;
+        for (size_t i = 0; i < ctx.pairs.size(); i++)
+        {
+            if (dCollide(ctx.pairs[i].first, ctx.pairs[i].second, 1, &c, sizeof(dContactGeom)) == 0)
+            {
+                ctx.pairs[n_pairs++] = ctx.pairs[i];
+            }
+        }
+        ctx.pairs.resize(n_pairs);
+        if (ctx.pairs.empty())
+        {
+            return false;
+        }
+
+        dVector3 p0;
+        dCopyVector3(p0, b->posr->pos);
+        int num_samples = (int)dCeil(len / (REAL(0.5) * radius));
+        dReal t_free = 0, t_hit = -1;
+        for (int i = 1; i <= num_samples; i++)
+        {
+            dReal t = (dReal)i / num_samples;
+            setBodyPos(b, p0, d, t);
+            if (anyPenetration(ctx))
+            {
+                t_hit = t;
+                break;
+            }
+            t_free = t;
+        }
+        if (t_hit < 0)
+        {
+            setBodyPos(b, p0, d, 0);
+            return false;
+        }
+
+        for (int i = 0; i < SWEEP_REFINE_STEPS; i++)
+        {
+            dReal t = REAL(0.5) * (t_free + t_hit);
+            setBodyPos(b, p0, d, t);
+            if (anyPenetration(ctx))
+            {
+                t_hit = t;
+            }
+            else
+            {
+                t_free = t;
+            }
+        }
+        setBodyPos(b, p0, d, t_hit);
+        b->sweep_step_scale = 1 - t_hit;
+        return true;
+    }
+}
+
+int dSpaceSweepFastBodies(dSpaceID space, dWorldID w, dReal stepsize, void* data, dSweepFilterFn* filter)
+{
+    dAASSERT(space && w);
+    dUASSERT(dGeomIsSpace(space), "argument not a space");
+    int advanced = 0;
+    for (dxBody* b = w->firstbody; b != NULL; b = (dxBody*)b->next)
+    {
+        if ((b->flags & (dxBodyFastMoving | dxBodyDisabled)) != dxBodyFastMoving)
+        {
+            continue;
+        }
+        if (sweepBody(b, space, stepsize, data, filter))
+        {
+            advanced++;
+        }
+    }
+    return advanced;
+}
@@ -107,6 +107,10 @@ void dGeomTriMeshDataPreprocess(dTriMeshDataID g) { }
 void dGeomTriMeshDataGetBuffer(dTriMeshDataID g, unsigned char** buf, int* bufLen) { *buf = NULL; *bufLen=0; }
 void dGeomTriMeshDataSetBuffer(dTriMeshDataID g, unsigned char* buf) {}
 
+size_t dGeomTriMeshDataGetSerializedSize(dTriMeshDataID g) { return 0; }
+size_t dGeomTriMeshDataSerialize(dTriMeshDataID g, void* buffer, size_t bufferSize) { return 0; }
+int dGeomTriMeshDataBuildFromSerialized(dTriMeshDataID g, const void* blob, size_t blobSize) { return 0; }
+
 void dGeomTriMeshSetCallback(dGeomID g, dTriCallback* Callback) { }
 dTriCallback* dGeomTriMeshGetCallback(dGeomID g) { return 0; }
 
@@ -190,7 +190,7 @@ inline TrimeshCollidersCache *GetTrimeshCollidersCache(unsigned uiTLSKind)
 
 inline TrimeshCollidersCache *GetTrimeshCollidersCache(unsigned uiTLSKind)
 {
-	extern TrimeshCollidersCache g_ccTrimeshCollidersCache;
+	extern thread_local TrimeshCollidersCache g_ccTrimeshCollidersCache;
 
 	return &g_ccTrimeshCollidersCache;
 }
@@ -241,6 +241,15 @@ struct dxTriMeshData  : public dBase
 	// data for use in collision resolution
 	const void* Normals;
 	uint8* UseFlags;
+
+	// save / load a built mesh as one flat blob
+	// (see dGeomTriMeshDataSerialize). Loaded data points into the blob.
+	size_t GetSerializedSize() const;
+	size_t Serialize(void* Buffer, size_t BufferSize) const;
+	bool BuildFromSerialized(const void* Buffer, size_t BufferSize);
+
+	bool Single;             // vertex data is float (true) or double (false)
+	bool ExternalUseFlags;   // UseFlags is borrowed from a blob, don't free it
 #endif  // dTRIMESH_OPCODE
 
 #if dTRIMESH_GIMPACT
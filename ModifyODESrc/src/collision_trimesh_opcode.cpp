@@ -69,7 +69,7 @@ void TrimeshCollidersCache::InitOPCODECaches()
 
 
 // Trimesh data
-dxTriMeshData::dxTriMeshData() : UseFlags( NULL )
+dxTriMeshData::dxTriMeshData() : UseFlags( NULL ), Single( false ), ExternalUseFlags( false )
 {
 #if !dTRIMESH_ENABLED
   dUASSERT(false, "dTRIMESH_ENABLED is not defined. Trimesh geoms will not work");
@@ -78,7 +78,7 @@ dxTriMeshData::dxTriMeshData() : UseFlags( NULL )
 
 dxTriMeshData::~dxTriMeshData()
 {
-	if ( UseFlags )
+	if ( UseFlags && !ExternalUseFlags )
 		delete [] UseFlags;
 }
 
@@ -95,6 +95,7 @@ dxTriMeshData::Build(const void* Vertices, int VertexStide, int VertexCount,
     Mesh.SetPointers((IndexedTriangle*)Indices, (Point*)Vertices);
     Mesh.SetStrides(TriStride, VertexStide);
     Mesh.SetSingle(Single);
+    this->Single = Single;
     
     // Build tree
     BuildSettings Settings;
@@ -161,6 +162,7 @@ dxTriMeshData::Build(const void* Vertices, int VertexStide, int VertexCount,
     Normals = (dReal *) in_Normals;
 
 	UseFlags = 0;
+	ExternalUseFlags = false;
 
 #endif // dTRIMESH_ENABLED
 }
@@ -528,6 +530,205 @@ void dGeomTriMeshDataSetBuffer(dTriMeshDataID g, unsigned char* buf)
 }
 
 
+// Serialized trimesh data. Every section is stored packed (3 coordinates per
+// vertex, 3 indices per triangle) at a 16 byte aligned offset from the start
+// of the blob, and the OPCODE no-leaf nodes only hold relative links, so the
+// blob can be used in place from any address (e.g. a read-only file mapping).
+enum
+{
+	TRIMESH_BLOB_MAGIC = 0x4d54444f, // "ODTM"
+	TRIMESH_BLOB_VERSION = 1,
+	TRIMESH_BLOB_ALIGN = 16,
+};
+
+struct dxTriMeshBlobHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	uint32 HeaderSize;
+	uint32 CoordSize;        // 4 (float) or 8 (double)
+	uint32 IndexSize;        // sizeof(dTriIndex)
+	uint32 NodeSize;         // sizeof(AABBNoLeafNode), differs between 32/64 bit builds
+	uint32 VertexCount;
+	uint32 TriangleCount;
+	uint32 NodeCount;
+	uint32 HasUseFlags;
+	uint32 VertexOffset;
+	uint32 IndexOffset;
+	uint32 NodeOffset;
+	uint32 UseFlagsOffset;
+	uint32 TotalSize;
+	uint32 Reserved;
+	double AABBCenter[3];
+	double AABBExtents[3];
+};
+
+static inline size_t TriMeshBlobAlign(size_t Offset)
+{
+	return (Offset + TRIMESH_BLOB_ALIGN - 1) & ~size_t(TRIMESH_BLOB_ALIGN - 1);
+}
+
+// Fill the section offsets of Header from its counts, return the total size
+static size_t TriMeshBlobLayout(dxTriMeshBlobHeader& Header)
+{
+	size_t Offset = TriMeshBlobAlign(sizeof(dxTriMeshBlobHeader));
+	Header.VertexOffset = (uint32)Offset;
+	Offset = TriMeshBlobAlign(Offset + (size_t)Header.VertexCount * 3 * Header.CoordSize);
+	Header.IndexOffset = (uint32)Offset;
+	Offset = TriMeshBlobAlign(Offset + (size_t)Header.TriangleCount * 3 * Header.IndexSize);
+	Header.NodeOffset = (uint32)Offset;
+	Offset = TriMeshBlobAlign(Offset + (size_t)Header.NodeCount * Header.NodeSize);
+	Header.UseFlagsOffset = (uint32)Offset;
+	Offset += Header.HasUseFlags ? (size_t)Header.TriangleCount : 0;
+	return TriMeshBlobAlign(Offset);
+}
+
+static void TriMeshBlobFillHeader(const dxTriMeshData* Data, dxTriMeshBlobHeader& Header)
+{
+	memset(&Header, 0, sizeof(Header));
+	Header.Magic = TRIMESH_BLOB_MAGIC;
+	Header.Version = TRIMESH_BLOB_VERSION;
+	Header.HeaderSize = sizeof(dxTriMeshBlobHeader);
+	Header.CoordSize = Data->Single ? sizeof(float) : sizeof(double);
+	Header.IndexSize = sizeof(dTriIndex);
+	Header.NodeSize = sizeof(AABBNoLeafNode);
+	Header.VertexCount = Data->Mesh.GetNbVertices();
+	Header.TriangleCount = Data->Mesh.GetNbTriangles();
+	Header.NodeCount = Data->BVTree.HasSingleNode() ? 0 : Data->BVTree.GetNbNodes();
+	Header.HasUseFlags = Data->UseFlags != NULL;
+	for (int i = 0; i < 3; i++)
+	{
+		Header.AABBCenter[i] = Data->AABBCenter[i];
+		Header.AABBExtents[i] = Data->AABBExtents[i];
+	}
+}
+
+size_t dxTriMeshData::GetSerializedSize() const
+{
+	// Only the tree layout built in Build() can be exported
+	if (Mesh.GetNbTriangles() == 0 || (!BVTree.HasSingleNode() && (BVTree.HasLeafNodes() || BVTree.IsQuantized())))
+		return 0;
+
+	dxTriMeshBlobHeader Header;
+	TriMeshBlobFillHeader(this, Header);
+	size_t Total = TriMeshBlobLayout(Header);
+	// Offsets are stored as 32 bit values
+	return Total <= 0xffffffffu ? Total : 0;
+}
+
+size_t dxTriMeshData::Serialize(void* Buffer, size_t BufferSize) const
+{
+	size_t Total = GetSerializedSize();
+	if (Total == 0 || Buffer == NULL || BufferSize < Total)
+		return 0;
+
+	dxTriMeshBlobHeader Header;
+	TriMeshBlobFillHeader(this, Header);
+	TriMeshBlobLayout(Header);
+	Header.TotalSize = (uint32)Total;
+
+	char* Blob = (char*)Buffer;
+	memset(Blob, 0, Total);
+	memcpy(Blob, &Header, sizeof(Header));
+
+	// vertices, packed to 3 coordinates
+	const char* SrcVerts = (const char*)Mesh.GetVerts();
+	const size_t CoordBytes = 3 * Header.CoordSize;
+	for (uint32 i = 0; i < Header.VertexCount; i++)
+		memcpy(Blob + Header.VertexOffset + i * CoordBytes, SrcVerts + (size_t)i * Mesh.GetVertexStride(), CoordBytes);
+
+	// indices, packed to 3 per triangle
+	const char* SrcTris = (const char*)Mesh.GetTris();
+	const size_t TriBytes = 3 * sizeof(dTriIndex);
+	for (uint32 i = 0; i < Header.TriangleCount; i++)
+		memcpy(Blob + Header.IndexOffset + i * TriBytes, SrcTris + (size_t)i * Mesh.GetTriStride(), TriBytes);
+
+	if (Header.NodeCount > 0)
+	{
+		const AABBNoLeafTree* Tree = (const AABBNoLeafTree*)BVTree.GetTree();
+		memcpy(Blob + Header.NodeOffset, Tree->GetNodes(), (size_t)Header.NodeCount * sizeof(AABBNoLeafNode));
+	}
+
+	if (Header.HasUseFlags)
+		memcpy(Blob + Header.UseFlagsOffset, UseFlags, Header.TriangleCount);
+
+	return Total;
+}
+
+bool dxTriMeshData::BuildFromSerialized(const void* Buffer, size_t BufferSize)
+{
+	const char* Blob = (const char*)Buffer;
+	if (Blob == NULL || BufferSize < sizeof(dxTriMeshBlobHeader) || ((size_t)Blob & (sizeof(size_t) - 1)) != 0)
+		return false;
+
+	dxTriMeshBlobHeader Header;
+	memcpy(&Header, Blob, sizeof(Header));
+	if (Header.Magic != TRIMESH_BLOB_MAGIC || Header.Version != TRIMESH_BLOB_VERSION ||
+		Header.HeaderSize != sizeof(dxTriMeshBlobHeader) ||
+		(Header.CoordSize != sizeof(float) && Header.CoordSize != sizeof(double)) ||
+		Header.IndexSize != sizeof(dTriIndex) || Header.NodeSize != sizeof(AABBNoLeafNode) ||
+		Header.TotalSize > BufferSize || Header.TriangleCount == 0)
+		return false;
+
+	// the stored offsets must agree with the counts
+	dxTriMeshBlobHeader Expected = Header;
+	if (TriMeshBlobLayout(Expected) != Header.TotalSize ||
+		Expected.VertexOffset != Header.VertexOffset || Expected.IndexOffset != Header.IndexOffset ||
+		Expected.NodeOffset != Header.NodeOffset || Expected.UseFlagsOffset != Header.UseFlagsOffset)
+		return false;
+
+	// import against a staged interface, so the mesh is only touched once the tree is accepted
+	bool IsSingle = Header.CoordSize == sizeof(float);
+	MeshInterface Staged;
+	Staged.SetNbTriangles(Header.TriangleCount);
+	Staged.SetNbVertices(Header.VertexCount);
+	Staged.SetPointers((const IndexedTriangle*)(Blob + Header.IndexOffset), (const Point*)(Blob + Header.VertexOffset));
+	Staged.SetStrides(3 * sizeof(dTriIndex), 3 * Header.CoordSize);
+	Staged.SetSingle(IsSingle);
+
+	if (!BVTree.Import(&Staged, (const AABBNoLeafNode*)(Blob + Header.NodeOffset), Header.NodeCount))
+		return false;
+
+	Mesh = Staged;
+	BVTree.SetMeshInterface(&Mesh);
+	Single = IsSingle;
+
+	for (int i = 0; i < 3; i++)
+	{
+		AABBCenter[i] = (dReal)Header.AABBCenter[i];
+		AABBExtents[i] = (dReal)Header.AABBExtents[i];
+	}
+	AABBCenter[3] = AABBExtents[3] = REAL(0.0);
+
+	Normals = NULL;
+
+	if (UseFlags && !ExternalUseFlags)
+		delete [] UseFlags;
+	UseFlags = Header.HasUseFlags ? (uint8*)(Blob + Header.UseFlagsOffset) : NULL;
+	ExternalUseFlags = true;
+
+	return true;
+}
+
+size_t dGeomTriMeshDataGetSerializedSize(dTriMeshDataID g)
+{
+    dUASSERT(g, "argument not trimesh data");
+	return g->GetSerializedSize();
+}
+
+size_t dGeomTriMeshDataSerialize(dTriMeshDataID g, void* buffer, size_t bufferSize)
+{
+    dUASSERT(g, "argument not trimesh data");
+	return g->Serialize(buffer, bufferSize);
+}
+
+int dGeomTriMeshDataBuildFromSerialized(dTriMeshDataID g, const void* blob, size_t blobSize)
+{
+    dUASSERT(g, "argument not trimesh data");
+	return g->BuildFromSerialized(blob, blobSize) ? 1 : 0;
+}
+
+
 dxTriMesh::dxTriMesh(dSpaceID Space, dTriMeshDataID Data) : dxGeom(Space, 1)
 {
     type = dTriMeshClass;
@@ -44,7 +44,8 @@
 
 #if !dTLS_ENABLED
 // Have collider cache instance unconditionally of OPCODE or GIMPACT selection
-/*extern */TrimeshCollidersCache g_ccTrimeshCollidersCache;
+// one cache per thread, so that spaces can be collided from several threads
+/*extern */thread_local TrimeshCollidersCache g_ccTrimeshCollidersCache;
 #endif
 
 
@@ -31,6 +31,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 *************************************************************************/
 #include <ode/dampedstepcommon.h>
+#include "world_profile.h"
 
 
 static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena, 
@@ -38,6 +39,7 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
                              dxJoint * const *_joint, unsigned int _nj, dReal stepsize)
 {
   IFTIMING(dTimerStart("preprocessing"));
+  dxProfilePhases profile_phases(world, dProfilePreprocess);
 
   const dReal stepsizeRecip = dRecip(stepsize);
 
@@ -67,6 +69,8 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
       for (; _jcurr != _jend; ++_jcurr)
       {
           dxJoint *joint = *_jcurr;
+          // Add by Zhenhua Song: spring torque of the stable PD, and its damping added below
+          const dReal pdDamping = addStablePDSpringTorque(joint, stepsize);
 
           //joint->isAnisotropicDamping = false;
           //joint->aveldamping[0] = 0;
@@ -80,8 +84,9 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
               // the damping matrix is defined in ref frame
               // we should convert it to global frame
               dMatrix3 tmp;
-              dMultiply2_333 (tmp, D, joint->dampingRefBody->posr.R);
-              dMultiply0_333 (D, joint->dampingRefBody->posr.R,tmp);
+              dMultiply2_333 (tmp, D, joint->dampingRefBody->posr->R);
+              dMultiply0_333 (D, joint->dampingRefBody->posr->R,tmp);
+              D[0] += pdDamping; D[5] += pdDamping; D[10] += pdDamping;
 
               int bid0 = joint->node[0].body->tag;
               int blockId0 = ((bid0 * iplusdSkip + bid0) * iplusdBlockDim);
@@ -146,7 +151,7 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
           }
           else
           {
-              double d = joint->aveldamping[0] * stepsize;
+              double d = joint->aveldamping[0] * stepsize + pdDamping;
               int bid0 = joint->node[0].body->tag;
               int blockId0 = ((bid0 * iplusdSkip + bid0) * iplusdBlockDim);
               block = iplusd + blockId0;
@@ -219,12 +224,12 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
       // added by Libin
       // inverse inertia tensor is no longer necessary, since we will compute (M+D)^-1
       // compute inverse inertia tensor in global frame
-      //dMultiply2_333 (tmp,b->invI,b->posr.R);
-      //dMultiply0_333 (invIrow,b->posr.R,tmp);
+      //dMultiply2_333 (tmp,b->invI,b->posr->R);
+      //dMultiply0_333 (invIrow,b->posr->R,tmp);
       
       // compute inertia tensor in global frame
-      dMultiply2_333 (tmp,b->mass.I,b->posr.R);
-      dMultiply0_333 (b->curI,b->posr.R,tmp);
+      dMultiply2_333 (tmp,b->mass.I,b->posr->R);
+      dMultiply0_333 (b->curI,b->posr->R,tmp);
       // compute I+D
       int bid = b->tag;
       int blockId = ((bid * iplusdSkip + bid) * iplusdBlockDim);
@@ -599,6 +604,7 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
 
           {
               IFTIMING(dTimerNow("create J"));
+              profile_phases.next(dProfileCreateJ);
               // get jacobian data from constraints. a (2*m)x8 matrix will be created
               // to store the two jacobian blocks from each constraint. it has this
               // format:
@@ -657,6 +663,7 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
 
           {
               IFTIMING(dTimerNow("compute A"));
+              profile_phases.next(dProfileComputeA);
               {
                   // compute A = J*invM*J'. first compute JinvM = J*invM. this has the same
                   // format as J so we just go through the constraints in J multiplying by
@@ -924,6 +931,7 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
       BEGIN_STATE_SAVE(memarena, tmp1state) {
           // compute the right hand side `rhs'
           IFTIMING(dTimerNow("compute rhs"));
+          profile_phases.next(dProfileComputeRhs);
 
           dReal *tmp1 = memarena->AllocateArray<dReal>((size_t)nb * 8);
           dSetZero(tmp1, nb * 8);
@@ -1001,6 +1009,7 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
 
       BEGIN_STATE_SAVE(memarena, lcpstate) {
           IFTIMING(dTimerNow("solving LCP problem"));
+          profile_phases.next(dProfileSolveLCP);
 
           // solve the LCP problem and get lambda.
           // this will destroy A but that's OK
@@ -1036,6 +1045,7 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
 
     {
       IFTIMING(dTimerNow ("compute constraint force"));
+      profile_phases.next(dProfileConstraintForce);
 
       // compute the constraint force `cforce'
       // compute cforce = J'*lambda
@@ -1102,6 +1112,7 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
   {
     // compute the velocity update
     IFTIMING(dTimerNow ("compute velocity update"));
+    profile_phases.next(dProfileIntegrateVelocity);
 #if DebugPrint
         {
             printf("cforce:\n");
@@ -1180,6 +1191,7 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
     // update the position and orientation from the new linear/angular velocity
     // (over the given timestep)
     IFTIMING(dTimerNow ("update position"));
+    profile_phases.next(dProfileIntegratePosition);
     dxBody *const *const bodyend = body + nb;
     for (dxBody *const *bodycurr = body; bodycurr != bodyend; ++bodycurr) {
       dxBody *b = *bodycurr;
@@ -1189,6 +1201,7 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
 
   {
     IFTIMING(dTimerNow ("tidy up"));
+    profile_phases.next(dProfileTidyUp);
 
     // zero all force accumulators
     dxBody *const *const bodyend = body + nb;
@@ -1206,6 +1219,7 @@ static void dInternalDamppedStepIsland_x2 (dxWorldProcessMemArena *memarena,
   }
 
   IFTIMING(dTimerEnd());
+  profile_phases.end();
   if (m > 0) IFTIMING(dTimerReport (stdout,1));
 
 }
@@ -1320,8 +1334,10 @@ extern "C" int dWorldDampedStep (dWorldID w, dReal stepsize)
     bool result = false;
 
     dxWorldProcessIslandsInfo islandsinfo;
+    unsigned long long profile_begin = dxProfileBegin (w);
     if (dxReallocateWorldProcessContext (w, islandsinfo, stepsize, &dxEstimateDamppedStepMemoryRequirements))
     {
+        dxProfileStepBegun (w, profile_begin);
         dxProcessIslands (w, islandsinfo, stepsize, &dInternalDamppedStepIsland);
 
         result = true;
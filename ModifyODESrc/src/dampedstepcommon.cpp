@@ -505,4 +505,51 @@ int sparseInverse(
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+// Add by Zhenhua Song
+dReal addStablePDSpringTorque(dxJoint* joint, dReal stepsize)
+{
+    if (!joint->useStablePD)
+        return 0;
+
+    dxBody* child = joint->node[0].body;
+    dxBody* parent = joint->node[1].body;
+
+    // rotation from the current local rotation to the target, on the short arc
+    dQuaternion local, delta;
+    if (parent)
+        dQMultiply1(local, parent->q, child->q);
+    else
+        memcpy(local, child->q, sizeof(dQuaternion));
+    dNormalize4(local);
+    dQMultiply2(delta, joint->pdTarget, local);
+    if (delta[0] < 0)
+    {
+        delta[0] = -delta[0]; delta[1] = -delta[1]; delta[2] = -delta[2]; delta[3] = -delta[3];
+    }
+
+    // kp * rotvec(delta) in parent frame. angle / sin(angle / 2) tends to 2 / cos(angle / 2) at 0
+    dReal sin_half = dSqrt(delta[1] * delta[1] + delta[2] * delta[2] + delta[3] * delta[3]);
+    dReal scale = sin_half > REAL(1e-12) ? 2 * dAtan2(sin_half, delta[0]) / sin_half : 2 / delta[0];
+    dVector3 local_torque, torque;
+    for (int i = 0; i < 3; i++)
+        local_torque[i] = joint->pdKp * scale * delta[i + 1];
+
+    dReal torque_len = dCalcVectorLength3(local_torque);
+    if (joint->pdTorqueLimit > 0 && torque_len > joint->pdTorqueLimit)
+        dScaleVector3(local_torque, joint->pdTorqueLimit / torque_len);
+
+    if (parent)
+    {
+        dMultiply0_331(torque, parent->posr->R, local_torque);
+        dAddVectors3(child->tacc, child->tacc, torque);
+        dSubtractVectors3(parent->tacc, parent->tacc, torque);
+    }
+    else
+    {
+        dAddVectors3(child->tacc, child->tacc, local_torque);
+    }
+
+    return (joint->pdKp * stepsize + joint->pdKd) * stepsize;
+}
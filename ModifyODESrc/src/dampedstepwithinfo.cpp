@@ -80,6 +80,8 @@ static void dInternalDamppedStepIslandWithInfo_x2(dxWorldProcessMemArena* memare
         for (; _jcurr != _jend; ++_jcurr)
         {
             dxJoint* joint = *_jcurr;
+            // Add by Zhenhua Song: spring torque of the stable PD, and its damping added below
+            const dReal pdDamping = addStablePDSpringTorque(joint, stepsize);
 
             //joint->isAnisotropicDamping = false;
             //joint->aveldamping[0] = 0;
@@ -93,8 +95,9 @@ static void dInternalDamppedStepIslandWithInfo_x2(dxWorldProcessMemArena* memare
                 // the damping matrix is defined in ref frame
                 // we should convert it to global frame
                 dMatrix3 tmp;
-                dMultiply2_333(tmp, D, joint->dampingRefBody->posr.R);
-                dMultiply0_333(D, joint->dampingRefBody->posr.R, tmp);
+                dMultiply2_333(tmp, D, joint->dampingRefBody->posr->R);
+                dMultiply0_333(D, joint->dampingRefBody->posr->R, tmp);
+                D[0] += pdDamping; D[5] += pdDamping; D[10] += pdDamping;
 
                 int bid0 = joint->node[0].body->tag;
                 int blockId0 = ((bid0 * iplusdSkip + bid0) * iplusdBlockDim);
@@ -159,7 +162,7 @@ static void dInternalDamppedStepIslandWithInfo_x2(dxWorldProcessMemArena* memare
             }
             else
             {
-                double d = joint->aveldamping[0] * stepsize;
+                double d = joint->aveldamping[0] * stepsize + pdDamping;
                 int bid0 = joint->node[0].body->tag;
                 int blockId0 = ((bid0 * iplusdSkip + bid0) * iplusdBlockDim);
                 block = iplusd + blockId0;
@@ -232,12 +235,12 @@ static void dInternalDamppedStepIslandWithInfo_x2(dxWorldProcessMemArena* memare
             // added by Libin
             // inverse inertia tensor is no longer necessary, since we will compute (M+D)^-1
             // compute inverse inertia tensor in global frame
-            //dMultiply2_333 (tmp,b->invI,b->posr.R);
-            //dMultiply0_333 (invIrow,b->posr.R,tmp);
+            //dMultiply2_333 (tmp,b->invI,b->posr->R);
+            //dMultiply0_333 (invIrow,b->posr->R,tmp);
 
             // compute inertia tensor in global frame
-            dMultiply2_333(tmp, b->mass.I, b->posr.R);
-            dMultiply0_333(b->curI, b->posr.R, tmp);
+            dMultiply2_333(tmp, b->mass.I, b->posr->R);
+            dMultiply0_333(b->curI, b->posr->R, tmp);
             // compute I+D
             int bid = b->tag;
             int blockId = ((bid * iplusdSkip + bid) * iplusdBlockDim);
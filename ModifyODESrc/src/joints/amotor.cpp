@@ -55,10 +55,10 @@ dxJointAMotor::computeGlobalAxes( dVector3 ax[3] )
     if ( mode == dAMotorEuler )
     {
         // special handling for euler mode
-        dMultiply0_331( ax[0], node[0].body->posr.R, axis[0] );
+        dMultiply0_331( ax[0], node[0].body->posr->R, axis[0] );
         if ( node[1].body )
         {
-            dMultiply0_331( ax[2], node[1].body->posr.R, axis[2] );
+            dMultiply0_331( ax[2], node[1].body->posr->R, axis[2] );
         }
         else
         {
@@ -76,14 +76,14 @@ dxJointAMotor::computeGlobalAxes( dVector3 ax[3] )
             if ( rel[i] == 1 )
             {
                 // relative to b1
-                dMultiply0_331( ax[i], node[0].body->posr.R, axis[i] );
+                dMultiply0_331( ax[i], node[0].body->posr->R, axis[i] );
             }
             else if ( rel[i] == 2 )
             {
                 // relative to b2
                 if ( node[1].body )   // jds: don't assert, just ignore
                 {
-                    dMultiply0_331( ax[i], node[1].body->posr.R, axis[i] );
+                    dMultiply0_331( ax[i], node[1].body->posr->R, axis[i] );
                 }
             }
             else
@@ -113,10 +113,10 @@ dxJointAMotor::computeEulerAngles( dVector3 ax[3] )
 
     // calculate references in global frame
     dVector3 ref1, ref2;
-    dMultiply0_331( ref1, node[0].body->posr.R, reference1 );
+    dMultiply0_331( ref1, node[0].body->posr->R, reference1 );
     if ( node[1].body )
     {
-        dMultiply0_331( ref2, node[1].body->posr.R, reference2 );
+        dMultiply0_331( ref2, node[1].body->posr->R, reference2 );
     }
     else
     {
@@ -153,17 +153,17 @@ dxJointAMotor::setEulerReferenceVectors()
     if ( node[0].body && node[1].body )
     {
         dVector3 r;  // axis[2] and axis[0] in global coordinates
-        dMultiply0_331( r, node[1].body->posr.R, axis[2] );
-        dMultiply1_331( reference1, node[0].body->posr.R, r );
-        dMultiply0_331( r, node[0].body->posr.R, axis[0] );
-        dMultiply1_331( reference2, node[1].body->posr.R, r );
+        dMultiply0_331( r, node[1].body->posr->R, axis[2] );
+        dMultiply1_331( reference1, node[0].body->posr->R, r );
+        dMultiply0_331( r, node[0].body->posr->R, axis[0] );
+        dMultiply1_331( reference2, node[1].body->posr->R, r );
     }
 
     else     // jds
     {
         // else if (j->node[0].body) {
-        // dMultiply1_331 (j->reference1,j->node[0].body->posr.R,j->axis[2]);
-        // dMultiply0_331 (j->reference2,j->node[0].body->posr.R,j->axis[0]);
+        // dMultiply1_331 (j->reference1,j->node[0].body->posr->R,j->axis[2]);
+        // dMultiply0_331 (j->reference2,j->node[0].body->posr->R,j->axis[0]);
 
         // We want to handle angular motors attached to passive geoms
         dVector3 r;  // axis[2] and axis[0] in global coordinates
@@ -171,8 +171,8 @@ dxJointAMotor::setEulerReferenceVectors()
         r[1] = axis[2][1];
         r[2] = axis[2][2];
         r[3] = axis[2][3];
-        dMultiply1_331( reference1, node[0].body->posr.R, r );
-        dMultiply0_331( r, node[0].body->posr.R, axis[0] );
+        dMultiply1_331( reference1, node[0].body->posr->R, r );
+        dMultiply0_331( r, node[0].body->posr->R, axis[0] );
         reference2[0] += r[0];
         reference2[1] += r[1];
         reference2[2] += r[2];
@@ -350,14 +350,14 @@ void dJointSetAMotorAxis( dJointID j, int anum, int rel, dReal x, dReal y, dReal
     {
         if ( rel == 1 )
         {
-            dMultiply1_331( joint->axis[anum], joint->node[0].body->posr.R, r );
+            dMultiply1_331( joint->axis[anum], joint->node[0].body->posr->R, r );
         }
         else
         {
             // don't assert; handle the case of attachment to a bodiless geom
             if ( joint->node[1].body )   // jds
             {
-                dMultiply1_331( joint->axis[anum], joint->node[1].body->posr.R, r );
+                dMultiply1_331( joint->axis[anum], joint->node[1].body->posr->R, r );
             }
             else
             {
@@ -440,13 +440,13 @@ void dJointGetAMotorAxis( dJointID j, int anum, dVector3 result )
     {
         if ( joint->rel[anum] == 1 )
         {
-            dMultiply0_331( result, joint->node[0].body->posr.R, joint->axis[anum] );
+            dMultiply0_331( result, joint->node[0].body->posr->R, joint->axis[anum] );
         }
         else
         {
             if ( joint->node[1].body )   // jds
             {
-                dMultiply0_331( result, joint->node[1].body->posr.R, joint->axis[anum] );
+                dMultiply0_331( result, joint->node[1].body->posr->R, joint->axis[anum] );
             }
             else
             {
@@ -94,9 +94,9 @@ void dxJointContact::getInfo2( dxJoint::Info2 *info )
 
     // c1,c2 = contact points with respect to body PORs
     dVector3 c1, c2 = {0,0,0};
-    c1[0] = contact.geom.pos[0] - node[0].body->posr.pos[0];
-    c1[1] = contact.geom.pos[1] - node[0].body->posr.pos[1];
-    c1[2] = contact.geom.pos[2] - node[0].body->posr.pos[2];
+    c1[0] = contact.geom.pos[0] - node[0].body->posr->pos[0];
+    c1[1] = contact.geom.pos[1] - node[0].body->posr->pos[1];
+    c1[2] = contact.geom.pos[2] - node[0].body->posr->pos[2];
 
     // set jacobian for normal. supporting force is along normal vector
     info->J1l[0] = normal[0];
@@ -105,9 +105,9 @@ void dxJointContact::getInfo2( dxJoint::Info2 *info )
     dCalcVectorCross3( info->J1a, c1, normal );
     if ( node[1].body )
     {
-        c2[0] = contact.geom.pos[0] - node[1].body->posr.pos[0];
-        c2[1] = contact.geom.pos[1] - node[1].body->posr.pos[1];
-        c2[2] = contact.geom.pos[2] - node[1].body->posr.pos[2];
+        c2[0] = contact.geom.pos[0] - node[1].body->posr->pos[0];
+        c2[1] = contact.geom.pos[1] - node[1].body->posr->pos[1];
+        c2[2] = contact.geom.pos[2] - node[1].body->posr->pos[2];
         info->J2l[0] = -normal[0];
         info->J2l[1] = -normal[1];
         info->J2l[2] = -normal[2];
@@ -293,14 +293,14 @@ void dxJointContact::simpleGetInfo2(dxJoint::Info2* info)
 
     // c1,c2 = contact points with respect to body PORs
     dVector3 c1, c2 = { 0,0,0 };
-    dSubtractVectors3(c1, contact.geom.pos, node[0].body->posr.pos);
+    dSubtractVectors3(c1, contact.geom.pos, node[0].body->posr->pos);
 
     // set jacobian for normal. supporting force is along normal vector
     dCopyVector3(info->J1l, normal);
     dCalcVectorCross3(info->J1a, c1, normal);
     if (node[1].body)
     {
-        dSubtractVectors3(c2, contact.geom.pos, node[1].body->posr.pos);
+        dSubtractVectors3(c2, contact.geom.pos, node[1].body->posr->pos);
         dCopyNegatedVector3(info->J2l, normal);
         dCalcVectorCross3(info->J2a, c2, normal);
         dNegateVector3(info->J2a);
@@ -125,9 +125,9 @@ dxJointContact2::getInfo2(dxJoint::Info2 *info)
 
     // c1,c2 = contact points with respect to body PORs
     dVector3 c1, c2 = { 0, 0, 0 };
-    c1[0] = contact.geom.pos[0] - node[0].body->posr.pos[0];
-    c1[1] = contact.geom.pos[1] - node[0].body->posr.pos[1];
-    c1[2] = contact.geom.pos[2] - node[0].body->posr.pos[2];
+    c1[0] = contact.geom.pos[0] - node[0].body->posr->pos[0];
+    c1[1] = contact.geom.pos[1] - node[0].body->posr->pos[1];
+    c1[2] = contact.geom.pos[2] - node[0].body->posr->pos[2];
 
     // set jacobian for normal
     info->J1l[0] = normal[0];
@@ -136,9 +136,9 @@ dxJointContact2::getInfo2(dxJoint::Info2 *info)
     dCalcVectorCross3(info->J1a, c1, normal);
     if (node[1].body)
     {
-        c2[0] = contact.geom.pos[0] - node[1].body->posr.pos[0];
-        c2[1] = contact.geom.pos[1] - node[1].body->posr.pos[1];
-        c2[2] = contact.geom.pos[2] - node[1].body->posr.pos[2];
+        c2[0] = contact.geom.pos[0] - node[1].body->posr->pos[0];
+        c2[1] = contact.geom.pos[1] - node[1].body->posr->pos[1];
+        c2[2] = contact.geom.pos[2] - node[1].body->posr->pos[2];
         info->J2l[0] = -normal[0];
         info->J2l[1] = -normal[1];
         info->J2l[2] = -normal[2];
@@ -53,14 +53,14 @@ void dxJointContactMaxForce::getInfo2(dxJoint::Info2* info)
 
     // c1,c2 = contact points with respect to body PORs
     dVector3 c1, c2 = { 0,0,0 };
-    dSubtractVectors3(c1, contact.geom.pos, node[0].body->posr.pos);
+    dSubtractVectors3(c1, contact.geom.pos, node[0].body->posr->pos);
 
     // set jacobian for normal. supporting force is along normal vector
     dCopyVector3(info->J1l, normal);
     dCalcVectorCross3(info->J1a, c1, normal);
     if (node[1].body)
     {
-        dSubtractVectors3(c2, contact.geom.pos, node[1].body->posr.pos);
+        dSubtractVectors3(c2, contact.geom.pos, node[1].body->posr->pos);
         dCopyNegatedVector3(info->J2l, normal);
         dCalcVectorCross3(info->J2a, c2, normal);
         dNegateVector3(info->J2a);
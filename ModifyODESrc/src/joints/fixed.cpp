@@ -75,7 +75,7 @@ dxJointFixed::getInfo2 ( dxJoint::Info2 *info )
     info->cfm[2] = cfm;
 
     dVector3 ofs;
-    dMultiply0_331 ( ofs, node[0].body->posr.R, offset );
+    dMultiply0_331 ( ofs, node[0].body->posr->R, offset );
     if ( node[1].body )
     {
         dSetCrossMatrixPlus( info->J1a, ofs, s );
@@ -89,14 +89,14 @@ dxJointFixed::getInfo2 ( dxJoint::Info2 *info )
     if ( node[1].body )
     {
         for ( int j = 0; j < 3; j++ )
-            info->c[j] = k * ( node[1].body->posr.pos[j]
-                               - node[0].body->posr.pos[j]
+            info->c[j] = k * ( node[1].body->posr->pos[j]
+                               - node[0].body->posr->pos[j]
                                + ofs[j] );
     }
     else
     {
         for ( int j = 0; j < 3; j++ )
-            info->c[j] = k * ( offset[j] - node[0].body->posr.pos[j] );
+            info->c[j] = k * ( offset[j] - node[0].body->posr->pos[j] );
     }
 }
 
@@ -117,14 +117,14 @@ void dJointSetFixed ( dJointID j )
         {
             dReal ofs[4];
             for ( i = 0; i < 4; i++ )
-                ofs[i] = joint->node[0].body->posr.pos[i] - joint->node[1].body->posr.pos[i];
-            dMultiply1_331 ( joint->offset, joint->node[0].body->posr.R, ofs );
+                ofs[i] = joint->node[0].body->posr->pos[i] - joint->node[1].body->posr->pos[i];
+            dMultiply1_331 ( joint->offset, joint->node[0].body->posr->R, ofs );
         }
         else
         {
-            joint->offset[0] = joint->node[0].body->posr.pos[0];
-            joint->offset[1] = joint->node[0].body->posr.pos[1];
-            joint->offset[2] = joint->node[0].body->posr.pos[2];
+            joint->offset[0] = joint->node[0].body->posr->pos[0];
+            joint->offset[1] = joint->node[0].body->posr->pos[1];
+            joint->offset[2] = joint->node[0].body->posr->pos[2];
         }
     }
 
@@ -103,7 +103,7 @@ dxJointHinge::getInfo2( dxJoint::Info2 *info )
 
     dVector3 ax1;  // length 1 joint axis in global coordinates, from 1st body
     dVector3 p, q; // plane space vectors for ax1
-    dMultiply0_331( ax1, node[0].body->posr.R, axis1 );
+    dMultiply0_331( ax1, node[0].body->posr->R, axis1 );
     dPlaneSpace( ax1, p, q );
 
     int s3 = 3 * info->rowskip;
@@ -145,7 +145,7 @@ dxJointHinge::getInfo2( dxJoint::Info2 *info )
     dVector3 ax2, b;
     if ( node[1].body )
     {
-        dMultiply0_331( ax2, node[1].body->posr.R, axis2 );
+        dMultiply0_331( ax2, node[1].body->posr->R, axis2 );
     }
     else
     {
@@ -194,19 +194,19 @@ void dJointSetHingeAnchorDelta( dJointID j, dReal x, dReal y, dReal z, dReal dx,
     if ( joint->node[0].body )
     {
         dReal q[4];
-        q[0] = x - joint->node[0].body->posr.pos[0];
-        q[1] = y - joint->node[0].body->posr.pos[1];
-        q[2] = z - joint->node[0].body->posr.pos[2];
+        q[0] = x - joint->node[0].body->posr->pos[0];
+        q[1] = y - joint->node[0].body->posr->pos[1];
+        q[2] = z - joint->node[0].body->posr->pos[2];
         q[3] = 0;
-        dMultiply1_331( joint->anchor1, joint->node[0].body->posr.R, q );
+        dMultiply1_331( joint->anchor1, joint->node[0].body->posr->R, q );
 
         if ( joint->node[1].body )
         {
-            q[0] = x - joint->node[1].body->posr.pos[0];
-            q[1] = y - joint->node[1].body->posr.pos[1];
-            q[2] = z - joint->node[1].body->posr.pos[2];
+            q[0] = x - joint->node[1].body->posr->pos[0];
+            q[1] = y - joint->node[1].body->posr->pos[1];
+            q[2] = z - joint->node[1].body->posr->pos[2];
             q[3] = 0;
-            dMultiply1_331( joint->anchor2, joint->node[1].body->posr.R, q );
+            dMultiply1_331( joint->anchor2, joint->node[1].body->posr->R, q );
         }
         else
         {
@@ -326,7 +326,7 @@ void dJointGetHingeAxis1(dJointID j, dVector3 result)
 
     if (joint->node[0].body)
     {
-        dMultiply0_331(result, j->node[0].body->posr.R, joint->axis1);
+        dMultiply0_331(result, j->node[0].body->posr->R, joint->axis1);
     }
     else
     {
@@ -344,7 +344,7 @@ void dJointGetHingeAxis2(dJointID j, dVector3 result)
 
     if (joint->node[1].body)
     {
-        dMultiply0_331(result, j->node[1].body->posr.R, joint->axis2);
+        dMultiply0_331(result, j->node[1].body->posr->R, joint->axis2);
     }
     else
     {
@@ -435,7 +435,7 @@ dReal dJointGetHingeAngleRate( dJointID j )
     if ( joint->node[0].body )
     {
         dVector3 axis;
-        dMultiply0_331( axis, joint->node[0].body->posr.R, joint->axis1 );
+        dMultiply0_331( axis, joint->node[0].body->posr->R, joint->axis1 );
         dReal rate = dCalcVectorDot3( axis, joint->node[0].body->avel );
         if ( joint->node[1].body ) rate -= dCalcVectorDot3( axis, joint->node[1].body->avel );
         if ( joint->flags & dJOINT_REVERSE ) rate = - rate;
@@ -64,6 +64,11 @@ dxJoint::dxJoint( dxWorld *w ) :
     isAnisotropicDamping = false;
     useImplicitDamping = false;
     dampingRefBody = 0;
+
+    // Add by Zhenhua Song
+    useStablePD = false;
+    pdKp = pdKd = pdTorqueLimit = 0;
+    dQSetIdentity(pdTarget);
 }
 
 dxJoint::~dxJoint()
@@ -95,14 +100,14 @@ void setBall( dxJoint *joint, dxJoint::Info2 *info,
     info->J1l[0] = 1;
     info->J1l[s+1] = 1;
     info->J1l[2*s+2] = 1;
-    dMultiply0_331( a1, joint->node[0].body->posr.R, anchor1 ); // R * anchor1
+    dMultiply0_331( a1, joint->node[0].body->posr->R, anchor1 ); // R * anchor1
     dSetCrossMatrixMinus( info->J1a, a1, s ); // cross vector -> - cross matrix
     if ( joint->node[1].body )
     {
         info->J2l[0] = -1;
         info->J2l[s+1] = -1;
         info->J2l[2*s+2] = -1;
-        dMultiply0_331( a2, joint->node[1].body->posr.R, anchor2 ); // R * anchor2
+        dMultiply0_331( a2, joint->node[1].body->posr->R, anchor2 ); // R * anchor2
         dSetCrossMatrixPlus( info->J2a, a2, s ); // cross vector -> cross matrix
     }
 
@@ -112,8 +117,8 @@ void setBall( dxJoint *joint, dxJoint::Info2 *info,
     {
         for ( int j = 0; j < 3; j++ )
         {
-            info->c[j] = k * ( a2[j] + joint->node[1].body->posr.pos[j] -
-                               a1[j] - joint->node[0].body->posr.pos[j] );
+            info->c[j] = k * ( a2[j] + joint->node[1].body->posr->pos[j] -
+                               a1[j] - joint->node[0].body->posr->pos[j] );
         }
     }
     else
@@ -121,7 +126,7 @@ void setBall( dxJoint *joint, dxJoint::Info2 *info,
         for ( int j = 0; j < 3; j++ )
         {
             info->c[j] = k * ( anchor2[j] - a1[j] -
-                               joint->node[0].body->posr.pos[j] );
+                               joint->node[0].body->posr->pos[j] );
         }
     }
 }
@@ -150,7 +155,7 @@ void setBall2( dxJoint *joint, dxJoint::Info2 *info,
     for ( i = 0; i < 3; i++ ) info->J1l[i] = axis[i];
     for ( i = 0; i < 3; i++ ) info->J1l[s+i] = q1[i];
     for ( i = 0; i < 3; i++ ) info->J1l[2*s+i] = q2[i];
-    dMultiply0_331( a1, joint->node[0].body->posr.R, anchor1 );
+    dMultiply0_331( a1, joint->node[0].body->posr->R, anchor1 );
     dCalcVectorCross3( info->J1a, a1, axis );
     dCalcVectorCross3( info->J1a + s, a1, q1 );
     dCalcVectorCross3( info->J1a + 2*s, a1, q2 );
@@ -159,7 +164,7 @@ void setBall2( dxJoint *joint, dxJoint::Info2 *info,
         for ( i = 0; i < 3; i++ ) info->J2l[i] = -axis[i];
         for ( i = 0; i < 3; i++ ) info->J2l[s+i] = -q1[i];
         for ( i = 0; i < 3; i++ ) info->J2l[2*s+i] = -q2[i];
-        dMultiply0_331( a2, joint->node[1].body->posr.R, anchor2 );
+        dMultiply0_331( a2, joint->node[1].body->posr->R, anchor2 );
         dReal *J2a = info->J2a;
         dCalcVectorCross3( J2a, a2, axis );
         dNegateVector3( J2a );
@@ -175,10 +180,10 @@ void setBall2( dxJoint *joint, dxJoint::Info2 *info,
     dReal k1 = info->fps * erp1;
     dReal k = info->fps * info->erp;
 
-    for ( i = 0; i < 3; i++ ) a1[i] += joint->node[0].body->posr.pos[i];
+    for ( i = 0; i < 3; i++ ) a1[i] += joint->node[0].body->posr->pos[i];
     if ( joint->node[1].body )
     {
-        for ( i = 0; i < 3; i++ ) a2[i] += joint->node[1].body->posr.pos[i];
+        for ( i = 0; i < 3; i++ ) a2[i] += joint->node[1].body->posr->pos[i];
         
         dVector3 a2_minus_a1;
         dSubtractVectors3(a2_minus_a1, a2, a1);
@@ -248,7 +253,7 @@ void setFixedOrientation( dxJoint *joint, dxJoint::Info2 *info, dQuaternion qrel
         qerr[2] = -qerr[2];
         qerr[3] = -qerr[3];
     }
-    dMultiply0_331( e, joint->node[0].body->posr.R, qerr + 1 );  // @@@ bad SIMD padding!
+    dMultiply0_331( e, joint->node[0].body->posr->R, qerr + 1 );  // @@@ bad SIMD padding!
     dReal k = info->fps * info->erp;
     info->c[start_row] = 2 * k * e[0];
     info->c[start_row+1] = 2 * k * e[1];
@@ -264,18 +269,18 @@ void setAnchors( dxJoint *j, dReal x, dReal y, dReal z,
     if ( j->node[0].body )
     {
         dReal q[4];
-        q[0] = x - j->node[0].body->posr.pos[0];
-        q[1] = y - j->node[0].body->posr.pos[1];
-        q[2] = z - j->node[0].body->posr.pos[2];
+        q[0] = x - j->node[0].body->posr->pos[0];
+        q[1] = y - j->node[0].body->posr->pos[1];
+        q[2] = z - j->node[0].body->posr->pos[2];
         q[3] = 0;
-        dMultiply1_331( anchor1, j->node[0].body->posr.R, q );
+        dMultiply1_331( anchor1, j->node[0].body->posr->R, q );
         if ( j->node[1].body )
         {
-            q[0] = x - j->node[1].body->posr.pos[0];
-            q[1] = y - j->node[1].body->posr.pos[1];
-            q[2] = z - j->node[1].body->posr.pos[2];
+            q[0] = x - j->node[1].body->posr->pos[0];
+            q[1] = y - j->node[1].body->posr->pos[1];
+            q[2] = z - j->node[1].body->posr->pos[2];
             q[3] = 0;
-            dMultiply1_331( anchor2, j->node[1].body->posr.R, q );
+            dMultiply1_331( anchor2, j->node[1].body->posr->R, q );
         }
         else
         {
@@ -303,14 +308,14 @@ void setAxes( dxJoint *j, dReal x, dReal y, dReal z, dVector3 axis1, dVector3 ax
         dNormalize3( q );
         if ( axis1 )
         {
-            dMultiply1_331( axis1, j->node[0].body->posr.R, q );
+            dMultiply1_331( axis1, j->node[0].body->posr->R, q );
             axis1[3] = 0;
         }
         if ( axis2 )
         {
             if ( j->node[1].body )
             {
-                dMultiply1_331( axis2, j->node[1].body->posr.R, q );
+                dMultiply1_331( axis2, j->node[1].body->posr->R, q );
             }
             else
             {
@@ -328,10 +333,10 @@ void getAnchor( dxJoint *j, dVector3 result, dVector3 anchor1 )
 {
     if ( j->node[0].body )
     {
-        dMultiply0_331( result, j->node[0].body->posr.R, anchor1 );
-        result[0] += j->node[0].body->posr.pos[0];
-        result[1] += j->node[0].body->posr.pos[1];
-        result[2] += j->node[0].body->posr.pos[2];
+        dMultiply0_331( result, j->node[0].body->posr->R, anchor1 );
+        result[0] += j->node[0].body->posr->pos[0];
+        result[1] += j->node[0].body->posr->pos[1];
+        result[2] += j->node[0].body->posr->pos[2];
     }
 }
 
@@ -340,10 +345,10 @@ void getAnchor2( dxJoint *j, dVector3 result, dVector3 anchor2 )
 {
     if ( j->node[1].body )
     {
-        dMultiply0_331( result, j->node[1].body->posr.R, anchor2 );
-        result[0] += j->node[1].body->posr.pos[0];
-        result[1] += j->node[1].body->posr.pos[1];
-        result[2] += j->node[1].body->posr.pos[2];
+        dMultiply0_331( result, j->node[1].body->posr->R, anchor2 );
+        result[0] += j->node[1].body->posr->pos[0];
+        result[1] += j->node[1].body->posr->pos[1];
+        result[2] += j->node[1].body->posr->pos[2];
     }
     else
     {
@@ -358,7 +363,7 @@ void getAxis( dxJoint *j, dVector3 result, dVector3 axis1 )
 {
     if ( j->node[0].body )
     {
-        dMultiply0_331( result, j->node[0].body->posr.R, axis1 );
+        dMultiply0_331( result, j->node[0].body->posr->R, axis1 );
     }
 }
 
@@ -367,7 +372,7 @@ void getAxis2( dxJoint *j, dVector3 result, dVector3 axis2 )
 {
     if ( j->node[1].body )
     {
-        dMultiply0_331( result, j->node[1].body->posr.R, axis2 );
+        dMultiply0_331( result, j->node[1].body->posr->R, axis2 );
     }
     else
     {
@@ -637,9 +642,9 @@ int dxJointLimitMotor::addLimot(dxJoint *joint, dxJoint::Info2 *info, int row,
         if ( !rotational && joint->node[1].body )
         {
             dVector3 c;
-            c[0] = REAL( 0.5 ) * ( joint->node[1].body->posr.pos[0] - joint->node[0].body->posr.pos[0] );
-            c[1] = REAL( 0.5 ) * ( joint->node[1].body->posr.pos[1] - joint->node[0].body->posr.pos[1] );
-            c[2] = REAL( 0.5 ) * ( joint->node[1].body->posr.pos[2] - joint->node[0].body->posr.pos[2] );
+            c[0] = REAL( 0.5 ) * ( joint->node[1].body->posr->pos[0] - joint->node[0].body->posr->pos[0] );
+            c[1] = REAL( 0.5 ) * ( joint->node[1].body->posr->pos[1] - joint->node[0].body->posr->pos[1] );
+            c[2] = REAL( 0.5 ) * ( joint->node[1].body->posr->pos[2] - joint->node[0].body->posr->pos[2] );
             dCalcVectorCross3( ltd, c, ax1 );
             info->J1a[srow+0] = ltd[0];
             info->J1a[srow+1] = ltd[1];
@@ -168,6 +168,13 @@ struct dxJoint : public dObject
     
     // added by Heyuan Yao
     bool useImplicitDamping;
+
+    // Add by Zhenhua Song
+    // implicit stable PD in damped step, see dJointSetStablePD
+    bool useStablePD;
+    dReal pdKp, pdKd;
+    dReal pdTorqueLimit; // <= 0 for no limit
+    dQuaternion pdTarget; // child in parent frame
     ////////////////////////////////////////////////////////////
 
 
@@ -61,30 +61,30 @@ dReal dJointGetPistonPosition ( dJointID j )
     {
         dVector3 q;
         // get the anchor (or offset) in global coordinates
-        dMultiply0_331 ( q, joint->node[0].body->posr.R, joint->anchor1 );
+        dMultiply0_331 ( q, joint->node[0].body->posr->R, joint->anchor1 );
 
         if ( joint->node[1].body )
         {
             dVector3 anchor2;
             // get the anchor2 in global coordinates
-            dMultiply0_331 ( anchor2, joint->node[1].body->posr.R, joint->anchor2 );
-
-            q[0] = ( ( joint->node[0].body->posr.pos[0] + q[0] ) -
-                     ( joint->node[1].body->posr.pos[0] + anchor2[0] ) );
-            q[1] = ( ( joint->node[0].body->posr.pos[1] + q[1] ) -
-                     ( joint->node[1].body->posr.pos[1] + anchor2[1] ) );
-            q[2] = ( ( joint->node[0].body->posr.pos[2] + q[2] ) -
-                     ( joint->node[1].body->posr.pos[2] + anchor2[2] ) );
+            dMultiply0_331 ( anchor2, joint->node[1].body->posr->R, joint->anchor2 );
+
+            q[0] = ( ( joint->node[0].body->posr->pos[0] + q[0] ) -
+                     ( joint->node[1].body->posr->pos[0] + anchor2[0] ) );
+            q[1] = ( ( joint->node[0].body->posr->pos[1] + q[1] ) -
+                     ( joint->node[1].body->posr->pos[1] + anchor2[1] ) );
+            q[2] = ( ( joint->node[0].body->posr->pos[2] + q[2] ) -
+                     ( joint->node[1].body->posr->pos[2] + anchor2[2] ) );
         }
         else
         {
             // N.B. When there is no body 2 the joint->anchor2 is already in
             //      global coordinates
-            q[0] = ( ( joint->node[0].body->posr.pos[0] + q[0] ) -
+            q[0] = ( ( joint->node[0].body->posr->pos[0] + q[0] ) -
                      ( joint->anchor2[0] ) );
-            q[1] = ( ( joint->node[0].body->posr.pos[1] + q[1] ) -
+            q[1] = ( ( joint->node[0].body->posr->pos[1] + q[1] ) -
                      ( joint->anchor2[1] ) );
-            q[2] = ( ( joint->node[0].body->posr.pos[2] + q[2] ) -
+            q[2] = ( ( joint->node[0].body->posr->pos[2] + q[2] ) -
                      ( joint->anchor2[2] ) );
 
             if ( joint->flags & dJOINT_REVERSE )
@@ -97,7 +97,7 @@ dReal dJointGetPistonPosition ( dJointID j )
 
         // get axis in global coordinates
         dVector3 ax;
-        dMultiply0_331 ( ax, joint->node[0].body->posr.R, joint->axis1 );
+        dMultiply0_331 ( ax, joint->node[0].body->posr->R, joint->axis1 );
 
         return dCalcVectorDot3 ( ax, q );
     }
@@ -115,7 +115,7 @@ dReal dJointGetPistonPositionRate ( dJointID j )
 
     // get axis in global coordinates
     dVector3 ax;
-    dMultiply0_331 ( ax, joint->node[0].body->posr.R, joint->axis1 );
+    dMultiply0_331 ( ax, joint->node[0].body->posr->R, joint->axis1 );
 
     // The linear velocity created by the rotation can be discarded since
     // the rotation is along the prismatic axis and this rotation don't create
@@ -161,7 +161,7 @@ dReal dJointGetPistonAngleRate ( dJointID j )
     if ( joint->node[0].body )
     {
         dVector3 axis;
-        dMultiply0_331 ( axis, joint->node[0].body->posr.R, joint->axis1 );
+        dMultiply0_331 ( axis, joint->node[0].body->posr->R, joint->axis1 );
         dReal rate = dCalcVectorDot3 ( axis, joint->node[0].body->avel );
         if ( joint->node[1].body ) rate -= dCalcVectorDot3 ( axis, joint->node[1].body->avel );
         if ( joint->flags & dJOINT_REVERSE ) rate = - rate;
@@ -239,13 +239,13 @@ dxJointPiston::getInfo2 ( dxJoint::Info2 *info )
         0,0,0
     };
 
-    pos1 = node[0].body->posr.pos;
-    R1   = node[0].body->posr.R;
+    pos1 = node[0].body->posr->pos;
+    R1   = node[0].body->posr->R;
 
     if ( node[1].body )
     {
-        pos2 = node[1].body->posr.pos;
-        R2   = node[1].body->posr.R;
+        pos2 = node[1].body->posr->pos;
+        R2   = node[1].body->posr->R;
 
         dMultiply0_331 ( lanchor2, R2, anchor2 );
         dist[0] = lanchor2[0] + pos2[0] - pos1[0];
@@ -305,7 +305,7 @@ dxJointPiston::getInfo2 ( dxJoint::Info2 *info )
     // only along p and q that we want the same angular velocity and need to reduce
     // the error
     dVector3 ax1, p, q;
-    dMultiply0_331 ( ax1, node[0].body->posr.R, axis1 );
+    dMultiply0_331 ( ax1, node[0].body->posr->R, axis1 );
 
     // Find the 2 axis perpendicular to the rotoide axis.
     dPlaneSpace ( ax1, p, q );
@@ -447,18 +447,18 @@ void dJointSetPistonAnchorOffset (dJointID j, dReal x, dReal y, dReal z,
 
     if (joint->node[0].body)
     {
-        joint->node[0].body->posr.pos[0] -= dx;
-        joint->node[0].body->posr.pos[1] -= dy;
-        joint->node[0].body->posr.pos[2] -= dz;
+        joint->node[0].body->posr->pos[0] -= dx;
+        joint->node[0].body->posr->pos[1] -= dy;
+        joint->node[0].body->posr->pos[2] -= dz;
     }
 
     setAnchors (joint,x ,y, z, joint->anchor1, joint->anchor2);
 
     if (joint->node[0].body)
     {
-        joint->node[0].body->posr.pos[0] += dx;
-        joint->node[0].body->posr.pos[1] += dy;
-        joint->node[0].body->posr.pos[2] += dz;
+        joint->node[0].body->posr->pos[0] += dx;
+        joint->node[0].body->posr->pos[1] += dy;
+        joint->node[0].body->posr->pos[2] += dz;
     }
 
     joint->computeInitialRelativeRotation();
@@ -519,22 +519,22 @@ void dJointSetPistonAxisDelta ( dJointID j, dReal x, dReal y, dReal z,
     dVector3 c = {0,0,0};
     if ( joint->node[1].body )
     {
-        c[0] = ( joint->node[0].body->posr.pos[0] -
-                 joint->node[1].body->posr.pos[0] - dx );
-        c[1] = ( joint->node[0].body->posr.pos[1] -
-                 joint->node[1].body->posr.pos[1] - dy );
-        c[2] = ( joint->node[0].body->posr.pos[2] -
-                 joint->node[1].body->posr.pos[2] - dz );
+        c[0] = ( joint->node[0].body->posr->pos[0] -
+                 joint->node[1].body->posr->pos[0] - dx );
+        c[1] = ( joint->node[0].body->posr->pos[1] -
+                 joint->node[1].body->posr->pos[1] - dy );
+        c[2] = ( joint->node[0].body->posr->pos[2] -
+                 joint->node[1].body->posr->pos[2] - dz );
     }
     else if ( joint->node[0].body )
     {
-        c[0] = joint->node[0].body->posr.pos[0] - dx;
-        c[1] = joint->node[0].body->posr.pos[1] - dy;
-        c[2] = joint->node[0].body->posr.pos[2] - dz;
+        c[0] = joint->node[0].body->posr->pos[0] - dx;
+        c[1] = joint->node[0].body->posr->pos[1] - dy;
+        c[2] = joint->node[0].body->posr->pos[2] - dz;
     }
 
     // Convert into frame of body 1
-    dMultiply1_331 ( joint->anchor1, joint->node[0].body->posr.R, c );
+    dMultiply1_331 ( joint->anchor1, joint->node[0].body->posr->R, c );
 }
 
 
@@ -652,12 +652,12 @@ void dJointAddPistonForce ( dJointID j, dReal force )
         // d is the position of the prismatic joint (i.e. elongation)
         // Since axis1 x axis1 == 0
         // We can do the following.
-        dMultiply0_331 ( c, joint->node[0].body->posr.R, joint->anchor1 );
+        dMultiply0_331 ( c, joint->node[0].body->posr->R, joint->anchor1 );
         dCalcVectorCross3( ltd, c, axis );
         dBodyAddTorque ( joint->node[0].body, ltd[0], ltd[1], ltd[2] );
 
 
-        dMultiply0_331 ( c, joint->node[1].body->posr.R, joint->anchor2 );
+        dMultiply0_331 ( c, joint->node[1].body->posr->R, joint->anchor2 );
         dCalcVectorCross3( ltd, c, axis );
         dBodyAddTorque ( joint->node[1].body, ltd[0], ltd[1], ltd[2] );
     }
@@ -119,7 +119,7 @@ dxJointPlane2D::getInfo2( dxJoint::Info2 *info )
     // error correction (against drift):
 
     // a) linear vz, so that z (== pos[2]) == 0
-    info->c[0] = eps * -node[0].body->posr.pos[2];
+    info->c[0] = eps * -node[0].body->posr->pos[2];
 
 # if 0
     // b) angular correction? -> left to application !!!
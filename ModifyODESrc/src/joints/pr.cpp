@@ -67,21 +67,21 @@ dReal dJointGetPRPosition( dJointID j )
 
     dVector3 q;
     // get the offset in global coordinates
-    dMultiply0_331( q, joint->node[0].body->posr.R, joint->offset );
+    dMultiply0_331( q, joint->node[0].body->posr->R, joint->offset );
 
     if ( joint->node[1].body )
     {
         dVector3 anchor2;
 
         // get the anchor2 in global coordinates
-        dMultiply0_331( anchor2, joint->node[1].body->posr.R, joint->anchor2 );
+        dMultiply0_331( anchor2, joint->node[1].body->posr->R, joint->anchor2 );
 
-        q[0] = (( joint->node[0].body->posr.pos[0] + q[0] ) -
-                ( joint->node[1].body->posr.pos[0] + anchor2[0] ) );
-        q[1] = (( joint->node[0].body->posr.pos[1] + q[1] ) -
-                ( joint->node[1].body->posr.pos[1] + anchor2[1] ) );
-        q[2] = (( joint->node[0].body->posr.pos[2] + q[2] ) -
-                ( joint->node[1].body->posr.pos[2] + anchor2[2] ) );
+        q[0] = (( joint->node[0].body->posr->pos[0] + q[0] ) -
+                ( joint->node[1].body->posr->pos[0] + anchor2[0] ) );
+        q[1] = (( joint->node[0].body->posr->pos[1] + q[1] ) -
+                ( joint->node[1].body->posr->pos[1] + anchor2[1] ) );
+        q[2] = (( joint->node[0].body->posr->pos[2] + q[2] ) -
+                ( joint->node[1].body->posr->pos[2] + anchor2[2] ) );
 
     }
     else
@@ -89,11 +89,11 @@ dReal dJointGetPRPosition( dJointID j )
         //N.B. When there is no body 2 the joint->anchor2 is already in
         //     global coordinates
 
-        q[0] = (( joint->node[0].body->posr.pos[0] + q[0] ) -
+        q[0] = (( joint->node[0].body->posr->pos[0] + q[0] ) -
                 ( joint->anchor2[0] ) );
-        q[1] = (( joint->node[0].body->posr.pos[1] + q[1] ) -
+        q[1] = (( joint->node[0].body->posr->pos[1] + q[1] ) -
                 ( joint->anchor2[1] ) );
-        q[2] = (( joint->node[0].body->posr.pos[2] + q[2] ) -
+        q[2] = (( joint->node[0].body->posr->pos[2] + q[2] ) -
                 ( joint->anchor2[2] ) );
 
         if ( joint->flags & dJOINT_REVERSE )
@@ -106,7 +106,7 @@ dReal dJointGetPRPosition( dJointID j )
 
     dVector3 axP;
     // get prismatic axis in global coordinates
-    dMultiply0_331( axP, joint->node[0].body->posr.R, joint->axisP1 );
+    dMultiply0_331( axP, joint->node[0].body->posr->R, joint->axisP1 );
 
     return dCalcVectorDot3( axP, q );
 }
@@ -118,7 +118,7 @@ dReal dJointGetPRPositionRate( dJointID j )
     checktype( joint, PR );
     // get axis1 in global coordinates
     dVector3 ax1;
-    dMultiply0_331( ax1, joint->node[0].body->posr.R, joint->axisP1 );
+    dMultiply0_331( ax1, joint->node[0].body->posr->R, joint->axisP1 );
 
     if ( joint->node[1].body )
     {
@@ -164,7 +164,7 @@ dReal dJointGetPRAngleRate( dJointID j )
     if ( joint->node[0].body )
     {
         dVector3 axis;
-        dMultiply0_331( axis, joint->node[0].body->posr.R, joint->axisR1 );
+        dMultiply0_331( axis, joint->node[0].body->posr->R, joint->axisR1 );
         dReal rate = dCalcVectorDot3( axis, joint->node[0].body->avel );
         if ( joint->node[1].body ) rate -= dCalcVectorDot3( axis, joint->node[1].body->avel );
         if ( joint->flags & dJOINT_REVERSE ) rate = -rate;
@@ -240,12 +240,12 @@ dxJointPR::getInfo2( dxJoint::Info2 *info )
     // vector pos2-pos1.
 
     dReal *pos1, *pos2 = 0, *R1, *R2 = 0;
-    pos1 = node[0].body->posr.pos;
-    R1 = node[0].body->posr.R;
+    pos1 = node[0].body->posr->pos;
+    R1 = node[0].body->posr->R;
     if ( node[1].body )
     {
-        pos2 = node[1].body->posr.pos;
-        R2 = node[1].body->posr.R;
+        pos2 = node[1].body->posr->pos;
+        R2 = node[1].body->posr->R;
     }
     else
     {
@@ -297,7 +297,7 @@ dxJointPR::getInfo2( dxJoint::Info2 *info )
     // where p and q are unit vectors normal to the rotoide axis, and w1 and w2
     // are the angular velocity vectors of the two bodies.
     dVector3 ax1;
-    dMultiply0_331( ax1, node[0].body->posr.R, axisR1 );
+    dMultiply0_331( ax1, node[0].body->posr->R, axisR1 );
     dCalcVectorCross3( q , ax1, axP );
 
     info->J1a[0] = axP[0];
@@ -82,32 +82,32 @@ dReal dJointGetPUPosition( dJointID j )
 
     dVector3 q;
     // get the offset in global coordinates
-    dMultiply0_331( q, joint->node[0].body->posr.R, joint->anchor1 );
+    dMultiply0_331( q, joint->node[0].body->posr->R, joint->anchor1 );
 
     if ( joint->node[1].body )
     {
         dVector3 anchor2;
 
         // get the anchor2 in global coordinates
-        dMultiply0_331( anchor2, joint->node[1].body->posr.R, joint->anchor2 );
-
-        q[0] = (( joint->node[0].body->posr.pos[0] + q[0] ) -
-                ( joint->node[1].body->posr.pos[0] + anchor2[0] ) );
-        q[1] = (( joint->node[0].body->posr.pos[1] + q[1] ) -
-                ( joint->node[1].body->posr.pos[1] + anchor2[1] ) );
-        q[2] = (( joint->node[0].body->posr.pos[2] + q[2] ) -
-                ( joint->node[1].body->posr.pos[2] + anchor2[2] ) );
+        dMultiply0_331( anchor2, joint->node[1].body->posr->R, joint->anchor2 );
+
+        q[0] = (( joint->node[0].body->posr->pos[0] + q[0] ) -
+                ( joint->node[1].body->posr->pos[0] + anchor2[0] ) );
+        q[1] = (( joint->node[0].body->posr->pos[1] + q[1] ) -
+                ( joint->node[1].body->posr->pos[1] + anchor2[1] ) );
+        q[2] = (( joint->node[0].body->posr->pos[2] + q[2] ) -
+                ( joint->node[1].body->posr->pos[2] + anchor2[2] ) );
     }
     else
     {
         //N.B. When there is no body 2 the joint->anchor2 is already in
         //     global coordinates
 
-        q[0] = (( joint->node[0].body->posr.pos[0] + q[0] ) -
+        q[0] = (( joint->node[0].body->posr->pos[0] + q[0] ) -
                 ( joint->anchor2[0] ) );
-        q[1] = (( joint->node[0].body->posr.pos[1] + q[1] ) -
+        q[1] = (( joint->node[0].body->posr->pos[1] + q[1] ) -
                 ( joint->anchor2[1] ) );
-        q[2] = (( joint->node[0].body->posr.pos[2] + q[2] ) -
+        q[2] = (( joint->node[0].body->posr->pos[2] + q[2] ) -
                 ( joint->anchor2[2] ) );
 
         if ( joint->flags & dJOINT_REVERSE )
@@ -120,7 +120,7 @@ dReal dJointGetPUPosition( dJointID j )
 
     dVector3 axP;
     // get prismatic axis in global coordinates
-    dMultiply0_331( axP, joint->node[0].body->posr.R, joint->axisP1 );
+    dMultiply0_331( axP, joint->node[0].body->posr->R, joint->axisP1 );
 
     return dCalcVectorDot3( axP, q );
 }
@@ -144,21 +144,21 @@ dReal dJointGetPUPositionRate( dJointID j )
         if ( joint->node[1].body )
         {
             // Find joint->anchor2 in global coordinates
-            dMultiply0_331( anchor2, joint->node[1].body->posr.R, joint->anchor2 );
-
-            r[0] = ( joint->node[0].body->posr.pos[0] -
-                     ( anchor2[0] + joint->node[1].body->posr.pos[0] ) );
-            r[1] = ( joint->node[0].body->posr.pos[1] -
-                     ( anchor2[1] + joint->node[1].body->posr.pos[1] ) );
-            r[2] = ( joint->node[0].body->posr.pos[2] -
-                     ( anchor2[2] + joint->node[1].body->posr.pos[2] ) );
+            dMultiply0_331( anchor2, joint->node[1].body->posr->R, joint->anchor2 );
+
+            r[0] = ( joint->node[0].body->posr->pos[0] -
+                     ( anchor2[0] + joint->node[1].body->posr->pos[0] ) );
+            r[1] = ( joint->node[0].body->posr->pos[1] -
+                     ( anchor2[1] + joint->node[1].body->posr->pos[1] ) );
+            r[2] = ( joint->node[0].body->posr->pos[2] -
+                     ( anchor2[2] + joint->node[1].body->posr->pos[2] ) );
         }
         else
         {
             //N.B. When there is no body 2 the joint->anchor2 is already in
             //     global coordinates
-            // r = joint->node[0].body->posr.pos -  joint->anchor2;
-            dSubtractVectors3( r, joint->node[0].body->posr.pos, joint->anchor2 );
+            // r = joint->node[0].body->posr->pos -  joint->anchor2;
+            dSubtractVectors3( r, joint->node[0].body->posr->pos, joint->anchor2 );
         }
 
         // The body1 can have velocity coming from the rotation of
@@ -176,7 +176,7 @@ dReal dJointGetPUPositionRate( dJointID j )
         // get axisP1 in global coordinates and get the component
         // along this axis only
         dVector3 axP1;
-        dMultiply0_331( axP1, joint->node[0].body->posr.R, joint->axisP1 );
+        dMultiply0_331( axP1, joint->node[0].body->posr->R, joint->axisP1 );
 
         if ( joint->node[1].body )
         {
@@ -272,12 +272,12 @@ dxJointPU::getInfo2( dxJoint::Info2 *info )
     // vector pos2-pos1.
 
     dReal *pos1, *pos2 = 0, *R1, *R2 = 0;
-    pos1 = node[0].body->posr.pos;
-    R1 = node[0].body->posr.R;
+    pos1 = node[0].body->posr->pos;
+    R1 = node[0].body->posr->R;
     if ( node[1].body )
     {
-        pos2 = node[1].body->posr.pos;
-        R2 = node[1].body->posr.R;
+        pos2 = node[1].body->posr->pos;
+        R2 = node[1].body->posr->R;
     }
 
     dVector3 axP; // Axis of the prismatic joint in global frame
@@ -491,18 +491,18 @@ void dJointSetPUAnchorDelta( dJointID j, dReal x, dReal y, dReal z,
 
     if ( joint->node[0].body )
     {
-        joint->node[0].body->posr.pos[0] += dx;
-        joint->node[0].body->posr.pos[1] += dy;
-        joint->node[0].body->posr.pos[2] += dz;
+        joint->node[0].body->posr->pos[0] += dx;
+        joint->node[0].body->posr->pos[1] += dy;
+        joint->node[0].body->posr->pos[2] += dz;
     }
 
     setAnchors( joint, x, y, z, joint->anchor1, joint->anchor2 );
 
     if ( joint->node[0].body )
     {
-        joint->node[0].body->posr.pos[0] -= dx;
-        joint->node[0].body->posr.pos[1] -= dy;
-        joint->node[0].body->posr.pos[2] -= dz;
+        joint->node[0].body->posr->pos[0] -= dx;
+        joint->node[0].body->posr->pos[1] -= dy;
+        joint->node[0].body->posr->pos[2] -= dz;
     }
 
     joint->computeInitialRelativeRotations();
@@ -555,18 +555,18 @@ void dJointSetPUAnchorOffset( dJointID j, dReal x, dReal y, dReal z,
 
     if ( joint->node[0].body )
     {
-        joint->node[0].body->posr.pos[0] -= dx;
-        joint->node[0].body->posr.pos[1] -= dy;
-        joint->node[0].body->posr.pos[2] -= dz;
+        joint->node[0].body->posr->pos[0] -= dx;
+        joint->node[0].body->posr->pos[1] -= dy;
+        joint->node[0].body->posr->pos[2] -= dz;
     }
 
     setAnchors( joint, x, y, z, joint->anchor1, joint->anchor2 );
 
     if ( joint->node[0].body )
     {
-        joint->node[0].body->posr.pos[0] += dx;
-        joint->node[0].body->posr.pos[1] += dy;
-        joint->node[0].body->posr.pos[2] += dz;
+        joint->node[0].body->posr->pos[0] += dx;
+        joint->node[0].body->posr->pos[1] += dy;
+        joint->node[0].body->posr->pos[2] += dz;
     }
 
     joint->computeInitialRelativeRotations();
@@ -49,22 +49,22 @@ dReal dJointGetSliderPosition ( dJointID j )
 
     // get axis1 in global coordinates
     dVector3 ax1, q;
-    dMultiply0_331 ( ax1, joint->node[0].body->posr.R, joint->axis1 );
+    dMultiply0_331 ( ax1, joint->node[0].body->posr->R, joint->axis1 );
 
     if ( joint->node[1].body )
     {
         // get body2 + offset point in global coordinates
-        dMultiply0_331 ( q, joint->node[1].body->posr.R, joint->offset );
+        dMultiply0_331 ( q, joint->node[1].body->posr->R, joint->offset );
         for ( int i = 0; i < 3; i++ )
-            q[i] = joint->node[0].body->posr.pos[i]
+            q[i] = joint->node[0].body->posr->pos[i]
                    - q[i]
-                   - joint->node[1].body->posr.pos[i];
+                   - joint->node[1].body->posr->pos[i];
     }
     else
     {
-        q[0] = joint->node[0].body->posr.pos[0] - joint->offset[0];
-        q[1] = joint->node[0].body->posr.pos[1] - joint->offset[1];
-        q[2] = joint->node[0].body->posr.pos[2] - joint->offset[2];
+        q[0] = joint->node[0].body->posr->pos[0] - joint->offset[0];
+        q[1] = joint->node[0].body->posr->pos[1] - joint->offset[1];
+        q[2] = joint->node[0].body->posr->pos[2] - joint->offset[2];
 
         if ( joint->flags & dJOINT_REVERSE )
         {
@@ -89,7 +89,7 @@ dReal dJointGetSliderPositionRate ( dJointID j )
 
     // get axis1 in global coordinates
     dVector3 ax1;
-    dMultiply0_331 ( ax1, joint->node[0].body->posr.R, joint->axis1 );
+    dMultiply0_331 ( ax1, joint->node[0].body->posr->R, joint->axis1 );
 
     if ( joint->node[1].body )
     {
@@ -156,12 +156,12 @@ dxJointSlider::getInfo2 ( dxJoint::Info2 *info )
 
     dReal *pos1, *pos2, *R1, *R2;
     dVector3 c;
-    pos1 = node[0].body->posr.pos;
-    R1 = node[0].body->posr.R;
+    pos1 = node[0].body->posr->pos;
+    R1 = node[0].body->posr->R;
     if ( node[1].body )
     {
-        pos2 = node[1].body->posr.pos;
-        R2 = node[1].body->posr.R;
+        pos2 = node[1].body->posr->pos;
+        R2 = node[1].body->posr->R;
         for ( i = 0; i < 3; i++ )
             c[i] = pos2[i] - pos1[i];
     }
@@ -320,9 +320,9 @@ void dJointAddSliderForce ( dJointID j, dReal force )
         dVector3 ltd; // Linear Torque Decoupling vector (a torque)
 
         dVector3 c;
-        c[0] = REAL ( 0.5 ) * ( joint->node[1].body->posr.pos[0] - joint->node[0].body->posr.pos[0] );
-        c[1] = REAL ( 0.5 ) * ( joint->node[1].body->posr.pos[1] - joint->node[0].body->posr.pos[1] );
-        c[2] = REAL ( 0.5 ) * ( joint->node[1].body->posr.pos[2] - joint->node[0].body->posr.pos[2] );
+        c[0] = REAL ( 0.5 ) * ( joint->node[1].body->posr->pos[0] - joint->node[0].body->posr->pos[0] );
+        c[1] = REAL ( 0.5 ) * ( joint->node[1].body->posr->pos[1] - joint->node[0].body->posr->pos[1] );
+        c[2] = REAL ( 0.5 ) * ( joint->node[1].body->posr->pos[2] - joint->node[0].body->posr->pos[2] );
         dCalcVectorCross3( ltd, c, axis );
 
         dBodyAddTorque ( joint->node[0].body, ltd[0], ltd[1], ltd[2] );
@@ -385,16 +385,16 @@ dxJointSlider::computeOffset()
     if ( node[1].body )
     {
         dVector3 c;
-        c[0] = node[0].body->posr.pos[0] - node[1].body->posr.pos[0];
-        c[1] = node[0].body->posr.pos[1] - node[1].body->posr.pos[1];
-        c[2] = node[0].body->posr.pos[2] - node[1].body->posr.pos[2];
+        c[0] = node[0].body->posr->pos[0] - node[1].body->posr->pos[0];
+        c[1] = node[0].body->posr->pos[1] - node[1].body->posr->pos[1];
+        c[2] = node[0].body->posr->pos[2] - node[1].body->posr->pos[2];
 
-        dMultiply1_331 ( offset, node[1].body->posr.R, c );
+        dMultiply1_331 ( offset, node[1].body->posr->R, c );
     }
     else if ( node[0].body )
     {
-        offset[0] = node[0].body->posr.pos[0];
-        offset[1] = node[0].body->posr.pos[1];
-        offset[2] = node[0].body->posr.pos[2];
+        offset[0] = node[0].body->posr->pos[0];
+        offset[1] = node[0].body->posr->pos[1];
+        offset[2] = node[0].body->posr->pos[2];
     }
 }
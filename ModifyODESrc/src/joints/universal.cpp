@@ -54,12 +54,12 @@ dxJointUniversal::dxJointUniversal( dxWorld *w ) :
 void
 dxJointUniversal::getAxes( dVector3 ax1, dVector3 ax2 )
 {
-    // This says "ax1 = joint->node[0].body->posr.R * joint->axis1"
-    dMultiply0_331( ax1, node[0].body->posr.R, axis1 );
+    // This says "ax1 = joint->node[0].body->posr->R * joint->axis1"
+    dMultiply0_331( ax1, node[0].body->posr->R, axis1 );
 
     if ( node[1].body )
     {
-        dMultiply0_331( ax2, node[1].body->posr.R, axis2 );
+        dMultiply0_331( ax2, node[1].body->posr->R, axis2 );
     }
     else
     {
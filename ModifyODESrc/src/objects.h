@@ -45,6 +45,7 @@ enum {
   dxBodyAngularDamping =            64, // use angular damping
   dxBodyMaxAngularSpeed =           128,// use maximum angular speed
   dxBodyGyroscopic =                256,// use gyroscopic term
+  dxBodyFastMoving =                512,// swept before collision, see dSpaceSweepFastBodies
 };
 
 
@@ -126,11 +127,19 @@ struct dxBody : public dObject {
   dMatrix3 curI;    // mass.I in current frame
   //dVector3 curIavel_h; // I*qdot/h;
   /////////////////////
-  dxPosR posr;			// position and orientation of point of reference
-  dQuaternion q;		// orientation quaternion
-  dVector3 lvel,avel;		// linear and angular velocity of POR
+  // the state below points either into the own_ members or, if the world
+  // keeps its body state contiguous, into the arrays of world->body_storage
+  dxPosR *posr;			// position and orientation of point of reference
+  dReal *q;			// orientation quaternion
+  dReal *lvel,*avel;		// linear and angular velocity of POR
+  int storage_index;		// row in world->body_storage, or -1
+  dxPosR own_posr;
+  dQuaternion own_q;
+  dVector3 own_lvel,own_avel;
   dVector3 facc,tacc;		// force and torque accumulators
   dVector3 finite_rot_axis;	// finite rotation axis, unit length or 0=none
+  dReal sweep_step_scale;	// part of the next step left for the linear motion
+				// after dSpaceSweepFastBodies advanced the body, else 1
 
   // auto-disable information
   dxAutoDisable adis;		// auto-disable parameters
@@ -149,6 +158,34 @@ struct dxBody : public dObject {
 };
 
 
+// let the geoms that share the posr of body b follow it after b->posr moved
+// from old_posr (in collision_kernel.cpp)
+void dxBodyPosrMoved (dxBody *b, dxPosR *old_posr);
+
+
+// contiguous state of all bodies of a world, see dWorldSetContiguousBodyStorage
+struct dxBodyStorage {
+  int size, capacity;
+  unsigned generation;		// incremented when the arrays move or rows are reordered
+  dxBody **bodies;		// body of each row
+  dxPosR *posr;
+  dQuaternion *q;
+  dVector3 *lvel, *avel;
+};
+
+
+// phase accumulators of the world profiler, see world_profile.h. indexed by
+// the dProfile* phases of <ode/objects.h>, which includes this header through
+// extutils.h, so the size is fixed here and checked in world_profile.cpp
+#define dxPROFILE_MAX_PHASES 16
+struct dxWorldProfile {
+  int enabled;
+  unsigned long long steps;
+  unsigned long long ticks[dxPROFILE_MAX_PHASES];	// nanoseconds
+  unsigned long long calls[dxPROFILE_MAX_PHASES];
+};
+
+
 struct dxWorld : public dBase {
   dxBody *firstbody;		// body linked list
   dxJoint *firstjoint;		// joint linked list
@@ -164,6 +201,9 @@ struct dxWorld : public dBase {
   dxContactParameters contactp;
   dxDampingParameters dampingp; // damping parameters
   dReal max_angular_speed;      // limit the angular velocity to this magnitude
+  dxBodyStorage *body_storage;  // 0 if each body holds its own state
+  unsigned long rand_seed;      // random state of the solvers, instead of the global dRand seed
+  dxWorldProfile profile;       // phase timings, off unless dWorldSetProfiling
 };
 
 
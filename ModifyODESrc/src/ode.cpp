@@ -37,6 +37,7 @@
 #include "joints/joints.h"
 #include "step.h"
 #include "quickstep.h"
+#include "world_profile.h"
 #include "util.h"
 #include "odetls.h"
 
@@ -229,6 +230,89 @@ void dWorldCheck (dxWorld *w)
   checkWorld (w);
 }
 
+//****************************************************************************
+// contiguous body storage
+
+// point the state of body b to row i of the storage, copying its current
+// state there first
+static void bodyStorageMove (dxBodyStorage *s, dxBody *b, int i)
+{
+  dxPosR *old_posr = b->posr;
+  if (old_posr != s->posr + i) {
+    s->posr[i] = *old_posr;
+    memcpy (s->q[i],b->q,sizeof(dQuaternion));
+    memcpy (s->lvel[i],b->lvel,sizeof(dVector3));
+    memcpy (s->avel[i],b->avel,sizeof(dVector3));
+  }
+  b->posr = s->posr + i;
+  b->q = s->q[i];
+  b->lvel = s->lvel[i];
+  b->avel = s->avel[i];
+  b->storage_index = i;
+  s->bodies[i] = b;
+  dxBodyPosrMoved (b,old_posr);
+}
+
+
+// point the state of body b back to its own members
+static void bodyStorageDetach (dxBody *b)
+{
+  dxPosR *old_posr = b->posr;
+  b->own_posr = *old_posr;
+  memcpy (b->own_q,b->q,sizeof(dQuaternion));
+  memcpy (b->own_lvel,b->lvel,sizeof(dVector3));
+  memcpy (b->own_avel,b->avel,sizeof(dVector3));
+  b->posr = &b->own_posr;
+  b->q = b->own_q;
+  b->lvel = b->own_lvel;
+  b->avel = b->own_avel;
+  b->storage_index = -1;
+  dxBodyPosrMoved (b,old_posr);
+}
+
+
+static void bodyStorageReserve (dxBodyStorage *s, int capacity)
+{
+  if (capacity <= s->capacity) return;
+  dxBodyStorage old = *s;
+  s->capacity = capacity;
+  s->bodies = (dxBody**) dAlloc (capacity * sizeof(dxBody*));
+  s->posr = (dxPosR*) dAlloc (capacity * sizeof(dxPosR));
+  s->q = (dQuaternion*) dAlloc (capacity * sizeof(dQuaternion));
+  s->lvel = (dVector3*) dAlloc (capacity * sizeof(dVector3));
+  s->avel = (dVector3*) dAlloc (capacity * sizeof(dVector3));
+  for (int i=0; i<s->size; i++) bodyStorageMove (s,old.bodies[i],i);
+  s->generation++;
+  if (old.capacity) {
+    dFree (old.bodies,old.capacity * sizeof(dxBody*));
+    dFree (old.posr,old.capacity * sizeof(dxPosR));
+    dFree (old.q,old.capacity * sizeof(dQuaternion));
+    dFree (old.lvel,old.capacity * sizeof(dVector3));
+    dFree (old.avel,old.capacity * sizeof(dVector3));
+  }
+}
+
+
+static void bodyStorageAdd (dxBodyStorage *s, dxBody *b)
+{
+  if (s->size == s->capacity) bodyStorageReserve (s,s->capacity ? 2*s->capacity : 16);
+  bodyStorageMove (s,b,s->size++);
+}
+
+
+// remove body b, filling its row with the last one
+static void bodyStorageRemove (dxBodyStorage *s, dxBody *b)
+{
+  int i = b->storage_index;
+  dIASSERT (i >= 0 && i < s->size && s->bodies[i] == b);
+  bodyStorageDetach (b);
+  s->size--;
+  if (i != s->size) {
+    bodyStorageMove (s,s->bodies[s->size],i);
+    s->generation++;
+  }
+}
+
 //****************************************************************************
 // body
 
@@ -260,17 +344,24 @@ dxBody *dBodyCreate (dxWorld *w)
   b->invI[5] = 1;
   b->invI[10] = 1;
   b->invMass = 1;
-  dSetZero (b->posr.pos,4);
+  b->posr = &b->own_posr;
+  b->q = b->own_q;
+  b->lvel = b->own_lvel;
+  b->avel = b->own_avel;
+  b->storage_index = -1;
+  dSetZero (b->posr->pos,4);
   dSetZero (b->q,4);
   b->q[0] = 1;
-  dRSetIdentity (b->posr.R);
+  dRSetIdentity (b->posr->R);
   dSetZero (b->lvel,4);
   dSetZero (b->avel,4);
   dSetZero (b->facc,4);
   dSetZero (b->tacc,4);
   dSetZero (b->finite_rot_axis,4);
+  b->sweep_step_scale = 1;
   addObjectToList (b,(dObject **) &w->firstbody);
   w->nb++;
+  if (w->body_storage) bodyStorageAdd (w->body_storage,b);
 
   // set auto-disable parameters
   b->average_avel_buffer = b->average_lvel_buffer = 0; // no buffer at beginning
@@ -321,6 +412,7 @@ void dBodyDestroy (dxBody *b)
   }
   removeObjectFromList (b);
   b->world->nb--;
+  if (b->world->body_storage) bodyStorageRemove (b->world->body_storage,b);
 
   // delete the average buffers
   if(b->average_lvel_buffer)
@@ -355,9 +447,9 @@ void *dBodyGetData (dBodyID b)
 void dBodySetPosition (dBodyID b, dReal x, dReal y, dReal z)
 {
   dAASSERT (b);
-  b->posr.pos[0] = x;
-  b->posr.pos[1] = y;
-  b->posr.pos[2] = z;
+  b->posr->pos[0] = x;
+  b->posr->pos[1] = y;
+  b->posr->pos[2] = z;
 
   // notify all attached geoms that this body has moved
   for (dxGeom *geom = b->geom; geom; geom = dGeomGetBodyNext (geom))
@@ -367,7 +459,7 @@ void dBodySetPosition (dBodyID b, dReal x, dReal y, dReal z)
 // Add By Zhenhua Song
 void dBodySetRotAndQuatNoNorm(dBodyID b, const dMatrix3 R, const dQuaternion q) {
     dAASSERT(R && q);
-    memcpy(b->posr.R, R, sizeof(dMatrix3));
+    memcpy(b->posr->R, R, sizeof(dMatrix3));
     memcpy(b->q, q, sizeof(dQuaternion));
 
     // notify all attached geoms that this body has moved
@@ -379,8 +471,8 @@ void dBodySetRotation (dBodyID b, const dMatrix3 R)
 {
   dAASSERT (b && R);
 
-  memcpy(b->posr.R, R, sizeof(dMatrix3));
-  dOrthogonalizeR(b->posr.R);
+  memcpy(b->posr->R, R, sizeof(dMatrix3));
+  dOrthogonalizeR(b->posr->R);
   dRtoQ (R, b->q);
   dNormalize4 (b->q);
 
@@ -398,7 +490,7 @@ void dBodySetQuaternion (dBodyID b, const dQuaternion q)
   b->q[2] = q[2];
   b->q[3] = q[3];
   dNormalize4 (b->q);
-  dQtoR (b->q,b->posr.R);
+  dQtoR (b->q,b->posr->R);
 
   // notify all attached geoms that this body has moved
   for (dxGeom *geom = b->geom; geom; geom = dGeomGetBodyNext (geom))
@@ -427,14 +519,14 @@ void dBodySetAngularVel (dBodyID b, dReal x, dReal y, dReal z)
 const dReal * dBodyGetPosition (dBodyID b)
 {
   dAASSERT (b);
-  return b->posr.pos;
+  return b->posr->pos;
 }
 
 
 void dBodyCopyPosition (dBodyID b, dVector3 pos)
 {
 	dAASSERT (b);
-	dReal* src = b->posr.pos;
+	dReal* src = b->posr->pos;
 	pos[0] = src[0];
 	pos[1] = src[1];
 	pos[2] = src[2];
@@ -444,14 +536,14 @@ void dBodyCopyPosition (dBodyID b, dVector3 pos)
 const dReal * dBodyGetRotation (dBodyID b)
 {
   dAASSERT (b);
-  return b->posr.R;
+  return b->posr->R;
 }
 
 
 void dBodyCopyRotation (dBodyID b, dMatrix3 R) // Modify by Zhenhua Song
 {
 	dAASSERT (b);
-	const dReal* src = b->posr.R;
+	const dReal* src = b->posr->R;
     memcpy(R, src, sizeof(dReal) * 12);
 }
 
@@ -541,7 +633,7 @@ void dBodyAddRelForce (dBodyID b, dReal fx, dReal fy, dReal fz)
   t1[1] = fy;
   t1[2] = fz;
   t1[3] = 0;
-  dMultiply0_331 (t2,b->posr.R,t1);
+  dMultiply0_331 (t2,b->posr->R,t1);
   b->facc[0] += t2[0];
   b->facc[1] += t2[1];
   b->facc[2] += t2[2];
@@ -556,7 +648,7 @@ void dBodyAddRelTorque (dBodyID b, dReal fx, dReal fy, dReal fz)
   t1[1] = fy;
   t1[2] = fz;
   t1[3] = 0;
-  dMultiply0_331 (t2,b->posr.R,t1);
+  dMultiply0_331 (t2,b->posr->R,t1);
   b->tacc[0] += t2[0];
   b->tacc[1] += t2[1];
   b->tacc[2] += t2[2];
@@ -574,9 +666,9 @@ void dBodyAddForceAtPos (dBodyID b, dReal fx, dReal fy, dReal fz,
   f[0] = fx;
   f[1] = fy;
   f[2] = fz;
-  q[0] = px - b->posr.pos[0];
-  q[1] = py - b->posr.pos[1];
-  q[2] = pz - b->posr.pos[2];
+  q[0] = px - b->posr->pos[0];
+  q[1] = py - b->posr->pos[1];
+  q[2] = pz - b->posr->pos[2];
   dAddVectorCross3(b->tacc,q,f);
 }
 
@@ -594,7 +686,7 @@ void dBodyAddForceAtRelPos (dBodyID b, dReal fx, dReal fy, dReal fz,
   prel[1] = py;
   prel[2] = pz;
   prel[3] = 0;
-  dMultiply0_331 (p,b->posr.R,prel);
+  dMultiply0_331 (p,b->posr->R,prel);
   b->facc[0] += f[0];
   b->facc[1] += f[1];
   b->facc[2] += f[2];
@@ -611,14 +703,14 @@ void dBodyAddRelForceAtPos (dBodyID b, dReal fx, dReal fy, dReal fz,
   frel[1] = fy;
   frel[2] = fz;
   frel[3] = 0;
-  dMultiply0_331 (f,b->posr.R,frel);
+  dMultiply0_331 (f,b->posr->R,frel);
   b->facc[0] += f[0];
   b->facc[1] += f[1];
   b->facc[2] += f[2];
   dVector3 q;
-  q[0] = px - b->posr.pos[0];
-  q[1] = py - b->posr.pos[1];
-  q[2] = pz - b->posr.pos[2];
+  q[0] = px - b->posr->pos[0];
+  q[1] = py - b->posr->pos[1];
+  q[2] = pz - b->posr->pos[2];
   dAddVectorCross3(b->tacc,q,f);
 }
 
@@ -636,8 +728,8 @@ void dBodyAddRelForceAtRelPos (dBodyID b, dReal fx, dReal fy, dReal fz,
   prel[1] = py;
   prel[2] = pz;
   prel[3] = 0;
-  dMultiply0_331 (f,b->posr.R,frel);
-  dMultiply0_331 (p,b->posr.R,prel);
+  dMultiply0_331 (f,b->posr->R,frel);
+  dMultiply0_331 (p,b->posr->R,prel);
   b->facc[0] += f[0];
   b->facc[1] += f[1];
   b->facc[2] += f[2];
@@ -686,10 +778,10 @@ void dBodyGetRelPointPos (dBodyID b, dReal px, dReal py, dReal pz,
   prel[1] = py;
   prel[2] = pz;
   prel[3] = 0;
-  dMultiply0_331 (p,b->posr.R,prel);
-  result[0] = p[0] + b->posr.pos[0];
-  result[1] = p[1] + b->posr.pos[1];
-  result[2] = p[2] + b->posr.pos[2];
+  dMultiply0_331 (p,b->posr->R,prel);
+  result[0] = p[0] + b->posr->pos[0];
+  result[1] = p[1] + b->posr->pos[1];
+  result[2] = p[2] + b->posr->pos[2];
 }
 
 
@@ -701,7 +793,7 @@ void dBodyGetRelPointVel (dBodyID b, dReal px, dReal py, dReal pz, dVector3 resu
   prel[1] = py;
   prel[2] = pz;
   prel[3] = 0;
-  dMultiply0_331 (p,b->posr.R,prel);
+  dMultiply0_331 (p,b->posr->R,prel);
   result[0] = b->lvel[0];
   result[1] = b->lvel[1];
   result[2] = b->lvel[2];
@@ -714,9 +806,9 @@ void dBodyGetPointVel (dBodyID b, dReal px, dReal py, dReal pz,
 {
   dAASSERT (b);
   dVector3 p;
-  p[0] = px - b->posr.pos[0];
-  p[1] = py - b->posr.pos[1];
-  p[2] = pz - b->posr.pos[2];
+  p[0] = px - b->posr->pos[0];
+  p[1] = py - b->posr->pos[1];
+  p[2] = pz - b->posr->pos[2];
   p[3] = 0;
   result[0] = b->lvel[0];
   result[1] = b->lvel[1];
@@ -730,11 +822,11 @@ void dBodyGetPosRelPoint (dBodyID b, dReal px, dReal py, dReal pz,
 {
   dAASSERT (b);
   dVector3 prel;
-  prel[0] = px - b->posr.pos[0];
-  prel[1] = py - b->posr.pos[1];
-  prel[2] = pz - b->posr.pos[2];
+  prel[0] = px - b->posr->pos[0];
+  prel[1] = py - b->posr->pos[1];
+  prel[2] = pz - b->posr->pos[2];
   prel[3] = 0;
-  dMultiply1_331 (result,b->posr.R,prel);
+  dMultiply1_331 (result,b->posr->R,prel);
 }
 
 
@@ -747,7 +839,7 @@ void dBodyVectorToWorld (dBodyID b, dReal px, dReal py, dReal pz,
   p[1] = py;
   p[2] = pz;
   p[3] = 0;
-  dMultiply0_331 (result,b->posr.R,p);
+  dMultiply0_331 (result,b->posr->R,p);
 }
 
 
@@ -760,7 +852,7 @@ void dBodyVectorFromWorld (dBodyID b, dReal px, dReal py, dReal pz,
   p[1] = py;
   p[2] = pz;
   p[3] = 0;
-  dMultiply1_331 (result,b->posr.R,p);
+  dMultiply1_331 (result,b->posr->R,p);
 }
 
 
@@ -1150,6 +1242,27 @@ void dBodySetGyroscopicMode(dBodyID b, int enabled)
                 b->flags &= ~dxBodyGyroscopic;
 }
 
+int dBodyGetFastMoving(dBodyID b)
+{
+        dAASSERT(b);
+        return (b->flags & dxBodyFastMoving) != 0;
+}
+
+void dBodySetFastMoving(dBodyID b, int enabled)
+{
+        dAASSERT(b);
+        if (enabled)
+                b->flags |= dxBodyFastMoving;
+        else
+                b->flags &= ~dxBodyFastMoving;
+}
+
+int dBodyGetStorageIndex(dBodyID b)
+{
+        dAASSERT(b);
+        return b->storage_index;
+}
+
 // Add by Zhenhua Song
 int dBodyGetNumGeoms(dBodyID b)
 {
@@ -1176,8 +1289,8 @@ void dBodyGetInertia(dBodyID b, dReal* out)
     dMatrix3 tmp;
     // compute inverse inertia tensor in global frame
     
-    dMultiply2_333(tmp, b->mass.I, b->posr.R);
-    dMultiply0_333(out, b->posr.R, tmp); // R * I * R^T
+    dMultiply2_333(tmp, b->mass.I, b->posr->R);
+    dMultiply0_333(out, b->posr->R, tmp); // R * I * R^T
 }
 
 // Add by Zhenhua Song
@@ -1187,8 +1300,8 @@ void dBodyGetInertiaInv(dBodyID b, dReal* out)
     dMatrix3 tmp;
     // compute inverse inertia tensor in global frame
 
-    dMultiply2_333(tmp, b->invI, b->posr.R);
-    dMultiply0_333(out, b->posr.R, tmp); // R * invI * R^T
+    dMultiply2_333(tmp, b->invI, b->posr->R);
+    dMultiply0_333(out, b->posr->R, tmp); // R * invI * R^T
 }
 
 // Add by Zhenhua Song
@@ -1635,6 +1748,64 @@ ODE_API const dReal * dJointGetKd(dxJoint* joint) {
     return joint->aveldamping;
 }
 
+// Add by Zhenhua Song
+ODE_API void dJointSetStablePD(dxJoint* joint, dReal kp, dReal kd, dReal torque_limit) {
+    dAASSERT(joint);
+
+    joint->useStablePD = true;
+    joint->pdKp = kp;
+    joint->pdKd = kd;
+    joint->pdTorqueLimit = torque_limit;
+}
+
+// Add by Zhenhua Song
+ODE_API void dJointDisableStablePD(dxJoint* joint) {
+    dAASSERT(joint);
+
+    joint->useStablePD = false;
+}
+
+// Add by Zhenhua Song
+ODE_API int dJointIsStablePD(dxJoint* joint) {
+    dAASSERT(joint);
+
+    return joint->useStablePD;
+}
+
+// Add by Zhenhua Song
+ODE_API void dJointSetStablePDTarget(dxJoint* joint, const dReal * q) {
+    dAASSERT(joint && q);
+
+    joint->pdTarget[0] = q[0];
+    joint->pdTarget[1] = q[1];
+    joint->pdTarget[2] = q[2];
+    joint->pdTarget[3] = q[3];
+    dNormalize4(joint->pdTarget);
+}
+
+// Add by Zhenhua Song
+ODE_API const dReal * dJointGetStablePDTarget(dxJoint* joint) {
+    dAASSERT(joint);
+
+    return joint->pdTarget;
+}
+
+// Add by Zhenhua Song
+ODE_API void dJointSetStablePDTargets(dxJoint* const * joints, int count, const dReal * qs, int input_in_scipy) {
+    dAASSERT(joints || count == 0);
+
+    const int w_index = input_in_scipy ? 3 : 0, xyz_index = input_in_scipy ? 0 : 1;
+    for (int i = 0; i < count; i++, qs += 4)
+    {
+        dxJoint* joint = joints[i];
+        joint->pdTarget[0] = qs[w_index];
+        joint->pdTarget[1] = qs[xyz_index];
+        joint->pdTarget[2] = qs[xyz_index + 1];
+        joint->pdTarget[3] = qs[xyz_index + 2];
+        dNormalize4(joint->pdTarget);
+    }
+}
+
 int dAreConnected (dBodyID b1, dBodyID b2)
 {
   dAASSERT (b1/* && b2*/); // b2 can be NULL to test for connection to environment
@@ -1697,6 +1868,9 @@ dxWorld * dWorldCreate()
   w->dampingp.linear_threshold = REAL(0.01) * REAL(0.01);
   w->dampingp.angular_threshold = REAL(0.01) * REAL(0.01);  
   w->max_angular_speed = dInfinity;
+  w->body_storage = 0;
+  w->rand_seed = dRandGetSeed(); // so dRandSetSeed before creating the world still decides the sequence
+  memset (&w->profile, 0, sizeof(w->profile));
 
   return w;
 }
@@ -1737,6 +1911,7 @@ void dWorldDestroy (dxWorld *w)
     w->wmem->Release();
   }
 
+  dWorldSetContiguousBodyStorage (w,0);
   delete w;
 }
 
@@ -1912,8 +2087,10 @@ extern "C" int dWorldStep (dWorldID w, dReal stepsize)
   bool result = false;
 
   dxWorldProcessIslandsInfo islandsinfo;
+  unsigned long long profile_begin = dxProfileBegin (w);
   if (dxReallocateWorldProcessContext (w, islandsinfo, stepsize, &dxEstimateStepMemoryRequirements))
   {
+    dxProfileStepBegun (w, profile_begin);
     dxProcessIslands (w, islandsinfo, stepsize, &dInternalStepIsland);
     
     result = true;
@@ -1974,8 +2151,10 @@ int dWorldQuickStep (dWorldID w, dReal stepsize)
   bool result = false;
 
   dxWorldProcessIslandsInfo islandsinfo;
+  unsigned long long profile_begin = dxProfileBegin (w);
   if (dxReallocateWorldProcessContext (w, islandsinfo, stepsize, &dxEstimateQuickStepMemoryRequirements))
   {
+    dxProfileStepBegun (w, profile_begin);
     dxProcessIslands (w, islandsinfo, stepsize, &dxQuickStepper);
     
     result = true;
@@ -2170,6 +2349,86 @@ void dWorldSetMaxAngularSpeed(dWorldID w, dReal max_speed)
         w->max_angular_speed = max_speed;
 }
 
+unsigned long dWorldGetRandSeed(dWorldID w)
+{
+        dAASSERT(w);
+        return w->rand_seed;
+}
+
+void dWorldSetRandSeed(dWorldID w, unsigned long s)
+{
+        dAASSERT(w);
+        w->rand_seed = s;
+}
+
+
+void dWorldSetContiguousBodyStorage (dWorldID w, int enabled)
+{
+  dAASSERT (w);
+  dxBodyStorage *s = w->body_storage;
+  if (enabled && !s) {
+    s = new dxBodyStorage;
+    s->size = 0;
+    s->capacity = 0;
+    s->generation = 0;
+    bodyStorageReserve (s,w->nb > 16 ? w->nb : 16);
+    // rows in creation order, the body list starts with the newest body
+    s->size = w->nb;
+    int i = w->nb;
+    for (dxBody *b = w->firstbody; b; b = (dxBody*) b->next) bodyStorageMove (s,b,--i);
+    w->body_storage = s;
+  }
+  else if (!enabled && s) {
+    for (int i=0; i<s->size; i++) bodyStorageDetach (s->bodies[i]);
+    dFree (s->bodies,s->capacity * sizeof(dxBody*));
+    dFree (s->posr,s->capacity * sizeof(dxPosR));
+    dFree (s->q,s->capacity * sizeof(dQuaternion));
+    dFree (s->lvel,s->capacity * sizeof(dVector3));
+    dFree (s->avel,s->capacity * sizeof(dVector3));
+    delete s;
+    w->body_storage = 0;
+  }
+}
+
+
+int dWorldGetContiguousBodyStorage (dWorldID w)
+{
+  dAASSERT (w);
+  return w->body_storage != 0;
+}
+
+
+void dWorldReserveBodyStorage (dWorldID w, int capacity)
+{
+  dAASSERT (w);
+  if (w->body_storage) bodyStorageReserve (w->body_storage,capacity);
+}
+
+
+int dWorldGetBodyStorage (dWorldID w, dBodyStorageInfo *info)
+{
+  dAASSERT (w && info);
+  dxBodyStorage *s = w->body_storage;
+  if (!s) return 0;
+  info->num_bodies = s->size;
+  info->generation = s->generation;
+  info->posr = (dReal*) s->posr;
+  info->q = (dReal*) s->q;
+  info->lvel = (dReal*) s->lvel;
+  info->avel = (dReal*) s->avel;
+  return 1;
+}
+
+
+void dWorldBodyStorageMoved (dWorldID w)
+{
+  dAASSERT (w);
+  for (dxBody *b = w->firstbody; b; b = (dxBody*) b->next) {
+    for (dxGeom *geom = b->geom; geom; geom = dGeomGetBodyNext (geom))
+      dGeomMoved (geom);
+  }
+}
+
 
 void dWorldSetQuickStepNumIterations (dWorldID w, int num)
 {
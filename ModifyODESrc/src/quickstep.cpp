@@ -32,6 +32,7 @@
 #include "joints/joint.h"
 #include "lcp.h"
 #include "util.h"
+#include "world_profile.h"
 #include <ode/extutils.h>
 
 typedef const dReal *dRealPtr;
@@ -344,7 +345,7 @@ static void SOR_LCP (dxWorldProcessMemArena *memarena,
   const unsigned int m, const unsigned int nb, dRealMutablePtr J, int *jb, dxBody * const *body,
   dRealPtr invI, dRealMutablePtr lambda, dRealMutablePtr fc, dRealMutablePtr b,
   dRealPtr lo, dRealPtr hi, dRealPtr cfm, const int *findex,
-  const dxQuickStepParameters *qs)
+  const dxQuickStepParameters *qs, unsigned long *rand_seed)
 {
 #ifdef WARM_STARTING
   {
@@ -474,7 +475,7 @@ static void SOR_LCP (dxWorldProcessMemArena *memarena,
 #ifdef RANDOMLY_REORDER_CONSTRAINTS
     if ((iteration & 7) == 0) {
       for (unsigned int i=1; i<m; i++) {
-        int swapi = dRandInt(i+1);
+        int swapi = dRandIntR(rand_seed, i+1);
         IndexError tmp = order[i];
         order[i] = order[swapi];
         order[swapi] = tmp;
@@ -589,6 +590,7 @@ void dxQuickStepper (dxWorldProcessMemArena *memarena,
   dxJoint * const *_joint, unsigned int _nj, dReal stepsize)
 {
   IFTIMING(dTimerStart("preprocessing"));
+  dxProfilePhases profile_phases(world, dProfilePreprocess);
 
   const dReal stepsize1 = dRecip(stepsize);
 
@@ -610,14 +612,14 @@ void dxQuickStepper (dxWorldProcessMemArena *memarena,
       dxBody *b = *bodycurr;
 
       // compute inverse inertia tensor in global frame
-      dMultiply2_333 (tmp,b->invI,b->posr.R);
-      dMultiply0_333 (invIrow,b->posr.R,tmp);
+      dMultiply2_333 (tmp,b->invI,b->posr->R);
+      dMultiply0_333 (invIrow,b->posr->R,tmp);
 
       if (b->flags & dxBodyGyroscopic) {
         dMatrix3 I;
         // compute inertia tensor in global frame
-        dMultiply2_333 (tmp,b->mass.I,b->posr.R);
-        dMultiply0_333 (I,b->posr.R,tmp);
+        dMultiply2_333 (tmp,b->mass.I,b->posr->R);
+        dMultiply0_333 (I,b->posr->R,tmp);
         // compute rotational force
         dMultiply0_331 (tmp,I,b->avel);
         dSubtractVectorCross3(b->tacc,b->avel,tmp);
@@ -745,6 +747,7 @@ void dxQuickStepper (dxWorldProcessMemArena *memarena,
 
       {
         IFTIMING (dTimerNow ("create J"));
+        profile_phases.next(dProfileCreateJ);
         // get jacobian data from constraints. an m*12 matrix will be created
         // to store the two jacobian blocks from each constraint. it has this
         // format:
@@ -828,6 +831,7 @@ void dxQuickStepper (dxWorldProcessMemArena *memarena,
 
       BEGIN_STATE_SAVE(memarena, tmp1state) {
         IFTIMING (dTimerNow ("compute rhs"));
+        profile_phases.next(dProfileComputeRhs);
         // compute the right hand side `rhs'
         dReal *tmp1 = memarena->AllocateArray<dReal> ((size_t)nb*6);
         // put v/h + invM*fe into tmp1
@@ -875,8 +879,9 @@ void dxQuickStepper (dxWorldProcessMemArena *memarena,
 
     BEGIN_STATE_SAVE(memarena, lcpstate) {
       IFTIMING (dTimerNow ("solving LCP problem"));
+      profile_phases.next(dProfileSolveLCP);
       // solve the LCP problem and get lambda and invM*constraint_force
-      SOR_LCP (memarena,m,nb,J,jb,body,invI,lambda,cforce,rhs,lo,hi,cfm,findex,&world->qs);
+      SOR_LCP (memarena,m,nb,J,jb,body,invI,lambda,cforce,rhs,lo,hi,cfm,findex,&world->qs,&world->rand_seed);
 
     } END_STATE_SAVE(memarena, lcpstate);
 
@@ -956,6 +961,7 @@ void dxQuickStepper (dxWorldProcessMemArena *memarena,
 
   {
     IFTIMING (dTimerNow ("compute velocity update"));
+    profile_phases.next(dProfileIntegrateVelocity);
     // compute the velocity update:
     // add stepsize * invM * fe to the body velocity
     const dReal *invIrow = invI;
@@ -999,6 +1005,7 @@ void dxQuickStepper (dxWorldProcessMemArena *memarena,
     // update the position and orientation from the new linear/angular velocity
     // (over the given timestep)
     IFTIMING (dTimerNow ("update position"));
+    profile_phases.next(dProfileIntegratePosition);
     dxBody *const *const bodyend = body + nb;
     for (dxBody *const *bodycurr = body; bodycurr != bodyend; bodycurr++) {
       dxBody *b = *bodycurr;
@@ -1008,6 +1015,7 @@ void dxQuickStepper (dxWorldProcessMemArena *memarena,
 
   {
     IFTIMING (dTimerNow ("tidy up"));
+    profile_phases.next(dProfileTidyUp);
     // zero all force accumulators
     dxBody *const *const bodyend = body + nb;
     for (dxBody *const *bodycurr = body; bodycurr != bodyend; bodycurr++) {
@@ -1018,6 +1026,7 @@ void dxQuickStepper (dxWorldProcessMemArena *memarena,
   }
 
   IFTIMING (dTimerEnd());
+  profile_phases.end();
   IFTIMING (if (m > 0) dTimerReport (stdout,1));
 }
 
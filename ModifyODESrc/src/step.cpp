@@ -31,6 +31,7 @@
 #include "joints/joint.h"
 #include "lcp.h"
 #include "util.h"
+#include "world_profile.h"
 
 #include <ode/extutils.h> // Add by Zhenhua Song
 //****************************************************************************
@@ -60,6 +61,7 @@ static void dInternalStepIsland_x2 (dxWorldProcessMemArena *memarena,
                              dxJoint * const *_joint, unsigned int _nj, dReal stepsize)
 {
   IFTIMING(dTimerStart("preprocessing"));
+  dxProfilePhases profile_phases(world, dProfilePreprocess);
 
   const dReal stepsizeRecip = dRecip(stepsize);
 
@@ -84,14 +86,14 @@ static void dInternalStepIsland_x2 (dxWorldProcessMemArena *memarena,
       dxBody *b = *bodycurr;
 
       // compute inverse inertia tensor in global frame
-      dMultiply2_333 (tmp,b->invI,b->posr.R);
-      dMultiply0_333 (invIrow,b->posr.R,tmp); // R * invI * R^T
+      dMultiply2_333 (tmp,b->invI,b->posr->R);
+      dMultiply0_333 (invIrow,b->posr->R,tmp); // R * invI * R^T
 
       if (b->flags & dxBodyGyroscopic) {
         dMatrix3 I;
         // compute inertia tensor in global frame
-        dMultiply2_333 (tmp,b->mass.I,b->posr.R);
-        dMultiply0_333 (I,b->posr.R,tmp); // I = R * I * R^T
+        dMultiply2_333 (tmp,b->mass.I,b->posr->R);
+        dMultiply0_333 (I,b->posr->R,tmp); // I = R * I * R^T
         // compute rotational force
         dMultiply0_331 (tmp,I,b->avel); // tmp = I * \omega
         dSubtractVectorCross3 (b->tacc,b->avel,tmp); // tau = I \dot{\omega} + \omega \times I_c \omega. get I \dot{\omega}
@@ -342,6 +344,7 @@ static void dInternalStepIsland_x2 (dxWorldProcessMemArena *memarena,
 
       {
         IFTIMING(dTimerNow ("create J")); // Actually, shape of J is m x (6*numBody). compress it to (2*m) x 8
+        profile_phases.next(dProfileCreateJ);
         // get jacobian data from constraints. a (2*m)x8 matrix will be created
         // to store the two jacobian blocks from each constraint. it has this
         // format:
@@ -400,6 +403,7 @@ static void dInternalStepIsland_x2 (dxWorldProcessMemArena *memarena,
 
       {
         IFTIMING(dTimerNow ("compute A")); 
+        profile_phases.next(dProfileComputeA);
         {
           // when not compressed, shape of J is m x (6*numBody), shape of invM is (6*numBody) x (6*numBody), so shape of A = J*invM*J^T is mxm.
           // for memory align, shape of A is m x dPAD(m)
@@ -542,6 +546,7 @@ static void dInternalStepIsland_x2 (dxWorldProcessMemArena *memarena,
     BEGIN_STATE_SAVE(memarena, tmp1state) {
       // compute the right hand side `rhs'
       IFTIMING(dTimerNow ("compute rhs"));
+      profile_phases.next(dProfileComputeRhs);
 
       dReal *tmp1 = memarena->AllocateArray<dReal> ((size_t)nb*8);
       //dSetZero (tmp1,nb*8);
@@ -591,6 +596,7 @@ static void dInternalStepIsland_x2 (dxWorldProcessMemArena *memarena,
 
     BEGIN_STATE_SAVE(memarena, lcpstate) {
       IFTIMING(dTimerNow ("solving LCP problem"));
+      profile_phases.next(dProfileSolveLCP);
 
       // solve the LCP problem and get lambda.
       // this will destroy A but that's OK
@@ -630,6 +636,7 @@ static void dInternalStepIsland_x2 (dxWorldProcessMemArena *memarena,
 
     {
       IFTIMING(dTimerNow ("compute constraint force"));
+      profile_phases.next(dProfileConstraintForce);
 
       // compute the constraint force `cforce'
       // compute cforce = J'*lambda
@@ -702,6 +709,7 @@ static void dInternalStepIsland_x2 (dxWorldProcessMemArena *memarena,
   {
     // compute the velocity update
     IFTIMING(dTimerNow ("compute velocity update"));
+    profile_phases.next(dProfileIntegrateVelocity);
 
     // add fe to cforce and multiply cforce by stepsize
     dReal data[4];
@@ -723,6 +731,7 @@ static void dInternalStepIsland_x2 (dxWorldProcessMemArena *memarena,
     // update the position and orientation from the new linear/angular velocity
     // (over the given timestep)
     IFTIMING(dTimerNow ("update position"));
+    profile_phases.next(dProfileIntegratePosition);
     dxBody *const *const bodyend = body + nb;
     for (dxBody *const *bodycurr = body; bodycurr != bodyend; ++bodycurr) {
       dxBody *b = *bodycurr;
@@ -732,6 +741,7 @@ static void dInternalStepIsland_x2 (dxWorldProcessMemArena *memarena,
 
   {
     IFTIMING(dTimerNow ("tidy up"));
+    profile_phases.next(dProfileTidyUp);
 
     // zero all force accumulators
     dxBody *const *const bodyend = body + nb;
@@ -749,6 +759,7 @@ static void dInternalStepIsland_x2 (dxWorldProcessMemArena *memarena,
   }
 
   IFTIMING(dTimerEnd());
+  profile_phases.end();
   if (m > 0) IFTIMING(dTimerReport (stdout,1));
 
 }
@@ -80,14 +80,14 @@ static void dInternalStepIslandWithInfo_x2(dxWorldProcessMemArena* memarena,
             dxBody* b = *bodycurr;
 
             // compute inverse inertia tensor in global frame
-            dMultiply2_333(tmp, b->invI, b->posr.R);
-            dMultiply0_333(invIrow, b->posr.R, tmp); // R * invI * R^T
+            dMultiply2_333(tmp, b->invI, b->posr->R);
+            dMultiply0_333(invIrow, b->posr->R, tmp); // R * invI * R^T
 
             if (b->flags & dxBodyGyroscopic) {
                 dMatrix3 I;
                 // compute inertia tensor in global frame
-                dMultiply2_333(tmp, b->mass.I, b->posr.R);
-                dMultiply0_333(I, b->posr.R, tmp); // I = R * I * R^T
+                dMultiply2_333(tmp, b->mass.I, b->posr->R);
+                dMultiply0_333(I, b->posr->R, tmp); // I = R * I * R^T
                 // compute rotational force
                 dMultiply0_331(tmp, I, b->avel); // tmp = I * \omega
                 dSubtractVectorCross3(b->tacc, b->avel, tmp); // tau = I \dot{\omega} + \omega \times I_c \omega. get I \dot{\omega}
@@ -267,9 +267,12 @@ void dxStepBody (dxBody *b, dReal h)
 
 
   // handle linear velocity
-  // printf("dxstepbody pos = %lf, %lf, %lf, vel = %lf, %lf, %lf, ", b->posr.pos[0], b->posr.pos[1], b->posr.pos[2], b->lvel[0], b->lvel[1], b->lvel[2]);
-  for (unsigned int j=0; j<3; j++) b->posr.pos[j] += h * b->lvel[j];
-  // printf("after pos = %lf, %lf, %lf\n", b->posr.pos[0], b->posr.pos[1], b->posr.pos[2]);
+  // printf("dxstepbody pos = %lf, %lf, %lf, vel = %lf, %lf, %lf, ", b->posr->pos[0], b->posr->pos[1], b->posr->pos[2], b->lvel[0], b->lvel[1], b->lvel[2]);
+  // a body advanced by dSpaceSweepFastBodies already covered part of the step
+  const dReal hl = h * b->sweep_step_scale;
+  b->sweep_step_scale = 1;
+  for (unsigned int j=0; j<3; j++) b->posr->pos[j] += hl * b->lvel[j];
+  // printf("after pos = %lf, %lf, %lf\n", b->posr->pos[0], b->posr->pos[1], b->posr->pos[2]);
 
   if (b->flags & dxBodyFlagFiniteRotation) {
     dVector3 irv;	// infitesimal rotation vector
@@ -331,7 +334,7 @@ void dxStepBody (dxBody *b, dReal h)
 
   // normalize the quaternion and convert it to a rotation matrix
   dNormalize4 (b->q);
-  dQtoR (b->q,b->posr.R);
+  dQtoR (b->q,b->posr->R);
 
   // notify all attached geoms that this body has moved
   for (dxGeom *geom = b->geom; geom; geom = dGeomGetBodyNext (geom))
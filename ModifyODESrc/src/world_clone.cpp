@@ -0,0 +1,366 @@
+// Deep copy of a world and the geoms of a space, for building many copies of
+// a scene or forking a rollout without loading the scene again. The copy
+// has the same bodies, masses and state, joints (with their damping and
+// damping reference body), geoms (with offsets, contact attributes,
+// character ids and indices) and world parameters. Lists are rebuilt in the
+// same order, so the copy steps exactly like the source.
+//
+// Contact joints are not copied, take the copy between steps when the
+// contact joint group is empty. Trimesh data and character pair tables are
+// shared with the source, they must outlive the copy.
+
+#include <ode/common.h>
+#include <ode/objects.h>
+#include <ode/collision.h>
+#include <ode/collision_trimesh.h>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include "config.h"
+#include "objects.h"
+#include "joints/joint.h"
+#include "collision_kernel.h"
+
+namespace
+{
+    typedef std::unordered_map<const void*, void*> CloneMap;
+
+    template<typename T>
+    T* lookup(const CloneMap& map, T* src)
+    {
+        if (src == NULL) return NULL;
+        CloneMap::const_iterator it = map.find(src);
+        return it == map.end() ? NULL : (T*)it->second;
+    }
+
+    void copyWorldParameters(const dxWorld* src, dxWorld* dst)
+    {
+        memcpy(dst->gravity, src->gravity, sizeof(dVector3));
+        dst->global_erp = src->global_erp;
+        dst->global_cfm = src->global_cfm;
+        dst->adis = src->adis;
+        dst->body_flags = src->body_flags;
+        dst->qs = src->qs;
+        dst->contactp = src->contactp;
+        dst->dampingp = src->dampingp;
+        dst->max_angular_speed = src->max_angular_speed;
+        dst->rand_seed = src->rand_seed;
+    }
+
+    void copyBody(const dxBody* src, dxBody* dst)
+    {
+        dst->flags = src->flags;
+        dst->mass = src->mass;
+        memcpy(dst->invI, src->invI, sizeof(dMatrix3));
+        dst->invMass = src->invMass;
+        memcpy(dst->curI, src->curI, sizeof(dMatrix3));
+        *dst->posr = *src->posr;
+        memcpy(dst->q, src->q, sizeof(dQuaternion));
+        memcpy(dst->lvel, src->lvel, sizeof(dVector3));
+        memcpy(dst->avel, src->avel, sizeof(dVector3));
+        memcpy(dst->facc, src->facc, sizeof(dVector3));
+        memcpy(dst->tacc, src->tacc, sizeof(dVector3));
+        memcpy(dst->finite_rot_axis, src->finite_rot_axis, sizeof(dVector3));
+
+        // the average buffers are sized by adis.average_samples
+        dBodySetAutoDisableAverageSamplesCount(dst, src->adis.average_samples);
+        dst->adis = src->adis;
+        dst->adis_timeleft = src->adis_timeleft;
+        dst->adis_stepsleft = src->adis_stepsleft;
+        if (src->average_lvel_buffer && dst->average_lvel_buffer)
+        {
+            memcpy(dst->average_lvel_buffer, src->average_lvel_buffer, src->adis.average_samples * sizeof(dVector3));
+            memcpy(dst->average_avel_buffer, src->average_avel_buffer, src->adis.average_samples * sizeof(dVector3));
+        }
+        dst->average_counter = src->average_counter;
+        dst->average_ready = src->average_ready;
+
+        dst->moved_callback = src->moved_callback;
+        dst->dampingp = src->dampingp;
+        dst->max_angular_speed = src->max_angular_speed;
+    }
+
+    dxJoint* createJoint(dxWorld* w, dJointType type)
+    {
+        switch (type)
+        {
+        case dJointTypeBall: return dJointCreateBall(w, 0);
+        case dJointTypeEmptyBall: return dJointCreateEmptyBall(w, 0);
+        case dJointTypeHinge: return dJointCreateHinge(w, 0);
+        case dJointTypeSlider: return dJointCreateSlider(w, 0);
+        case dJointTypeUniversal: return dJointCreateUniversal(w, 0);
+        case dJointTypeHinge2: return dJointCreateHinge2(w, 0);
+        case dJointTypeFixed: return dJointCreateFixed(w, 0);
+        case dJointTypeNull: return dJointCreateNull(w, 0);
+        case dJointTypeAMotor: return dJointCreateAMotor(w, 0);
+        case dJointTypeLMotor: return dJointCreateLMotor(w, 0);
+        case dJointTypePlane2D: return dJointCreatePlane2D(w, 0);
+        case dJointTypePR: return dJointCreatePR(w, 0);
+        case dJointTypePU: return dJointCreatePU(w, 0);
+        case dJointTypePiston: return dJointCreatePiston(w, 0);
+        default: return NULL; // contact joints
+        }
+    }
+
+    // copy all members of src into the new joint dst of the same type, then
+    // put back the links of dst to its own world. The nodes point to the new
+    // bodies, they are linked into the body joint lists by linkJointNodes.
+    // (dJointAttach would recompute the relative anchors and axes from the
+    // world frame ones, which is not exact.)
+    void copyJoint(const dxJoint* src, dxJoint* dst, const CloneMap& map)
+    {
+        dxWorld* world = dst->world;
+        dObject* next = dst->next;
+        dObject** tome = dst->tome;
+
+        memcpy((void*)dst, (const void*)src, src->size());
+
+        dst->world = world;
+        dst->next = next;
+        dst->tome = tome;
+        dst->tag = 0;
+        dst->userdata = 0;
+        dst->feedback = 0;
+        dst->dampingRefBody = lookup(map, src->dampingRefBody);
+        for (int i = 0; i < 2; i++)
+        {
+            dst->node[i].joint = dst;
+            dst->node[i].body = lookup(map, src->node[i].body);
+            dst->node[i].next = 0;
+        }
+    }
+
+    // rebuild the joint list of dst in the order of the one of src
+    void linkJointNodes(const dxBody* src, dxBody* dst, const CloneMap& map)
+    {
+        dxJointNode** tail = &dst->firstjoint;
+        for (dxJointNode* n = src->firstjoint; n; n = n->next)
+        {
+            dxJoint* nj = lookup(map, n->joint);
+            if (nj == NULL) continue; // contact joint
+            dxJointNode* node = &nj->node[n == &n->joint->node[0] ? 0 : 1];
+            *tail = node;
+            tail = &node->next;
+        }
+        *tail = 0;
+    }
+
+    dxGeom* createGeom(dxSpace* space, dxGeom* src)
+    {
+        switch (src->type)
+        {
+        case dSphereClass:
+            return dCreateSphere(space, dGeomSphereGetRadius(src));
+        case dBoxClass:
+        {
+            dVector3 l;
+            dGeomBoxGetLengths(src, l);
+            return dCreateBox(space, l[0], l[1], l[2]);
+        }
+        case dCapsuleClass:
+        {
+            dReal r, l;
+            dGeomCapsuleGetParams(src, &r, &l);
+            return dCreateCapsule(space, r, l);
+        }
+        case dCylinderClass:
+        {
+            dReal r, l;
+            dGeomCylinderGetParams(src, &r, &l);
+            return dCreateCylinder(space, r, l);
+        }
+        case dPlaneClass:
+        {
+            dVector4 p;
+            dGeomPlaneGetParams(src, p);
+            return dCreatePlane(space, p[0], p[1], p[2], p[3]);
+        }
+        case dRayClass:
+        {
+            dxGeom* g = dCreateRay(space, dGeomRayGetLength(src));
+            int first_contact, backface_cull;
+            dGeomRayGetParams(src, &first_contact, &backface_cull);
+            dGeomRaySetParams(g, first_contact, backface_cull);
+            dGeomRaySetClosestHit(g, dGeomRayGetClosestHit(src));
+            return g;
+        }
+        case dTriMeshClass:
+        {
+            dxGeom* g = dCreateTriMesh(space, dGeomTriMeshGetData(src), dGeomTriMeshGetCallback(src),
+                dGeomTriMeshGetArrayCallback(src), dGeomTriMeshGetRayCallback(src));
+            dGeomTriMeshSetTriMergeCallback(g, dGeomTriMeshGetTriMergeCallback(src));
+            return g;
+        }
+        default:
+            return NULL;
+        }
+    }
+
+    // attributes that do not depend on other geoms or bodies
+    void copyGeomAttributes(const dxGeom* src, dxGeom* dst)
+    {
+        dst->category_bits = src->category_bits;
+        dst->collide_bits = src->collide_bits;
+        dst->contact_attrs = src->contact_attrs; // ignore_geoms are remapped later
+        dst->character_id = src->character_id;
+        dst->geom_index = src->geom_index;
+        if (src->pair_table) dGeomSetCharacterPairTable(dst, src->pair_table);
+        dst->draw_local_axis = src->draw_local_axis;
+        dst->render_by_default_color = src->render_by_default_color;
+        memcpy(dst->render_user_color, src->render_user_color, sizeof(dVector3));
+        if (!src->body && (src->gflags & GEOM_PLACEABLE))
+        {
+            dGeomSetPosition(dst, src->final_posr->pos[0], src->final_posr->pos[1], src->final_posr->pos[2]);
+            dGeomSetRotation(dst, src->final_posr->R);
+        }
+        if (!(src->gflags & GEOM_ENABLED)) dGeomDisable(dst);
+    }
+
+    dxSpace* createSpace(dxSpace* src)
+    {
+        dxSpace* space = NULL;
+        if (src->type == dSimpleSpaceClass)
+        {
+            space = dSimpleSpaceCreate(0);
+        }
+        else if (src->type == dHashSpaceClass)
+        {
+            // levels, auto-level flag and its history, so the copy picks the same levels
+            dxHashSpaceLevelState state;
+            space = dHashSpaceCreate(0);
+            dHashSpaceGetLevelState(src, &state);
+            dHashSpaceSetLevelState(space, &state);
+            dHashSpaceSetStatsEnabled(space, dHashSpaceGetStatsEnabled(src));
+        }
+        if (space)
+        {
+            // the copy owns its geoms
+            dSpaceSetCleanup(space, 1);
+            space->category_bits = src->category_bits;
+            space->collide_bits = src->collide_bits;
+        }
+        return space;
+    }
+
+    bool canClone(dxWorld* w, dxSpace* space)
+    {
+        if (space->type != dSimpleSpaceClass && space->type != dHashSpaceClass) return false;
+        for (dxGeom* g = space->first; g; g = g->next)
+        {
+            if (dGeomIsSpace(g)) return false;
+            if (g->type != dSphereClass && g->type != dBoxClass && g->type != dCapsuleClass
+                && g->type != dCylinderClass && g->type != dPlaneClass && g->type != dRayClass
+                && g->type != dTriMeshClass) return false;
+            if (g->body && g->body->world != w) return false;
+        }
+        return true;
+    }
+}
+
+dWorldID dWorldClone(dWorldID w, dSpaceID space, dSpaceID* space_out,
+    dBodyID* src_bodies, dBodyID* new_bodies,
+    dJointID* src_joints, dJointID* new_joints,
+    dGeomID* src_geoms, dGeomID* new_geoms)
+{
+    dAASSERT(w && space && space_out);
+    if (!canClone(w, space)) return NULL;
+
+    dxWorld* nw = dWorldCreate();
+    copyWorldParameters(w, nw);
+    if (w->body_storage) dWorldSetContiguousBodyStorage(nw, 1);
+    CloneMap map;
+
+    // new bodies and joints go to the head of the lists, create them from the back
+    std::vector<dxBody*> bodies;
+    for (dxBody* b = w->firstbody; b; b = (dxBody*)b->next) bodies.push_back(b);
+    for (int i = (int)bodies.size() - 1; i >= 0; i--)
+    {
+        dxBody* nb = dBodyCreate(nw);
+        copyBody(bodies[i], nb);
+        map[bodies[i]] = nb;
+    }
+
+    std::vector<dxJoint*> joints;
+    for (dxJoint* j = w->firstjoint; j; j = (dxJoint*)j->next) joints.push_back(j);
+    for (int i = (int)joints.size() - 1; i >= 0; i--)
+    {
+        dxJoint* nj = createJoint(nw, joints[i]->type());
+        if (nj == NULL) continue;
+        copyJoint(joints[i], nj, map);
+        map[joints[i]] = nj;
+    }
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        linkJointNodes(bodies[i], lookup(map, bodies[i]), map);
+    }
+
+    dxSpace* ns = createSpace(space);
+    std::vector<dxGeom*> geoms;
+    for (dxGeom* g = space->first; g; g = g->next) geoms.push_back(g);
+    for (int i = (int)geoms.size() - 1; i >= 0; i--)
+    {
+        dxGeom* ng = createGeom(ns, geoms[i]);
+        copyGeomAttributes(geoms[i], ng);
+        map[geoms[i]] = ng;
+    }
+
+    // attach the geoms to the bodies keeping the order of the body geom lists, then the offsets
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        std::vector<dxGeom*> body_geoms;
+        for (dxGeom* g = bodies[i]->geom; g; g = g->body_next)
+        {
+            if (g->parent_space == space) body_geoms.push_back(g);
+        }
+        for (int k = (int)body_geoms.size() - 1; k >= 0; k--)
+        {
+            dxGeom* src = body_geoms[k];
+            dxGeom* ng = lookup(map, src);
+            dGeomSetBody(ng, lookup(map, bodies[i]));
+            if (src->offset_posr)
+            {
+                dGeomSetOffsetPosition(ng, 0, 0, 0);
+                *ng->offset_posr = *src->offset_posr;
+                ng->gflags |= GEOM_POSR_BAD;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < geoms.size(); i++)
+    {
+        dGeomContactAttrs* attrs = &lookup(map, geoms[i])->contact_attrs;
+        for (int k = 0; k < attrs->num_ignore_geoms; k++)
+        {
+            attrs->ignore_geoms[k] = lookup(map, attrs->ignore_geoms[k]);
+        }
+    }
+
+    // dGeomSetBody moved the attached geoms to the front, put the list in the source order
+    for (int i = (int)geoms.size() - 1; i >= 0; i--)
+    {
+        dxGeom* ng = lookup(map, geoms[i]);
+        ng->spaceRemove();
+        ng->spaceAdd(&ns->first);
+        ng->gflags |= GEOM_DIRTY | GEOM_AABB_BAD;
+        if (ng->offset_posr) ng->gflags |= GEOM_POSR_BAD;
+    }
+    ns->current_geom = 0;
+
+    *space_out = ns;
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        if (src_bodies) src_bodies[i] = bodies[i];
+        if (new_bodies) new_bodies[i] = lookup(map, bodies[i]);
+    }
+    for (size_t i = 0; i < joints.size(); i++)
+    {
+        if (src_joints) src_joints[i] = joints[i];
+        if (new_joints) new_joints[i] = lookup(map, joints[i]);
+    }
+    for (size_t i = 0; i < geoms.size(); i++)
+    {
+        if (src_geoms) src_geoms[i] = geoms[i];
+        if (new_geoms) new_geoms[i] = lookup(map, geoms[i]);
+    }
+    return nw;
+}
@@ -0,0 +1,61 @@
+// Per-world phase profiler: enable, reset and read the accumulators that
+// the steppers and dCollideContactCallback fill through world_profile.h.
+
+#include <ode/common.h>
+#include <ode/objects.h>
+#include <cstring>
+#include "config.h"
+#include "objects.h"
+#include "world_profile.h"
+
+static_assert(dProfilePhaseCount <= dxPROFILE_MAX_PHASES, "dxWorldProfile is too small");
+
+void dWorldSetProfiling (dWorldID w, int enabled)
+{
+    dAASSERT(w);
+    w->profile.enabled = enabled != 0;
+}
+
+int dWorldGetProfiling (dWorldID w)
+{
+    dAASSERT(w);
+    return w->profile.enabled;
+}
+
+void dWorldResetProfile (dWorldID w)
+{
+    dAASSERT(w);
+    int enabled = w->profile.enabled;
+    memset(&w->profile, 0, sizeof(w->profile));
+    w->profile.enabled = enabled;
+}
+
+void dWorldGetProfile (dWorldID w, dWorldProfile *profile)
+{
+    dAASSERT(w && profile);
+    const dxWorldProfile &p = w->profile;
+    for (int i = 0; i < dProfilePhaseCount; i++)
+    {
+        profile->seconds[i] = p.ticks[i] * 1e-9;
+        profile->calls[i] = p.calls[i];
+    }
+
+    // the broadphase span contains the near callbacks
+    unsigned long long nested = p.ticks[dProfileNarrowphase] + p.ticks[dProfileContacts];
+    unsigned long long broad = p.ticks[dProfileBroadphase];
+    profile->seconds[dProfileBroadphase] = (broad > nested ? broad - nested : 0) * 1e-9;
+    profile->steps = p.steps;
+}
+
+unsigned long long dWorldProfileBegin (dWorldID w)
+{
+    dAASSERT(w);
+    return dxProfileBegin(w);
+}
+
+void dWorldProfileEnd (dWorldID w, int phase, unsigned long long begin)
+{
+    dAASSERT(w);
+    dUASSERT(phase >= 0 && phase < dProfilePhaseCount, "bad profiler phase");
+    dxProfileEnd(w, phase, begin);
+}
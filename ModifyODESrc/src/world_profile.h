@@ -0,0 +1,90 @@
+// Timing helpers of the per-world profiler (dWorldSetProfiling). Times are
+// steady_clock nanoseconds accumulated in dxWorld::profile. When the
+// profiler is off every helper reduces to a test of profile.enabled.
+//
+// dxProfilePhases follows the IFTIMING markers of a stepper: next() closes
+// the running phase and opens the given one, like dTimerNow.
+
+#ifndef _ODE_WORLD_PROFILE_H_
+#define _ODE_WORLD_PROFILE_H_
+
+#include <chrono>
+#include <ode/objects.h>
+#include "objects.h"
+
+static inline unsigned long long dxProfileTicks()
+{
+    return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 0 if the profiler of the world is disabled
+static inline unsigned long long dxProfileBegin(const dxWorld *w)
+{
+    if (!w->profile.enabled)
+        return 0;
+    unsigned long long t = dxProfileTicks();
+    return t ? t : 1;
+}
+
+static inline void dxProfileEnd(dxWorld *w, int phase, unsigned long long begin)
+{
+    if (begin == 0)
+        return;
+    w->profile.ticks[phase] += dxProfileTicks() - begin;
+    w->profile.calls[phase]++;
+}
+
+// end of the island build, which happens once per step
+static inline void dxProfileStepBegun(dxWorld *w, unsigned long long begin)
+{
+    if (begin == 0)
+        return;
+    dxProfileEnd(w, dProfileIslands, begin);
+    w->profile.steps++;
+}
+
+class dxProfilePhases
+{
+public:
+    dxProfilePhases(dxWorld *w, int first_phase):
+        profile(w->profile.enabled ? &w->profile : NULL), phase(first_phase), begin(0)
+    {
+        if (profile)
+            begin = dxProfileTicks();
+    }
+
+    ~dxProfilePhases()
+    {
+        end();
+    }
+
+    void next(int next_phase)
+    {
+        if (profile)
+        {
+            unsigned long long now = dxProfileTicks();
+            profile->ticks[phase] += now - begin;
+            profile->calls[phase]++;
+            phase = next_phase;
+            begin = now;
+        }
+    }
+
+    void end()
+    {
+        if (profile)
+        {
+            profile->ticks[phase] += dxProfileTicks() - begin;
+            profile->calls[phase]++;
+            profile = NULL;
+        }
+    }
+
+private:
+    dxWorldProfile *profile;
+    int phase;
+    unsigned long long begin;
+};
+
+#endif
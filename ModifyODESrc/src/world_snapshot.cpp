@@ -0,0 +1,371 @@
+// Snapshot / restore of the dynamic state of a world to a flat byte buffer,
+// for planning and branching rollouts that go back to the same state many
+// times. Only state that changes while stepping is saved: body state and
+// accumulators, auto-disable counters and buffers, joint lambda and flags,
+// the random seed of the world, the order of the geoms in the spaces of the
+// body geoms (the contact order, and so the solver result, depends on it)
+// and the adaptive level state of hash spaces. Masses, joint anchors etc.
+// are not saved. Sweep-and-prune and quadtree spaces keep their order in
+// structures other than the geom list, so a world with body geoms in such a
+// space cannot be snapshotted.
+//
+// The buffer refers to bodies, joints and geoms by position and address,
+// so it can only be restored into the world it was taken from, with the
+// same bodies, joints and geoms. Take it between steps, when the contact
+// joint group is empty.
+
+#include <ode/common.h>
+#include <ode/objects.h>
+#include <ode/collision.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include "config.h"
+#include "objects.h"
+#include "joints/joint.h"
+#include "collision_kernel.h"
+
+namespace
+{
+    const uint32_t SNAPSHOT_MAGIC = 0x53574f44; // "DOWS"
+    const uint32_t SNAPSHOT_VERSION = 2;
+
+    struct SnapshotHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t num_bodies;
+        uint32_t num_joints;
+        uint32_t num_spaces;
+        uint32_t real_size;     // sizeof(dReal)
+        uint64_t total_size;
+        uint64_t world;         // address of the world the snapshot was taken from
+        uint64_t rand_seed;
+    };
+
+    // followed by average_samples * 2 dVector3 of the auto-disable buffers
+    struct BodyRecord
+    {
+        dVector3 pos;
+        dMatrix3 R;
+        dQuaternion q;
+        dVector3 lvel, avel;
+        dVector3 facc, tacc;
+        dVector3 finite_rot_axis;
+        dMatrix3 curI;
+        dReal adis_timeleft;
+        uint32_t flags;
+        int32_t adis_stepsleft;
+        uint32_t average_counter;
+        int32_t average_ready;
+        uint32_t average_samples;
+        uint32_t reserved;
+    };
+
+    struct JointRecord
+    {
+        dReal lambda[6];
+        uint32_t flags;
+        uint32_t reserved;
+    };
+
+    // followed by num_geoms addresses of the geoms, in list order,
+    // then a dxHashSpaceLevelState for hash spaces
+    struct SpaceRecord
+    {
+        uint64_t space;
+        uint32_t num_geoms;
+        int32_t type;
+    };
+
+    // only simple and hash spaces keep their state in the geom list
+    bool canRelink(const dxSpace* s)
+    {
+        return s->type == dSimpleSpaceClass || s->type == dHashSpaceClass;
+    }
+
+    size_t spaceRecordSize(const dxSpace* s)
+    {
+        return sizeof(SpaceRecord) + (size_t)s->count * sizeof(uint64_t)
+            + (s->type == dHashSpaceClass ? sizeof(dxHashSpaceLevelState) : 0);
+    }
+
+    size_t averageBufferSize(const dxBody* b)
+    {
+        return (b->average_lvel_buffer ? b->adis.average_samples * 2 * sizeof(dVector3) : 0);
+    }
+
+    // the spaces directly holding the body geoms, in body order
+    void collectSpaces(const dxWorld* w, std::vector<dxSpace*>& spaces)
+    {
+        for (dxBody* b = w->firstbody; b; b = (dxBody*)b->next)
+        {
+            for (dxGeom* g = b->geom; g; g = g->body_next)
+            {
+                dxSpace* s = g->parent_space;
+                if (s != NULL && std::find(spaces.begin(), spaces.end(), s) == spaces.end())
+                {
+                    spaces.push_back(s);
+                }
+            }
+        }
+    }
+
+    size_t snapshotSize(const dxWorld* w, const std::vector<dxSpace*>& spaces)
+    {
+        size_t size = sizeof(SnapshotHeader);
+        for (dxBody* b = w->firstbody; b; b = (dxBody*)b->next)
+        {
+            size += sizeof(BodyRecord) + averageBufferSize(b);
+        }
+        size += (size_t)w->nj * sizeof(JointRecord);
+        for (size_t i = 0; i < spaces.size(); i++)
+        {
+            size += spaceRecordSize(spaces[i]);
+        }
+        return size;
+    }
+
+    // relink the geoms of the space in the given order and mark all of them dirty,
+    // so the AABBs are recomputed by the next collide as they would have been.
+    void relinkSpace(dxSpace* s, const uint64_t* order, int num_geoms)
+    {
+        for (int i = num_geoms - 1; i >= 0; i--)
+        {
+            dxGeom* g = (dxGeom*)(uintptr_t)order[i];
+            g->spaceRemove();
+            g->spaceAdd(&s->first);
+        }
+        for (dxGeom* g = s->first; g; g = g->next)
+        {
+            g->gflags |= GEOM_DIRTY | GEOM_AABB_BAD;
+            if (g->offset_posr) g->gflags |= GEOM_POSR_BAD;
+        }
+        s->current_geom = 0;
+    }
+}
+
+size_t dWorldGetSnapshotSize(dWorldID w)
+{
+    dAASSERT(w);
+    std::vector<dxSpace*> spaces;
+    collectSpaces(w, spaces);
+    return snapshotSize(w, spaces);
+}
+
+size_t dWorldSnapshot(dWorldID w, void* buffer, size_t buffer_size)
+{
+    dAASSERT(w && buffer);
+    std::vector<dxSpace*> spaces;
+    collectSpaces(w, spaces);
+    for (size_t i = 0; i < spaces.size(); i++)
+    {
+        if (!canRelink(spaces[i])) return 0;
+    }
+    size_t total = snapshotSize(w, spaces);
+    if (buffer_size < total) return 0;
+
+    char* p = (char*)buffer;
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.num_bodies = (uint32_t)w->nb;
+    header.num_joints = (uint32_t)w->nj;
+    header.num_spaces = (uint32_t)spaces.size();
+    header.real_size = (uint32_t)sizeof(dReal);
+    header.total_size = total;
+    header.world = (uint64_t)(uintptr_t)w;
+    header.rand_seed = w->rand_seed;
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+
+    for (dxBody* b = w->firstbody; b; b = (dxBody*)b->next)
+    {
+        BodyRecord r;
+        memset(&r, 0, sizeof(r));
+        memcpy(r.pos, b->posr->pos, sizeof(dVector3));
+        memcpy(r.R, b->posr->R, sizeof(dMatrix3));
+        memcpy(r.q, b->q, sizeof(dQuaternion));
+        memcpy(r.lvel, b->lvel, sizeof(dVector3));
+        memcpy(r.avel, b->avel, sizeof(dVector3));
+        memcpy(r.facc, b->facc, sizeof(dVector3));
+        memcpy(r.tacc, b->tacc, sizeof(dVector3));
+        memcpy(r.finite_rot_axis, b->finite_rot_axis, sizeof(dVector3));
+        memcpy(r.curI, b->curI, sizeof(dMatrix3));
+        r.adis_timeleft = b->adis_timeleft;
+        r.flags = b->flags;
+        r.adis_stepsleft = b->adis_stepsleft;
+        r.average_counter = b->average_counter;
+        r.average_ready = b->average_ready;
+        r.average_samples = b->average_lvel_buffer ? b->adis.average_samples : 0;
+        memcpy(p, &r, sizeof(r));
+        p += sizeof(r);
+        if (r.average_samples)
+        {
+            size_t n = r.average_samples * sizeof(dVector3);
+            memcpy(p, b->average_lvel_buffer, n);
+            memcpy(p + n, b->average_avel_buffer, n);
+            p += 2 * n;
+        }
+    }
+
+    for (dxJoint* j = w->firstjoint; j; j = (dxJoint*)j->next)
+    {
+        JointRecord r;
+        memset(&r, 0, sizeof(r));
+        memcpy(r.lambda, j->lambda, sizeof(r.lambda));
+        r.flags = j->flags;
+        memcpy(p, &r, sizeof(r));
+        p += sizeof(r);
+    }
+
+    for (size_t i = 0; i < spaces.size(); i++)
+    {
+        SpaceRecord r;
+        memset(&r, 0, sizeof(r));
+        r.space = (uint64_t)(uintptr_t)spaces[i];
+        r.num_geoms = (uint32_t)spaces[i]->count;
+        r.type = spaces[i]->type;
+        memcpy(p, &r, sizeof(r));
+        p += sizeof(r);
+        for (dxGeom* g = spaces[i]->first; g; g = g->next)
+        {
+            uint64_t address = (uint64_t)(uintptr_t)g;
+            memcpy(p, &address, sizeof(address));
+            p += sizeof(address);
+        }
+        if (r.type == dHashSpaceClass)
+        {
+            dxHashSpaceLevelState state;
+            memset(&state, 0, sizeof(state));
+            dHashSpaceGetLevelState(spaces[i], &state);
+            memcpy(p, &state, sizeof(state));
+            p += sizeof(state);
+        }
+    }
+    return total;
+}
+
+int dWorldRestore(dWorldID w, const void* buffer, size_t buffer_size)
+{
+    dAASSERT(w && buffer);
+    if (buffer_size < sizeof(SnapshotHeader)) return 0;
+    SnapshotHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION
+        || header.real_size != sizeof(dReal) || header.world != (uint64_t)(uintptr_t)w
+        || header.num_bodies != (uint32_t)w->nb || header.num_joints != (uint32_t)w->nj
+        || header.total_size > buffer_size)
+    {
+        return 0;
+    }
+
+    // check the layout first, so a mismatched buffer leaves the world untouched
+    std::vector<dxSpace*> spaces;
+    collectSpaces(w, spaces);
+    if (header.num_spaces != spaces.size() || header.total_size != snapshotSize(w, spaces)) return 0;
+
+    const char* p = (const char*)buffer + sizeof(header);
+    for (dxBody* b = w->firstbody; b; b = (dxBody*)b->next)
+    {
+        BodyRecord r;
+        memcpy(&r, p, sizeof(r));
+        if (r.average_samples != (b->average_lvel_buffer ? b->adis.average_samples : 0)) return 0;
+        p += sizeof(r) + averageBufferSize(b);
+    }
+    const char* joint_records = p;
+    p += (size_t)w->nj * sizeof(JointRecord);
+    const char* space_records = p;
+    std::vector<dxGeom*> current, saved;
+    for (size_t i = 0; i < spaces.size(); i++)
+    {
+        SpaceRecord r;
+        memcpy(&r, p, sizeof(r));
+        p += sizeof(r);
+        if (r.space != (uint64_t)(uintptr_t)spaces[i] || r.num_geoms != (uint32_t)spaces[i]->count
+            || r.type != spaces[i]->type || !canRelink(spaces[i])) return 0;
+        current.clear();
+        saved.resize(r.num_geoms);
+        for (dxGeom* g = spaces[i]->first; g; g = g->next) current.push_back(g);
+        for (uint32_t k = 0; k < r.num_geoms; k++)
+        {
+            uint64_t address;
+            memcpy(&address, p + k * sizeof(uint64_t), sizeof(address));
+            saved[k] = (dxGeom*)(uintptr_t)address;
+        }
+        p += r.num_geoms * sizeof(uint64_t);
+        if (r.type == dHashSpaceClass) p += sizeof(dxHashSpaceLevelState);
+        std::sort(current.begin(), current.end());
+        std::sort(saved.begin(), saved.end());
+        if (current != saved) return 0;
+    }
+
+    // write the state
+    p = (const char*)buffer + sizeof(header);
+    for (dxBody* b = w->firstbody; b; b = (dxBody*)b->next)
+    {
+        BodyRecord r;
+        memcpy(&r, p, sizeof(r));
+        p += sizeof(r);
+        memcpy(b->posr->pos, r.pos, sizeof(dVector3));
+        memcpy(b->posr->R, r.R, sizeof(dMatrix3));
+        memcpy(b->q, r.q, sizeof(dQuaternion));
+        memcpy(b->lvel, r.lvel, sizeof(dVector3));
+        memcpy(b->avel, r.avel, sizeof(dVector3));
+        memcpy(b->facc, r.facc, sizeof(dVector3));
+        memcpy(b->tacc, r.tacc, sizeof(dVector3));
+        memcpy(b->finite_rot_axis, r.finite_rot_axis, sizeof(dVector3));
+        memcpy(b->curI, r.curI, sizeof(dMatrix3));
+        b->adis_timeleft = r.adis_timeleft;
+        b->flags = r.flags;
+        b->adis_stepsleft = r.adis_stepsleft;
+        b->average_counter = r.average_counter;
+        b->average_ready = r.average_ready;
+        if (r.average_samples)
+        {
+            size_t n = r.average_samples * sizeof(dVector3);
+            memcpy(b->average_lvel_buffer, p, n);
+            memcpy(b->average_avel_buffer, p + n, n);
+            p += 2 * n;
+        }
+        for (dxGeom* g = b->geom; g; g = g->body_next)
+        {
+            dGeomMoved(g);
+        }
+    }
+
+    p = joint_records;
+    for (dxJoint* j = w->firstjoint; j; j = (dxJoint*)j->next)
+    {
+        JointRecord r;
+        memcpy(&r, p, sizeof(r));
+        p += sizeof(r);
+        memcpy(j->lambda, r.lambda, sizeof(r.lambda));
+        j->flags = r.flags;
+    }
+
+    p = space_records;
+    std::vector<uint64_t> order;
+    for (size_t i = 0; i < spaces.size(); i++)
+    {
+        SpaceRecord r;
+        memcpy(&r, p, sizeof(r));
+        p += sizeof(r);
+        order.resize(r.num_geoms);
+        memcpy(order.data(), p, r.num_geoms * sizeof(uint64_t));
+        p += r.num_geoms * sizeof(uint64_t);
+        relinkSpace(spaces[i], order.data(), (int)r.num_geoms);
+        if (r.type == dHashSpaceClass)
+        {
+            dxHashSpaceLevelState state;
+            memcpy(&state, p, sizeof(state));
+            p += sizeof(state);
+            dHashSpaceSetLevelState(spaces[i], &state);
+        }
+    }
+
+    w->rand_seed = header.rand_seed;
+    return 1;
+}
@@ -0,0 +1,103 @@
+'''
+*************************************************************************
+
+BSD 3-Clause License
+
+Copyright (c) 2023,  Visual Computing and Learning Lab, Peking University
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*************************************************************************
+'''
+'''
+Benchmark of the swept collision of fast moving bodies (Body.fast_moving).
+
+A small box is thrown at a thin static capsule (a limb) with increasing speed.
+For every speed we report the smallest number of substeps per control frame
+that stops the box without the sweep, whether the box still tunnels with the
+sweep at the default substep count, and the simulation time of both.
+'''
+import argparse
+import time
+import numpy as np
+import VclSimuBackend as ode
+
+
+def throw_once(speed: float, substep: int, fast_moving: bool, fps: int, box_size: float, limb_radius: float):
+    world = ode.World()
+    world.setGravityYEarth()
+    space = ode.HashSpace()
+    limb = ode.GeomCapsule(space, limb_radius, 1.0)  # along z axis, static
+    limb.PositionNumpy = np.array([0.0, 1.0, 0.0])
+
+    box = ode.GeomBox(space, [box_size] * 3)
+    body = ode.Body(world)
+    mass = ode.Mass()
+    mass.setBox(100, box_size, box_size, box_size)
+    body.setMass(mass)
+    box.body = body
+    body.PositionNumpy = np.array([-1.0, 1.0, 0.0])
+    body.setLinearVel(np.array([speed, 0.0, 0.0]))
+    body.fast_moving = fast_moving
+
+    sim_dt = 1.0 / (fps * substep)
+    num_step = int(np.ceil(2.0 / speed / sim_dt))  # long enough to fly 2 meters
+    start = time.perf_counter()
+    for _ in range(num_step):
+        world.damped_step_fast_collision(space, sim_dt)
+    cost = time.perf_counter() - start
+
+    tunneled = body.PositionNumpy[0] > limb_radius + 0.5 * box_size
+    return tunneled, cost
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--fps", type=int, default=20, help="control frames per second, as env_fps")
+    parser.add_argument("--substep", type=int, default=6, help="substeps kept for the scene, as env_substep")
+    parser.add_argument("--max_substep", type=int, default=96)
+    parser.add_argument("--box_size", type=float, default=0.1)
+    parser.add_argument("--limb_radius", type=float, default=0.04)
+    parser.add_argument("--speeds", type=float, nargs="+", default=[5, 10, 20, 40, 60, 80])
+    args = parser.parse_args()
+
+    print(f"{'speed':>8} {'substep w/o sweep':>18} {'time':>10} {'tunnel w/ sweep':>16} {'time':>10}")
+    for speed in args.speeds:
+        need, need_cost = None, None
+        for substep in range(1, args.max_substep + 1):
+            tunneled, cost = throw_once(speed, substep, False, args.fps, args.box_size, args.limb_radius)
+            if not tunneled:
+                need, need_cost = substep, cost
+                break
+
+        tunneled, cost = throw_once(speed, args.substep, True, args.fps, args.box_size, args.limb_radius)
+        need_str = str(need) if need is not None else f">{args.max_substep}"
+        need_cost_str = f"{need_cost * 1e3:.3f}ms" if need_cost is not None else "-"
+        print(f"{speed:8.1f} {need_str:>18} {need_cost_str:>10} {str(bool(tunneled)):>16} {cost * 1e3:8.3f}ms")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,120 @@
+'''
+*************************************************************************
+
+BSD 3-Clause License
+
+Copyright (c) 2023,  Visual Computing and Learning Lab, Peking University
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*************************************************************************
+'''
+'''
+Stress test of stepping independent worlds from several Python threads.
+
+World.step / dampedStep / quickStep / damped_step_fast_collision and the bulk
+getBody* / loadBody* calls release the GIL, so N worlds stepped by a thread pool
+should scale with the number of threads. The body state is read every step in
+place, through World.body_state_views. For every thread count we report the
+wall time, the speedup over one thread, and check that the final states are
+bitwise equal to the single thread run.
+'''
+import argparse
+import time
+from concurrent.futures import ThreadPoolExecutor
+from typing import List
+import numpy as np
+import VclSimuBackend as ode
+
+
+class BoxPile:
+    def __init__(self, num_box: int, seed: int):
+        self.world = ode.World()
+        self.world.setGravityYEarth()
+        self.world.contiguous_body_storage = True
+        self.world.reserve_body_storage(num_box)
+        self.space = ode.HashSpace()
+        self.plane = ode.GeomPlane(self.space, (0, 1, 0), 0)
+        rng = np.random.default_rng(seed)
+        self.bodies = []
+        self.geoms = []
+        for i in range(num_box):
+            size = rng.uniform(0.1, 0.3, 3)
+            body = ode.Body(self.world)
+            mass = ode.Mass()
+            mass.setBox(100, *size)
+            body.setMass(mass)
+            geom = ode.GeomBox(self.space, size)
+            geom.body = body
+            body.PositionNumpy = np.array([rng.uniform(-1, 1), 0.2 + 0.4 * i, rng.uniform(-1, 1)])
+            self.bodies.append(body)
+            self.geoms.append(geom)
+        self.body_id = self.world.getAllBodyID()
+        self.state = self.world.body_state_views()  # no body is created after this
+        self.init_pos = self.world.getBodyPos(self.body_id)
+        self.init_quat = self.world.getBodyQuatScipy(self.body_id)
+
+    def run(self, num_step: int, dt: float) -> np.ndarray:
+        self.world.loadBodyPos(self.body_id, self.init_pos)
+        self.world.loadBodyQuat(self.body_id, self.init_quat)
+        self.world.loadBodyLinVel(self.body_id, np.zeros_like(self.init_pos))
+        self.world.loadBodyAngVel(self.body_id, np.zeros_like(self.init_pos))
+        lowest, fastest = np.inf, 0.0
+        for _ in range(num_step):
+            self.world.damped_step_fast_collision(self.space, dt)
+            lowest = min(lowest, self.state["pos"][:, 1].min())
+            fastest = max(fastest, np.abs(self.state["linvel"]).max())
+        assert lowest > -0.5 and np.isfinite(fastest), "a box fell through the plane or diverged"
+        return np.concatenate([self.world.getBodyPos(self.body_id), self.world.getBodyQuatScipy(self.body_id)])
+
+
+def run_all(piles: List[BoxPile], num_thread: int, num_step: int, dt: float):
+    start = time.perf_counter()
+    with ThreadPoolExecutor(max_workers=num_thread) as pool:
+        result = list(pool.map(lambda pile: pile.run(num_step, dt), piles))
+    return time.perf_counter() - start, result
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--num_world", type=int, default=16)
+    parser.add_argument("--num_box", type=int, default=30)
+    parser.add_argument("--num_step", type=int, default=600)
+    parser.add_argument("--dt", type=float, default=1.0 / 120)
+    parser.add_argument("--threads", type=int, nargs="+", default=[1, 2, 4, 8])
+    args = parser.parse_args()
+
+    piles = [BoxPile(args.num_box, seed) for seed in range(args.num_world)]
+    base_cost, base_result = run_all(piles, 1, args.num_step, args.dt)
+    print(f"{'threads':>8} {'time':>10} {'speedup':>8} {'same result':>12}")
+    for num_thread in args.threads:
+        cost, result = run_all(piles, num_thread, args.num_step, args.dt)
+        same = all(np.array_equal(a, b) for a, b in zip(base_result, result))
+        print(f"{num_thread:8d} {cost:9.3f}s {base_cost / cost:8.2f} {str(same):>12}")
+
+
+if __name__ == "__main__":
+    main()
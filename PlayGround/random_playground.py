@@ -98,6 +98,7 @@ class RandomPlayground(ControlVAE):
         body.setMass(mass)
         self.other_objects[name] = body
         body.PositionNumpy = np.array([100.0,1.0,0.0])
+        body.fast_moving = True  # swept in ODEScene.pre_simulate_step, so thrown boxes do not tunnel through thin limbs
         box.character_id = -2 - np.random.randint(0,100)
     
         